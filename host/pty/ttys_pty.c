@@ -0,0 +1,345 @@
+/**
+ * @file ttys_pty.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Linux pseudo-terminal backend for ttys on the host build. The
+ * reader thread only queues bytes on the simulated USART's wire, everything
+ * else (the frame timing, RXNE, the ttys ISR and ring) runs on the firmware's
+ * thread, so ttys sees the same sequence of events as on the part.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+// ptsname_r()
+#define _GNU_SOURCE
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Simulator includes */
+#include <sim.h>
+
+/* Module includes */
+#include <ttys_pty.h>
+
+// Last, its CR1..CR3 delay macros would rename the USART registers
+#include <termios.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Types
+////////////////////////////////////////////////////////////////////////////////
+
+/* One pty backed instance */
+typedef struct {
+  USART_TypeDef *ptyPort;
+  int masterFd;
+  int slaveFd;  // Held open so the pty outlives the clients using it
+  pthread_t ptyReader;
+  atomic_bool isRunning;
+  bool isOpen;
+
+  atomic_uint rxBytes;  // Written by the reader thread
+  uint32_t txBytes;
+  uint32_t txDrops;
+
+} ttys_pty_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Function Declarations
+////////////////////////////////////////////////////////////////////////////////
+static void ttys_pty_once(void);
+static void *ttys_pty_reader(void *ptyArg);
+static void ttys_pty_tx(void *hookCtx, uint8_t txData);
+static void ttys_pty_idle(void);
+static void ttys_pty_deadline(struct timespec *ptyDeadline, uint32_t ptyMs);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Variables
+////////////////////////////////////////////////////////////////////////////////
+static ttys_pty_t ptyInstances[TTYS_NUM_INSTANCES];
+static USART_TypeDef *const ptyPorts[TTYS_NUM_INSTANCES] = {
+    TTYS_PORT_1, TTYS_PORT_2, TTYS_PORT_3};
+static uint32_t ptyNumOpen;
+
+// Input arrived: the readers bump ptyRxSeq, the idle hook waits for it to
+// move past the last value it saw
+static pthread_once_t ptyOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t ptyLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ptyRxCond;
+static uint32_t ptyRxSeq;
+static uint32_t ptyIdleSeq;
+
+////////////////////////////////////////////////////////////////////////////////
+// Global Function Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Backs a ttys instance with a new pty in raw mode and starts its
+ *         reader thread. Clients open the slave side, whose name is
+ *         returned.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[out]: slaveName. The slave device, e.g. /dev/pts/3, may be NULL
+ * @param[in]: slaveNameLen
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_pty_open(uint32_t ttysInstIdx, char *slaveName,
+                       size_t slaveNameLen) {
+  char ptyName[64];
+  struct termios ptyTerm;
+
+  if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_PTY_ERR_IDX;
+
+  ttys_pty_t *ptyTmp = &ptyInstances[ttysInstIdx];
+  if (ptyTmp->isOpen) return TTYS_PTY_ERR_OPEN;
+
+  (void)pthread_once(&ptyOnce, ttys_pty_once);
+
+  int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (masterFd < 0) return TTYS_PTY_ERR_OPEN;
+
+  if (grantpt(masterFd) != 0 || unlockpt(masterFd) != 0 ||
+      ptsname_r(masterFd, ptyName, sizeof(ptyName)) != 0) {
+    (void)close(masterFd);
+    return TTYS_PTY_ERR_OPEN;
+  }
+
+  int slaveFd = open(ptyName, O_RDWR | O_NOCTTY);
+  if (slaveFd < 0) {
+    (void)close(masterFd);
+    return TTYS_PTY_ERR_OPEN;
+  }
+
+  // Raw, the line discipline would echo and translate CR/LF
+  if (tcgetattr(slaveFd, &ptyTerm) != 0) {
+    (void)close(slaveFd);
+    (void)close(masterFd);
+    return TTYS_PTY_ERR_OPEN;
+  }
+  cfmakeraw(&ptyTerm);
+  (void)tcsetattr(slaveFd, TCSANOW, &ptyTerm);
+
+  // TX waits in poll() with a bound instead of blocking in write()
+  (void)fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+
+  ptyTmp->ptyPort = ptyPorts[ttysInstIdx];
+  ptyTmp->masterFd = masterFd;
+  ptyTmp->slaveFd = slaveFd;
+  ptyTmp->txBytes = 0U;
+  ptyTmp->txDrops = 0U;
+  atomic_store(&ptyTmp->rxBytes, 0U);
+  atomic_store(&ptyTmp->isRunning, true);
+
+  sim_usart_set_tx_hook(ptyTmp->ptyPort, ttys_pty_tx, ptyTmp);
+
+  if (pthread_create(&ptyTmp->ptyReader, NULL, ttys_pty_reader, ptyTmp) !=
+      0) {
+    sim_usart_set_tx_hook(ptyTmp->ptyPort, NULL, NULL);
+    (void)close(slaveFd);
+    (void)close(masterFd);
+    return TTYS_PTY_ERR_THREAD;
+  }
+
+  if (ptyNumOpen++ == 0U) sim_set_idle_hook(ttys_pty_idle);
+  ptyTmp->isOpen = true;
+
+  if (slaveName != NULL && slaveNameLen != 0U) {
+    (void)snprintf(slaveName, slaveNameLen, "%s", ptyName);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Stops the reader thread and closes the pty. Bytes still queued on
+ *         the USART's wire are delivered.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_pty_close(uint32_t ttysInstIdx) {
+  if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_PTY_ERR_IDX;
+
+  ttys_pty_t *ptyTmp = &ptyInstances[ttysInstIdx];
+  if (!ptyTmp->isOpen) return TTYS_PTY_ERR_NOT_OPEN;
+
+  atomic_store(&ptyTmp->isRunning, false);
+  (void)pthread_join(ptyTmp->ptyReader, NULL);
+
+  sim_usart_set_tx_hook(ptyTmp->ptyPort, NULL, NULL);
+  (void)close(ptyTmp->slaveFd);
+  (void)close(ptyTmp->masterFd);
+
+  if (--ptyNumOpen == 0U) sim_set_idle_hook(NULL);
+  ptyTmp->isOpen = false;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Copies the byte counts of a pty backed instance.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[out]: ptyStats
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_pty_get_stats(uint32_t ttysInstIdx, ttys_pty_stats_t *ptyStats) {
+  if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_PTY_ERR_IDX;
+  if (ptyStats == NULL) return TTYS_ERR_NULL;
+
+  ttys_pty_t *ptyTmp = &ptyInstances[ttysInstIdx];
+
+  ptyStats->rxBytes = atomic_load(&ptyTmp->rxBytes);
+  ptyStats->txBytes = ptyTmp->txBytes;
+  ptyStats->txDrops = ptyTmp->txDrops;
+
+  return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Function Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Sets the input condition up on the monotonic clock.
+ *
+ * @return[out]: void
+ **/
+static void ttys_pty_once(void) {
+  pthread_condattr_t ptyAttr;
+
+  (void)pthread_condattr_init(&ptyAttr);
+  (void)pthread_condattr_setclock(&ptyAttr, CLOCK_MONOTONIC);
+  (void)pthread_cond_init(&ptyRxCond, &ptyAttr);
+  (void)pthread_condattr_destroy(&ptyAttr);
+}
+
+/**
+ * @brief: Reader thread. Queues what the pty receives on the USART's wire,
+ *         where the firmware's thread picks it up a frame at a time, and
+ *         wakes __WFI(). A full wire is backpressure: the rest waits here
+ *         and the pty's own buffer then holds the client off.
+ *
+ * @param[in]: ptyArg. The ttys_pty_t
+ * @return[out]: void*
+ **/
+static void *ttys_pty_reader(void *ptyArg) {
+  ttys_pty_t *ptyTmp = (ttys_pty_t *)ptyArg;
+  uint8_t rxBuf[TTYS_PTY_READ_SIZE];
+  struct pollfd ptyPoll = {.fd = ptyTmp->masterFd, .events = POLLIN};
+  struct timespec ptyRetry = {.tv_sec = 0, .tv_nsec = 1000000L};
+
+  while (atomic_load(&ptyTmp->isRunning)) {
+    // Waking up now and then to see a close
+    if (poll(&ptyPoll, 1U, TTYS_PTY_IDLE_MS) <= 0) continue;
+
+    ssize_t rxLen = read(ptyTmp->masterFd, rxBuf, sizeof(rxBuf));
+    if (rxLen <= 0) {
+      if (rxLen < 0 && errno != EAGAIN && errno != EINTR) {
+        (void)nanosleep(&ptyRetry, NULL);
+      }
+      continue;
+    }
+
+    uint32_t rxDone = 0U;
+    while (rxDone < (uint32_t)rxLen && atomic_load(&ptyTmp->isRunning)) {
+      rxDone += sim_usart_rx_push(ptyTmp->ptyPort, &rxBuf[rxDone],
+                                  (uint32_t)rxLen - rxDone);
+
+      (void)pthread_mutex_lock(&ptyLock);
+      ptyRxSeq++;
+      (void)pthread_cond_signal(&ptyRxCond);
+      (void)pthread_mutex_unlock(&ptyLock);
+
+      if (rxDone < (uint32_t)rxLen) (void)nanosleep(&ptyRetry, NULL);
+    }
+
+    atomic_fetch_add(&ptyTmp->rxBytes, rxDone);
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief: USART TX hook, writes each byte sent to the pty. Drops it if the
+ *         pty does not take it within TTYS_PTY_TX_WAIT_MS.
+ *
+ * @param[in]: hookCtx. The ttys_pty_t
+ * @param[in]: txData
+ * @return[out]: void
+ **/
+static void ttys_pty_tx(void *hookCtx, uint8_t txData) {
+  ttys_pty_t *ptyTmp = (ttys_pty_t *)hookCtx;
+  struct pollfd ptyPoll = {.fd = ptyTmp->masterFd, .events = POLLOUT};
+
+  for (;;) {
+    ssize_t txLen = write(ptyTmp->masterFd, &txData, 1U);
+
+    if (txLen == 1) {
+      ptyTmp->txBytes++;
+      return;
+    }
+    if (txLen < 0 && errno == EINTR) continue;
+    if (txLen < 0 && errno == EAGAIN &&
+        poll(&ptyPoll, 1U, TTYS_PTY_TX_WAIT_MS) > 0) {
+      continue;
+    }
+
+    ptyTmp->txDrops++;
+    return;
+  }
+}
+
+/**
+ * @brief: __WFI() idle hook, nothing is scheduled. Waits for pty input, at
+ *         most TTYS_PTY_IDLE_MS, instead of skipping virtual time.
+ *
+ * @return[out]: void
+ **/
+static void ttys_pty_idle(void) {
+  struct timespec ptyDeadline;
+
+  ttys_pty_deadline(&ptyDeadline, TTYS_PTY_IDLE_MS);
+
+  (void)pthread_mutex_lock(&ptyLock);
+  while (ptyRxSeq == ptyIdleSeq) {
+    if (pthread_cond_timedwait(&ptyRxCond, &ptyLock, &ptyDeadline) ==
+        ETIMEDOUT) {
+      break;
+    }
+  }
+  ptyIdleSeq = ptyRxSeq;
+  (void)pthread_mutex_unlock(&ptyLock);
+}
+
+/**
+ * @brief: Monotonic time ptyMs from now.
+ *
+ * @param[out]: ptyDeadline
+ * @param[in]: ptyMs
+ * @return[out]: void
+ **/
+static void ttys_pty_deadline(struct timespec *ptyDeadline, uint32_t ptyMs) {
+  (void)clock_gettime(CLOCK_MONOTONIC, ptyDeadline);
+
+  ptyDeadline->tv_nsec += (long)ptyMs * 1000000L;
+  while (ptyDeadline->tv_nsec >= 1000000000L) {
+    ptyDeadline->tv_nsec -= 1000000000L;
+    ptyDeadline->tv_sec++;
+  }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file ttys_pty.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Linux pseudo-terminal backend for ttys on the host build. Each
+ * attached ttys instance gets a pty: a reader thread queues what arrives on
+ * it as the peer's bytes on the simulated USART, so they reach the ttys ring
+ * through USARTx_IRQHandler exactly as on the part, and every byte the USART
+ * sends is written to the pty. screen, socat or a test harness can then talk
+ * to the unchanged ttys code.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef TTYS_PTY_H
+#define TTYS_PTY_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Module includes */
+#include <ttys.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Longest wait of __WFI() for pty input when nothing else is scheduled
+#define TTYS_PTY_IDLE_MS 10U
+
+// Longest wait for the pty to take a TX byte before it is dropped, so an
+// unread terminal cannot stall the firmware
+#define TTYS_PTY_TX_WAIT_MS 100U
+
+// Bytes moved per read() of the reader thread
+#define TTYS_PTY_READ_SIZE 256U
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Error Codes */
+typedef enum {
+
+  TTYS_PTY_ERR_IDX = 0x64U,
+  TTYS_PTY_ERR_OPEN,
+  TTYS_PTY_ERR_THREAD,
+  TTYS_PTY_ERR_NOT_OPEN,
+
+} ttys_pty_errors_t;
+
+/* Pty statistics */
+typedef struct {
+  uint32_t rxBytes;  // Bytes read from the pty and queued to the USART
+  uint32_t txBytes;  // Bytes the USART sent, written to the pty
+  uint32_t txDrops;  // Bytes the pty did not take within TTYS_PTY_TX_WAIT_MS
+
+} ttys_pty_stats_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+//
+// The instance is set up with ttys_def_init()/ttys_init()/ttys_start() as
+// usual, the baud rate only sets the virtual frame time. The idle loop must
+// sleep in __WFI() (tmr_sleep_until() does): the virtual clock, and so the
+// serial line, only moves while the firmware waits or polls a register.
+//
+uint32_t ttys_pty_open(uint32_t ttysInstIdx, char *slaveName,
+                       size_t slaveNameLen);
+uint32_t ttys_pty_close(uint32_t ttysInstIdx);
+uint32_t ttys_pty_get_stats(uint32_t ttysInstIdx, ttys_pty_stats_t *ptyStats);
+
+#endif  // ttys_pty.h
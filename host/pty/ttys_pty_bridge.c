@@ -0,0 +1,65 @@
+/**
+ * @file ttys_pty_bridge.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief The shell on the host build, served on a pty through ttys instance
+ * 2. Prints the slave device to attach to, e.g. screen /dev/pts/3.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Module includes */
+#include <shell.h>
+#include <ttys_pty.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t bridgeTtysConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  char slaveName[64];
+
+  if (ttys_def_init(TTYS_INSTANCE_2) != EXIT_SUCCESS ||
+      ttys_init(TTYS_INSTANCE_2, &bridgeTtysConfig) != EXIT_SUCCESS ||
+      ttys_start(TTYS_INSTANCE_2) != EXIT_SUCCESS) {
+    fprintf(stderr, "ttys_pty_bridge: ttys setup failed\n");
+    return EXIT_FAILURE;
+  }
+
+  if (ttys_pty_open(TTYS_INSTANCE_2, slaveName, sizeof(slaveName)) !=
+      EXIT_SUCCESS) {
+    fprintf(stderr, "ttys_pty_bridge: no pty\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("ttys instance 2 on %s\n", slaveName);
+  (void)fflush(stdout);
+
+  (void)shell_init(TTYS_INSTANCE_2, NULL, 0U);
+
+  for (;;) {
+    (void)shell_poll();
+    __WFI();
+  }
+}
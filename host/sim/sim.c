@@ -0,0 +1,1568 @@
+/**
+ * @file sim.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host simulation of the STM32F401 peripherals used by the modules.
+ * The register blocks are anonymous mappings at the real peripheral and
+ * system control addresses, so (uint32_t) register and buffer addresses stay
+ * valid on a non-PIE host build. Time only moves in sim_advance(), __WFI()
+ * and thread-mode polls, one scheduled event (a counter wrap, a serial frame)
+ * at a time; after every step and every LL write the interrupt lines are
+ * re-evaluated and the highest priority enabled one is taken by calling its
+ * handler, nesting on priority like the NVIC.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx_ll_bus.h>
+#include <stm32f4xx_ll_dma.h>
+#include <stm32f4xx_ll_gpio.h>
+#include <stm32f4xx_ll_tim.h>
+#include <stm32f4xx_ll_usart.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Mapped address windows, peripherals (APB1 to AHB1) and the private bus
+#define SIM_PERIPH_SIZE 0x00030000UL
+#define SIM_PPB_BASE 0xE0000000UL
+#define SIM_PPB_SIZE 0x00100000UL
+
+#define SIM_NUM_IRQS 96U
+#define SIM_MAX_NEST 16U
+#define SIM_NUM_PORTS 8U
+#define SIM_PORT_MASK 0x9FU  // A to E and H
+#define SIM_NO_EVENT UINT64_MAX
+
+// Dispatches of one IRQ at the same instant before it is called a storm
+#define SIM_STORM_LIMIT 100000U
+
+// Software flow control characters the peer honours
+#define SIM_XON 0x11U
+#define SIM_XOFF 0x13U
+
+// Register access counts are kept for the GPIO ports and RCC, one word each
+#define SIM_COUNT_BASE GPIOA_BASE
+#define SIM_COUNT_END (RCC_BASE + 0x400UL)
+#define SIM_COUNT_WORDS ((SIM_COUNT_END - SIM_COUNT_BASE) / 4U)
+
+#define SIM_STACKED_XPSR 0x01000000UL
+#define SIM_EXC_RETURN 0xFFFFFFF9UL
+#define SIM_RESET_PC 0x08000000UL
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  uint32_t driveMask;   // Pins driven from outside
+  uint32_t driveLevel;
+  uint32_t lastIdr;     // For EXTI edges
+  uint32_t gatedWrites;
+  bool isGated;         // AHB1 clock off, registers frozen
+  GPIO_TypeDef gatedRegs;
+
+} sim_gpio_t;
+
+typedef struct {
+  TIM_TypeDef *const timReg;
+  const IRQn_Type timIrq;
+  __IO uint32_t *const enReg;
+  const uint32_t enBit;
+  const uint32_t cntMask;
+  TIM_TypeDef *const itrMaster[4];  // Trigger sources ITR0 to ITR3
+  uint32_t pscShadow;
+  uint32_t pscCnt;
+  uint32_t lastCr1;
+
+} sim_tim_t;
+
+typedef struct {
+  USART_TypeDef *const usartReg;
+  const IRQn_Type usartIrq;
+  __IO uint32_t *const enReg;
+  const uint32_t enBit;
+  const uint32_t pclkDiv;  // Core cycles per kernel clock
+
+  /* Transmitter, TDR and the shift register */
+  uint8_t txData;
+  bool isTdrFull;
+  uint8_t txShift;
+  bool isTxBusy;
+  uint64_t txDoneAt;
+
+  /* Receiver, fed from the peer's wire queue */
+  uint8_t rxShift;
+  bool isRxBusy;
+  uint64_t rxDoneAt;
+  uint8_t wire[SIM_WIRE_SIZE];
+  atomic_uint wireHead;
+  atomic_uint wireTail;
+
+  /* Peer */
+  bool isCtsAsserted;
+  bool isPeerXonXoff;
+  bool isPeerPaused;
+  bool isRxHeld;
+
+  sim_tx_hook_t txHook;
+  void *hookCtx;
+  sim_usart_stats_t usartStats;
+
+} sim_usart_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static void sim_map(void);
+static void sim_update(void);
+static void sim_step_to(uint64_t simTime);
+static uint64_t sim_next_event(void);
+static void sim_irq_check(void);
+static int32_t sim_irq_next(bool isMaskable);
+static bool sim_irq_line(uint32_t irqN);
+static void sim_irq_take(uint32_t irqN);
+static void (*sim_irq_vector(uint32_t irqN))(void);
+
+static void sim_gpio_update(uint32_t portIdx);
+static uint32_t sim_gpio_levels(GPIO_TypeDef *simPort, const sim_gpio_t *simGpio);
+
+static sim_tim_t *sim_tim_find(TIM_TypeDef *simTim);
+static bool sim_tim_is_internal(const sim_tim_t *simTim);
+static uint64_t sim_tim_next(const sim_tim_t *simTim);
+static void sim_tim_advance(sim_tim_t *simTim, uint64_t simCycles);
+static void sim_tim_count(sim_tim_t *simTim, uint64_t numTicks);
+static void sim_tim_uev(sim_tim_t *simTim, bool isOverflow);
+static void sim_tim_ug(sim_tim_t *simTim);
+static void sim_tim_cen(sim_tim_t *simTim);
+static void sim_tim_trgo(const sim_tim_t *simTim);
+static void sim_dma_request(void);
+
+static sim_usart_t *sim_usart_find(USART_TypeDef *simUsart);
+static uint64_t sim_usart_frame(const sim_usart_t *simUsart);
+static bool sim_usart_is_on(const sim_usart_t *simUsart);
+static void sim_usart_kick(sim_usart_t *simUsart);
+static void sim_usart_events(sim_usart_t *simUsart);
+static void sim_usart_rx_byte(sim_usart_t *simUsart, uint8_t rxData);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+/* IRQ handlers, weak so a test only links the modules it uses */
+extern void EXTI0_IRQHandler(void) __attribute__((weak));
+extern void EXTI1_IRQHandler(void) __attribute__((weak));
+extern void EXTI2_IRQHandler(void) __attribute__((weak));
+extern void EXTI3_IRQHandler(void) __attribute__((weak));
+extern void EXTI4_IRQHandler(void) __attribute__((weak));
+extern void EXTI9_5_IRQHandler(void) __attribute__((weak));
+extern void EXTI15_10_IRQHandler(void) __attribute__((weak));
+extern void TIM1_UP_TIM10_IRQHandler(void) __attribute__((weak));
+extern void TIM2_IRQHandler(void) __attribute__((weak));
+extern void TIM3_IRQHandler(void) __attribute__((weak));
+extern void TIM4_IRQHandler(void) __attribute__((weak));
+extern void USART1_IRQHandler(void) __attribute__((weak));
+extern void USART2_IRQHandler(void) __attribute__((weak));
+extern void USART6_IRQHandler(void) __attribute__((weak));
+extern void DMA2_Stream5_IRQHandler(void) __attribute__((weak));
+
+uint32_t SystemCoreClock = SIM_CORE_CLOCK;
+
+static uint64_t simNow;
+static uint32_t simPrimask;
+static uint32_t simPc = SIM_RESET_PC;
+static uint32_t simDepth;
+static uint32_t simAdvancing;
+static uint32_t simActive[SIM_MAX_NEST];
+static uint32_t simFrames[SIM_MAX_NEST][8];
+static uint32_t simThreadStack[8];
+static uint32_t simIrqCounts[SIM_NUM_IRQS];
+static uint32_t simStormIrq;
+static uint32_t simStormCount;
+static uint64_t simStormTime;
+static sim_idle_hook_t simIdleHook;
+static sim_reset_hook_t simResetHook;
+
+static sim_gpio_t simGpio[SIM_NUM_PORTS];
+static uint32_t simRegReads[SIM_COUNT_WORDS];
+static uint32_t simRegWrites[SIM_COUNT_WORDS];
+
+// TIM1 on APB2, TIM2 to TIM4 on APB1, their ITR maps from RM0368
+static sim_tim_t simTims[] = {
+    {.timReg = TIM1, .timIrq = TIM1_UP_TIM10_IRQn, .enReg = &RCC->APB2ENR,
+     .enBit = RCC_APB2ENR_TIM1EN, .cntMask = 0xFFFFU,
+     .itrMaster = {TIM5, TIM2, TIM3, TIM4}},
+    {.timReg = TIM2, .timIrq = TIM2_IRQn, .enReg = &RCC->APB1ENR,
+     .enBit = RCC_APB1ENR_TIM2EN, .cntMask = 0xFFFFFFFFU,
+     .itrMaster = {TIM1, NULL, TIM3, TIM4}},
+    {.timReg = TIM3, .timIrq = TIM3_IRQn, .enReg = &RCC->APB1ENR,
+     .enBit = RCC_APB1ENR_TIM3EN, .cntMask = 0xFFFFU,
+     .itrMaster = {TIM1, TIM2, TIM5, TIM4}},
+    {.timReg = TIM4, .timIrq = TIM4_IRQn, .enReg = &RCC->APB1ENR,
+     .enBit = RCC_APB1ENR_TIM4EN, .cntMask = 0xFFFFU,
+     .itrMaster = {TIM1, TIM2, TIM3, NULL}},
+};
+
+#define SIM_NUM_TIMS (sizeof(simTims) / sizeof(simTims[0]))
+
+static uint32_t simDmaLen;
+static uint32_t simDmaLastCr;
+
+static sim_usart_t simUsarts[] = {
+    {.usartReg = USART1, .usartIrq = USART1_IRQn, .enReg = &RCC->APB2ENR,
+     .enBit = RCC_APB2ENR_USART1EN, .pclkDiv = 1U, .isCtsAsserted = true},
+    {.usartReg = USART2, .usartIrq = USART2_IRQn, .enReg = &RCC->APB1ENR,
+     .enBit = RCC_APB1ENR_USART2EN, .pclkDiv = SIM_APB1_DIV,
+     .isCtsAsserted = true},
+    {.usartReg = USART6, .usartIrq = USART6_IRQn, .enReg = &RCC->APB2ENR,
+     .enBit = RCC_APB2ENR_USART6EN, .pclkDiv = 1U, .isCtsAsserted = true},
+};
+
+#define SIM_NUM_USARTS (sizeof(simUsarts) / sizeof(simUsarts[0]))
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Returns the virtual time, in core cycles since start-up.
+ *
+ * @return[out]: uint64_t
+ **/
+uint64_t sim_now(void) { return simNow; }
+
+/**
+ * @brief: Moves the virtual clock on, one scheduled event at a time, taking
+ *         the interrupts each event raises.
+ *
+ * @param[in]: simCycles
+ * @return[out]: void
+ **/
+void sim_advance(uint64_t simCycles) {
+  uint64_t simTarget = simNow + simCycles;
+
+  simAdvancing++;
+  sim_sync();
+
+  do {
+    uint64_t simNext = sim_next_event();
+    sim_step_to((simNext < simTarget) ? simNext : simTarget);
+    sim_irq_check();
+  } while (simNow < simTarget);
+
+  simAdvancing--;
+}
+
+/**
+ * @brief: Sets the PC stacked in the exception frame of the following
+ *         interrupts, as if the CPU had been interrupted there.
+ *
+ * @param[in]: simPcNew
+ * @return[out]: void
+ **/
+void sim_set_pc(uint32_t simPcNew) { simPc = simPcNew; }
+
+/**
+ * @brief: Returns how many times an IRQ handler has been called.
+ *
+ * @param[in]: irqN
+ * @return[out]: uint32_t
+ **/
+uint32_t sim_irq_count(IRQn_Type irqN) {
+  if (irqN < 0 || (uint32_t)irqN >= SIM_NUM_IRQS) return 0U;
+
+  return simIrqCounts[irqN];
+}
+
+/**
+ * @brief: Sets the hook __WFI() calls when nothing is scheduled, so a host
+ *         backend can wait for input instead of skipping virtual time.
+ *
+ * @param[in]: idleHook
+ * @return[out]: void
+ **/
+void sim_set_idle_hook(sim_idle_hook_t idleHook) { simIdleHook = idleHook; }
+
+/**
+ * @brief: Sets the hook NVIC_SystemReset() calls.
+ *
+ * @param[in]: resetHook
+ * @return[out]: void
+ **/
+void sim_set_reset_hook(sim_reset_hook_t resetHook) {
+  simResetHook = resetHook;
+}
+
+/**
+ * @brief: Counts an access made by the register macros of stm32f4xx.h. A
+ *         read-modify-write counts as one read and one write.
+ *
+ * @param[in]: simReg
+ * @param[in]: accessType. SIM_REG_READ and/or SIM_REG_WRITE
+ * @return[out]: void
+ **/
+void sim_reg_access(const volatile void *simReg, uint32_t accessType) {
+  uintptr_t regAddr = (uintptr_t)simReg;
+
+  if (regAddr < SIM_COUNT_BASE || regAddr >= SIM_COUNT_END) return;
+
+  uint32_t regIdx = (uint32_t)(regAddr - SIM_COUNT_BASE) / 4U;
+  if (accessType & SIM_REG_READ) simRegReads[regIdx]++;
+  if (accessType & SIM_REG_WRITE) simRegWrites[regIdx]++;
+}
+
+/**
+ * @brief: Returns the number of reads of a GPIO or RCC register made
+ *         through the register macros since sim_reg_clear_counts().
+ *
+ * @param[in]: simReg
+ * @return[out]: uint32_t
+ **/
+uint32_t sim_reg_reads(const volatile void *simReg) {
+  uintptr_t regAddr = (uintptr_t)simReg;
+
+  if (regAddr < SIM_COUNT_BASE || regAddr >= SIM_COUNT_END) return 0U;
+
+  return simRegReads[(regAddr - SIM_COUNT_BASE) / 4U];
+}
+
+/**
+ * @brief: Returns the number of writes to a GPIO or RCC register made
+ *         through the register macros since sim_reg_clear_counts().
+ *
+ * @param[in]: simReg
+ * @return[out]: uint32_t
+ **/
+uint32_t sim_reg_writes(const volatile void *simReg) {
+  uintptr_t regAddr = (uintptr_t)simReg;
+
+  if (regAddr < SIM_COUNT_BASE || regAddr >= SIM_COUNT_END) return 0U;
+
+  return simRegWrites[(regAddr - SIM_COUNT_BASE) / 4U];
+}
+
+/**
+ * @brief: Clears the register access counts.
+ *
+ * @return[out]: void
+ **/
+void sim_reg_clear_counts(void) {
+  (void)memset(simRegReads, 0, sizeof(simRegReads));
+  (void)memset(simRegWrites, 0, sizeof(simRegWrites));
+}
+
+/**
+ * @brief: Drives pins of a port from outside, as a push-pull source would.
+ *
+ * @param[in]: simPort
+ * @param[in]: pinMask
+ * @param[in]: isHigh
+ * @return[out]: void
+ **/
+void sim_gpio_drive(GPIO_TypeDef *simPort, uint32_t pinMask, bool isHigh) {
+  sim_gpio_t *simGpioTmp =
+      &simGpio[((uintptr_t)simPort - GPIOA_BASE) / 0x400U];
+
+  simGpioTmp->driveMask |= pinMask;
+  simGpioTmp->driveLevel =
+      isHigh ? (simGpioTmp->driveLevel | pinMask)
+             : (simGpioTmp->driveLevel & ~pinMask);
+  sim_sync();
+}
+
+/**
+ * @brief: Stops driving pins, they follow their pulls again.
+ *
+ * @param[in]: simPort
+ * @param[in]: pinMask
+ * @return[out]: void
+ **/
+void sim_gpio_release(GPIO_TypeDef *simPort, uint32_t pinMask) {
+  simGpio[((uintptr_t)simPort - GPIOA_BASE) / 0x400U].driveMask &= ~pinMask;
+  sim_sync();
+}
+
+/**
+ * @brief: Returns the number of register writes made to a port while its
+ *         clock was gated. Those writes are lost on the part, and undone
+ *         here.
+ *
+ * @param[in]: simPort
+ * @return[out]: uint32_t
+ **/
+uint32_t sim_gpio_gated_writes(GPIO_TypeDef *simPort) {
+  sim_sync();
+
+  return simGpio[((uintptr_t)simPort - GPIOA_BASE) / 0x400U].gatedWrites;
+}
+
+/**
+ * @brief: Steps a timer in encoder mode, positive steps count up. The
+ *         polarity of TI1 against TI2 sets the direction, as on the part.
+ *
+ * @param[in]: simTim
+ * @param[in]: encSteps
+ * @return[out]: void
+ **/
+void sim_tim_encoder(TIM_TypeDef *simTim, int32_t encSteps) {
+  sim_tim_t *simTimTmp = sim_tim_find(simTim);
+  uint32_t timSms = simTim->SMCR & TIM_SMCR_SMS;
+
+  if (simTimTmp == NULL || timSms == 0U || timSms > 3U) return;
+  if ((simTim->CR1 & TIM_CR1_CEN) == 0U) return;
+
+  if (((simTim->CCER >> 1U) ^ (simTim->CCER >> 5U)) & 1U) encSteps = -encSteps;
+
+  if (encSteps >= 0) {
+    simTim->CR1 &= ~TIM_CR1_DIR;
+    sim_tim_count(simTimTmp, (uint64_t)encSteps);
+  } else {
+    simTim->CR1 |= TIM_CR1_DIR;
+    sim_tim_count(simTimTmp, (uint64_t)(-(int64_t)encSteps));
+  }
+
+  sim_sync();
+}
+
+/**
+ * @brief: Sets the function given each byte a USART finishes sending.
+ *
+ * @param[in]: simUsart
+ * @param[in]: txHook
+ * @param[in]: hookCtx
+ * @return[out]: void
+ **/
+void sim_usart_set_tx_hook(USART_TypeDef *simUsart, sim_tx_hook_t txHook,
+                           void *hookCtx) {
+  sim_usart_t *simUsartTmp = sim_usart_find(simUsart);
+
+  simUsartTmp->txHook = txHook;
+  simUsartTmp->hookCtx = hookCtx;
+}
+
+/**
+ * @brief: Queues bytes for the peer to send to a USART. The peer sends them
+ *         back to back at the USART's baud rate once the receiver is enabled,
+ *         holding off while RTS is deasserted (RTSE set and DR unread) or
+ *         after an XOFF if it honours XON/XOFF. Single producer, it may run
+ *         on a host thread of its own.
+ *
+ * @param[in]: simUsart
+ * @param[in]: rxData
+ * @param[in]: rxLen
+ * @return[out]: uint32_t. Bytes queued
+ **/
+uint32_t sim_usart_rx_push(USART_TypeDef *simUsart, const uint8_t *rxData,
+                           uint32_t rxLen) {
+  sim_usart_t *simUsartTmp = sim_usart_find(simUsart);
+  uint32_t wireTail =
+      atomic_load_explicit(&simUsartTmp->wireTail, memory_order_relaxed);
+  uint32_t wireHead =
+      atomic_load_explicit(&simUsartTmp->wireHead, memory_order_acquire);
+  uint32_t wireFree = SIM_WIRE_SIZE - (wireTail - wireHead);
+
+  if (rxLen > wireFree) rxLen = wireFree;
+
+  for (uint32_t rxIdx = 0U; rxIdx < rxLen; rxIdx++) {
+    simUsartTmp->wire[(wireTail + rxIdx) % SIM_WIRE_SIZE] = rxData[rxIdx];
+  }
+
+  atomic_store_explicit(&simUsartTmp->wireTail, wireTail + rxLen,
+                        memory_order_release);
+
+  return rxLen;
+}
+
+/**
+ * @brief: Returns the bytes the peer has yet to start sending.
+ *
+ * @param[in]: simUsart
+ * @return[out]: uint32_t
+ **/
+uint32_t sim_usart_rx_queued(USART_TypeDef *simUsart) {
+  sim_usart_t *simUsartTmp = sim_usart_find(simUsart);
+
+  return atomic_load(&simUsartTmp->wireTail) -
+         atomic_load(&simUsartTmp->wireHead);
+}
+
+/**
+ * @brief: Sets the peer's RTS, the USART's CTS input. With CTSE set a
+ *         deasserted CTS holds the next frame back.
+ *
+ * @param[in]: simUsart
+ * @param[in]: isAsserted
+ * @return[out]: void
+ **/
+void sim_usart_set_cts(USART_TypeDef *simUsart, bool isAsserted) {
+  sim_usart_t *simUsartTmp = sim_usart_find(simUsart);
+
+  if (simUsartTmp->isCtsAsserted != isAsserted) simUsart->SR |= USART_SR_CTS;
+  simUsartTmp->isCtsAsserted = isAsserted;
+  sim_sync();
+}
+
+/**
+ * @brief: Sets whether the peer stops sending on XOFF and resumes on XON.
+ *
+ * @param[in]: simUsart
+ * @param[in]: isHonoured
+ * @return[out]: void
+ **/
+void sim_usart_set_peer_xonxoff(USART_TypeDef *simUsart, bool isHonoured) {
+  sim_usart_t *simUsartTmp = sim_usart_find(simUsart);
+
+  simUsartTmp->isPeerXonXoff = isHonoured;
+  if (!isHonoured) simUsartTmp->isPeerPaused = false;
+  sim_sync();
+}
+
+/**
+ * @brief: Copies the line statistics of a USART.
+ *
+ * @param[in]: simUsart
+ * @param[out]: simStats
+ * @return[out]: void
+ **/
+void sim_usart_get_stats(USART_TypeDef *simUsart, sim_usart_stats_t *simStats) {
+  *simStats = sim_usart_find(simUsart)->usartStats;
+}
+
+/**
+ * @brief: Applies the side effects of register writes made at the current
+ *         time and takes any interrupt they raise.
+ *
+ * @return[out]: void
+ **/
+void sim_sync(void) {
+  sim_update();
+  sim_irq_check();
+}
+
+/**
+ * @brief: Charges a thread-mode register poll a few cycles, so busy-wait
+ *         loops on a flag or a counter see time pass.
+ *
+ * @return[out]: void
+ **/
+void sim_poll(void) {
+  if (simDepth != 0U || simAdvancing != 0U) return;
+
+  sim_advance(SIM_POLL_CYCLES);
+}
+
+/**
+ * @brief: Reads DR, clearing RXNE and the error flags like the SR then DR
+ *         read sequence does.
+ *
+ * @param[in]: simUsart
+ * @return[out]: uint8_t
+ **/
+uint8_t sim_usart_read_dr(USART_TypeDef *simUsart) {
+  uint8_t rxData = (uint8_t)simUsart->DR;
+
+  simUsart->SR &= ~(USART_SR_RXNE | USART_SR_ORE | USART_SR_FE | USART_SR_NE |
+                    USART_SR_PE);
+  sim_sync();
+
+  return rxData;
+}
+
+/**
+ * @brief: Writes DR, loading TDR. The byte moves to the shift register as
+ *         soon as it is free, setting TXE again.
+ *
+ * @param[in]: simUsart
+ * @param[in]: txData
+ * @return[out]: void
+ **/
+void sim_usart_write_dr(USART_TypeDef *simUsart, uint8_t txData) {
+  sim_usart_t *simUsartTmp = sim_usart_find(simUsart);
+
+  simUsartTmp->txData = txData;
+  simUsartTmp->isTdrFull = true;
+  simUsart->SR &= ~(USART_SR_TXE | USART_SR_TC);
+  sim_sync();
+}
+
+/* Core */
+
+void __disable_irq(void) { simPrimask = 1U; }
+
+void __enable_irq(void) {
+  simPrimask = 0U;
+  sim_irq_check();
+}
+
+uint32_t __get_PRIMASK(void) { return simPrimask; }
+
+void __set_PRIMASK(uint32_t priMask) {
+  simPrimask = priMask & 1U;
+  sim_irq_check();
+}
+
+uint32_t __get_MSP(void) {
+  if (simDepth == 0U) return (uint32_t)(uintptr_t)simThreadStack;
+
+  return (uint32_t)(uintptr_t)simFrames[simDepth - 1U];
+}
+
+uint32_t __get_PSP(void) { return 0U; }
+
+uint32_t __get_IPSR(void) {
+  return (simDepth == 0U) ? 0U : (simActive[simDepth - 1U] + 16U);
+}
+
+/**
+ * @brief: Sleeps until an interrupt that could preempt is pending, moving
+ *         the virtual clock to the events on the way. With nothing scheduled
+ *         it calls the idle hook, or sleeps SIM_IDLE_CYCLES, and returns.
+ *         PRIMASK does not stop the wake-up, as on the part.
+ *
+ * @return[out]: void
+ **/
+void __WFI(void) {
+  simAdvancing++;
+  sim_update();
+
+  while (sim_irq_next(false) < 0) {
+    uint64_t simNext = sim_next_event();
+
+    if (simNext == SIM_NO_EVENT) {
+      if (simIdleHook != NULL) {
+        simIdleHook();
+        sim_update();
+      } else {
+        sim_step_to(simNow + SIM_IDLE_CYCLES);
+      }
+      break;
+    }
+
+    sim_step_to(simNext);
+  }
+
+  simAdvancing--;
+  sim_irq_check();
+}
+
+void NVIC_EnableIRQ(IRQn_Type irqN) {
+  if (irqN < 0) return;
+
+  NVIC->ISER[(uint32_t)irqN >> 5U] |= 1UL << ((uint32_t)irqN & 31U);
+  sim_sync();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irqN) {
+  if (irqN < 0) return;
+
+  NVIC->ISER[(uint32_t)irqN >> 5U] &= ~(1UL << ((uint32_t)irqN & 31U));
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irqN) {
+  if (irqN < 0) return;
+
+  NVIC->ISPR[(uint32_t)irqN >> 5U] |= 1UL << ((uint32_t)irqN & 31U);
+  sim_sync();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irqN) {
+  if (irqN < 0) return;
+
+  NVIC->ISPR[(uint32_t)irqN >> 5U] &= ~(1UL << ((uint32_t)irqN & 31U));
+}
+
+void NVIC_SetPriority(IRQn_Type irqN, uint32_t irqPrio) {
+  uint8_t irqIp = (uint8_t)((irqPrio << (8U - __NVIC_PRIO_BITS)) & 0xFFUL);
+
+  if (irqN >= 0) {
+    NVIC->IP[irqN] = irqIp;
+  } else {
+    SCB->SHP[((uint32_t)irqN & 0xFUL) - 4UL] = irqIp;
+  }
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type irqN) {
+  if (irqN >= 0) return (uint32_t)NVIC->IP[irqN] >> (8U - __NVIC_PRIO_BITS);
+
+  return (uint32_t)SCB->SHP[((uint32_t)irqN & 0xFUL) - 4UL] >>
+         (8U - __NVIC_PRIO_BITS);
+}
+
+void NVIC_SystemReset(void) {
+  if (simResetHook != NULL) simResetHook();
+
+  fprintf(stderr, "sim: NVIC_SystemReset() at cycle %llu\n",
+          (unsigned long long)simNow);
+  abort();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Maps the register windows and loads the reset values the modules
+ *         depend on, before any constructor of the program runs.
+ *
+ * @return[out]: void
+ **/
+__attribute__((constructor(101))) static void sim_map(void) {
+  void *periphMap = mmap((void *)PERIPH_BASE, SIM_PERIPH_SIZE,
+                         PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1,
+                         0);
+  void *ppbMap = mmap((void *)SIM_PPB_BASE, SIM_PPB_SIZE,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+  if (periphMap != (void *)PERIPH_BASE || ppbMap != (void *)SIM_PPB_BASE) {
+    fprintf(stderr, "sim: cannot map the register windows (build with -no-pie)\n");
+    abort();
+  }
+
+  /* Debug pins PA13/PA14/PA15/PB3/PB4 in AF with their pulls */
+  GPIOA->MODER = 0xA8000000UL;
+  GPIOA->PUPDR = 0x64000000UL;
+  GPIOA->OSPEEDR = 0x0C000000UL;
+  GPIOB->MODER = 0x00000280UL;
+  GPIOB->PUPDR = 0x00000100UL;
+  GPIOB->OSPEEDR = 0x000000C0UL;
+
+  for (uint32_t usartIdx = 0U; usartIdx < SIM_NUM_USARTS; usartIdx++) {
+    simUsarts[usartIdx].usartReg->SR = USART_SR_TXE | USART_SR_TC;
+  }
+
+  for (uint32_t timIdx = 0U; timIdx < SIM_NUM_TIMS; timIdx++) {
+    simTims[timIdx].timReg->ARR = simTims[timIdx].cntMask;
+  }
+
+  *(__IO uint32_t *)&SCB->CPUID = 0x410FC241UL;
+  DWT->CTRL = 0x40000000UL;
+}
+
+/**
+ * @brief: Brings every model up to date with the registers at the current
+ *         time: GPIO levels and gating, EXTI, timer events and the serial
+ *         lines.
+ *
+ * @return[out]: void
+ **/
+static void sim_update(void) {
+  for (uint32_t portIdx = 0U; portIdx < SIM_NUM_PORTS; portIdx++) {
+    if ((SIM_PORT_MASK >> portIdx) & 1U) sim_gpio_update(portIdx);
+  }
+
+  // Software triggers go straight to pending
+  if (EXTI->SWIER != 0U) {
+    EXTI->PR |= EXTI->SWIER;
+    EXTI->SWIER = 0U;
+  }
+
+  for (uint32_t timIdx = 0U; timIdx < SIM_NUM_TIMS; timIdx++) {
+    sim_tim_t *simTimTmp = &simTims[timIdx];
+
+    if (simTimTmp->timReg->EGR & TIM_EGR_UG) {
+      simTimTmp->timReg->EGR = 0U;
+      sim_tim_ug(simTimTmp);
+    }
+
+    sim_tim_cen(simTimTmp);
+  }
+
+  // NDTR is latched when the stream is enabled
+  if ((DMA2_Stream5->CR & DMA_SxCR_EN) && !(simDmaLastCr & DMA_SxCR_EN)) {
+    simDmaLen = DMA2_Stream5->NDTR;
+  }
+  simDmaLastCr = DMA2_Stream5->CR;
+
+  for (uint32_t usartIdx = 0U; usartIdx < SIM_NUM_USARTS; usartIdx++) {
+    sim_usart_kick(&simUsarts[usartIdx]);
+  }
+}
+
+/**
+ * @brief: Moves the clock to simTime, which is at most the next event, and
+ *         handles the events due then.
+ *
+ * @param[in]: simTime
+ * @return[out]: void
+ **/
+static void sim_step_to(uint64_t simTime) {
+  uint64_t simCycles = simTime - simNow;
+
+  for (uint32_t timIdx = 0U; timIdx < SIM_NUM_TIMS; timIdx++) {
+    sim_tim_advance(&simTims[timIdx], simCycles);
+  }
+
+  if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) &&
+      (CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk)) {
+    DWT->CYCCNT += (uint32_t)simCycles;
+  }
+
+  simNow = simTime;
+
+  for (uint32_t usartIdx = 0U; usartIdx < SIM_NUM_USARTS; usartIdx++) {
+    sim_usart_events(&simUsarts[usartIdx]);
+  }
+
+  sim_update();
+}
+
+/**
+ * @brief: Returns the time of the next scheduled event, SIM_NO_EVENT if
+ *         there is none.
+ *
+ * @return[out]: uint64_t
+ **/
+static uint64_t sim_next_event(void) {
+  uint64_t simNext = SIM_NO_EVENT;
+
+  for (uint32_t timIdx = 0U; timIdx < SIM_NUM_TIMS; timIdx++) {
+    uint64_t timNext = sim_tim_next(&simTims[timIdx]);
+    if (timNext < simNext) simNext = timNext;
+  }
+
+  for (uint32_t usartIdx = 0U; usartIdx < SIM_NUM_USARTS; usartIdx++) {
+    const sim_usart_t *simUsartTmp = &simUsarts[usartIdx];
+
+    if (simUsartTmp->isTxBusy && simUsartTmp->txDoneAt < simNext) {
+      simNext = simUsartTmp->txDoneAt;
+    }
+    if (simUsartTmp->isRxBusy && simUsartTmp->rxDoneAt < simNext) {
+      simNext = simUsartTmp->rxDoneAt;
+    }
+  }
+
+  return simNext;
+}
+
+/**
+ * @brief: Takes pending interrupts while one can preempt the running code,
+ *         tail-chaining until none is left.
+ *
+ * @return[out]: void
+ **/
+static void sim_irq_check(void) {
+  int32_t irqN;
+
+  while ((irqN = sim_irq_next(true)) >= 0) {
+    if ((uint32_t)irqN == simStormIrq && simNow == simStormTime) {
+      if (++simStormCount > SIM_STORM_LIMIT) {
+        fprintf(stderr, "sim: IRQ %ld never clears its source\n", (long)irqN);
+        abort();
+      }
+    } else {
+      simStormIrq = (uint32_t)irqN;
+      simStormTime = simNow;
+      simStormCount = 0U;
+    }
+
+    sim_irq_take((uint32_t)irqN);
+  }
+}
+
+/**
+ * @brief: Returns the pending, enabled IRQ with the most urgent priority that
+ *         can preempt the running code, or -1.
+ *
+ * @param[in]: isMaskable. Whether PRIMASK blocks it (it does not block WFI)
+ * @return[out]: int32_t
+ **/
+static int32_t sim_irq_next(bool isMaskable) {
+  uint32_t curPrio = (simDepth == 0U) ? 0x100U : NVIC->IP[simActive[simDepth - 1U]];
+  int32_t irqBest = -1;
+
+  if (isMaskable && simPrimask != 0U) return -1;
+  if (simDepth >= SIM_MAX_NEST) return -1;
+
+  for (uint32_t irqN = 0U; irqN < SIM_NUM_IRQS; irqN++) {
+    uint32_t irqBit = 1UL << (irqN & 31U);
+
+    if ((NVIC->ISER[irqN >> 5U] & irqBit) == 0U) continue;
+    if (NVIC->IABR[irqN >> 5U] & irqBit) continue;
+    if (NVIC->IP[irqN] >= curPrio) continue;
+    if (!(NVIC->ISPR[irqN >> 5U] & irqBit) && !sim_irq_line(irqN)) continue;
+
+    if (irqBest < 0 || NVIC->IP[irqN] < NVIC->IP[irqBest]) {
+      irqBest = (int32_t)irqN;
+    }
+  }
+
+  return irqBest;
+}
+
+/**
+ * @brief: Returns the level of a peripheral interrupt line.
+ *
+ * @param[in]: irqN
+ * @return[out]: bool
+ **/
+static bool sim_irq_line(uint32_t irqN) {
+  uint32_t extiPending = EXTI->PR & EXTI->IMR;
+
+  switch (irqN) {
+    case EXTI0_IRQn:
+    case EXTI1_IRQn:
+    case EXTI2_IRQn:
+    case EXTI3_IRQn:
+    case EXTI4_IRQn:
+      return (extiPending >> (irqN - EXTI0_IRQn)) & 1U;
+
+    case EXTI9_5_IRQn:
+      return (extiPending & 0x03E0U) != 0U;
+
+    case EXTI15_10_IRQn:
+      return (extiPending & 0xFC00U) != 0U;
+
+    case DMA2_Stream5_IRQn: {
+      uint32_t dmaCr = DMA2_Stream5->CR;
+      uint32_t dmaIsr = DMA2->HISR;
+
+      return ((dmaIsr & DMA_HISR_TCIF5) && (dmaCr & DMA_SxCR_TCIE)) ||
+             ((dmaIsr & DMA_HISR_HTIF5) && (dmaCr & DMA_SxCR_HTIE)) ||
+             ((dmaIsr & DMA_HISR_TEIF5) && (dmaCr & DMA_SxCR_TEIE));
+    }
+
+    default:
+      break;
+  }
+
+  for (uint32_t timIdx = 0U; timIdx < SIM_NUM_TIMS; timIdx++) {
+    TIM_TypeDef *timReg = simTims[timIdx].timReg;
+
+    if ((uint32_t)simTims[timIdx].timIrq == irqN) {
+      return (timReg->SR & TIM_SR_UIF) && (timReg->DIER & TIM_DIER_UIE);
+    }
+  }
+
+  for (uint32_t usartIdx = 0U; usartIdx < SIM_NUM_USARTS; usartIdx++) {
+    USART_TypeDef *usartReg = simUsarts[usartIdx].usartReg;
+    uint32_t usartSr = usartReg->SR;
+    uint32_t usartCr1 = usartReg->CR1;
+
+    if ((uint32_t)simUsarts[usartIdx].usartIrq != irqN) continue;
+
+    return ((usartSr & (USART_SR_RXNE | USART_SR_ORE)) &&
+            (usartCr1 & USART_CR1_RXNEIE)) ||
+           ((usartSr & USART_SR_TXE) && (usartCr1 & USART_CR1_TXEIE)) ||
+           ((usartSr & USART_SR_TC) && (usartCr1 & USART_CR1_TCIE)) ||
+           ((usartSr & USART_SR_IDLE) && (usartCr1 & USART_CR1_IDLEIE));
+  }
+
+  return false;
+}
+
+/**
+ * @brief: Enters an IRQ handler: stacks a frame with the simulated PC, marks
+ *         the IRQ active and calls the handler.
+ *
+ * @param[in]: irqN
+ * @return[out]: void
+ **/
+static void sim_irq_take(uint32_t irqN) {
+  void (*irqHandler)(void) = sim_irq_vector(irqN);
+  uint32_t irqBit = 1UL << (irqN & 31U);
+  uint32_t *irqFrame = simFrames[simDepth];
+
+  if (irqHandler == NULL) {
+    fprintf(stderr, "sim: IRQ %lu enabled without a handler\n",
+            (unsigned long)irqN);
+    abort();
+  }
+
+  NVIC->ISPR[irqN >> 5U] &= ~irqBit;
+  NVIC->IABR[irqN >> 5U] |= irqBit;
+
+  memset(irqFrame, 0, 8U * sizeof(uint32_t));
+  irqFrame[5] = SIM_EXC_RETURN;
+  irqFrame[6] = simPc;
+  irqFrame[7] = SIM_STACKED_XPSR | __get_IPSR();
+
+  simActive[simDepth++] = irqN;
+  SCB->ICSR = (SCB->ICSR & ~SCB_ICSR_VECTACTIVE_Msk) | (irqN + 16U);
+  simIrqCounts[irqN]++;
+
+  irqHandler();
+
+  simDepth--;
+  NVIC->IABR[irqN >> 5U] &= ~irqBit;
+  SCB->ICSR = (SCB->ICSR & ~SCB_ICSR_VECTACTIVE_Msk) | __get_IPSR();
+}
+
+/**
+ * @brief: Returns the handler of an IRQ, NULL if none is linked.
+ *
+ * @param[in]: irqN
+ * @return[out]: void (*)(void)
+ **/
+static void (*sim_irq_vector(uint32_t irqN))(void) {
+  switch (irqN) {
+    case EXTI0_IRQn: return EXTI0_IRQHandler;
+    case EXTI1_IRQn: return EXTI1_IRQHandler;
+    case EXTI2_IRQn: return EXTI2_IRQHandler;
+    case EXTI3_IRQn: return EXTI3_IRQHandler;
+    case EXTI4_IRQn: return EXTI4_IRQHandler;
+    case EXTI9_5_IRQn: return EXTI9_5_IRQHandler;
+    case EXTI15_10_IRQn: return EXTI15_10_IRQHandler;
+    case TIM1_UP_TIM10_IRQn: return TIM1_UP_TIM10_IRQHandler;
+    case TIM2_IRQn: return TIM2_IRQHandler;
+    case TIM3_IRQn: return TIM3_IRQHandler;
+    case TIM4_IRQn: return TIM4_IRQHandler;
+    case USART1_IRQn: return USART1_IRQHandler;
+    case USART2_IRQn: return USART2_IRQHandler;
+    case USART6_IRQn: return USART6_IRQHandler;
+    case DMA2_Stream5_IRQn: return DMA2_Stream5_IRQHandler;
+    default: return NULL;
+  }
+}
+
+/* GPIO */
+
+/**
+ * @brief: Updates a port: undoes and counts writes made while it is gated,
+ *         applies BSRR, recomputes IDR and raises the EXTI edges.
+ *
+ * @param[in]: portIdx
+ * @return[out]: void
+ **/
+static void sim_gpio_update(uint32_t portIdx) {
+  GPIO_TypeDef *simPort = (GPIO_TypeDef *)(GPIOA_BASE + portIdx * 0x400U);
+  sim_gpio_t *simGpioTmp = &simGpio[portIdx];
+  bool isClocked = (RCC->AHB1ENR >> portIdx) & 1U;
+
+  // Writes made since the last update happened under the previous gating
+  if (simGpioTmp->isGated) {
+    GPIO_TypeDef *gatedRegs = &simGpioTmp->gatedRegs;
+
+    if (simPort->MODER != gatedRegs->MODER ||
+        simPort->OTYPER != gatedRegs->OTYPER ||
+        simPort->OSPEEDR != gatedRegs->OSPEEDR ||
+        simPort->PUPDR != gatedRegs->PUPDR || simPort->ODR != gatedRegs->ODR ||
+        simPort->BSRR != 0U || simPort->AFR[0] != gatedRegs->AFR[0] ||
+        simPort->AFR[1] != gatedRegs->AFR[1]) {
+      simGpioTmp->gatedWrites++;
+      simPort->MODER = gatedRegs->MODER;
+      simPort->OTYPER = gatedRegs->OTYPER;
+      simPort->OSPEEDR = gatedRegs->OSPEEDR;
+      simPort->PUPDR = gatedRegs->PUPDR;
+      simPort->ODR = gatedRegs->ODR;
+      simPort->BSRR = 0U;
+      simPort->AFR[0] = gatedRegs->AFR[0];
+      simPort->AFR[1] = gatedRegs->AFR[1];
+    }
+  }
+
+  if (simPort->BSRR != 0U) {
+    uint32_t portBsrr = simPort->BSRR;
+
+    simPort->ODR = (simPort->ODR & ~(portBsrr >> 16U)) | (portBsrr & 0xFFFFU);
+    simPort->BSRR = 0U;
+  }
+
+  if (!isClocked) {
+    if (!simGpioTmp->isGated) {
+      simGpioTmp->gatedRegs = *simPort;
+      simGpioTmp->isGated = true;
+    }
+
+    // An unclocked port reads as 0
+    simPort->IDR = 0U;
+    return;
+  }
+
+  simGpioTmp->isGated = false;
+
+  uint32_t portIdr = sim_gpio_levels(simPort, simGpioTmp);
+  uint32_t portEdges = portIdr ^ simGpioTmp->lastIdr;
+
+  simPort->IDR = portIdr;
+  simGpioTmp->lastIdr = portIdr;
+
+  for (uint32_t pinPos = 0U; portEdges != 0U; pinPos++, portEdges >>= 1U) {
+    uint32_t pinBit = 1UL << pinPos;
+    uint32_t extiPort =
+        (SYSCFG->EXTICR[pinPos >> 2U] >> ((pinPos & 3U) * 4U)) & 0xFU;
+
+    if ((portEdges & 1U) == 0U || extiPort != portIdx) continue;
+
+    if (((portIdr & pinBit) && (EXTI->RTSR & pinBit)) ||
+        (!(portIdr & pinBit) && (EXTI->FTSR & pinBit))) {
+      EXTI->PR |= pinBit;
+    }
+  }
+}
+
+/**
+ * @brief: Returns the pin levels of a clocked port: analog pins read 0,
+ *         push-pull outputs their ODR bit, inputs (and open-drain outputs
+ *         left high) the external driver or else their pull.
+ *
+ * @param[in]: simPort
+ * @param[in]: simGpio
+ * @return[out]: uint32_t
+ **/
+static uint32_t sim_gpio_levels(GPIO_TypeDef *simPort,
+                                const sim_gpio_t *simGpio) {
+  uint32_t portLevels = 0U;
+
+  for (uint32_t pinPos = 0U; pinPos < 16U; pinPos++) {
+    uint32_t pinBit = 1UL << pinPos;
+    uint32_t pinMode = (simPort->MODER >> (pinPos * 2U)) & 3U;
+    uint32_t pinPull = (simPort->PUPDR >> (pinPos * 2U)) & 3U;
+    bool isHigh;
+
+    if (pinMode == LL_GPIO_MODE_ANALOG) continue;
+
+    if (pinMode == LL_GPIO_MODE_OUTPUT && !(simPort->OTYPER & pinBit)) {
+      isHigh = (simPort->ODR & pinBit) != 0U;
+    } else if (pinMode == LL_GPIO_MODE_OUTPUT && !(simPort->ODR & pinBit)) {
+      isHigh = false;
+    } else if (simGpio->driveMask & pinBit) {
+      isHigh = (simGpio->driveLevel & pinBit) != 0U;
+    } else {
+      isHigh = (pinPull == LL_GPIO_PULL_UP);
+    }
+
+    if (isHigh) portLevels |= pinBit;
+  }
+
+  return portLevels;
+}
+
+/* TIM */
+
+static sim_tim_t *sim_tim_find(TIM_TypeDef *simTim) {
+  for (uint32_t timIdx = 0U; timIdx < SIM_NUM_TIMS; timIdx++) {
+    if (simTims[timIdx].timReg == simTim) return &simTims[timIdx];
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief: Whether the counter runs on the internal clock: enabled, clocked,
+ *         and not in encoder or external clock mode.
+ *
+ * @param[in]: simTim
+ * @return[out]: bool
+ **/
+static bool sim_tim_is_internal(const sim_tim_t *simTim) {
+  TIM_TypeDef *timReg = simTim->timReg;
+  uint32_t timSms = timReg->SMCR & TIM_SMCR_SMS;
+
+  if ((timReg->CR1 & TIM_CR1_CEN) == 0U) return false;
+  if ((*simTim->enReg & simTim->enBit) == 0U) return false;
+  if (timReg->SMCR & TIM_SMCR_ECE) return false;
+
+  return (timSms == 0U || (timSms >= 4U && timSms <= 6U));
+}
+
+/**
+ * @brief: Returns the time of the next counter wrap.
+ *
+ * @param[in]: simTim
+ * @return[out]: uint64_t
+ **/
+static uint64_t sim_tim_next(const sim_tim_t *simTim) {
+  TIM_TypeDef *timReg = simTim->timReg;
+  uint32_t timArr = timReg->ARR & simTim->cntMask;
+  uint32_t timCnt = timReg->CNT & simTim->cntMask;
+  uint64_t numTicks;
+
+  if (!sim_tim_is_internal(simTim) || timArr == 0U) return SIM_NO_EVENT;
+
+  if (timReg->CR1 & TIM_CR1_DIR) {
+    numTicks = (uint64_t)timCnt + 1U;
+  } else {
+    numTicks = (uint64_t)((timCnt <= timArr) ? timArr : simTim->cntMask) -
+               timCnt + 1U;
+  }
+
+  return simNow + numTicks * ((uint64_t)simTim->pscShadow + 1U) -
+         simTim->pscCnt;
+}
+
+/**
+ * @brief: Runs the prescaler and the counter of an internally clocked timer.
+ *
+ * @param[in]: simTim
+ * @param[in]: simCycles
+ * @return[out]: void
+ **/
+static void sim_tim_advance(sim_tim_t *simTim, uint64_t simCycles) {
+  if (!sim_tim_is_internal(simTim) || simCycles == 0U) return;
+
+  uint64_t pscDiv = (uint64_t)simTim->pscShadow + 1U;
+  uint64_t pscTotal = simTim->pscCnt + simCycles;
+
+  simTim->pscCnt = (uint32_t)(pscTotal % pscDiv);
+  sim_tim_count(simTim, pscTotal / pscDiv);
+}
+
+/**
+ * @brief: Counts ticks in the current direction, with an update event at
+ *         each overflow (up, at ARR) or underflow (down, at 0).
+ *
+ * @param[in]: simTim
+ * @param[in]: numTicks
+ * @return[out]: void
+ **/
+static void sim_tim_count(sim_tim_t *simTim, uint64_t numTicks) {
+  TIM_TypeDef *timReg = simTim->timReg;
+
+  while (numTicks != 0U && (timReg->CR1 & TIM_CR1_CEN)) {
+    uint32_t timArr = timReg->ARR & simTim->cntMask;
+    uint32_t timCnt = timReg->CNT & simTim->cntMask;
+
+    // The counter is blocked while ARR is 0
+    if (timArr == 0U) return;
+
+    if (timReg->CR1 & TIM_CR1_DIR) {
+      if (numTicks <= timCnt) {
+        timReg->CNT = timCnt - (uint32_t)numTicks;
+        return;
+      }
+
+      numTicks -= (uint64_t)timCnt + 1U;
+      timReg->CNT = timArr;
+      sim_tim_uev(simTim, true);
+    } else {
+      uint32_t cntLimit = (timCnt <= timArr) ? timArr : simTim->cntMask;
+
+      if (numTicks <= (uint64_t)(cntLimit - timCnt)) {
+        timReg->CNT = timCnt + (uint32_t)numTicks;
+        return;
+      }
+
+      numTicks -= (uint64_t)(cntLimit - timCnt) + 1U;
+      timReg->CNT = 0U;
+      if (cntLimit == timArr) sim_tim_uev(simTim, true);
+    }
+
+    if (timReg->CR1 & TIM_CR1_OPM) timReg->CR1 &= ~TIM_CR1_CEN;
+  }
+}
+
+/**
+ * @brief: Update event: loads the prescaler, sets UIF (only overflows do
+ *         with URS set), requests DMA and drives TRGO in update mode.
+ *
+ * @param[in]: simTim
+ * @param[in]: isOverflow
+ * @return[out]: void
+ **/
+static void sim_tim_uev(sim_tim_t *simTim, bool isOverflow) {
+  TIM_TypeDef *timReg = simTim->timReg;
+
+  if (timReg->CR1 & TIM_CR1_UDIS) return;
+
+  simTim->pscShadow = timReg->PSC & 0xFFFFU;
+
+  if (isOverflow || !(timReg->CR1 & TIM_CR1_URS)) {
+    timReg->SR |= TIM_SR_UIF;
+    if ((timReg->DIER & TIM_DIER_UDE) && timReg == TIM1) sim_dma_request();
+  }
+
+  if ((timReg->CR2 & TIM_CR2_MMS) == LL_TIM_TRGO_UPDATE) sim_tim_trgo(simTim);
+}
+
+/**
+ * @brief: UG, reinitialises the counter and the prescaler.
+ *
+ * @param[in]: simTim
+ * @return[out]: void
+ **/
+static void sim_tim_ug(sim_tim_t *simTim) {
+  TIM_TypeDef *timReg = simTim->timReg;
+
+  simTim->pscCnt = 0U;
+  timReg->CNT = (timReg->CR1 & TIM_CR1_DIR) ? (timReg->ARR & simTim->cntMask)
+                                             : 0U;
+  sim_tim_uev(simTim, false);
+
+  if ((timReg->CR2 & TIM_CR2_MMS) == LL_TIM_TRGO_RESET) sim_tim_trgo(simTim);
+}
+
+/**
+ * @brief: Drives TRGO on a counter enable when it is the TRGO source.
+ *
+ * @param[in]: simTim
+ * @return[out]: void
+ **/
+static void sim_tim_cen(sim_tim_t *simTim) {
+  TIM_TypeDef *timReg = simTim->timReg;
+  bool isStarted = (timReg->CR1 & TIM_CR1_CEN) && !(simTim->lastCr1 & TIM_CR1_CEN);
+
+  simTim->lastCr1 = timReg->CR1;
+
+  if (isStarted && (timReg->CR2 & TIM_CR2_MMS) == LL_TIM_TRGO_ENABLE) {
+    sim_tim_trgo(simTim);
+  }
+}
+
+/**
+ * @brief: A TRGO pulse, seen by the timers that take it as their trigger.
+ *
+ * @param[in]: simTim
+ * @return[out]: void
+ **/
+static void sim_tim_trgo(const sim_tim_t *simTim) {
+  for (uint32_t timIdx = 0U; timIdx < SIM_NUM_TIMS; timIdx++) {
+    sim_tim_t *simSlave = &simTims[timIdx];
+    TIM_TypeDef *slaveReg = simSlave->timReg;
+    uint32_t slaveTs = (slaveReg->SMCR & TIM_SMCR_TS) >> 4U;
+
+    if (simSlave == simTim || slaveTs > 3U) continue;
+    if (simSlave->itrMaster[slaveTs] != simTim->timReg) continue;
+
+    switch (slaveReg->SMCR & TIM_SMCR_SMS) {
+      case LL_TIM_SLAVEMODE_RESET:
+        sim_tim_ug(simSlave);
+        break;
+
+      case LL_TIM_SLAVEMODE_TRIGGER:
+        slaveReg->CR1 |= TIM_CR1_CEN;
+        sim_tim_cen(simSlave);
+        break;
+
+      case LL_TIM_CLOCKSOURCE_EXT_MODE1:
+        if (*simSlave->enReg & simSlave->enBit) sim_tim_count(simSlave, 1U);
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+/**
+ * @brief: TIM1 update request on DMA2 stream 5 channel 6, one peripheral to
+ *         memory transfer.
+ *
+ * @return[out]: void
+ **/
+static void sim_dma_request(void) {
+  DMA_Stream_TypeDef *dmaStream = DMA2_Stream5;
+  uint32_t dmaCr = dmaStream->CR;
+
+  if (!(dmaCr & DMA_SxCR_EN) || (dmaCr & DMA_SxCR_CHSEL) != LL_DMA_CHANNEL_6) {
+    return;
+  }
+  if (!(RCC->AHB1ENR & RCC_AHB1ENR_DMA2EN) || (dmaCr & DMA_SxCR_DIR) != 0U) {
+    return;
+  }
+  if (dmaStream->NDTR == 0U || simDmaLen == 0U) return;
+
+  uint32_t pSize = 1UL << ((dmaCr & DMA_SxCR_PSIZE) >> 11U);
+  uint32_t mSize = 1UL << ((dmaCr & DMA_SxCR_MSIZE) >> 13U);
+  uint32_t dmaIdx = simDmaLen - dmaStream->NDTR;
+  uint32_t dmaData = 0U;
+
+  // IDR has to be current for a GPIO source
+  for (uint32_t portIdx = 0U; portIdx < SIM_NUM_PORTS; portIdx++) {
+    if ((SIM_PORT_MASK >> portIdx) & 1U) sim_gpio_update(portIdx);
+  }
+
+  memcpy(&dmaData,
+         (const void *)(uintptr_t)(dmaStream->PAR +
+                                   ((dmaCr & DMA_SxCR_PINC) ? dmaIdx * pSize
+                                                            : 0U)),
+         pSize);
+  memcpy((void *)(uintptr_t)(dmaStream->M0AR +
+                             ((dmaCr & DMA_SxCR_MINC) ? dmaIdx * mSize : 0U)),
+         &dmaData, mSize);
+
+  dmaStream->NDTR--;
+
+  if (dmaStream->NDTR == simDmaLen / 2U) DMA2->HISR |= DMA_HISR_HTIF5;
+
+  if (dmaStream->NDTR == 0U) {
+    DMA2->HISR |= DMA_HISR_TCIF5;
+
+    if (dmaCr & DMA_SxCR_CIRC) {
+      dmaStream->NDTR = simDmaLen;
+    } else {
+      dmaStream->CR &= ~DMA_SxCR_EN;
+      simDmaLastCr = dmaStream->CR;
+    }
+  }
+}
+
+/* USART */
+
+static sim_usart_t *sim_usart_find(USART_TypeDef *simUsart) {
+  for (uint32_t usartIdx = 0U; usartIdx < SIM_NUM_USARTS; usartIdx++) {
+    if (simUsarts[usartIdx].usartReg == simUsart) return &simUsarts[usartIdx];
+  }
+
+  fprintf(stderr, "sim: no USART at %p\n", (void *)simUsart);
+  abort();
+}
+
+/**
+ * @brief: Returns the length of a frame in core cycles, from BRR, the word
+ *         length and the stop bits.
+ *
+ * @param[in]: simUsart
+ * @return[out]: uint64_t
+ **/
+static uint64_t sim_usart_frame(const sim_usart_t *simUsart) {
+  static const uint32_t stopHalves[4] = {2U, 1U, 4U, 3U};
+  USART_TypeDef *usartReg = simUsart->usartReg;
+  uint32_t usartBrr = usartReg->BRR & 0xFFFFU;
+  uint32_t usartDiv = (usartReg->CR1 & USART_CR1_OVER8)
+                          ? (((usartBrr >> 4U) << 3U) | (usartBrr & 7U))
+                          : usartBrr;
+  uint32_t frameHalves = 2U * ((usartReg->CR1 & USART_CR1_M) ? 10U : 9U) +
+                         stopHalves[(usartReg->CR2 & USART_CR2_STOP) >> 12U];
+
+  // An unset BRR runs at 115200 baud
+  uint64_t bitCycles = (usartDiv == 0U)
+                           ? (SIM_CORE_CLOCK / 115200U)
+                           : (uint64_t)usartDiv * simUsart->pclkDiv;
+
+  return (bitCycles * frameHalves) / 2U;
+}
+
+static bool sim_usart_is_on(const sim_usart_t *simUsart) {
+  return (*simUsart->enReg & simUsart->enBit) &&
+         (simUsart->usartReg->CR1 & USART_CR1_UE);
+}
+
+/**
+ * @brief: Starts the frames that can start now: TDR into the shift register
+ *         (held by CTS with CTSE), and the peer's next byte (held by RTS with
+ *         RTSE while DR is unread, or by an XOFF).
+ *
+ * @param[in]: simUsart
+ * @return[out]: void
+ **/
+static void sim_usart_kick(sim_usart_t *simUsart) {
+  USART_TypeDef *usartReg = simUsart->usartReg;
+
+  if (!sim_usart_is_on(simUsart)) return;
+
+  if (!simUsart->isTxBusy && simUsart->isTdrFull &&
+      (usartReg->CR1 & USART_CR1_TE) &&
+      (!(usartReg->CR3 & USART_CR3_CTSE) || simUsart->isCtsAsserted)) {
+    simUsart->txShift = simUsart->txData;
+    simUsart->isTdrFull = false;
+    simUsart->isTxBusy = true;
+    simUsart->txDoneAt = simNow + sim_usart_frame(simUsart);
+    usartReg->SR |= USART_SR_TXE;
+  }
+
+  uint32_t wireHead =
+      atomic_load_explicit(&simUsart->wireHead, memory_order_relaxed);
+  uint32_t wireTail =
+      atomic_load_explicit(&simUsart->wireTail, memory_order_acquire);
+
+  if (simUsart->isRxBusy || wireHead == wireTail ||
+      !(usartReg->CR1 & USART_CR1_RE)) {
+    return;
+  }
+
+  bool isRtsHeld =
+      (usartReg->CR3 & USART_CR3_RTSE) && (usartReg->SR & USART_SR_RXNE);
+
+  if (simUsart->isPeerPaused || isRtsHeld) {
+    if (!simUsart->isRxHeld) {
+      if (simUsart->isPeerPaused) {
+        simUsart->usartStats.xoffHolds++;
+      } else {
+        simUsart->usartStats.rtsHolds++;
+      }
+    }
+
+    simUsart->isRxHeld = true;
+    return;
+  }
+
+  simUsart->isRxHeld = false;
+  simUsart->rxShift = simUsart->wire[wireHead % SIM_WIRE_SIZE];
+  atomic_store_explicit(&simUsart->wireHead, wireHead + 1U,
+                        memory_order_release);
+  simUsart->isRxBusy = true;
+  simUsart->rxDoneAt = simNow + sim_usart_frame(simUsart);
+}
+
+/**
+ * @brief: Ends the frames due now. A sent byte goes to the TX hook (and
+ *         back to the receiver in half-duplex), a received one to DR.
+ *
+ * @param[in]: simUsart
+ * @return[out]: void
+ **/
+static void sim_usart_events(sim_usart_t *simUsart) {
+  USART_TypeDef *usartReg = simUsart->usartReg;
+
+  if (simUsart->isTxBusy && simUsart->txDoneAt <= simNow) {
+    uint8_t txData = simUsart->txShift;
+
+    simUsart->isTxBusy = false;
+    simUsart->usartStats.txBytes++;
+
+    if (usartReg->CR3 & USART_CR3_HDSEL) sim_usart_rx_byte(simUsart, txData);
+
+    if (simUsart->isPeerXonXoff && txData == SIM_XOFF) {
+      simUsart->isPeerPaused = true;
+    } else if (simUsart->isPeerXonXoff && txData == SIM_XON) {
+      simUsart->isPeerPaused = false;
+    }
+
+    if (simUsart->txHook != NULL) simUsart->txHook(simUsart->hookCtx, txData);
+
+    sim_usart_kick(simUsart);
+    if (!simUsart->isTxBusy && !simUsart->isTdrFull) {
+      usartReg->SR |= USART_SR_TC;
+    }
+  }
+
+  if (simUsart->isRxBusy && simUsart->rxDoneAt <= simNow) {
+    simUsart->isRxBusy = false;
+    sim_usart_rx_byte(simUsart, simUsart->rxShift);
+    sim_usart_kick(simUsart);
+  }
+}
+
+/**
+ * @brief: A byte reaching the receiver: into DR, or lost to an overrun if
+ *         DR is still unread.
+ *
+ * @param[in]: simUsart
+ * @param[in]: rxData
+ * @return[out]: void
+ **/
+static void sim_usart_rx_byte(sim_usart_t *simUsart, uint8_t rxData) {
+  USART_TypeDef *usartReg = simUsart->usartReg;
+
+  if (!sim_usart_is_on(simUsart) || !(usartReg->CR1 & USART_CR1_RE)) return;
+
+  if (usartReg->SR & USART_SR_RXNE) {
+    usartReg->SR |= USART_SR_ORE;
+    simUsart->usartStats.rxOverruns++;
+    return;
+  }
+
+  usartReg->DR = rxData;
+  usartReg->SR |= USART_SR_RXNE;
+  simUsart->usartStats.rxBytes++;
+}
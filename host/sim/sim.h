@@ -0,0 +1,117 @@
+/**
+ * @file sim.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host simulation of the STM32F401 peripherals used by the modules.
+ * The GPIO, RCC, TIM, USART, EXTI, DMA and core register blocks are host
+ * memory at their real addresses. A virtual clock, in CPU cycles, moves the
+ * counters, the serial lines and DWT->CYCCNT, and the simulated NVIC calls the
+ * modules' IRQ handlers when an enabled interrupt line is raised.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef SIM_H_
+#define SIM_H_
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Simulator includes */
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Core clock, HCLK; APB1 runs at HCLK / SIM_APB1_DIV
+#define SIM_CORE_CLOCK 84000000U
+#define SIM_APB1_DIV 2U
+
+// Cost of a flag or counter read in thread mode, lets polling loops end
+#define SIM_POLL_CYCLES 4U
+
+// Sleep length of __WFI() when nothing is scheduled and no idle hook is set
+#define SIM_IDLE_CYCLES (SIM_CORE_CLOCK / 1000U)
+
+// Bytes a peer can queue towards a USART
+#define SIM_WIRE_SIZE 4096U
+
+// Cycle helpers
+#define SIM_US(us) ((uint64_t)(us) * (SIM_CORE_CLOCK / 1000000U))
+#define SIM_MS(ms) ((uint64_t)(ms) * (SIM_CORE_CLOCK / 1000U))
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Called for every byte a USART finishes sending, in simulator context */
+typedef void (*sim_tx_hook_t)(void *hookCtx, uint8_t txData);
+
+/* Called by __WFI() when no event is scheduled, may block for host input */
+typedef void (*sim_idle_hook_t)(void);
+
+/* Called by NVIC_SystemReset(), must not return */
+typedef void (*sim_reset_hook_t)(void);
+
+/* Line statistics of a simulated USART */
+typedef struct {
+  uint32_t txBytes;      // Bytes sent on TX
+  uint32_t rxBytes;      // Bytes that reached DR
+  uint32_t rxOverruns;   // Bytes lost to ORE, DR still held the previous one
+  uint32_t rtsHolds;     // Times the peer held a byte back on RTS
+  uint32_t xoffHolds;    // Times the peer held a byte back after an XOFF
+
+} sim_usart_stats_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Virtual clock */
+uint64_t sim_now(void);
+void sim_advance(uint64_t simCycles);
+
+/* Core */
+void sim_set_pc(uint32_t simPc);
+uint32_t sim_irq_count(IRQn_Type irqN);
+void sim_set_idle_hook(sim_idle_hook_t idleHook);
+void sim_set_reset_hook(sim_reset_hook_t resetHook);
+
+/* GPIO */
+void sim_gpio_drive(GPIO_TypeDef *simPort, uint32_t pinMask, bool isHigh);
+void sim_gpio_release(GPIO_TypeDef *simPort, uint32_t pinMask);
+uint32_t sim_gpio_gated_writes(GPIO_TypeDef *simPort);
+
+/* GPIO and RCC register accesses made through the register macros */
+uint32_t sim_reg_reads(const volatile void *simReg);
+uint32_t sim_reg_writes(const volatile void *simReg);
+void sim_reg_clear_counts(void);
+
+/* TIM */
+void sim_tim_encoder(TIM_TypeDef *simTim, int32_t encSteps);
+
+/* USART, sim_usart_rx_push() may be called from any one host thread */
+void sim_usart_set_tx_hook(USART_TypeDef *simUsart, sim_tx_hook_t txHook,
+                           void *hookCtx);
+uint32_t sim_usart_rx_push(USART_TypeDef *simUsart, const uint8_t *rxData,
+                           uint32_t rxLen);
+uint32_t sim_usart_rx_queued(USART_TypeDef *simUsart);
+void sim_usart_set_cts(USART_TypeDef *simUsart, bool isAsserted);
+void sim_usart_set_peer_xonxoff(USART_TypeDef *simUsart, bool isHonoured);
+void sim_usart_get_stats(USART_TypeDef *simUsart, sim_usart_stats_t *simStats);
+
+/* Hooks of the LL stand-ins, not for tests */
+void sim_sync(void);
+void sim_poll(void);
+uint8_t sim_usart_read_dr(USART_TypeDef *simUsart);
+void sim_usart_write_dr(USART_TypeDef *simUsart, uint8_t txData);
+
+#endif  // sim.h
@@ -0,0 +1,450 @@
+/**
+ * @file stm32f4xx.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the STM32F401xE device and Cortex-M4 core headers.
+ * The register blocks sit at their real addresses, backed by host memory the
+ * simulator maps at start-up (sim.c), so the modules' register and address
+ * arithmetic is unchanged. Core intrinsics and NVIC calls go to the simulator.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_H
+#define __STM32F4xx_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define __IO volatile
+#define __I volatile const
+#define __O volatile
+#define __STATIC_INLINE static inline
+#define __STATIC_FORCEINLINE static inline __attribute__((always_inline))
+
+#define __NVIC_PRIO_BITS 4U
+
+// Register accesses through these macros (and so through the LL stand-ins)
+// are counted for the GPIO and RCC blocks, see sim_reg_writes()
+#define SIM_REG_READ 1U
+#define SIM_REG_WRITE 2U
+
+#define SET_BIT(REG, BIT) \
+  (sim_reg_access(&(REG), SIM_REG_READ | SIM_REG_WRITE), (REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT) \
+  (sim_reg_access(&(REG), SIM_REG_READ | SIM_REG_WRITE), (REG) &= ~(BIT))
+#define READ_BIT(REG, BIT) \
+  (sim_reg_access(&(REG), SIM_REG_READ), (REG) & (BIT))
+#define CLEAR_REG(REG) (sim_reg_access(&(REG), SIM_REG_WRITE), (REG) = (0x0))
+#define WRITE_REG(REG, VAL) \
+  (sim_reg_access(&(REG), SIM_REG_WRITE), (REG) = (VAL))
+#define READ_REG(REG) (sim_reg_access(&(REG), SIM_REG_READ), (REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) \
+  WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+#define POSITION_VAL(VAL) (__CLZ(__RBIT(VAL)))
+
+#define assert_param(expr) ((void)0U)
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0U, ENABLE = !DISABLE } FunctionalState;
+typedef enum { SUCCESS = 0U, ERROR = !SUCCESS } ErrorStatus;
+
+/* Interrupt numbers used by the modules and the simulator */
+typedef enum {
+
+  NonMaskableInt_IRQn = -14,
+  HardFault_IRQn = -13,
+  MemoryManagement_IRQn = -12,
+  BusFault_IRQn = -11,
+  UsageFault_IRQn = -10,
+  SVCall_IRQn = -5,
+  DebugMonitor_IRQn = -4,
+  PendSV_IRQn = -2,
+  SysTick_IRQn = -1,
+  EXTI0_IRQn = 6,
+  EXTI1_IRQn = 7,
+  EXTI2_IRQn = 8,
+  EXTI3_IRQn = 9,
+  EXTI4_IRQn = 10,
+  EXTI9_5_IRQn = 23,
+  TIM1_UP_TIM10_IRQn = 25,
+  TIM2_IRQn = 28,
+  TIM3_IRQn = 29,
+  TIM4_IRQn = 30,
+  USART1_IRQn = 37,
+  USART2_IRQn = 38,
+  EXTI15_10_IRQn = 40,
+  DMA2_Stream5_IRQn = 68,
+  USART6_IRQn = 71,
+
+} IRQn_Type;
+
+/* Peripheral register blocks */
+typedef struct {
+  __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR, PLLCFGR, CFGR, CIR, AHB1RSTR, AHB2RSTR;
+  uint32_t RESERVED0[2];
+  __IO uint32_t APB1RSTR, APB2RSTR;
+  uint32_t RESERVED1[2];
+  __IO uint32_t AHB1ENR, AHB2ENR;
+  uint32_t RESERVED2[2];
+  __IO uint32_t APB1ENR, APB2ENR;
+  uint32_t RESERVED3[2];
+  __IO uint32_t AHB1LPENR, AHB2LPENR;
+  uint32_t RESERVED4[2];
+  __IO uint32_t APB1LPENR, APB2LPENR;
+  uint32_t RESERVED5[2];
+  __IO uint32_t BDCR, CSR;
+  uint32_t RESERVED6[2];
+  __IO uint32_t SSCGR, PLLI2SCFGR;
+  uint32_t RESERVED7;
+  __IO uint32_t DCKCFGR;
+} RCC_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC,
+      ARR, RCR, CCR1, CCR2, CCR3, CCR4, BDTR, DCR, DMAR, OR;
+} TIM_TypeDef;
+
+typedef struct {
+  __IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+typedef struct {
+  __IO uint32_t IMR, EMR, RTSR, FTSR, SWIER, PR;
+} EXTI_TypeDef;
+
+typedef struct {
+  __IO uint32_t MEMRMP, PMC, EXTICR[4];
+  uint32_t RESERVED[2];
+  __IO uint32_t CMPCR;
+} SYSCFG_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+  __IO uint32_t LISR, HISR, LIFCR, HIFCR;
+} DMA_TypeDef;
+
+/* Core register blocks */
+typedef struct {
+  __IO uint32_t ISER[8U];
+  uint32_t RESERVED0[24U];
+  __IO uint32_t ICER[8U];
+  uint32_t RESERVED1[24U];
+  __IO uint32_t ISPR[8U];
+  uint32_t RESERVED2[24U];
+  __IO uint32_t ICPR[8U];
+  uint32_t RESERVED3[24U];
+  __IO uint32_t IABR[8U];
+  uint32_t RESERVED4[56U];
+  __IO uint8_t IP[240U];
+  uint32_t RESERVED5[644U];
+  __O uint32_t STIR;
+} NVIC_Type;
+
+typedef struct {
+  __I uint32_t CPUID;
+  __IO uint32_t ICSR, VTOR, AIRCR, SCR, CCR;
+  __IO uint8_t SHP[12U];
+  __IO uint32_t SHCSR, CFSR, HFSR, DFSR, MMFAR, BFAR, AFSR;
+  __I uint32_t PFR[2U], DFR, ADR, MMFR[4U], ISAR[5U];
+  uint32_t RESERVED0[5U];
+  __IO uint32_t CPACR;
+} SCB_Type;
+
+typedef struct {
+  __IO uint32_t CTRL, LOAD, VAL;
+  __I uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct {
+  __IO uint32_t CTRL, CYCCNT, CPICNT, EXCCNT, SLEEPCNT, LSUCNT, FOLDCNT;
+  __I uint32_t PCSR;
+} DWT_Type;
+
+typedef struct {
+  __IO uint32_t DHCSR;
+  __O uint32_t DCRSR;
+  __IO uint32_t DCRDR, DEMCR;
+} CoreDebug_Type;
+
+////////////////////////////////////////////////////////////////////////////////
+// Memory Map
+////////////////////////////////////////////////////////////////////////////////
+
+#define PERIPH_BASE 0x40000000UL
+#define APB1PERIPH_BASE PERIPH_BASE
+#define APB2PERIPH_BASE (PERIPH_BASE + 0x00010000UL)
+#define AHB1PERIPH_BASE (PERIPH_BASE + 0x00020000UL)
+
+#define TIM2_BASE (APB1PERIPH_BASE + 0x0000UL)
+#define TIM3_BASE (APB1PERIPH_BASE + 0x0400UL)
+#define TIM4_BASE (APB1PERIPH_BASE + 0x0800UL)
+#define TIM5_BASE (APB1PERIPH_BASE + 0x0C00UL)
+#define USART2_BASE (APB1PERIPH_BASE + 0x4400UL)
+#define PWR_BASE (APB1PERIPH_BASE + 0x7000UL)
+#define TIM1_BASE (APB2PERIPH_BASE + 0x0000UL)
+#define USART1_BASE (APB2PERIPH_BASE + 0x1000UL)
+#define USART6_BASE (APB2PERIPH_BASE + 0x1400UL)
+#define SYSCFG_BASE (APB2PERIPH_BASE + 0x3800UL)
+#define EXTI_BASE (APB2PERIPH_BASE + 0x3C00UL)
+#define GPIOA_BASE (AHB1PERIPH_BASE + 0x0000UL)
+#define GPIOB_BASE (AHB1PERIPH_BASE + 0x0400UL)
+#define GPIOC_BASE (AHB1PERIPH_BASE + 0x0800UL)
+#define GPIOD_BASE (AHB1PERIPH_BASE + 0x0C00UL)
+#define GPIOE_BASE (AHB1PERIPH_BASE + 0x1000UL)
+#define GPIOH_BASE (AHB1PERIPH_BASE + 0x1C00UL)
+#define RCC_BASE (AHB1PERIPH_BASE + 0x3800UL)
+#define DMA1_BASE (AHB1PERIPH_BASE + 0x6000UL)
+#define DMA2_BASE (AHB1PERIPH_BASE + 0x6400UL)
+#define DMA2_Stream5_BASE (DMA2_BASE + 0x088UL)
+
+#define SCS_BASE 0xE000E000UL
+#define SysTick_BASE (SCS_BASE + 0x0010UL)
+#define NVIC_BASE (SCS_BASE + 0x0100UL)
+#define SCB_BASE (SCS_BASE + 0x0D00UL)
+#define CoreDebug_BASE 0xE000EDF0UL
+#define DWT_BASE 0xE0001000UL
+
+#define TIM1 ((TIM_TypeDef *)TIM1_BASE)
+#define TIM2 ((TIM_TypeDef *)TIM2_BASE)
+#define TIM3 ((TIM_TypeDef *)TIM3_BASE)
+#define TIM4 ((TIM_TypeDef *)TIM4_BASE)
+#define TIM5 ((TIM_TypeDef *)TIM5_BASE)
+#define USART1 ((USART_TypeDef *)USART1_BASE)
+#define USART2 ((USART_TypeDef *)USART2_BASE)
+#define USART6 ((USART_TypeDef *)USART6_BASE)
+#define SYSCFG ((SYSCFG_TypeDef *)SYSCFG_BASE)
+#define EXTI ((EXTI_TypeDef *)EXTI_BASE)
+#define GPIOA ((GPIO_TypeDef *)GPIOA_BASE)
+#define GPIOB ((GPIO_TypeDef *)GPIOB_BASE)
+#define GPIOC ((GPIO_TypeDef *)GPIOC_BASE)
+#define GPIOD ((GPIO_TypeDef *)GPIOD_BASE)
+#define GPIOE ((GPIO_TypeDef *)GPIOE_BASE)
+#define GPIOH ((GPIO_TypeDef *)GPIOH_BASE)
+#define RCC ((RCC_TypeDef *)RCC_BASE)
+#define DMA1 ((DMA_TypeDef *)DMA1_BASE)
+#define DMA2 ((DMA_TypeDef *)DMA2_BASE)
+#define DMA2_Stream5 ((DMA_Stream_TypeDef *)DMA2_Stream5_BASE)
+
+#define SysTick ((SysTick_Type *)SysTick_BASE)
+#define NVIC ((NVIC_Type *)NVIC_BASE)
+#define SCB ((SCB_Type *)SCB_BASE)
+#define CoreDebug ((CoreDebug_Type *)CoreDebug_BASE)
+#define DWT ((DWT_Type *)DWT_BASE)
+
+////////////////////////////////////////////////////////////////////////////////
+// Register Bits
+////////////////////////////////////////////////////////////////////////////////
+
+/* RCC */
+#define RCC_AHB1ENR_GPIOAEN (1UL << 0)
+#define RCC_AHB1ENR_GPIOBEN (1UL << 1)
+#define RCC_AHB1ENR_GPIOCEN (1UL << 2)
+#define RCC_AHB1ENR_GPIODEN (1UL << 3)
+#define RCC_AHB1ENR_GPIOEEN (1UL << 4)
+#define RCC_AHB1ENR_GPIOHEN (1UL << 7)
+#define RCC_AHB1ENR_DMA1EN (1UL << 21)
+#define RCC_AHB1ENR_DMA2EN (1UL << 22)
+#define RCC_APB1ENR_TIM2EN (1UL << 0)
+#define RCC_APB1ENR_TIM3EN (1UL << 1)
+#define RCC_APB1ENR_TIM4EN (1UL << 2)
+#define RCC_APB1ENR_USART2EN (1UL << 17)
+#define RCC_APB2ENR_TIM1EN (1UL << 0)
+#define RCC_APB2ENR_USART1EN (1UL << 4)
+#define RCC_APB2ENR_USART6EN (1UL << 5)
+#define RCC_APB2ENR_SYSCFGEN (1UL << 14)
+
+/* GPIO */
+#define GPIO_MODER_MODER0 (3UL << 0)
+#define GPIO_PUPDR_PUPDR0 (3UL << 0)
+#define GPIO_OSPEEDER_OSPEEDR0 (3UL << 0)
+#define GPIO_OTYPER_OT_0 (1UL << 0)
+#define GPIO_BSRR_BS_0 (1UL << 0)
+#define GPIO_BSRR_BR_0 (1UL << 16)
+
+/* TIM */
+#define TIM_CR1_CEN (1UL << 0)
+#define TIM_CR1_UDIS (1UL << 1)
+#define TIM_CR1_URS (1UL << 2)
+#define TIM_CR1_OPM (1UL << 3)
+#define TIM_CR1_DIR (1UL << 4)
+#define TIM_CR1_ARPE (1UL << 7)
+#define TIM_CR2_MMS (7UL << 4)
+#define TIM_SMCR_SMS (7UL << 0)
+#define TIM_SMCR_TS (7UL << 4)
+#define TIM_SMCR_MSM (1UL << 7)
+#define TIM_SMCR_ECE (1UL << 14)
+#define TIM_DIER_UIE (1UL << 0)
+#define TIM_DIER_UDE (1UL << 8)
+#define TIM_SR_UIF (1UL << 0)
+#define TIM_EGR_UG (1UL << 0)
+#define TIM_CCMR1_CC1S (3UL << 0)
+#define TIM_CCMR1_IC1F_Pos 4U
+#define TIM_CCMR1_IC1F (15UL << TIM_CCMR1_IC1F_Pos)
+#define TIM_CCER_CC1E (1UL << 0)
+#define TIM_CCER_CC1P (1UL << 1)
+#define TIM_CCER_CC1NP (1UL << 3)
+
+/* USART */
+#define USART_SR_PE (1UL << 0)
+#define USART_SR_FE (1UL << 1)
+#define USART_SR_NE (1UL << 2)
+#define USART_SR_ORE (1UL << 3)
+#define USART_SR_IDLE (1UL << 4)
+#define USART_SR_RXNE (1UL << 5)
+#define USART_SR_TC (1UL << 6)
+#define USART_SR_TXE (1UL << 7)
+#define USART_SR_CTS (1UL << 9)
+#define USART_CR1_RE (1UL << 2)
+#define USART_CR1_TE (1UL << 3)
+#define USART_CR1_IDLEIE (1UL << 4)
+#define USART_CR1_RXNEIE (1UL << 5)
+#define USART_CR1_TCIE (1UL << 6)
+#define USART_CR1_TXEIE (1UL << 7)
+#define USART_CR1_PEIE (1UL << 8)
+#define USART_CR1_PS (1UL << 9)
+#define USART_CR1_PCE (1UL << 10)
+#define USART_CR1_M (1UL << 12)
+#define USART_CR1_UE (1UL << 13)
+#define USART_CR1_OVER8 (1UL << 15)
+#define USART_CR2_STOP (3UL << 12)
+#define USART_CR3_EIE (1UL << 0)
+#define USART_CR3_HDSEL (1UL << 3)
+#define USART_CR3_RTSE (1UL << 8)
+#define USART_CR3_CTSE (1UL << 9)
+
+/* DMA */
+#define DMA_SxCR_EN (1UL << 0)
+#define DMA_SxCR_TEIE (1UL << 2)
+#define DMA_SxCR_HTIE (1UL << 3)
+#define DMA_SxCR_TCIE (1UL << 4)
+#define DMA_SxCR_DIR (3UL << 6)
+#define DMA_SxCR_CIRC (1UL << 8)
+#define DMA_SxCR_PINC (1UL << 9)
+#define DMA_SxCR_MINC (1UL << 10)
+#define DMA_SxCR_PSIZE (3UL << 11)
+#define DMA_SxCR_MSIZE (3UL << 13)
+#define DMA_SxCR_PL (3UL << 16)
+#define DMA_SxCR_CHSEL (7UL << 25)
+#define DMA_HISR_TEIF5 (1UL << 9)
+#define DMA_HISR_HTIF5 (1UL << 10)
+#define DMA_HISR_TCIF5 (1UL << 11)
+
+/* Core */
+#define SCB_ICSR_VECTACTIVE_Msk 0x1FFUL
+#define SCB_AIRCR_PRIGROUP_Pos 8U
+#define SCB_AIRCR_PRIGROUP_Msk (7UL << SCB_AIRCR_PRIGROUP_Pos)
+#define SCB_SCR_SLEEPDEEP_Msk (1UL << 2)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+////////////////////////////////////////////////////////////////////////////////
+// Core Interface (sim.c)
+////////////////////////////////////////////////////////////////////////////////
+
+extern uint32_t SystemCoreClock;
+
+/* Section bounds of the log format strings, see LOG_STR_SECTION */
+extern const char __start_log_fmt[];
+extern const char __stop_log_fmt[];
+
+/* Counts an access made through the register macros */
+void sim_reg_access(const volatile void *simReg, uint32_t accessType);
+
+/* Interrupt masking, unmasking runs any pending interrupt */
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+
+/* Stack pointers and the active exception, the MSP points at the frame the
+   simulator stacked for the running handler */
+uint32_t __get_MSP(void);
+uint32_t __get_PSP(void);
+uint32_t __get_IPSR(void);
+
+/* Sleeps until an interrupt is pending, advancing the virtual clock */
+void __WFI(void);
+
+/* NVIC, backed by the NVIC register block */
+void NVIC_EnableIRQ(IRQn_Type irqN);
+void NVIC_DisableIRQ(IRQn_Type irqN);
+void NVIC_SetPendingIRQ(IRQn_Type irqN);
+void NVIC_ClearPendingIRQ(IRQn_Type irqN);
+void NVIC_SetPriority(IRQn_Type irqN, uint32_t irqPrio);
+uint32_t NVIC_GetPriority(IRQn_Type irqN);
+void NVIC_SystemReset(void);
+
+__STATIC_INLINE uint32_t NVIC_GetPriorityGrouping(void) {
+  return (SCB->AIRCR & SCB_AIRCR_PRIGROUP_Msk) >> SCB_AIRCR_PRIGROUP_Pos;
+}
+
+__STATIC_INLINE uint32_t NVIC_EncodePriority(uint32_t prioGroup,
+                                             uint32_t preemptPrio,
+                                             uint32_t subPrio) {
+  uint32_t prioGroupTmp = prioGroup & 0x07UL;
+  uint32_t preemptBits = ((7UL - prioGroupTmp) > __NVIC_PRIO_BITS)
+                             ? __NVIC_PRIO_BITS
+                             : (7UL - prioGroupTmp);
+  uint32_t subBits = ((prioGroupTmp + __NVIC_PRIO_BITS) < 7UL)
+                         ? 0UL
+                         : (prioGroupTmp - 7UL + __NVIC_PRIO_BITS);
+
+  return ((preemptPrio & ((1UL << preemptBits) - 1UL)) << subBits) |
+         (subPrio & ((1UL << subBits) - 1UL));
+}
+
+/* Barriers and hints, there is a single simulated core */
+__STATIC_FORCEINLINE void __DSB(void) { __sync_synchronize(); }
+__STATIC_FORCEINLINE void __DMB(void) { __sync_synchronize(); }
+__STATIC_FORCEINLINE void __ISB(void) { __sync_synchronize(); }
+__STATIC_FORCEINLINE void __NOP(void) { __asm volatile("nop"); }
+__STATIC_FORCEINLINE void __CLREX(void) {}
+
+/* Exclusives, interrupts are only taken at simulator calls so the pair
+   cannot be split */
+__STATIC_FORCEINLINE uint32_t __LDREXW(volatile uint32_t *addr) {
+  return *addr;
+}
+
+__STATIC_FORCEINLINE uint32_t __STREXW(uint32_t value, volatile uint32_t *addr) {
+  *addr = value;
+  return 0U;
+}
+
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value) {
+  return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t value) {
+  uint32_t result = 0U;
+
+  for (uint32_t bitIdx = 0U; bitIdx < 32U; bitIdx++) {
+    result = (result << 1U) | ((value >> bitIdx) & 1U);
+  }
+
+  return result;
+}
+
+#endif  // stm32f4xx.h
@@ -0,0 +1,94 @@
+/**
+ * @file stm32f4xx_ll_bus.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the LL bus (RCC clock enable) driver. The enable
+ * registers are the simulated RCC block, so gating a port's clock is seen by
+ * the GPIO model.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_LL_BUS_H
+#define __STM32F4xx_LL_BUS_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define LL_AHB1_GRP1_PERIPH_GPIOA RCC_AHB1ENR_GPIOAEN
+#define LL_AHB1_GRP1_PERIPH_GPIOB RCC_AHB1ENR_GPIOBEN
+#define LL_AHB1_GRP1_PERIPH_GPIOC RCC_AHB1ENR_GPIOCEN
+#define LL_AHB1_GRP1_PERIPH_GPIOD RCC_AHB1ENR_GPIODEN
+#define LL_AHB1_GRP1_PERIPH_GPIOE RCC_AHB1ENR_GPIOEEN
+#define LL_AHB1_GRP1_PERIPH_GPIOH RCC_AHB1ENR_GPIOHEN
+#define LL_AHB1_GRP1_PERIPH_DMA1 RCC_AHB1ENR_DMA1EN
+#define LL_AHB1_GRP1_PERIPH_DMA2 RCC_AHB1ENR_DMA2EN
+
+#define LL_APB1_GRP1_PERIPH_TIM2 RCC_APB1ENR_TIM2EN
+#define LL_APB1_GRP1_PERIPH_TIM3 RCC_APB1ENR_TIM3EN
+#define LL_APB1_GRP1_PERIPH_TIM4 RCC_APB1ENR_TIM4EN
+#define LL_APB1_GRP1_PERIPH_USART2 RCC_APB1ENR_USART2EN
+
+#define LL_APB2_GRP1_PERIPH_TIM1 RCC_APB2ENR_TIM1EN
+#define LL_APB2_GRP1_PERIPH_USART1 RCC_APB2ENR_USART1EN
+#define LL_APB2_GRP1_PERIPH_USART6 RCC_APB2ENR_USART6EN
+#define LL_APB2_GRP1_PERIPH_SYSCFG RCC_APB2ENR_SYSCFGEN
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+__STATIC_INLINE void LL_AHB1_GRP1_EnableClock(uint32_t periphs) {
+  SET_BIT(RCC->AHB1ENR, periphs);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_AHB1_GRP1_DisableClock(uint32_t periphs) {
+  CLEAR_BIT(RCC->AHB1ENR, periphs);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_AHB1_GRP1_IsEnabledClock(uint32_t periphs) {
+  return (READ_BIT(RCC->AHB1ENR, periphs) == periphs) ? 1UL : 0UL;
+}
+
+__STATIC_INLINE void LL_APB1_GRP1_EnableClock(uint32_t periphs) {
+  SET_BIT(RCC->APB1ENR, periphs);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_APB1_GRP1_DisableClock(uint32_t periphs) {
+  CLEAR_BIT(RCC->APB1ENR, periphs);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_APB1_GRP1_IsEnabledClock(uint32_t periphs) {
+  return (READ_BIT(RCC->APB1ENR, periphs) == periphs) ? 1UL : 0UL;
+}
+
+__STATIC_INLINE void LL_APB2_GRP1_EnableClock(uint32_t periphs) {
+  SET_BIT(RCC->APB2ENR, periphs);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_APB2_GRP1_DisableClock(uint32_t periphs) {
+  CLEAR_BIT(RCC->APB2ENR, periphs);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_APB2_GRP1_IsEnabledClock(uint32_t periphs) {
+  return (READ_BIT(RCC->APB2ENR, periphs) == periphs) ? 1UL : 0UL;
+}
+
+#endif  // stm32f4xx_ll_bus.h
@@ -0,0 +1,35 @@
+/**
+ * @file stm32f4xx_ll_cortex.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the LL Cortex driver, pulls in the simulated core.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_LL_CORTEX_H
+#define __STM32F4xx_LL_CORTEX_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+__STATIC_INLINE void LL_LPM_EnableSleep(void) {
+  CLEAR_BIT(SCB->SCR, SCB_SCR_SLEEPDEEP_Msk);
+}
+
+__STATIC_INLINE void LL_LPM_EnableDeepSleep(void) {
+  SET_BIT(SCB->SCR, SCB_SCR_SLEEPDEEP_Msk);
+}
+
+#endif  // stm32f4xx_ll_cortex.h
@@ -0,0 +1,176 @@
+/**
+ * @file stm32f4xx_ll_dma.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the LL DMA driver. The simulator serves the TIM1
+ * update request on DMA2 stream 5 channel 6 (the cap sampler's stream), other
+ * streams are plain registers.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_LL_DMA_H
+#define __STM32F4xx_LL_DMA_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define LL_DMA_STREAM_0 0UL
+#define LL_DMA_STREAM_1 1UL
+#define LL_DMA_STREAM_2 2UL
+#define LL_DMA_STREAM_3 3UL
+#define LL_DMA_STREAM_4 4UL
+#define LL_DMA_STREAM_5 5UL
+#define LL_DMA_STREAM_6 6UL
+#define LL_DMA_STREAM_7 7UL
+
+#define LL_DMA_CHANNEL_0 0UL
+#define LL_DMA_CHANNEL_6 (6UL << 25)
+#define LL_DMA_CHANNEL_7 (7UL << 25)
+
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY 0UL
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH (1UL << 6)
+#define LL_DMA_MODE_NORMAL 0UL
+#define LL_DMA_MODE_CIRCULAR DMA_SxCR_CIRC
+#define LL_DMA_PERIPH_NOINCREMENT 0UL
+#define LL_DMA_PERIPH_INCREMENT DMA_SxCR_PINC
+#define LL_DMA_MEMORY_NOINCREMENT 0UL
+#define LL_DMA_MEMORY_INCREMENT DMA_SxCR_MINC
+#define LL_DMA_PDATAALIGN_BYTE 0UL
+#define LL_DMA_PDATAALIGN_HALFWORD (1UL << 11)
+#define LL_DMA_PDATAALIGN_WORD (2UL << 11)
+#define LL_DMA_MDATAALIGN_BYTE 0UL
+#define LL_DMA_MDATAALIGN_HALFWORD (1UL << 13)
+#define LL_DMA_MDATAALIGN_WORD (2UL << 13)
+#define LL_DMA_PRIORITY_LOW 0UL
+#define LL_DMA_PRIORITY_VERYHIGH DMA_SxCR_PL
+
+#define SIM_DMA_STREAM(DMAx, Stream) \
+  ((DMA_Stream_TypeDef *)((uintptr_t)(DMAx) + 0x10UL + 0x18UL * (Stream)))
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Stream configuration */
+__STATIC_INLINE void LL_DMA_EnableStream(DMA_TypeDef *DMAx, uint32_t Stream) {
+  SET_BIT(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_EN);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_DMA_DisableStream(DMA_TypeDef *DMAx, uint32_t Stream) {
+  CLEAR_BIT(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_EN);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_DMA_IsEnabledStream(DMA_TypeDef *DMAx,
+                                                uint32_t Stream) {
+  return ((READ_BIT(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_EN) ==
+           (DMA_SxCR_EN))
+              ? 1UL
+              : 0UL);
+}
+
+__STATIC_INLINE void LL_DMA_ConfigTransfer(DMA_TypeDef *DMAx, uint32_t Stream,
+                                           uint32_t Configuration) {
+  MODIFY_REG(SIM_DMA_STREAM(DMAx, Stream)->CR,
+             DMA_SxCR_DIR | DMA_SxCR_CIRC | DMA_SxCR_PINC | DMA_SxCR_MINC |
+                 DMA_SxCR_PSIZE | DMA_SxCR_MSIZE | DMA_SxCR_PL,
+             Configuration);
+}
+
+__STATIC_INLINE void LL_DMA_SetChannelSelection(DMA_TypeDef *DMAx,
+                                                uint32_t Stream,
+                                                uint32_t Channel) {
+  MODIFY_REG(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_CHSEL, Channel);
+}
+
+__STATIC_INLINE void LL_DMA_SetDataLength(DMA_TypeDef *DMAx, uint32_t Stream,
+                                          uint32_t NbData) {
+  WRITE_REG(SIM_DMA_STREAM(DMAx, Stream)->NDTR, NbData & 0xFFFFUL);
+}
+
+__STATIC_INLINE uint32_t LL_DMA_GetDataLength(DMA_TypeDef *DMAx,
+                                              uint32_t Stream) {
+  sim_poll();
+  return READ_REG(SIM_DMA_STREAM(DMAx, Stream)->NDTR);
+}
+
+__STATIC_INLINE void LL_DMA_ConfigAddresses(DMA_TypeDef *DMAx, uint32_t Stream,
+                                            uint32_t SrcAddress,
+                                            uint32_t DstAddress,
+                                            uint32_t Direction) {
+  if (Direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH) {
+    WRITE_REG(SIM_DMA_STREAM(DMAx, Stream)->M0AR, SrcAddress);
+    WRITE_REG(SIM_DMA_STREAM(DMAx, Stream)->PAR, DstAddress);
+  } else {
+    WRITE_REG(SIM_DMA_STREAM(DMAx, Stream)->PAR, SrcAddress);
+    WRITE_REG(SIM_DMA_STREAM(DMAx, Stream)->M0AR, DstAddress);
+  }
+}
+
+/* Interrupts */
+__STATIC_INLINE void LL_DMA_EnableIT_TC(DMA_TypeDef *DMAx, uint32_t Stream) {
+  SET_BIT(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_TCIE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_DMA_DisableIT_TC(DMA_TypeDef *DMAx, uint32_t Stream) {
+  CLEAR_BIT(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_TCIE);
+}
+
+__STATIC_INLINE void LL_DMA_EnableIT_HT(DMA_TypeDef *DMAx, uint32_t Stream) {
+  SET_BIT(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_HTIE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_DMA_DisableIT_HT(DMA_TypeDef *DMAx, uint32_t Stream) {
+  CLEAR_BIT(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_HTIE);
+}
+
+__STATIC_INLINE void LL_DMA_EnableIT_TE(DMA_TypeDef *DMAx, uint32_t Stream) {
+  SET_BIT(SIM_DMA_STREAM(DMAx, Stream)->CR, DMA_SxCR_TEIE);
+  sim_sync();
+}
+
+/* Stream 5 flags, cleared in HISR directly as the memory-backed HIFCR has no
+   side effects */
+__STATIC_INLINE uint32_t LL_DMA_IsActiveFlag_TC5(DMA_TypeDef *DMAx) {
+  return ((READ_BIT(DMAx->HISR, DMA_HISR_TCIF5) == (DMA_HISR_TCIF5)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE uint32_t LL_DMA_IsActiveFlag_HT5(DMA_TypeDef *DMAx) {
+  return ((READ_BIT(DMAx->HISR, DMA_HISR_HTIF5) == (DMA_HISR_HTIF5)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE uint32_t LL_DMA_IsActiveFlag_TE5(DMA_TypeDef *DMAx) {
+  return ((READ_BIT(DMAx->HISR, DMA_HISR_TEIF5) == (DMA_HISR_TEIF5)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE void LL_DMA_ClearFlag_TC5(DMA_TypeDef *DMAx) {
+  CLEAR_BIT(DMAx->HISR, DMA_HISR_TCIF5);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_DMA_ClearFlag_HT5(DMA_TypeDef *DMAx) {
+  CLEAR_BIT(DMAx->HISR, DMA_HISR_HTIF5);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_DMA_ClearFlag_TE5(DMA_TypeDef *DMAx) {
+  CLEAR_BIT(DMAx->HISR, DMA_HISR_TEIF5);
+  sim_sync();
+}
+
+#endif  // stm32f4xx_ll_dma.h
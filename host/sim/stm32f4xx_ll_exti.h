@@ -0,0 +1,104 @@
+/**
+ * @file stm32f4xx_ll_exti.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the LL EXTI driver. Edges on the simulated pin
+ * levels set PR for the lines routed to the port (SYSCFG EXTICR); PR is
+ * cleared through LL_EXTI_ClearFlag_0_31(), as a plain memory write cannot
+ * model write-one-to-clear.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_LL_EXTI_H
+#define __STM32F4xx_LL_EXTI_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define LL_EXTI_LINE_0 (1UL << 0)
+#define LL_EXTI_LINE_1 (1UL << 1)
+#define LL_EXTI_LINE_2 (1UL << 2)
+#define LL_EXTI_LINE_3 (1UL << 3)
+#define LL_EXTI_LINE_4 (1UL << 4)
+#define LL_EXTI_LINE_5 (1UL << 5)
+#define LL_EXTI_LINE_6 (1UL << 6)
+#define LL_EXTI_LINE_7 (1UL << 7)
+#define LL_EXTI_LINE_8 (1UL << 8)
+#define LL_EXTI_LINE_9 (1UL << 9)
+#define LL_EXTI_LINE_10 (1UL << 10)
+#define LL_EXTI_LINE_11 (1UL << 11)
+#define LL_EXTI_LINE_12 (1UL << 12)
+#define LL_EXTI_LINE_13 (1UL << 13)
+#define LL_EXTI_LINE_14 (1UL << 14)
+#define LL_EXTI_LINE_15 (1UL << 15)
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+__STATIC_INLINE void LL_EXTI_EnableIT_0_31(uint32_t ExtiLine) {
+  SET_BIT(EXTI->IMR, ExtiLine);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_EXTI_DisableIT_0_31(uint32_t ExtiLine) {
+  CLEAR_BIT(EXTI->IMR, ExtiLine);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_EXTI_IsEnabledIT_0_31(uint32_t ExtiLine) {
+  return ((READ_BIT(EXTI->IMR, ExtiLine) == (ExtiLine)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE void LL_EXTI_EnableEvent_0_31(uint32_t ExtiLine) {
+  SET_BIT(EXTI->EMR, ExtiLine);
+}
+
+__STATIC_INLINE void LL_EXTI_DisableEvent_0_31(uint32_t ExtiLine) {
+  CLEAR_BIT(EXTI->EMR, ExtiLine);
+}
+
+__STATIC_INLINE void LL_EXTI_EnableRisingTrig_0_31(uint32_t ExtiLine) {
+  SET_BIT(EXTI->RTSR, ExtiLine);
+}
+
+__STATIC_INLINE void LL_EXTI_DisableRisingTrig_0_31(uint32_t ExtiLine) {
+  CLEAR_BIT(EXTI->RTSR, ExtiLine);
+}
+
+__STATIC_INLINE void LL_EXTI_EnableFallingTrig_0_31(uint32_t ExtiLine) {
+  SET_BIT(EXTI->FTSR, ExtiLine);
+}
+
+__STATIC_INLINE void LL_EXTI_DisableFallingTrig_0_31(uint32_t ExtiLine) {
+  CLEAR_BIT(EXTI->FTSR, ExtiLine);
+}
+
+__STATIC_INLINE void LL_EXTI_GenerateSWI_0_31(uint32_t ExtiLine) {
+  SET_BIT(EXTI->SWIER, ExtiLine);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_EXTI_IsActiveFlag_0_31(uint32_t ExtiLine) {
+  sim_poll();
+  return ((READ_BIT(EXTI->PR, ExtiLine) == (ExtiLine)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE void LL_EXTI_ClearFlag_0_31(uint32_t ExtiLine) {
+  CLEAR_BIT(EXTI->PR, ExtiLine);
+  sim_sync();
+}
+
+#endif  // stm32f4xx_ll_exti.h
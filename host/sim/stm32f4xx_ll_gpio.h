@@ -0,0 +1,158 @@
+/**
+ * @file stm32f4xx_ll_gpio.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the LL GPIO driver. The accessors are the LL ones
+ * on the simulated register block, followed by a simulator sync so BSRR is
+ * applied, IDR follows the pin levels and writes to a gated port are caught.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_LL_GPIO_H
+#define __STM32F4xx_LL_GPIO_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define LL_GPIO_PIN_0 (1UL << 0)
+#define LL_GPIO_PIN_1 (1UL << 1)
+#define LL_GPIO_PIN_2 (1UL << 2)
+#define LL_GPIO_PIN_3 (1UL << 3)
+#define LL_GPIO_PIN_4 (1UL << 4)
+#define LL_GPIO_PIN_5 (1UL << 5)
+#define LL_GPIO_PIN_6 (1UL << 6)
+#define LL_GPIO_PIN_7 (1UL << 7)
+#define LL_GPIO_PIN_8 (1UL << 8)
+#define LL_GPIO_PIN_9 (1UL << 9)
+#define LL_GPIO_PIN_10 (1UL << 10)
+#define LL_GPIO_PIN_11 (1UL << 11)
+#define LL_GPIO_PIN_12 (1UL << 12)
+#define LL_GPIO_PIN_13 (1UL << 13)
+#define LL_GPIO_PIN_14 (1UL << 14)
+#define LL_GPIO_PIN_15 (1UL << 15)
+#define LL_GPIO_PIN_ALL 0xFFFFUL
+
+#define LL_GPIO_MODE_INPUT 0UL
+#define LL_GPIO_MODE_OUTPUT 1UL
+#define LL_GPIO_MODE_ALTERNATE 2UL
+#define LL_GPIO_MODE_ANALOG 3UL
+
+#define LL_GPIO_OUTPUT_PUSHPULL 0UL
+#define LL_GPIO_OUTPUT_OPENDRAIN GPIO_OTYPER_OT_0
+
+#define LL_GPIO_SPEED_FREQ_LOW 0UL
+#define LL_GPIO_SPEED_FREQ_MEDIUM 1UL
+#define LL_GPIO_SPEED_FREQ_HIGH 2UL
+#define LL_GPIO_SPEED_FREQ_VERY_HIGH 3UL
+
+#define LL_GPIO_PULL_NO 0UL
+#define LL_GPIO_PULL_UP 1UL
+#define LL_GPIO_PULL_DOWN 2UL
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+__STATIC_INLINE void LL_GPIO_SetPinMode(GPIO_TypeDef *GPIOx, uint32_t Pin,
+                                        uint32_t Mode) {
+  MODIFY_REG(GPIOx->MODER, (GPIO_MODER_MODER0 << (POSITION_VAL(Pin) * 2U)),
+             (Mode << (POSITION_VAL(Pin) * 2U)));
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_GPIO_GetPinMode(GPIO_TypeDef *GPIOx, uint32_t Pin) {
+  return (READ_BIT(GPIOx->MODER,
+                   (GPIO_MODER_MODER0 << (POSITION_VAL(Pin) * 2U))) >>
+          (POSITION_VAL(Pin) * 2U));
+}
+
+__STATIC_INLINE void LL_GPIO_SetPinOutputType(GPIO_TypeDef *GPIOx,
+                                              uint32_t PinMask,
+                                              uint32_t OutputType) {
+  MODIFY_REG(GPIOx->OTYPER, PinMask, (PinMask * OutputType));
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_GPIO_SetPinSpeed(GPIO_TypeDef *GPIOx, uint32_t Pin,
+                                         uint32_t Speed) {
+  MODIFY_REG(GPIOx->OSPEEDR,
+             (GPIO_OSPEEDER_OSPEEDR0 << (POSITION_VAL(Pin) * 2U)),
+             (Speed << (POSITION_VAL(Pin) * 2U)));
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_GPIO_SetPinPull(GPIO_TypeDef *GPIOx, uint32_t Pin,
+                                        uint32_t Pull) {
+  MODIFY_REG(GPIOx->PUPDR, (GPIO_PUPDR_PUPDR0 << (POSITION_VAL(Pin) * 2U)),
+             (Pull << (POSITION_VAL(Pin) * 2U)));
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_GPIO_GetPinPull(GPIO_TypeDef *GPIOx, uint32_t Pin) {
+  return (READ_BIT(GPIOx->PUPDR,
+                   (GPIO_PUPDR_PUPDR0 << (POSITION_VAL(Pin) * 2U))) >>
+          (POSITION_VAL(Pin) * 2U));
+}
+
+__STATIC_INLINE uint32_t LL_GPIO_ReadInputPort(GPIO_TypeDef *GPIOx) {
+  sim_sync();
+  return (uint32_t)(READ_REG(GPIOx->IDR));
+}
+
+__STATIC_INLINE uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef *GPIOx,
+                                               uint32_t PinMask) {
+  sim_sync();
+  return ((READ_BIT(GPIOx->IDR, PinMask) == (PinMask)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE void LL_GPIO_WriteOutputPort(GPIO_TypeDef *GPIOx,
+                                             uint32_t PortValue) {
+  WRITE_REG(GPIOx->ODR, PortValue);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_GPIO_ReadOutputPort(GPIO_TypeDef *GPIOx) {
+  sim_sync();
+  return (uint32_t)(READ_REG(GPIOx->ODR));
+}
+
+__STATIC_INLINE uint32_t LL_GPIO_IsOutputPinSet(GPIO_TypeDef *GPIOx,
+                                                uint32_t PinMask) {
+  sim_sync();
+  return ((READ_BIT(GPIOx->ODR, PinMask) == (PinMask)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE void LL_GPIO_SetOutputPin(GPIO_TypeDef *GPIOx,
+                                          uint32_t PinMask) {
+  sim_sync();
+  WRITE_REG(GPIOx->BSRR, PinMask);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_GPIO_ResetOutputPin(GPIO_TypeDef *GPIOx,
+                                            uint32_t PinMask) {
+  sim_sync();
+  WRITE_REG(GPIOx->BSRR, (PinMask << 16));
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint32_t PinMask) {
+  sim_sync();
+  uint32_t odr = READ_REG(GPIOx->ODR);
+  WRITE_REG(GPIOx->BSRR, ((odr & PinMask) << 16u) | (~odr & PinMask));
+  sim_sync();
+}
+
+#endif  // stm32f4xx_ll_gpio.h
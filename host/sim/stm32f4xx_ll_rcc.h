@@ -0,0 +1,48 @@
+/**
+ * @file stm32f4xx_ll_rcc.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the LL RCC driver. The simulated clock tree is the
+ * usual 84 MHz STM32F401 setup: HCLK = SYSCLK, APB1 at HCLK / 2, APB2 at
+ * HCLK, so the timer kernels run at HCLK on both buses.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_LL_RCC_H
+#define __STM32F4xx_LL_RCC_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  uint32_t SYSCLK_Frequency;
+  uint32_t HCLK_Frequency;
+  uint32_t PCLK1_Frequency;
+  uint32_t PCLK2_Frequency;
+
+} LL_RCC_ClocksTypeDef;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+__STATIC_INLINE void LL_RCC_GetSystemClocksFreq(LL_RCC_ClocksTypeDef *clocks) {
+  clocks->SYSCLK_Frequency = SystemCoreClock;
+  clocks->HCLK_Frequency = SystemCoreClock;
+  clocks->PCLK1_Frequency = SystemCoreClock / SIM_APB1_DIV;
+  clocks->PCLK2_Frequency = SystemCoreClock;
+}
+
+#endif  // stm32f4xx_ll_rcc.h
@@ -0,0 +1,267 @@
+/**
+ * @file stm32f4xx_ll_tim.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the LL TIM driver. Register writes are the LL ones
+ * on the simulated block followed by a simulator sync, which applies UG,
+ * counter enables and TRGO; flag and counter reads from thread mode cost a
+ * few virtual cycles so polling loops see time pass.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_LL_TIM_H
+#define __STM32F4xx_LL_TIM_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define LL_TIM_COUNTERDIRECTION_UP 0UL
+#define LL_TIM_COUNTERDIRECTION_DOWN TIM_CR1_DIR
+
+#define LL_TIM_UPDATESOURCE_REGULAR 0UL
+#define LL_TIM_UPDATESOURCE_COUNTER TIM_CR1_URS
+
+#define LL_TIM_CLOCKSOURCE_INTERNAL 0UL
+#define LL_TIM_CLOCKSOURCE_EXT_MODE1 (7UL << 0)
+#define LL_TIM_CLOCKSOURCE_EXT_MODE2 TIM_SMCR_ECE
+
+#define LL_TIM_ENCODERMODE_X2_TI1 (1UL << 0)
+#define LL_TIM_ENCODERMODE_X2_TI2 (2UL << 0)
+#define LL_TIM_ENCODERMODE_X4_TI12 (3UL << 0)
+
+#define LL_TIM_TRGO_RESET 0UL
+#define LL_TIM_TRGO_ENABLE (1UL << 4)
+#define LL_TIM_TRGO_UPDATE (2UL << 4)
+
+#define LL_TIM_SLAVEMODE_DISABLED 0UL
+#define LL_TIM_SLAVEMODE_RESET (4UL << 0)
+#define LL_TIM_SLAVEMODE_GATED (5UL << 0)
+#define LL_TIM_SLAVEMODE_TRIGGER (6UL << 0)
+
+#define LL_TIM_TS_ITR0 0UL
+#define LL_TIM_TS_ITR1 (1UL << 4)
+#define LL_TIM_TS_ITR2 (2UL << 4)
+#define LL_TIM_TS_ITR3 (3UL << 4)
+
+#define LL_TIM_CHANNEL_CH1 TIM_CCER_CC1E
+#define LL_TIM_CHANNEL_CH1N (1UL << 2)
+#define LL_TIM_CHANNEL_CH2 (1UL << 4)
+#define LL_TIM_CHANNEL_CH2N (1UL << 6)
+#define LL_TIM_CHANNEL_CH3 (1UL << 8)
+#define LL_TIM_CHANNEL_CH3N (1UL << 10)
+#define LL_TIM_CHANNEL_CH4 (1UL << 12)
+
+#define LL_TIM_ACTIVEINPUT_DIRECTTI (1UL << 16)
+#define LL_TIM_ACTIVEINPUT_INDIRECTTI (2UL << 16)
+
+#define LL_TIM_IC_FILTER_FDIV1 0UL
+#define LL_TIM_IC_FILTER_FDIV1_N2 (1UL << 20)
+
+#define LL_TIM_IC_POLARITY_RISING 0UL
+#define LL_TIM_IC_POLARITY_FALLING TIM_CCER_CC1P
+#define LL_TIM_IC_POLARITY_BOTHEDGE (TIM_CCER_CC1P | TIM_CCER_CC1NP)
+
+/* Channel register maps, as in the LL driver */
+#define SIM_TIM_CH_IDX(Channel)                        \
+  (((Channel) == LL_TIM_CHANNEL_CH1)    ? 0U           \
+   : ((Channel) == LL_TIM_CHANNEL_CH1N) ? 1U           \
+   : ((Channel) == LL_TIM_CHANNEL_CH2)  ? 2U           \
+   : ((Channel) == LL_TIM_CHANNEL_CH2N) ? 3U           \
+   : ((Channel) == LL_TIM_CHANNEL_CH3)  ? 4U           \
+   : ((Channel) == LL_TIM_CHANNEL_CH3N) ? 5U           \
+                                        : 6U)
+#define SIM_TIM_CCMR(TIMx, iChannel) \
+  (((iChannel) < 4U) ? &(TIMx)->CCMR1 : &(TIMx)->CCMR2)
+#define SIM_TIM_CCMR_SHIFT(iChannel) \
+  ((((iChannel) == 2U) || ((iChannel) == 6U)) ? 8U : 0U)
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Time base */
+__STATIC_INLINE void LL_TIM_EnableCounter(TIM_TypeDef *TIMx) {
+  SET_BIT(TIMx->CR1, TIM_CR1_CEN);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_TIM_DisableCounter(TIM_TypeDef *TIMx) {
+  CLEAR_BIT(TIMx->CR1, TIM_CR1_CEN);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_TIM_IsEnabledCounter(TIM_TypeDef *TIMx) {
+  return ((READ_BIT(TIMx->CR1, TIM_CR1_CEN) == (TIM_CR1_CEN)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE void LL_TIM_SetUpdateSource(TIM_TypeDef *TIMx,
+                                            uint32_t UpdateSource) {
+  MODIFY_REG(TIMx->CR1, TIM_CR1_URS, UpdateSource);
+}
+
+__STATIC_INLINE uint32_t LL_TIM_GetUpdateSource(TIM_TypeDef *TIMx) {
+  return (uint32_t)(READ_BIT(TIMx->CR1, TIM_CR1_URS));
+}
+
+__STATIC_INLINE void LL_TIM_SetCounterMode(TIM_TypeDef *TIMx,
+                                           uint32_t CounterMode) {
+  MODIFY_REG(TIMx->CR1, TIM_CR1_DIR, CounterMode);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_TIM_GetDirection(TIM_TypeDef *TIMx) {
+  sim_poll();
+  return (uint32_t)(READ_BIT(TIMx->CR1, TIM_CR1_DIR));
+}
+
+__STATIC_INLINE void LL_TIM_SetCounter(TIM_TypeDef *TIMx, uint32_t Counter) {
+  WRITE_REG(TIMx->CNT, Counter);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_TIM_GetCounter(TIM_TypeDef *TIMx) {
+  sim_poll();
+  return (uint32_t)(READ_REG(TIMx->CNT));
+}
+
+__STATIC_INLINE void LL_TIM_SetPrescaler(TIM_TypeDef *TIMx, uint32_t Prescaler) {
+  WRITE_REG(TIMx->PSC, Prescaler);
+}
+
+__STATIC_INLINE uint32_t LL_TIM_GetPrescaler(TIM_TypeDef *TIMx) {
+  return (uint32_t)(READ_REG(TIMx->PSC));
+}
+
+__STATIC_INLINE void LL_TIM_SetAutoReload(TIM_TypeDef *TIMx,
+                                          uint32_t AutoReload) {
+  WRITE_REG(TIMx->ARR, AutoReload);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_TIM_GetAutoReload(TIM_TypeDef *TIMx) {
+  return (uint32_t)(READ_REG(TIMx->ARR));
+}
+
+/* Clock and slave mode */
+__STATIC_INLINE void LL_TIM_SetClockSource(TIM_TypeDef *TIMx,
+                                           uint32_t ClockSource) {
+  MODIFY_REG(TIMx->SMCR, TIM_SMCR_SMS | TIM_SMCR_ECE, ClockSource);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_TIM_SetEncoderMode(TIM_TypeDef *TIMx,
+                                           uint32_t EncoderMode) {
+  MODIFY_REG(TIMx->SMCR, TIM_SMCR_SMS, EncoderMode);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_TIM_SetTriggerOutput(TIM_TypeDef *TIMx,
+                                             uint32_t TimerSynchronization) {
+  MODIFY_REG(TIMx->CR2, TIM_CR2_MMS, TimerSynchronization);
+}
+
+__STATIC_INLINE void LL_TIM_SetSlaveMode(TIM_TypeDef *TIMx, uint32_t SlaveMode) {
+  MODIFY_REG(TIMx->SMCR, TIM_SMCR_SMS, SlaveMode);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_TIM_SetTriggerInput(TIM_TypeDef *TIMx,
+                                            uint32_t TriggerInput) {
+  MODIFY_REG(TIMx->SMCR, TIM_SMCR_TS, TriggerInput);
+}
+
+__STATIC_INLINE void LL_TIM_EnableMasterSlaveMode(TIM_TypeDef *TIMx) {
+  SET_BIT(TIMx->SMCR, TIM_SMCR_MSM);
+}
+
+__STATIC_INLINE void LL_TIM_DisableMasterSlaveMode(TIM_TypeDef *TIMx) {
+  CLEAR_BIT(TIMx->SMCR, TIM_SMCR_MSM);
+}
+
+/* Input capture */
+__STATIC_INLINE void LL_TIM_IC_SetActiveInput(TIM_TypeDef *TIMx,
+                                              uint32_t Channel,
+                                              uint32_t ICActiveInput) {
+  uint32_t iChannel = SIM_TIM_CH_IDX(Channel);
+  __IO uint32_t *pReg = SIM_TIM_CCMR(TIMx, iChannel);
+  MODIFY_REG(*pReg, (TIM_CCMR1_CC1S << SIM_TIM_CCMR_SHIFT(iChannel)),
+             (ICActiveInput >> 16U) << SIM_TIM_CCMR_SHIFT(iChannel));
+}
+
+__STATIC_INLINE void LL_TIM_IC_SetFilter(TIM_TypeDef *TIMx, uint32_t Channel,
+                                         uint32_t ICFilter) {
+  uint32_t iChannel = SIM_TIM_CH_IDX(Channel);
+  __IO uint32_t *pReg = SIM_TIM_CCMR(TIMx, iChannel);
+  MODIFY_REG(*pReg, (TIM_CCMR1_IC1F << SIM_TIM_CCMR_SHIFT(iChannel)),
+             (ICFilter >> 16U) << SIM_TIM_CCMR_SHIFT(iChannel));
+}
+
+__STATIC_INLINE void LL_TIM_IC_SetPolarity(TIM_TypeDef *TIMx, uint32_t Channel,
+                                           uint32_t ICPolarity) {
+  uint32_t ccpShift = SIM_TIM_CH_IDX(Channel) * 2U;
+  MODIFY_REG(TIMx->CCER, ((TIM_CCER_CC1NP | TIM_CCER_CC1P) << ccpShift),
+             (ICPolarity << ccpShift));
+}
+
+__STATIC_INLINE void LL_TIM_CC_EnableChannel(TIM_TypeDef *TIMx,
+                                             uint32_t Channels) {
+  SET_BIT(TIMx->CCER, Channels);
+}
+
+__STATIC_INLINE void LL_TIM_CC_DisableChannel(TIM_TypeDef *TIMx,
+                                              uint32_t Channels) {
+  CLEAR_BIT(TIMx->CCER, Channels);
+}
+
+/* Interrupts, DMA and events */
+__STATIC_INLINE void LL_TIM_EnableIT_UPDATE(TIM_TypeDef *TIMx) {
+  SET_BIT(TIMx->DIER, TIM_DIER_UIE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_TIM_DisableIT_UPDATE(TIM_TypeDef *TIMx) {
+  CLEAR_BIT(TIMx->DIER, TIM_DIER_UIE);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_TIM_IsEnabledIT_UPDATE(TIM_TypeDef *TIMx) {
+  return ((READ_BIT(TIMx->DIER, TIM_DIER_UIE) == (TIM_DIER_UIE)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE void LL_TIM_EnableDMAReq_UPDATE(TIM_TypeDef *TIMx) {
+  SET_BIT(TIMx->DIER, TIM_DIER_UDE);
+}
+
+__STATIC_INLINE void LL_TIM_DisableDMAReq_UPDATE(TIM_TypeDef *TIMx) {
+  CLEAR_BIT(TIMx->DIER, TIM_DIER_UDE);
+}
+
+__STATIC_INLINE uint32_t LL_TIM_IsActiveFlag_UPDATE(TIM_TypeDef *TIMx) {
+  sim_poll();
+  return ((READ_BIT(TIMx->SR, TIM_SR_UIF) == (TIM_SR_UIF)) ? 1UL : 0UL);
+}
+
+__STATIC_INLINE void LL_TIM_ClearFlag_UPDATE(TIM_TypeDef *TIMx) {
+  // rc_w0, writing ~UIF to the memory-backed SR would set the other flags
+  CLEAR_BIT(TIMx->SR, TIM_SR_UIF);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_TIM_GenerateEvent_UPDATE(TIM_TypeDef *TIMx) {
+  SET_BIT(TIMx->EGR, TIM_EGR_UG);
+  sim_sync();
+}
+
+#endif  // stm32f4xx_ll_tim.h
@@ -0,0 +1,222 @@
+/**
+ * @file stm32f4xx_ll_usart.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host stand-in for the LL USART driver. DR accesses go through the
+ * simulator, which models the TDR and shift register, the RXNE/ORE receive
+ * path and RTS/CTS, so they keep the hardware's side effects.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef __STM32F4xx_LL_USART_H
+#define __STM32F4xx_LL_USART_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <sim.h>
+#include <stm32f4xx.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define LL_USART_SR_PE USART_SR_PE
+#define LL_USART_SR_FE USART_SR_FE
+#define LL_USART_SR_NE USART_SR_NE
+#define LL_USART_SR_ORE USART_SR_ORE
+#define LL_USART_SR_IDLE USART_SR_IDLE
+#define LL_USART_SR_RXNE USART_SR_RXNE
+#define LL_USART_SR_TC USART_SR_TC
+#define LL_USART_SR_TXE USART_SR_TXE
+
+#define LL_USART_CR1_RXNEIE USART_CR1_RXNEIE
+#define LL_USART_CR1_TCIE USART_CR1_TCIE
+#define LL_USART_CR1_TXEIE USART_CR1_TXEIE
+
+#define LL_USART_DIRECTION_NONE 0UL
+#define LL_USART_DIRECTION_RX USART_CR1_RE
+#define LL_USART_DIRECTION_TX USART_CR1_TE
+#define LL_USART_DIRECTION_TX_RX (USART_CR1_TE | USART_CR1_RE)
+
+#define LL_USART_PARITY_NONE 0UL
+#define LL_USART_PARITY_EVEN USART_CR1_PCE
+#define LL_USART_PARITY_ODD (USART_CR1_PCE | USART_CR1_PS)
+
+#define LL_USART_DATAWIDTH_8B 0UL
+#define LL_USART_DATAWIDTH_9B USART_CR1_M
+
+#define LL_USART_OVERSAMPLING_16 0UL
+#define LL_USART_OVERSAMPLING_8 USART_CR1_OVER8
+
+#define LL_USART_STOPBITS_0_5 (1UL << 12)
+#define LL_USART_STOPBITS_1 0UL
+#define LL_USART_STOPBITS_1_5 (3UL << 12)
+#define LL_USART_STOPBITS_2 (2UL << 12)
+
+#define LL_USART_HWCONTROL_NONE 0UL
+#define LL_USART_HWCONTROL_RTS USART_CR3_RTSE
+#define LL_USART_HWCONTROL_CTS USART_CR3_CTSE
+#define LL_USART_HWCONTROL_RTS_CTS (USART_CR3_RTSE | USART_CR3_CTSE)
+
+#define LL_USART_WriteReg(__INSTANCE__, __REG__, __VALUE__) \
+  do {                                                      \
+    WRITE_REG((__INSTANCE__)->__REG__, (__VALUE__));        \
+    sim_sync();                                             \
+  } while (0)
+#define LL_USART_ReadReg(__INSTANCE__, __REG__) READ_REG((__INSTANCE__)->__REG__)
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Configuration */
+__STATIC_INLINE void LL_USART_Enable(USART_TypeDef *USARTx) {
+  SET_BIT(USARTx->CR1, USART_CR1_UE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_USART_Disable(USART_TypeDef *USARTx) {
+  CLEAR_BIT(USARTx->CR1, USART_CR1_UE);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_USART_IsEnabled(USART_TypeDef *USARTx) {
+  return (READ_BIT(USARTx->CR1, USART_CR1_UE) == (USART_CR1_UE));
+}
+
+__STATIC_INLINE void LL_USART_EnableDirectionRx(USART_TypeDef *USARTx) {
+  SET_BIT(USARTx->CR1, USART_CR1_RE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_USART_DisableDirectionRx(USART_TypeDef *USARTx) {
+  CLEAR_BIT(USARTx->CR1, USART_CR1_RE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_USART_SetTransferDirection(USART_TypeDef *USARTx,
+                                                   uint32_t TransferDirection) {
+  MODIFY_REG(USARTx->CR1, USART_CR1_RE | USART_CR1_TE, TransferDirection);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_USART_SetParity(USART_TypeDef *USARTx, uint32_t Parity) {
+  MODIFY_REG(USARTx->CR1, USART_CR1_PS | USART_CR1_PCE, Parity);
+}
+
+__STATIC_INLINE void LL_USART_SetDataWidth(USART_TypeDef *USARTx,
+                                           uint32_t DataWidth) {
+  MODIFY_REG(USARTx->CR1, USART_CR1_M, DataWidth);
+}
+
+__STATIC_INLINE void LL_USART_SetOverSampling(USART_TypeDef *USARTx,
+                                              uint32_t OverSampling) {
+  MODIFY_REG(USARTx->CR1, USART_CR1_OVER8, OverSampling);
+}
+
+__STATIC_INLINE uint32_t LL_USART_GetOverSampling(USART_TypeDef *USARTx) {
+  return READ_BIT(USARTx->CR1, USART_CR1_OVER8);
+}
+
+__STATIC_INLINE void LL_USART_SetStopBitsLength(USART_TypeDef *USARTx,
+                                                uint32_t StopBits) {
+  MODIFY_REG(USARTx->CR2, USART_CR2_STOP, StopBits);
+}
+
+__STATIC_INLINE void LL_USART_SetHWFlowCtrl(USART_TypeDef *USARTx,
+                                            uint32_t HardwareFlowControl) {
+  MODIFY_REG(USARTx->CR3, USART_CR3_RTSE | USART_CR3_CTSE,
+             HardwareFlowControl);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_USART_EnableHalfDuplex(USART_TypeDef *USARTx) {
+  SET_BIT(USARTx->CR3, USART_CR3_HDSEL);
+}
+
+__STATIC_INLINE void LL_USART_DisableHalfDuplex(USART_TypeDef *USARTx) {
+  CLEAR_BIT(USARTx->CR3, USART_CR3_HDSEL);
+}
+
+/* Data */
+__STATIC_INLINE uint8_t LL_USART_ReceiveData8(USART_TypeDef *USARTx) {
+  return sim_usart_read_dr(USARTx);
+}
+
+__STATIC_INLINE void LL_USART_TransmitData8(USART_TypeDef *USARTx,
+                                            uint8_t Value) {
+  sim_usart_write_dr(USARTx, Value);
+}
+
+/* Flags */
+__STATIC_INLINE uint32_t LL_USART_IsActiveFlag_RXNE(USART_TypeDef *USARTx) {
+  sim_poll();
+  return (READ_BIT(USARTx->SR, USART_SR_RXNE) == (USART_SR_RXNE));
+}
+
+__STATIC_INLINE uint32_t LL_USART_IsActiveFlag_TC(USART_TypeDef *USARTx) {
+  sim_poll();
+  return (READ_BIT(USARTx->SR, USART_SR_TC) == (USART_SR_TC));
+}
+
+__STATIC_INLINE uint32_t LL_USART_IsActiveFlag_TXE(USART_TypeDef *USARTx) {
+  sim_poll();
+  return (READ_BIT(USARTx->SR, USART_SR_TXE) == (USART_SR_TXE));
+}
+
+__STATIC_INLINE void LL_USART_ClearFlag_TC(USART_TypeDef *USARTx) {
+  // rc_w0, writing ~TC to the memory-backed SR would set the other flags
+  CLEAR_BIT(USARTx->SR, USART_SR_TC);
+  sim_sync();
+}
+
+/* Interrupts */
+__STATIC_INLINE void LL_USART_EnableIT_RXNE(USART_TypeDef *USARTx) {
+  SET_BIT(USARTx->CR1, USART_CR1_RXNEIE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_USART_DisableIT_RXNE(USART_TypeDef *USARTx) {
+  CLEAR_BIT(USARTx->CR1, USART_CR1_RXNEIE);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_USART_IsEnabledIT_RXNE(USART_TypeDef *USARTx) {
+  return (READ_BIT(USARTx->CR1, USART_CR1_RXNEIE) == (USART_CR1_RXNEIE));
+}
+
+__STATIC_INLINE void LL_USART_EnableIT_TXE(USART_TypeDef *USARTx) {
+  SET_BIT(USARTx->CR1, USART_CR1_TXEIE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_USART_DisableIT_TXE(USART_TypeDef *USARTx) {
+  CLEAR_BIT(USARTx->CR1, USART_CR1_TXEIE);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_USART_IsEnabledIT_TXE(USART_TypeDef *USARTx) {
+  return (READ_BIT(USARTx->CR1, USART_CR1_TXEIE) == (USART_CR1_TXEIE));
+}
+
+__STATIC_INLINE void LL_USART_EnableIT_TC(USART_TypeDef *USARTx) {
+  SET_BIT(USARTx->CR1, USART_CR1_TCIE);
+  sim_sync();
+}
+
+__STATIC_INLINE void LL_USART_DisableIT_TC(USART_TypeDef *USARTx) {
+  CLEAR_BIT(USARTx->CR1, USART_CR1_TCIE);
+  sim_sync();
+}
+
+__STATIC_INLINE uint32_t LL_USART_IsEnabledIT_TC(USART_TypeDef *USARTx) {
+  return (READ_BIT(USARTx->CR1, USART_CR1_TCIE) == (USART_CR1_TCIE));
+}
+
+#endif  // stm32f4xx_ll_usart.h
@@ -0,0 +1,207 @@
+/**
+ * @file bench_gpio_snapshot.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Change detection over 16 inputs on three ports: io_snapshot() and
+ * io_changed() against polling every input with io_get_val() and comparing
+ * it with its previous value. Both find the same changes. Prints the host
+ * time of a full scan as CSV, and the IDR reads each scan makes.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <time.h>
+
+/* Module includes */
+#include <gpio.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_NUM_INPUTS 16U
+#define BENCH_NUM_PORTS 3U
+
+// Scans per measurement
+#define BENCH_PASSES 50000U
+
+// Input changes checked before timing
+#define BENCH_CHG_STEPS 64U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const io_in_handler_t benchInputs[BENCH_NUM_INPUTS] = {
+    {IO_PORT_A, IO_PIN_00, IO_PULL_UP, IO_INVERT_DISABLE},
+    {IO_PORT_A, IO_PIN_01, IO_PULL_UP, IO_INVERT_ENABLE},
+    {IO_PORT_A, IO_PIN_04, IO_PULL_DWN, IO_INVERT_DISABLE},
+    {IO_PORT_A, IO_PIN_05, IO_PULL_DWN, IO_INVERT_DISABLE},
+    {IO_PORT_A, IO_PIN_08, IO_PULL_UP, IO_INVERT_ENABLE},
+    {IO_PORT_A, IO_PIN_10, IO_PULL_NO, IO_INVERT_DISABLE},
+    {IO_PORT_B, IO_PIN_00, IO_PULL_UP, IO_INVERT_DISABLE},
+    {IO_PORT_B, IO_PIN_01, IO_PULL_UP, IO_INVERT_DISABLE},
+    {IO_PORT_B, IO_PIN_02, IO_PULL_DWN, IO_INVERT_ENABLE},
+    {IO_PORT_B, IO_PIN_12, IO_PULL_DWN, IO_INVERT_DISABLE},
+    {IO_PORT_B, IO_PIN_13, IO_PULL_UP, IO_INVERT_DISABLE},
+    {IO_PORT_C, IO_PIN_06, IO_PULL_UP, IO_INVERT_DISABLE},
+    {IO_PORT_C, IO_PIN_07, IO_PULL_UP, IO_INVERT_ENABLE},
+    {IO_PORT_C, IO_PIN_08, IO_PULL_DWN, IO_INVERT_DISABLE},
+    {IO_PORT_C, IO_PIN_09, IO_PULL_DWN, IO_INVERT_DISABLE},
+    {IO_PORT_C, IO_PIN_13, IO_PULL_UP, IO_INVERT_DISABLE},
+};
+
+static io_confg_handler_t benchConfg = {BENCH_NUM_INPUTS, benchInputs, 0U,
+                                        NULL};
+
+static GPIO_TypeDef *const benchPorts[BENCH_NUM_PORTS] = {GPIOA, GPIOB,
+                                                          GPIOC};
+
+// Previous values of the per-index poll
+static uint32_t benchPrevVal[BENCH_NUM_INPUTS];
+static uint32_t benchPrevSnap;
+
+static volatile uint32_t benchSink;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t bench_ns(void) {
+  struct timespec benchTs;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &benchTs);
+  return (uint64_t)benchTs.tv_sec * 1000000000U + (uint64_t)benchTs.tv_nsec;
+}
+
+static void bench_report(const char *benchOp, uint64_t benchCalls,
+                         uint64_t benchNs) {
+  printf("%s,%llu,%llu.%02llu\n", benchOp, (unsigned long long)benchCalls,
+         (unsigned long long)(benchNs / benchCalls),
+         (unsigned long long)((benchNs * 100U / benchCalls) % 100U));
+}
+
+/**
+ * @brief: One scan the way the callers did it, every input read on its own
+ *
+ * @return[out]: uint32_t. Bitmap of the inputs that changed
+ **/
+static uint32_t bench_scan_poll(void) {
+  uint32_t ioChg = 0U;
+
+  for (uint32_t ioInIdx = 0U; ioInIdx < BENCH_NUM_INPUTS; ioInIdx++) {
+    uint32_t ioVal = io_get_val(ioInIdx);
+
+    if (ioVal != benchPrevVal[ioInIdx]) {
+      benchPrevVal[ioInIdx] = ioVal;
+      ioChg |= 1U << ioInIdx;
+    }
+  }
+  return ioChg;
+}
+
+/**
+ * @brief: One scan through a snapshot, visiting only the changed inputs
+ *
+ * @return[out]: uint32_t. Bitmap of the inputs that changed
+ **/
+static uint32_t bench_scan_snap(void) {
+  uint32_t ioSnap = io_snapshot();
+  uint32_t ioChg = io_changed(benchPrevSnap, ioSnap);
+  uint32_t ioVisit = ioChg;
+
+  benchPrevSnap = ioSnap;
+  while (ioVisit) {
+    benchSink += io_next_changed(&ioVisit);
+  }
+  return ioChg;
+}
+
+static uint32_t bench_idr_reads(void) {
+  uint32_t numReads = 0U;
+
+  for (uint32_t portIdx = 0U; portIdx < BENCH_NUM_PORTS; portIdx++) {
+    numReads += sim_reg_reads(&benchPorts[portIdx]->IDR);
+  }
+  return numReads;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  uint64_t benchStart = 0U;
+  uint32_t passIdx = 0U;
+  uint32_t numChg = 0U;
+
+  HOST_CHECK_EQ(io_init(&benchConfg), EXIT_SUCCESS);
+
+  // Both scans see the same changes while the inputs are driven
+  for (uint32_t ioInIdx = 0U; ioInIdx < BENCH_NUM_INPUTS; ioInIdx++) {
+    benchPrevVal[ioInIdx] = io_get_val(ioInIdx);
+  }
+  benchPrevSnap = io_snapshot();
+  for (passIdx = 0U; passIdx < BENCH_CHG_STEPS; passIdx++) {
+    const io_in_handler_t *drvIn = &benchInputs[(passIdx * 5U) %
+                                                BENCH_NUM_INPUTS];
+
+    // Flipping one input per step
+    sim_gpio_drive(drvIn->portx, drvIn->ioPinNo,
+                   !LL_GPIO_IsInputPinSet(drvIn->portx, drvIn->ioPinNo));
+    uint32_t ioChg = bench_scan_snap();
+    HOST_CHECK_EQ(ioChg, bench_scan_poll());
+    numChg += (uint32_t)__builtin_popcount(ioChg);
+  }
+  HOST_CHECK_EQ(numChg, BENCH_CHG_STEPS);
+
+  // IDR reads of one scan: one per port against one per input
+  sim_reg_clear_counts();
+  (void)bench_scan_snap();
+  uint32_t snapReads = bench_idr_reads();
+  sim_reg_clear_counts();
+  (void)bench_scan_poll();
+  uint32_t pollReads = bench_idr_reads();
+  HOST_CHECK_EQ(snapReads, BENCH_NUM_PORTS);
+  HOST_CHECK_EQ(pollReads, BENCH_NUM_INPUTS);
+
+  printf("# bench gpio, %u inputs on %u ports, IDR reads %u snapshot, "
+         "%u poll\n",
+         BENCH_NUM_INPUTS, BENCH_NUM_PORTS, snapReads, pollReads);
+  printf("op,calls,ns_per_call\n");
+
+  // Steady inputs, the usual case: nothing to report
+  benchStart = bench_ns();
+  for (passIdx = 0U; passIdx < BENCH_PASSES; passIdx++) {
+    benchSink += bench_scan_poll();
+  }
+  uint64_t pollNs = bench_ns() - benchStart;
+  bench_report("poll_get_val", BENCH_PASSES, pollNs);
+
+  benchStart = bench_ns();
+  for (passIdx = 0U; passIdx < BENCH_PASSES; passIdx++) {
+    benchSink += bench_scan_snap();
+  }
+  uint64_t snapNs = bench_ns() - benchStart;
+  bench_report("snapshot_changed", BENCH_PASSES, snapNs);
+
+  benchStart = bench_ns();
+  for (passIdx = 0U; passIdx < BENCH_PASSES; passIdx++) {
+    benchSink += io_snapshot();
+  }
+  bench_report("snapshot", BENCH_PASSES, bench_ns() - benchStart);
+
+  HOST_CHECK(snapNs < pollNs);
+
+  HOST_DONE();
+}
@@ -0,0 +1,160 @@
+/**
+ * @file bench_log.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Cost of a LOG() call site in host nanoseconds: with no and with
+ * four arguments, with the ring full (the record is dropped), and next to
+ * formatting the same line with snprintf(), which is what the deferred
+ * logger keeps off the hot path. The ring is drained with log_dump() between
+ * batches, outside the timed loops. Prints the results as CSV.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <time.h>
+
+/* Module includes */
+#include <log.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Batches of one full ring each. Draining a batch through the simulated
+// USART takes far longer than writing it, hence only a few.
+#define BENCH_BATCHES 16U
+#define BENCH_CALLS ((uint64_t)BENCH_BATCHES * LOG_NUM_RECORDS)
+
+#define BENCH_LINE_SIZE 64U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t benchTtysConfig = {
+    .ttysBaud = 4000000U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_8,
+};
+
+static volatile uint32_t benchArg;
+static char benchLine[BENCH_LINE_SIZE];
+static uint64_t benchDumped;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t bench_ns(void) {
+  struct timespec benchTs;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &benchTs);
+  return (uint64_t)benchTs.tv_sec * 1000000000U + (uint64_t)benchTs.tv_nsec;
+}
+
+static void bench_count_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  (void)txData;
+  benchDumped++;
+}
+
+static void bench_drain(void) {
+  HOST_CHECK_EQ(log_dump(TTYS_INSTANCE_1, LOG_NUM_RECORDS), LOG_NUM_RECORDS);
+}
+
+static void bench_report(const char *benchOp, uint64_t benchCalls,
+                         uint64_t benchNs) {
+  printf("%s,%llu,%llu.%02llu\n", benchOp, (unsigned long long)benchCalls,
+         (unsigned long long)(benchNs / benchCalls),
+         (unsigned long long)((benchNs * 100U / benchCalls) % 100U));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  uint64_t benchStart = 0U;
+  uint64_t benchNs = 0U;
+  uint32_t batchIdx = 0U;
+  uint32_t callIdx = 0U;
+
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_1), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_1, &benchTtysConfig), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART1, bench_count_hook, NULL);
+
+  printf("# bench log, %u records per batch\n", LOG_NUM_RECORDS);
+  printf("op,calls,ns_per_call\n");
+
+  for (batchIdx = 0U; batchIdx < BENCH_BATCHES; batchIdx++) {
+    benchStart = bench_ns();
+    for (callIdx = 0U; callIdx < LOG_NUM_RECORDS; callIdx++) {
+      LOG("bench: tick");
+    }
+    benchNs += bench_ns() - benchStart;
+    bench_drain();
+  }
+  bench_report("log_0_args", BENCH_CALLS, benchNs);
+
+  benchNs = 0U;
+  for (batchIdx = 0U; batchIdx < BENCH_BATCHES; batchIdx++) {
+    benchStart = bench_ns();
+    for (callIdx = 0U; callIdx < LOG_NUM_RECORDS; callIdx++) {
+      LOG("bench: ch %u adc %u mV, %d C, 0x%08x", callIdx, benchArg, -12,
+          0xBEEFU);
+    }
+    benchNs += bench_ns() - benchStart;
+    bench_drain();
+  }
+  uint64_t logNs = benchNs;
+  bench_report("log_4_args", BENCH_CALLS, logNs);
+
+  // The ring full, every record counted as a drop
+  for (callIdx = 0U; callIdx < LOG_NUM_RECORDS; callIdx++) {
+    LOG("bench: fill");
+  }
+  benchStart = bench_ns();
+  for (batchIdx = 0U; batchIdx < BENCH_BATCHES; batchIdx++) {
+    for (callIdx = 0U; callIdx < LOG_NUM_RECORDS; callIdx++) {
+      LOG("bench: dropped %u", callIdx);
+    }
+  }
+  bench_report("log_dropped", BENCH_CALLS, bench_ns() - benchStart);
+  HOST_CHECK_EQ(log_get_drops(), BENCH_CALLS);
+  bench_drain();
+
+  // The same line formatted in place
+  benchStart = bench_ns();
+  for (batchIdx = 0U; batchIdx < BENCH_BATCHES; batchIdx++) {
+    for (callIdx = 0U; callIdx < LOG_NUM_RECORDS; callIdx++) {
+      (void)snprintf(benchLine, BENCH_LINE_SIZE,
+                     "bench: ch %u adc %u mV, %d C, 0x%08x", callIdx, benchArg,
+                     -12, 0xBEEFU);
+    }
+  }
+  uint64_t printNs = bench_ns() - benchStart;
+  bench_report("snprintf_4_args", BENCH_CALLS, printNs);
+
+  // Every record was dumped: 9 bytes each, plus 16 for the arguments
+  while (!LL_USART_IsActiveFlag_TC(USART1)) {
+  }
+  HOST_CHECK_EQ(benchDumped,
+                BENCH_CALLS * (9U + 9U + 16U) + LOG_NUM_RECORDS * 9U);
+
+  // Storing four words against formatting them
+  HOST_CHECK(logNs < printNs);
+
+  HOST_DONE();
+}
@@ -0,0 +1,140 @@
+/**
+ * @file bench_modules.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Runs bench_modules() on the host. bench_cycles() reads
+ * CLOCK_MONOTONIC there, so the report is in host nanoseconds per call and
+ * shows the relative cost of the hot paths on the simulated peripherals.
+ * Prints the CSV report and checks its shape.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <bench.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// The cases of bench_modules()
+#define BENCH_NUM_CASES 9U
+
+#define BENCH_LINE_SIZE 128U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const io_in_handler_t benchInputs[] = {
+    {IO_PORT_A, IO_PIN_00, IO_PULL_UP, IO_INVERT_DISABLE},
+};
+
+static const io_out_handler_t benchOutputs[] = {
+    {IO_PORT_A, IO_PIN_05, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, RESET},
+};
+
+static io_confg_handler_t benchConfg = {1U, benchInputs, 1U, benchOutputs};
+
+static const ttys_config_t benchTtysConfig = {
+    .ttysBaud = 2000000U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_8,
+};
+
+static tmr_config_t benchTmrConfig = {
+    .tmrInstancesId = TMR_INSTANCE2,
+    .tmrBaseUnit = TMR_BASE_1MS,
+    .tmrPriority = TMR_PRIORITY_LOW,
+};
+
+// bench_ttys_irq() calls USART2_IRQHandler()
+static const bench_targets_t benchTargets = {
+    .ioInIdx = 0U,
+    .ioOutIdx = 0U,
+    .ttysInstIdx = TTYS_INSTANCE_2,
+    .tmrIdx = TMR_INSTANCE2,
+    .tmrTime = 10U,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void bench_tmr_cb(void) {}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  char *benchReport = NULL;
+  size_t reportLen = 0U;
+  uint32_t numCases = 0U;
+
+  HOST_CHECK_EQ(io_init(&benchConfg), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &benchTtysConfig), EXIT_SUCCESS);
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
+  HOST_CHECK_EQ(tmr_init(&benchTmrConfig), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE2, bench_tmr_cb, 1U),
+                TMR_RETURN_SUCCESS);
+
+  HOST_CHECK_EQ(bench_modules(&benchTargets, stdout), BENCH_ERR_NOT_INIT);
+  HOST_CHECK_EQ(bench_init(), EXIT_SUCCESS);
+
+  // The host clock moves while no virtual time passes
+  uint32_t coreStart = bench_core_cycles();
+  uint32_t benchStart = bench_cycles();
+  while (bench_cycles() == benchStart) {
+  }
+  HOST_CHECK_EQ(bench_core_cycles(), coreStart);
+
+  HOST_CHECK_EQ(trace_init(), EXIT_SUCCESS);
+  FILE *reportStream = open_memstream(&benchReport, &reportLen);
+  HOST_CHECK_EQ(bench_modules(&benchTargets, reportStream), EXIT_SUCCESS);
+  (void)fclose(reportStream);
+  printf("%s", benchReport);
+
+  // trace_event() was timed recording, and the ring is stopped again
+  HOST_CHECK(strstr(benchReport, "trace_event,1000,") != NULL);
+  HOST_CHECK(!traceRing.traceIsOn);
+  HOST_CHECK(traceRing.traceHead >= BENCH_DEF_ITERS);
+
+  // Header, column names and one line per case, each ended by "\n\r"
+  char *benchLine = strtok(benchReport, "\n\r");
+  HOST_CHECK(benchLine != NULL && strcmp(benchLine, "# bench v1, ns") == 0);
+  benchLine = strtok(NULL, "\n\r");
+  HOST_CHECK(benchLine != NULL &&
+             strcmp(benchLine, "name,iters,min,avg,max") == 0);
+
+  while ((benchLine = strtok(NULL, "\n\r")) != NULL) {
+    char benchName[BENCH_LINE_SIZE];
+    unsigned long benchIters = 0U;
+    unsigned long benchMin = 0U;
+    unsigned long benchAvg = 0U;
+    unsigned long benchMax = 0U;
+
+    HOST_CHECK_EQ(sscanf(benchLine, "%127[^,],%lu,%lu,%lu,%lu", benchName,
+                         &benchIters, &benchMin, &benchAvg, &benchMax),
+                  5);
+    HOST_CHECK(benchIters != 0U);
+    HOST_CHECK(benchMin <= benchAvg && benchAvg <= benchMax);
+    numCases++;
+  }
+  free(benchReport);
+
+  HOST_CHECK_EQ(numCases, BENCH_NUM_CASES);
+
+  HOST_DONE();
+}
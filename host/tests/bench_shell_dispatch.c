@@ -0,0 +1,194 @@
+/**
+ * @file bench_shell_dispatch.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Shell dispatch time with 200 commands registered (the 4 built-ins
+ * and 196 application commands), built with SHELL_HASH_SIZE 512. Times
+ * shell_find() hits and misses and shell_exec() of whole lines in host
+ * nanoseconds, next to the strcmp chain the perfect hash replaced, and prints
+ * them as CSV.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <time.h>
+
+/* Module includes */
+#include <shell.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_NUM_CMDS 200U
+#define BENCH_NUM_USER (BENCH_NUM_CMDS - 4U)
+#define BENCH_NAME_SIZE 16U
+
+// Passes over the whole command set per measurement
+#define BENCH_PASSES 2000U
+
+_Static_assert(SHELL_MAX_CMDS >= BENCH_NUM_CMDS,
+               "bench: build shell.c with SHELL_HASH_SIZE 512");
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t benchTtysConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+};
+
+// Name stems of a maintenance shell, each used with a number of suffixes
+static const char *const benchStems[] = {
+    "motor", "adc", "pwm", "log", "cfg", "net", "led", "fan", "bat", "imu",
+    "gps", "can", "spi", "i2c", "flash", "rtc", "wdt", "dma",
+};
+
+static char benchNames[BENCH_NUM_USER][BENCH_NAME_SIZE];
+static char benchMisses[BENCH_NUM_USER][BENCH_NAME_SIZE];
+static char benchLines[BENCH_NUM_USER][SHELL_LINE_SIZE];
+static shell_cmd_t benchCmds[BENCH_NUM_USER];
+
+static volatile uint32_t benchNumRun;
+static volatile uintptr_t benchSink;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t bench_cmd(uint32_t argc, char *argv[]) {
+  (void)argv;
+  benchNumRun += argc;
+  return EXIT_SUCCESS;
+}
+
+static uint64_t bench_ns(void) {
+  struct timespec benchTs;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &benchTs);
+  return (uint64_t)benchTs.tv_sec * 1000000000U + (uint64_t)benchTs.tv_nsec;
+}
+
+/**
+ * @brief: The dispatch the shell replaced, a strcmp over every command
+ **/
+static const shell_cmd_t *bench_find_linear(const char *cmdName) {
+  for (uint32_t cmdIdx = 0U; cmdIdx < BENCH_NUM_USER; cmdIdx++) {
+    if (strcmp(benchCmds[cmdIdx].cmdName, cmdName) == 0) {
+      return &benchCmds[cmdIdx];
+    }
+  }
+  return NULL;
+}
+
+static void bench_report(const char *benchOp, uint64_t benchCalls,
+                         uint64_t benchNs) {
+  printf("%s,%llu,%llu.%02llu\n", benchOp, (unsigned long long)benchCalls,
+         (unsigned long long)(benchNs / benchCalls),
+         (unsigned long long)((benchNs * 100U / benchCalls) % 100U));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  const uint32_t numStems = sizeof(benchStems) / sizeof(benchStems[0]);
+  uint64_t benchStart = 0U;
+  uint32_t passIdx = 0U;
+  uint32_t cmdIdx = 0U;
+  char benchLine[SHELL_LINE_SIZE];
+
+  for (cmdIdx = 0U; cmdIdx < BENCH_NUM_USER; cmdIdx++) {
+    (void)snprintf(benchNames[cmdIdx], BENCH_NAME_SIZE, "%s_%u",
+                   benchStems[cmdIdx % numStems], cmdIdx / numStems);
+    (void)snprintf(benchMisses[cmdIdx], BENCH_NAME_SIZE, "%s_x%u",
+                   benchStems[cmdIdx % numStems], cmdIdx / numStems);
+    (void)snprintf(benchLines[cmdIdx], SHELL_LINE_SIZE, "%s 1 0x20 on",
+                   benchNames[cmdIdx]);
+    benchCmds[cmdIdx].cmdName = benchNames[cmdIdx];
+    benchCmds[cmdIdx].cmdFunc = bench_cmd;
+    benchCmds[cmdIdx].cmdHelp = "bench command";
+  }
+
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &benchTtysConfig), EXIT_SUCCESS);
+
+  // Includes sending the prompt through the simulated USART
+  uint64_t initStart = bench_ns();
+  HOST_CHECK_EQ(shell_init(TTYS_INSTANCE_2, benchCmds, BENCH_NUM_USER),
+                EXIT_SUCCESS);
+  uint64_t initNs = bench_ns() - initStart;
+
+  // Every command is found, and only the commands are
+  for (cmdIdx = 0U; cmdIdx < BENCH_NUM_USER; cmdIdx++) {
+    HOST_CHECK(shell_find(benchNames[cmdIdx]) == &benchCmds[cmdIdx]);
+    HOST_CHECK(shell_find(benchMisses[cmdIdx]) == NULL);
+  }
+  HOST_CHECK(shell_find("help") != NULL && shell_find("ttys") != NULL);
+
+  printf("# bench shell, %u commands, %u hash slots\n", BENCH_NUM_CMDS,
+         SHELL_HASH_SIZE);
+  printf("op,calls,ns_per_call\n");
+  bench_report("init", 1U, initNs);
+
+  benchStart = bench_ns();
+  for (passIdx = 0U; passIdx < BENCH_PASSES; passIdx++) {
+    for (cmdIdx = 0U; cmdIdx < BENCH_NUM_USER; cmdIdx++) {
+      benchSink += (uintptr_t)shell_find(benchNames[cmdIdx]);
+    }
+  }
+  uint64_t hashNs = bench_ns() - benchStart;
+  bench_report("find_hit", (uint64_t)BENCH_PASSES * BENCH_NUM_USER, hashNs);
+
+  benchStart = bench_ns();
+  for (passIdx = 0U; passIdx < BENCH_PASSES; passIdx++) {
+    for (cmdIdx = 0U; cmdIdx < BENCH_NUM_USER; cmdIdx++) {
+      benchSink += (uintptr_t)shell_find(benchMisses[cmdIdx]);
+    }
+  }
+  bench_report("find_miss", (uint64_t)BENCH_PASSES * BENCH_NUM_USER,
+               bench_ns() - benchStart);
+
+  benchStart = bench_ns();
+  for (passIdx = 0U; passIdx < BENCH_PASSES; passIdx++) {
+    for (cmdIdx = 0U; cmdIdx < BENCH_NUM_USER; cmdIdx++) {
+      benchSink += (uintptr_t)bench_find_linear(benchNames[cmdIdx]);
+    }
+  }
+  uint64_t linearNs = bench_ns() - benchStart;
+  bench_report("strcmp_chain_hit", (uint64_t)BENCH_PASSES * BENCH_NUM_USER,
+               linearNs);
+
+  // Whole lines, tokenised in place and run. Each line is copied in first,
+  // as shell_poll() does from the RX ring.
+  benchNumRun = 0U;
+  benchStart = bench_ns();
+  for (passIdx = 0U; passIdx < BENCH_PASSES; passIdx++) {
+    for (cmdIdx = 0U; cmdIdx < BENCH_NUM_USER; cmdIdx++) {
+      (void)memcpy(benchLine, benchLines[cmdIdx], SHELL_LINE_SIZE);
+      (void)shell_exec(benchLine);
+    }
+  }
+  bench_report("exec_line", (uint64_t)BENCH_PASSES * BENCH_NUM_USER,
+               bench_ns() - benchStart);
+  HOST_CHECK_EQ(benchNumRun, 4U * BENCH_PASSES * BENCH_NUM_USER);
+
+  // One hash and one compare against a hundred compares on average
+  HOST_CHECK(hashNs < linearNs);
+
+  HOST_DONE();
+}
@@ -0,0 +1,145 @@
+/**
+ * @file bench_ttys.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Runs bench_ttys() on the simulated USART, 115200 to 4 Mbaud, with
+ * two tmr instances interrupting the loop. The tmr callbacks stand in for
+ * real interrupt work by holding the CPU for a few us of virtual time, so
+ * the USART IRQ is delayed the way it would be on target. Prints the
+ * bench's table and JSON and checks that every byte came back.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <bench.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_BYTES 4096U
+
+// USART1, on APB2, reaches 4 Mbaud with OVER8
+#define BENCH_TTYS TTYS_INSTANCE_1
+
+// A fast control loop and a slow housekeeping tick, and what each costs
+#define BENCH_FAST_US 50U
+#define BENCH_FAST_COST_US 2U
+#define BENCH_SLOW_MS 1U
+#define BENCH_SLOW_COST_US 20U
+
+#define BENCH_JSON_MAX 4096U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static tmr_config_t benchFastConfig = {
+    .tmrInstancesId = TMR_INSTANCE2,
+    .tmrBaseUnit = TMR_BASE_1US,
+    .tmrPriority = TMR_PRIORITY_HIGH,
+};
+
+static tmr_config_t benchSlowConfig = {
+    .tmrInstancesId = TMR_INSTANCE3,
+    .tmrBaseUnit = TMR_BASE_1MS,
+    .tmrPriority = TMR_PRIORITY_LOW,
+};
+
+static uint32_t benchFastIrqs;
+static uint32_t benchSlowIrqs;
+
+static bench_ttys_result_t benchResults[BENCH_TTYS_MAX_BAUDS];
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void bench_fast_cb(void) {
+  benchFastIrqs++;
+  sim_advance(SIM_US(BENCH_FAST_COST_US));
+}
+
+static void bench_slow_cb(void) {
+  benchSlowIrqs++;
+  sim_advance(SIM_US(BENCH_SLOW_COST_US));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  const bench_ttys_config_t benchConfig = {
+      .ttysInstIdx = BENCH_TTYS,
+      .benchBauds = NULL,
+      .benchBytes = BENCH_BYTES,
+  };
+  char *benchJson = NULL;
+  size_t jsonLen = 0U;
+
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2 |
+                           LL_APB1_GRP1_PERIPH_TIM3);
+  HOST_CHECK_EQ(tmr_init(&benchFastConfig), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_init(&benchSlowConfig), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE2, bench_fast_cb, BENCH_FAST_US),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE3, bench_slow_cb, BENCH_SLOW_MS),
+                TMR_RETURN_SUCCESS);
+
+  HOST_CHECK_EQ(ttys_def_init(BENCH_TTYS), EXIT_SUCCESS);
+  HOST_CHECK_EQ(bench_init(), EXIT_SUCCESS);
+
+  // The table and JSON go to stdout, a copy of the report is kept to check
+  HOST_CHECK_EQ(bench_ttys(&benchConfig, benchResults, stdout),
+                EXIT_SUCCESS);
+
+  FILE *jsonStream = open_memstream(&benchJson, &jsonLen);
+  HOST_CHECK_EQ(bench_ttys_report(jsonStream, benchResults, 5U),
+                EXIT_SUCCESS);
+  (void)fclose(jsonStream);
+  HOST_CHECK(jsonLen < BENCH_JSON_MAX);
+  HOST_CHECK(strstr(benchJson, "{\"bench\":\"ttys\",\"version\":1,") != NULL);
+  free(benchJson);
+
+  // The default rates, each looped back in full under the tmr load
+  const uint32_t benchBauds[] = {115200U, 460800U, 921600U, 2000000U,
+                                 4000000U};
+  for (uint32_t baudIdx = 0U; baudIdx < 5U; baudIdx++) {
+    const bench_ttys_result_t *benchResult = &benchResults[baudIdx];
+    uint32_t lineRate = benchResult->actualBaud / BENCH_TTYS_BITS_PER_CHAR;
+
+    HOST_CHECK_EQ(benchResult->reqBaud, benchBauds[baudIdx]);
+    HOST_CHECK_EQ(benchResult->benchErr, EXIT_SUCCESS);
+    HOST_CHECK_EQ(benchResult->bytesSent, BENCH_BYTES);
+    HOST_CHECK_EQ(benchResult->bytesRecv + benchResult->rxDrops, BENCH_BYTES);
+    HOST_CHECK_EQ(benchResult->lineErrs, 0U);
+
+    // Within 10 % of the line rate, the TX ring never ran dry for long
+    HOST_CHECK(benchResult->bytesPerSec <= lineRate);
+    HOST_CHECK(benchResult->bytesPerSec >= lineRate - lineRate / 10U);
+    HOST_CHECK(benchResult->txHighWater != 0U);
+  }
+
+  // At 115200 a character outlasts the longest callback, nothing is lost.
+  // From 460800 up the 20 us callback holds the USART IRQ off for more than
+  // a character, which overruns DR.
+  HOST_CHECK_EQ(benchResults[0U].rxDrops, 0U);
+  HOST_CHECK(benchResults[0U].latMaxUs <= BENCH_SLOW_COST_US + 2U);
+  HOST_CHECK(benchResults[4U].rxDrops != 0U);
+
+  HOST_CHECK(benchFastIrqs != 0U);
+  HOST_CHECK(benchSlowIrqs != 0U);
+
+  HOST_DONE();
+}
@@ -0,0 +1,228 @@
+/**
+ * @file bench_ttys_mux.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Per-channel latency of the ttys multiplexer under mixed load, in
+ * virtual time on the simulated USART. Telemetry and firmware update offer
+ * more than the line carries, the log is steady and the console sends a short
+ * line now and then. The latency of a write is the time from
+ * ttys_mux_write() until its last byte left the TX pin. Prints one CSV row
+ * per channel and checks that the bulk channels do not starve the console.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <ttys_mux.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_BAUD 115200U
+#define BENCH_RUN_MS 2000U
+
+// Writes waiting for their last byte, per channel
+#define BENCH_MAX_PENDING 64U
+
+// 8N1 frame time in us, and the longest mux frame on the wire
+#define BENCH_CHAR_US (10U * 1000000U / BENCH_BAUD)
+#define BENCH_FRAME_MAX TTYS_MUX_FRAME_MAX
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t benchTtysConfig = {
+    .ttysBaud = BENCH_BAUD,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+};
+
+static const uint8_t benchWeights[TTYS_MUX_NUM_CHANNELS] = {2U, 1U, 1U, 1U};
+
+// Load per channel: a write of writeLen bytes every periodMs
+static const struct {
+  const char *chanName;
+  uint32_t writeLen;
+  uint32_t periodMs;
+} benchLoad[TTYS_MUX_NUM_CHANNELS] = {
+    [TTYS_MUX_CONSOLE] = {"console", 8U, 20U},
+    [TTYS_MUX_TELEMETRY] = {"telemetry", 32U, 1U},
+    [TTYS_MUX_LOG] = {"log", 24U, 10U},
+    [TTYS_MUX_UPDATE] = {"update", 64U, 2U},
+};
+
+/* Latency bookkeeping of one channel */
+typedef struct {
+  uint64_t pendEnd[BENCH_MAX_PENDING];  // Channel byte count ending a write
+  uint64_t pendTime[BENCH_MAX_PENDING];
+  uint32_t pendHead;
+  uint32_t pendTail;
+
+  uint64_t bytesQueued;
+  uint64_t bytesSent;
+  uint32_t numWrites;
+  uint32_t numShort;  // Writes cut short by a full TX ring
+  uint64_t latSum;
+  uint64_t latMax;
+
+} bench_chan_t;
+
+static bench_chan_t benchChans[TTYS_MUX_NUM_CHANNELS];
+
+// Frame parser on the TX line, the CRC is left to the mux tests
+static uint32_t benchRxState;
+static uint32_t benchRxChan;
+static uint32_t benchRxLeft;
+static bool benchRxEsc;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Sees every byte leave the TX pin and ends the writes whose last
+ *         byte it was.
+ **/
+static void bench_tx_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+
+  if (txData == TTYS_MUX_SYNC) {
+    benchRxState = 1U;
+    benchRxEsc = false;
+    return;
+  }
+  if (txData == TTYS_MUX_ESC) {
+    benchRxEsc = true;
+    return;
+  }
+  if (benchRxEsc) {
+    txData ^= TTYS_MUX_ESC_XOR;
+    benchRxEsc = false;
+  }
+
+  switch (benchRxState) {
+    case 0U:
+      break;
+
+    case 1U:
+      benchRxChan = txData;
+      benchRxState = 2U;
+      break;
+
+    case 2U:
+      benchRxLeft = txData;
+      benchRxState = (benchRxLeft != 0U) ? 3U : 0U;
+      break;
+
+    default: {
+      bench_chan_t *benchChan = &benchChans[benchRxChan];
+
+      benchChan->bytesSent++;
+      while (benchChan->pendTail != benchChan->pendHead &&
+             benchChan->pendEnd[benchChan->pendTail % BENCH_MAX_PENDING] <=
+                 benchChan->bytesSent) {
+        uint64_t latCycles =
+            sim_now() -
+            benchChan->pendTime[benchChan->pendTail % BENCH_MAX_PENDING];
+
+        benchChan->latSum += latCycles;
+        if (latCycles > benchChan->latMax) benchChan->latMax = latCycles;
+        benchChan->pendTail++;
+      }
+
+      if (--benchRxLeft == 0U) benchRxState = 0U;
+      break;
+    }
+  }
+}
+
+static void bench_write(uint32_t muxChan) {
+  static uint8_t benchData[64];
+  bench_chan_t *benchChan = &benchChans[muxChan];
+
+  // No room to track it, the write is skipped like a full ring would
+  if (benchChan->pendHead - benchChan->pendTail == BENCH_MAX_PENDING) {
+    benchChan->numShort++;
+    return;
+  }
+
+  uint32_t numQueued =
+      ttys_mux_write(muxChan, benchData, benchLoad[muxChan].writeLen);
+
+  if (numQueued < benchLoad[muxChan].writeLen) benchChan->numShort++;
+  if (numQueued == 0U) return;
+
+  benchChan->bytesQueued += numQueued;
+  benchChan->pendEnd[benchChan->pendHead % BENCH_MAX_PENDING] =
+      benchChan->bytesQueued;
+  benchChan->pendTime[benchChan->pendHead % BENCH_MAX_PENDING] = sim_now();
+  benchChan->pendHead++;
+  benchChan->numWrites++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  uint32_t muxChan = 0U;
+
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &benchTtysConfig), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_start(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_mux_init(TTYS_INSTANCE_2, benchWeights), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, bench_tx_hook, NULL);
+
+  for (uint32_t runMs = 0U; runMs < BENCH_RUN_MS; runMs++) {
+    for (muxChan = 0U; muxChan < TTYS_MUX_NUM_CHANNELS; muxChan++) {
+      if (runMs % benchLoad[muxChan].periodMs == 0U) bench_write(muxChan);
+    }
+    sim_advance(SIM_MS(1));
+  }
+
+  printf("# bench ttys_mux, %u baud, weights %u/%u/%u/%u, %u ms\n",
+         BENCH_BAUD, benchWeights[0], benchWeights[1], benchWeights[2],
+         benchWeights[3], BENCH_RUN_MS);
+  printf("chan,writes,short,bytes,lat_avg_us,lat_max_us\n");
+
+  for (muxChan = 0U; muxChan < TTYS_MUX_NUM_CHANNELS; muxChan++) {
+    bench_chan_t *benchChan = &benchChans[muxChan];
+    uint32_t numDone = benchChan->pendTail;
+
+    printf("%s,%u,%u,%llu,%llu,%llu\n", benchLoad[muxChan].chanName,
+           benchChan->numWrites, benchChan->numShort,
+           (unsigned long long)benchChan->bytesSent,
+           (unsigned long long)((numDone != 0U)
+                                    ? benchChan->latSum / numDone / SIM_US(1)
+                                    : 0U),
+           (unsigned long long)(benchChan->latMax / SIM_US(1)));
+
+    // Every channel got the line at some point
+    HOST_CHECK(numDone > 0U);
+  }
+
+  // The console waits at most for one frame of every other channel and its
+  // own, plus the frame already on the wire
+  uint64_t consoleBound = (uint64_t)(TTYS_MUX_NUM_CHANNELS + 1U) *
+                          BENCH_FRAME_MAX * BENCH_CHAR_US * SIM_US(1);
+  HOST_CHECK(benchChans[TTYS_MUX_CONSOLE].latMax <= consoleBound);
+  HOST_CHECK_EQ(benchChans[TTYS_MUX_CONSOLE].numShort, 0U);
+  HOST_CHECK_EQ(benchChans[TTYS_MUX_LOG].numShort, 0U);
+
+  // The bulk channels were saturated, so the line was never idle
+  HOST_CHECK(benchChans[TTYS_MUX_TELEMETRY].numShort > 0U);
+
+  HOST_DONE();
+}
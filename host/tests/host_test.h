@@ -0,0 +1,68 @@
+/**
+ * @file host_test.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Checks shared by the host tests. A failed check is reported with its
+ * location and the test carries on, the exit status is 1 if any failed.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdint.h>
+#include <stdio.h>
+
+/* Simulator includes */
+#include <sim.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define HOST_CHECK(cond)                                                   \
+  do {                                                                     \
+    hostNumChecks++;                                                       \
+    if (!(cond)) {                                                         \
+      hostNumFailed++;                                                     \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+              #cond);                                                      \
+    }                                                                      \
+  } while (0)
+
+#define HOST_CHECK_EQ(actual, expected)                                    \
+  do {                                                                     \
+    unsigned long long hostActual = (unsigned long long)(actual);          \
+    unsigned long long hostExpected = (unsigned long long)(expected);      \
+    hostNumChecks++;                                                       \
+    if (hostActual != hostExpected) {                                      \
+      hostNumFailed++;                                                     \
+      fprintf(stderr, "%s:%d: %s is %llu, expected %llu\n", __FILE__,      \
+              __LINE__, #actual, hostActual, hostExpected);                \
+    }                                                                      \
+  } while (0)
+
+// Ends main(), prints the summary
+#define HOST_DONE()                                                        \
+  do {                                                                     \
+    printf("%s: %u checks, %u failed\n", __FILE__, hostNumChecks,          \
+           hostNumFailed);                                                 \
+    return (hostNumFailed == 0U) ? 0 : 1;                                  \
+  } while (0)
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned hostNumChecks;
+static unsigned hostNumFailed;
+
+#endif  // host_test.h
@@ -0,0 +1,307 @@
+/**
+ * @file test_cap.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Drives synthetic traces on the capture inputs, decodes the dump sent
+ * over ttys and compares it with the trace sample for sample. Also stops the
+ * capture with a DMA half completed but its IRQ not yet run.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <cap.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_SAMPLE_RATE 100000U
+#define TEST_SAMPLE_CYCLES (SIM_CORE_CLOCK / TEST_SAMPLE_RATE)
+
+// Samples advanced between two cap_process() calls, below half the ring
+#define TEST_CHUNK 100U
+
+#define TEST_PIN_MASK (LL_GPIO_PIN_0 | LL_GPIO_PIN_1 | LL_GPIO_PIN_2)
+
+#define TEST_MAX_RUNS 2048U
+#define TEST_DUMP_MAX 16384U
+#define TEST_DUMP_HDR_SIZE 14U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) types
+////////////////////////////////////////////////////////////////////////////////
+
+/* The capture as the dump sends it, or as the trace expects it */
+typedef struct {
+  cap_rle_t capRuns[TEST_MAX_RUNS];
+  uint32_t numRuns;
+  uint64_t numSamples;
+
+} test_capture_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+// PA2 is inverted, so the captured value is the pin levels with bit 2 flipped
+static const io_in_handler_t testInputs[] = {
+    {.portx = GPIOA, .ioPinNo = LL_GPIO_PIN_0, .ioInInvert = DISABLE},
+    {.portx = GPIOA, .ioPinNo = LL_GPIO_PIN_1, .ioInInvert = DISABLE},
+    {.portx = GPIOA, .ioPinNo = LL_GPIO_PIN_2, .ioInInvert = ENABLE},
+};
+
+static const cap_config_t testCapConfig = {
+    .capInputs = testInputs,
+    .numCapInputs = 3U,
+    .capSampleRate = TEST_SAMPLE_RATE,
+};
+
+static const ttys_config_t testTtysConfig = {
+    .ttysBaud = 2000000U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+};
+
+static test_capture_t testExpected;
+static test_capture_t testDecoded;
+
+static uint8_t testDump[TEST_DUMP_MAX];
+static uint32_t testDumpLen;
+
+static uint32_t testState;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_dump_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  if (testDumpLen < TEST_DUMP_MAX) testDump[testDumpLen] = txData;
+  testDumpLen++;
+}
+
+// xorshift32, so the traces are the same on every run
+static uint32_t test_rand(void) {
+  testState ^= testState << 13U;
+  testState ^= testState >> 17U;
+  testState ^= testState << 5U;
+  return testState;
+}
+
+/**
+ * @brief: Appends samples to the expected capture, the way cap.c folds them
+ **/
+static void test_expect(uint16_t capVal, uint32_t numSamples) {
+  test_capture_t *capExp = &testExpected;
+
+  capExp->numSamples += numSamples;
+  while (numSamples > 0U) {
+    cap_rle_t *capLast =
+        (capExp->numRuns != 0U) ? &capExp->capRuns[capExp->numRuns - 1U]
+                                : NULL;
+
+    if (capLast != NULL && capLast->capVal == capVal &&
+        capLast->capRun < CAP_RLE_RUN_MAX) {
+      uint32_t runAdd = CAP_RLE_RUN_MAX - capLast->capRun;
+
+      if (runAdd > numSamples) runAdd = numSamples;
+      capLast->capRun += (uint16_t)runAdd;
+      numSamples -= runAdd;
+      continue;
+    }
+
+    if (capExp->numRuns == TEST_MAX_RUNS) return;
+    capExp->capRuns[capExp->numRuns].capVal = capVal;
+    capExp->capRuns[capExp->numRuns].capRun = 0U;
+    capExp->numRuns++;
+  }
+}
+
+/**
+ * @brief: Holds the pins at pinLevels for numSamples sample periods,
+ *         running cap_process() like a main loop would
+ **/
+static void test_drive(uint32_t pinLevels, uint32_t numSamples,
+                       bool isProcessed) {
+  sim_gpio_drive(GPIOA, pinLevels & TEST_PIN_MASK, true);
+  sim_gpio_drive(GPIOA, ~pinLevels & TEST_PIN_MASK, false);
+  test_expect((uint16_t)((pinLevels ^ LL_GPIO_PIN_2) & TEST_PIN_MASK),
+              numSamples);
+
+  while (numSamples > 0U) {
+    uint32_t chunkSamples = (numSamples > TEST_CHUNK) ? TEST_CHUNK
+                                                       : numSamples;
+
+    sim_advance((uint64_t)chunkSamples * TEST_SAMPLE_CYCLES);
+    numSamples -= chunkSamples;
+    if (isProcessed) (void)cap_process();
+  }
+}
+
+/**
+ * @brief: Starts a capture. The first sample is taken one period after the
+ *         start, half a period away from the pin changes of test_drive().
+ **/
+static void test_start(uint32_t pinLevels) {
+  memset(&testExpected, 0, sizeof(testExpected));
+  sim_gpio_drive(GPIOA, pinLevels & TEST_PIN_MASK, true);
+  sim_gpio_drive(GPIOA, ~pinLevels & TEST_PIN_MASK, false);
+  HOST_CHECK_EQ(cap_start(), EXIT_SUCCESS);
+  sim_advance(TEST_SAMPLE_CYCLES / 2U);
+}
+
+/**
+ * @brief: Dumps the capture over USART2 and decodes it into testDecoded
+ **/
+static bool test_dump_decode(void) {
+  memset(&testDecoded, 0, sizeof(testDecoded));
+  testDumpLen = 0U;
+
+  if (cap_dump(TTYS_INSTANCE_2) != EXIT_SUCCESS) return false;
+  while (!LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+  if (testDumpLen > TEST_DUMP_MAX || testDumpLen < TEST_DUMP_HDR_SIZE) {
+    return false;
+  }
+  if (memcmp(testDump, CAP_DUMP_MAGIC, 3U) != 0) return false;
+
+  uint32_t numRecords = 0U;
+  memcpy(&numRecords, &testDump[10U], 4U);
+  if (numRecords > TEST_MAX_RUNS) return false;
+
+  uint32_t dumpPos = TEST_DUMP_HDR_SIZE;
+  for (uint32_t recIdx = 0U; recIdx < numRecords; recIdx++) {
+    cap_rle_t *capRun = &testDecoded.capRuns[recIdx];
+    uint32_t runLen = 0U;
+    uint32_t varShift = 0U;
+
+    if (dumpPos + 3U > testDumpLen) return false;
+    memcpy(&capRun->capVal, &testDump[dumpPos], 2U);
+    dumpPos += 2U;
+
+    while (dumpPos < testDumpLen) {
+      uint8_t varByte = testDump[dumpPos++];
+
+      runLen |= (uint32_t)(varByte & 0x7FU) << varShift;
+      varShift += 7U;
+      if (!(varByte & 0x80U)) break;
+    }
+
+    capRun->capRun = (uint16_t)runLen;
+    testDecoded.numSamples += runLen;
+  }
+  testDecoded.numRuns = numRecords;
+
+  return dumpPos == testDumpLen;
+}
+
+/**
+ * @brief: Dumps the stopped capture and compares it with the trace
+ **/
+static void test_check_capture(const char *traceName) {
+  cap_status_t capStatus;
+
+  HOST_CHECK_EQ(cap_get_status(&capStatus), EXIT_SUCCESS);
+  HOST_CHECK(!capStatus.isFull);
+  HOST_CHECK_EQ(capStatus.rawOverruns, 0U);
+  HOST_CHECK_EQ(capStatus.numSamples, testExpected.numSamples);
+  HOST_CHECK_EQ(capStatus.numRecords, testExpected.numRuns);
+
+  HOST_CHECK(test_dump_decode());
+  HOST_CHECK_EQ(testDecoded.numRuns, testExpected.numRuns);
+  HOST_CHECK_EQ(testDecoded.numSamples, testExpected.numSamples);
+  HOST_CHECK(memcmp(testDecoded.capRuns, testExpected.capRuns,
+                    testExpected.numRuns * sizeof(cap_rle_t)) == 0);
+
+  // Raw samples are half-words, the dump is what goes over the wire
+  printf("%-8s %8llu samples, %5u records, %6u bytes, ratio %.1f\n",
+         traceName, (unsigned long long)testExpected.numSamples,
+         testExpected.numRuns, testDumpLen,
+         (2.0 * (double)testExpected.numSamples) / testDumpLen);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOA);
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testTtysConfig), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_dump_hook, NULL);
+
+  HOST_CHECK_EQ(cap_init(&testCapConfig), EXIT_SUCCESS);
+
+  // Mostly idle bus with short bursts, runs longer than CAP_RLE_RUN_MAX
+  testState = 0x12345678U;
+  test_start(0x7U);
+  test_drive(0x7U, 70000U, true);
+  for (uint32_t burstIdx = 0U; burstIdx < 20U; burstIdx++) {
+    for (uint32_t bitIdx = 0U; bitIdx < 16U; bitIdx++) {
+      test_drive(0x6U | (test_rand() & 1U), 1U + (test_rand() & 3U), true);
+    }
+    test_drive(0x7U, 2000U + (test_rand() & 0x3FFU), true);
+  }
+  HOST_CHECK_EQ(cap_stop(), EXIT_SUCCESS);
+  test_check_capture("idle");
+  HOST_CHECK(2U * testExpected.numSamples > 100U * testDumpLen);
+
+  // Clock and data, a change every few samples
+  test_start(0x0U);
+  for (uint32_t bitIdx = 0U; bitIdx < 400U; bitIdx++) {
+    uint32_t dataBit = (test_rand() & 1U) << 1U;
+
+    test_drive(dataBit, 2U, true);
+    test_drive(dataBit | 0x1U, 2U, true);
+  }
+  HOST_CHECK_EQ(cap_stop(), EXIT_SUCCESS);
+  test_check_capture("clock");
+
+  // Noise, a change on every sample compresses worse than raw
+  test_start(0x0U);
+  for (uint32_t sampleIdx = 0U; sampleIdx < 1000U; sampleIdx++) {
+    test_drive(sampleIdx & 1U, 1U, true);
+  }
+  HOST_CHECK_EQ(cap_stop(), EXIT_SUCCESS);
+  test_check_capture("noise");
+  HOST_CHECK(2U * testExpected.numSamples < testDumpLen);
+
+  // Stopped with the half-transfer flagged but its IRQ held off
+  uint32_t numIrqs = sim_irq_count(DMA2_Stream5_IRQn);
+  test_start(0x1U);
+  test_drive(0x1U, CAP_RAW_HALF_SIZE - 10U, true);
+  __disable_irq();
+  test_drive(0x3U, 10U, false);
+  HOST_CHECK_EQ(cap_stop(), EXIT_SUCCESS);
+  __enable_irq();
+  test_check_capture("ht");
+  HOST_CHECK_EQ(sim_irq_count(DMA2_Stream5_IRQn), numIrqs);
+
+  // Same at the end of the ring, where NDTR has already reloaded
+  test_start(0x1U);
+  test_drive(0x1U, CAP_RAW_BUF_SIZE + CAP_RAW_HALF_SIZE, true);
+  __disable_irq();
+  test_drive(0x5U, CAP_RAW_HALF_SIZE, false);
+  HOST_CHECK_EQ(cap_stop(), EXIT_SUCCESS);
+  __enable_irq();
+  test_check_capture("tc");
+
+  // Stopped mid-half, only the samples written so far are compressed
+  test_start(0x2U);
+  test_drive(0x2U, CAP_RAW_HALF_SIZE + 37U, true);
+  HOST_CHECK_EQ(cap_stop(), EXIT_SUCCESS);
+  test_check_capture("partial");
+
+  HOST_DONE();
+}
@@ -0,0 +1,138 @@
+/**
+ * @file test_gpio_init.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Counts the GPIO and RCC register accesses of io_init() with the
+ * simulator's access counters: one clock enable for all the ports, and at
+ * most one write to each configuration register of a used port, however
+ * many pins it has. Unused ports are not touched at all.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <gpio.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_NUM_PORTS 6U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+// Port B inputs only, port C outputs only, port D both
+static const io_in_handler_t testInputs[] = {
+    {IO_PORT_B, IO_PIN_00, IO_PULL_UP, IO_INVERT_DISABLE},
+    {IO_PORT_B, IO_PIN_01, IO_PULL_DWN, IO_INVERT_ENABLE},
+    {IO_PORT_B, IO_PIN_12, IO_PULL_NO, IO_INVERT_DISABLE},
+    {IO_PORT_D, IO_PIN_02, IO_PULL_UP, IO_INVERT_DISABLE},
+};
+
+static const io_out_handler_t testOutputs[] = {
+    {IO_PORT_C, IO_PIN_00, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, SET},
+    {IO_PORT_C, IO_PIN_01, IO_SPDR_FREQ_MED, IO_OUPT_OPNDRAIN, RESET},
+    {IO_PORT_C, IO_PIN_02, IO_SPDR_FREQ_HIGH, IO_OUPT_PUSHPULL, SET},
+    {IO_PORT_C, IO_PIN_03, IO_SPDR_FREQ_VHIGH, IO_OUPT_PUSHPULL, RESET},
+    {IO_PORT_C, IO_PIN_09, IO_SPDR_FREQ_LOW, IO_OUPT_OPNDRAIN, SET},
+    {IO_PORT_D, IO_PIN_07, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, SET},
+};
+
+static io_confg_handler_t testConfg = {
+    sizeof(testInputs) / sizeof(testInputs[0]), testInputs,
+    sizeof(testOutputs) / sizeof(testOutputs[0]), testOutputs};
+
+static GPIO_TypeDef *const testPorts[TEST_NUM_PORTS] = {
+    GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOH};
+
+// Ports with inputs and with outputs in testConfg
+static const bool testHasIn[TEST_NUM_PORTS] = {false, true, false,
+                                               true,  false, false};
+static const bool testHasOut[TEST_NUM_PORTS] = {false, false, true,
+                                                true,  false, false};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t test_writes(const GPIO_TypeDef *simPort) {
+  return sim_reg_writes(&simPort->MODER) + sim_reg_writes(&simPort->OTYPER) +
+         sim_reg_writes(&simPort->OSPEEDR) + sim_reg_writes(&simPort->PUPDR) +
+         sim_reg_writes(&simPort->ODR) + sim_reg_writes(&simPort->BSRR) +
+         sim_reg_writes(&simPort->AFR[0]) + sim_reg_writes(&simPort->AFR[1]);
+}
+
+/**
+ * @brief: The accesses io_init() made since the counts were cleared.
+ **/
+static void test_counts(void) {
+  uint32_t numWrites = 0U;
+
+  // One enable for every port, and no other RCC register
+  HOST_CHECK_EQ(sim_reg_writes(&RCC->AHB1ENR), 1U);
+  HOST_CHECK_EQ(sim_reg_writes(&RCC->APB1ENR), 0U);
+  HOST_CHECK_EQ(sim_reg_writes(&RCC->APB2ENR), 0U);
+
+  for (uint32_t portIdx = 0U; portIdx < TEST_NUM_PORTS; portIdx++) {
+    const GPIO_TypeDef *simPort = testPorts[portIdx];
+    bool isUsed = testHasIn[portIdx] || testHasOut[portIdx];
+
+    HOST_CHECK_EQ(sim_reg_writes(&simPort->MODER), isUsed ? 1U : 0U);
+    HOST_CHECK_EQ(sim_reg_writes(&simPort->PUPDR),
+                  testHasIn[portIdx] ? 1U : 0U);
+    HOST_CHECK_EQ(sim_reg_writes(&simPort->OTYPER),
+                  testHasOut[portIdx] ? 1U : 0U);
+    HOST_CHECK_EQ(sim_reg_writes(&simPort->OSPEEDR),
+                  testHasOut[portIdx] ? 1U : 0U);
+    HOST_CHECK_EQ(sim_reg_writes(&simPort->BSRR),
+                  testHasOut[portIdx] ? 1U : 0U);
+    HOST_CHECK_EQ(sim_reg_writes(&simPort->ODR), 0U);
+
+    // Each read-modify-write reads its register once
+    HOST_CHECK(sim_reg_reads(&simPort->MODER) <= 1U);
+    HOST_CHECK(sim_reg_reads(&simPort->PUPDR) <= 1U);
+    HOST_CHECK(sim_reg_reads(&simPort->OSPEEDR) <= 1U);
+
+    numWrites += test_writes(simPort);
+  }
+
+  // 10 pins configured with 11 register writes (B, C, D), instead of two to
+  // five read-modify-writes per pin
+  printf("io_init: %u pins, %u GPIO writes\n",
+         testConfg.numIOInputs + testConfg.numIOOutputs, numWrites);
+  HOST_CHECK_EQ(numWrites, 2U + 4U + 5U);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  sim_reg_clear_counts();
+  HOST_CHECK_EQ(io_init(&testConfg), EXIT_SUCCESS);
+  test_counts();
+
+  // The settings did land
+  HOST_CHECK_EQ(LL_GPIO_GetPinPull(GPIOB, LL_GPIO_PIN_1), LL_GPIO_PULL_DOWN);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOC, LL_GPIO_PIN_9),
+                LL_GPIO_MODE_OUTPUT);
+  HOST_CHECK_EQ(io_get_output_val(4U), 1U);
+
+  // The same again with the clocks already on
+  sim_reg_clear_counts();
+  HOST_CHECK_EQ(io_init(&testConfg), EXIT_SUCCESS);
+  test_counts();
+
+  HOST_DONE();
+}
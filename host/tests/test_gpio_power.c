@@ -0,0 +1,217 @@
+/**
+ * @file test_gpio_power.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Checks the gpio power management against the simulated RCC/GPIO:
+ * which pins io_power_save() parks, when a port clock is gated, and that the
+ * next access ungates the port and restores the pin before touching it.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <gpio.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// MODER value with every pin in pinMask set to ioMode
+#define TEST_MODER(pinMask, ioMode) (ioMode * test_spread2(pinMask))
+
+// Indices into testInputs[] and testOutputs[]
+#define TEST_IN_PC0 0U
+#define TEST_IN_PC1 1U
+#define TEST_OUT_PC8 0U
+#define TEST_OUT_PD2 1U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const io_in_handler_t testInputs[] = {
+    {IO_PORT_C, IO_PIN_00, IO_PULL_NO, IO_INVERT_DISABLE},
+    {IO_PORT_C, IO_PIN_01, IO_PULL_UP, IO_INVERT_ENABLE},
+    {IO_PORT_B, IO_PIN_05, IO_PULL_UP, IO_INVERT_DISABLE},
+};
+
+static const io_out_handler_t testOutputs[] = {
+    {IO_PORT_C, IO_PIN_08, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, SET},
+    {IO_PORT_D, IO_PIN_02, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, RESET},
+};
+
+static io_confg_handler_t testConfg = {
+    sizeof(testInputs) / sizeof(testInputs[0]), testInputs,
+    sizeof(testOutputs) / sizeof(testOutputs[0]), testOutputs};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t test_spread2(uint32_t pinMask) {
+  uint32_t pinMask2 = 0U;
+
+  for (uint32_t pinPos = 0U; pinPos < 16U; pinPos++) {
+    if (pinMask & (1U << pinPos)) pinMask2 |= 1U << (2U * pinPos);
+  }
+
+  return pinMask2;
+}
+
+/**
+ * @brief: io_init() clocks only the ports in the config and writes the
+ *         configured modes.
+ **/
+static void test_init(void) {
+  HOST_CHECK_EQ(io_init(&testConfg), EXIT_SUCCESS);
+
+  HOST_CHECK(!LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOA));
+  HOST_CHECK(LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOB |
+                                         LL_AHB1_GRP1_PERIPH_GPIOC |
+                                         LL_AHB1_GRP1_PERIPH_GPIOD));
+  HOST_CHECK_EQ(READ_REG(GPIOC->MODER),
+                TEST_MODER(IO_PIN_08, LL_GPIO_MODE_OUTPUT));
+  HOST_CHECK_EQ(io_get_output_val(TEST_OUT_PC8), 1U);
+  HOST_CHECK_EQ(io_get_output_val(TEST_OUT_PD2), 0U);
+}
+
+/**
+ * @brief: Floating pins nobody configured are parked, configured, pulled and
+ *         AF pins are not, and no port with an open pin is gated.
+ **/
+static void test_park_unused(void) {
+  HOST_CHECK_EQ(io_power_save(), 0U);
+
+  // PC0, PC1 inputs and PC8 output stay, the rest of port C is analog
+  HOST_CHECK_EQ(READ_REG(GPIOC->MODER),
+                TEST_MODER(0xFFFFU & ~(IO_PIN_00 | IO_PIN_01 | IO_PIN_08),
+                           LL_GPIO_MODE_ANALOG) |
+                    TEST_MODER(IO_PIN_08, LL_GPIO_MODE_OUTPUT));
+
+  // PB3 and PB4 are the SWO/JTAG AF pins at reset, PB4 is pulled up as well
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOB, LL_GPIO_PIN_3),
+                LL_GPIO_MODE_ALTERNATE);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOB, LL_GPIO_PIN_4),
+                LL_GPIO_MODE_ALTERNATE);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOB, LL_GPIO_PIN_5),
+                LL_GPIO_MODE_INPUT);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOB, LL_GPIO_PIN_6),
+                LL_GPIO_MODE_ANALOG);
+
+  // Port A was never clocked and is left alone
+  HOST_CHECK(!LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOA));
+
+  HOST_CHECK(LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOB |
+                                         LL_AHB1_GRP1_PERIPH_GPIOC |
+                                         LL_AHB1_GRP1_PERIPH_GPIOD));
+}
+
+/**
+ * @brief: Closing the last open pin of a port gates it, and the next access
+ *         ungates it before restoring the pin, at its last level.
+ **/
+static void test_gate_and_wake(void) {
+  HOST_CHECK_EQ(io_close_output(TEST_OUT_PD2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOD, LL_GPIO_PIN_2), LL_GPIO_MODE_ANALOG);
+
+  HOST_CHECK_EQ(io_power_save(), LL_AHB1_GRP1_PERIPH_GPIOD);
+  HOST_CHECK(!LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOD));
+
+  // Lazy wake on the next access
+  HOST_CHECK_EQ(io_get_output_val(TEST_OUT_PD2), 0U);
+  HOST_CHECK(LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOD));
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOD, LL_GPIO_PIN_2), LL_GPIO_MODE_OUTPUT);
+
+  HOST_CHECK_EQ(io_set_val(TEST_OUT_PD2, 1U), EXIT_SUCCESS);
+  HOST_CHECK(LL_GPIO_IsInputPinSet(GPIOD, LL_GPIO_PIN_2));
+
+  // The output keeps its level across a park and a gate
+  io_close_output(TEST_OUT_PD2);
+  HOST_CHECK_EQ(io_power_save(), LL_AHB1_GRP1_PERIPH_GPIOD);
+  HOST_CHECK_EQ(io_toggle_val(TEST_OUT_PD2), EXIT_SUCCESS);
+  HOST_CHECK(!LL_GPIO_IsInputPinSet(GPIOD, LL_GPIO_PIN_2));
+
+  // Nothing was written while the clock was off
+  HOST_CHECK_EQ(sim_gpio_gated_writes(GPIOD), 0U);
+}
+
+/**
+ * @brief: Closed inputs read as inactive in snapshots whatever their
+ *         inversion, and a gated port is not read at all.
+ **/
+static void test_snapshot_closed(void) {
+  sim_gpio_drive(GPIOC, LL_GPIO_PIN_0, true);
+  sim_gpio_drive(GPIOC, LL_GPIO_PIN_1, false);
+  HOST_CHECK_EQ(io_snapshot() & 3U, 3U);
+
+  // PC1 is inverted, parked it would read 1 without the mask
+  io_close_input(TEST_IN_PC1);
+  HOST_CHECK_EQ(io_snapshot() & 3U, 1U);
+
+  // Port C is gated once PC0 and PC8 are closed as well
+  io_close_input(TEST_IN_PC0);
+  io_close_output(TEST_OUT_PC8);
+  HOST_CHECK_EQ(io_power_save() & LL_AHB1_GRP1_PERIPH_GPIOC,
+                LL_AHB1_GRP1_PERIPH_GPIOC);
+  HOST_CHECK_EQ(io_snapshot() & 3U, 0U);
+
+  // Reading PC0 wakes the port but only restores PC0
+  HOST_CHECK_EQ(io_get_val(TEST_IN_PC0), 1U);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOC, LL_GPIO_PIN_0), LL_GPIO_MODE_INPUT);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOC, LL_GPIO_PIN_1), LL_GPIO_MODE_ANALOG);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOC, LL_GPIO_PIN_8), LL_GPIO_MODE_ANALOG);
+  HOST_CHECK_EQ(io_snapshot() & 3U, 1U);
+
+  // PC1 comes back with its pull-up
+  HOST_CHECK_EQ(io_get_val(TEST_IN_PC1), 1U);
+  HOST_CHECK_EQ(LL_GPIO_GetPinPull(GPIOC, LL_GPIO_PIN_1), LL_GPIO_PULL_UP);
+
+  HOST_CHECK_EQ(sim_gpio_gated_writes(GPIOC), 0U);
+}
+
+/**
+ * @brief: A floating pin on an enabled EXTI line is kept open, so its port
+ *         is never gated.
+ **/
+static void test_exti_kept(void) {
+  io_init(&testConfg);
+  sim_gpio_release(GPIOC, LL_GPIO_PIN_0 | LL_GPIO_PIN_1);
+
+  // PC10 as another module's wake input, parked by the earlier tests
+  LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_10, LL_GPIO_MODE_INPUT);
+  LL_EXTI_EnableIT_0_31(LL_EXTI_LINE_10);
+
+  io_close_input(TEST_IN_PC0);
+  io_close_input(TEST_IN_PC1);
+  io_close_output(TEST_OUT_PC8);
+  HOST_CHECK_EQ(io_power_save() & LL_AHB1_GRP1_PERIPH_GPIOC, 0U);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOC, LL_GPIO_PIN_10), LL_GPIO_MODE_INPUT);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOC, LL_GPIO_PIN_11), LL_GPIO_MODE_ANALOG);
+
+  LL_EXTI_DisableIT_0_31(LL_EXTI_LINE_10);
+  HOST_CHECK_EQ(io_power_save() & LL_AHB1_GRP1_PERIPH_GPIOC,
+                LL_AHB1_GRP1_PERIPH_GPIOC);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  test_init();
+  test_park_unused();
+  test_gate_and_wake();
+  test_snapshot_closed();
+  test_exti_kept();
+
+  HOST_DONE();
+}
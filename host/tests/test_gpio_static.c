@@ -0,0 +1,236 @@
+/**
+ * @file test_gpio_static.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Instantiates IO_STATIC_CONFIG() for a board list spread over ports
+ * A, B, C and H and checks the port images the compiler folded. Then it
+ * checks the MODER/PUPDR/OSPEEDR/OTYPER/ODR values IO_STATIC_INIT() writes
+ * against the same list run through io_init(), and against values worked
+ * out by hand from the reset state. The lists the static checks must refuse
+ * are built by test_gpio_static_fail.c.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <gpio_static.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Every setting at least once, ports D and E left out
+#define TEST_IO(IN, OUT, X)                                               \
+  IN(X, A, IO_PIN_00, IO_PULL_UP, IO_INVERT_DISABLE)                      \
+  IN(X, A, IO_PIN_01, IO_PULL_DWN, IO_INVERT_ENABLE)                      \
+  OUT(X, A, IO_PIN_05, IO_SPDR_FREQ_HIGH, IO_OUPT_OPNDRAIN, SET)          \
+  OUT(X, B, IO_PIN_03, IO_SPDR_FREQ_VHIGH, IO_OUPT_PUSHPULL, RESET)       \
+  OUT(X, B, IO_PIN_10, IO_SPDR_FREQ_MED, IO_OUPT_PUSHPULL, SET)           \
+  IN(X, C, IO_PIN_13, IO_PULL_NO, IO_INVERT_ENABLE)                       \
+  OUT(X, C, IO_PIN_15, IO_SPDR_FREQ_LOW, IO_OUPT_OPNDRAIN, RESET)         \
+  IN(X, H, IO_PIN_00, IO_PULL_DWN, IO_INVERT_DISABLE)                     \
+  OUT(X, H, IO_PIN_01, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, SET)
+
+#define TEST_NUM_PORTS IO_STATIC_NUM_PORTS
+
+// A 2 bit field value at a pin's position
+#define TEST_F2(pinPos, val) ((uint32_t)(val) << (2U * (pinPos)))
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) types
+////////////////////////////////////////////////////////////////////////////////
+
+/* The registers the images write */
+typedef struct {
+  uint32_t portModer;
+  uint32_t portPupdr;
+  uint32_t portOspeedr;
+  uint32_t portOtyper;
+  uint32_t portOdr;
+
+} test_regs_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+IO_STATIC_CONFIG(testIO, TEST_IO);
+
+// In the order of the port images
+static GPIO_TypeDef *const testPorts[TEST_NUM_PORTS] = {
+    GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOH};
+
+static test_regs_t resetRegs[TEST_NUM_PORTS];
+static uint32_t resetClocks;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_read(test_regs_t *portRegs) {
+  // BSRR reaches ODR on the next simulator step
+  sim_advance(1U);
+
+  for (uint32_t portIdx = 0U; portIdx < TEST_NUM_PORTS; portIdx++) {
+    portRegs[portIdx].portModer = READ_REG(testPorts[portIdx]->MODER);
+    portRegs[portIdx].portPupdr = READ_REG(testPorts[portIdx]->PUPDR);
+    portRegs[portIdx].portOspeedr = READ_REG(testPorts[portIdx]->OSPEEDR);
+    portRegs[portIdx].portOtyper = READ_REG(testPorts[portIdx]->OTYPER);
+    portRegs[portIdx].portOdr = READ_REG(testPorts[portIdx]->ODR);
+  }
+}
+
+// Back to the reset state, clocks included
+static void test_reset(void) {
+  for (uint32_t portIdx = 0U; portIdx < TEST_NUM_PORTS; portIdx++) {
+    WRITE_REG(testPorts[portIdx]->MODER, resetRegs[portIdx].portModer);
+    WRITE_REG(testPorts[portIdx]->PUPDR, resetRegs[portIdx].portPupdr);
+    WRITE_REG(testPorts[portIdx]->OSPEEDR, resetRegs[portIdx].portOspeedr);
+    WRITE_REG(testPorts[portIdx]->OTYPER, resetRegs[portIdx].portOtyper);
+    WRITE_REG(testPorts[portIdx]->ODR, resetRegs[portIdx].portOdr);
+  }
+  WRITE_REG(RCC->AHB1ENR, resetClocks);
+  sim_advance(1U);
+}
+
+/**
+ * @brief: The handler arrays, in list order, and the folded port images.
+ **/
+static void test_images(void) {
+  HOST_CHECK_EQ(testIO.numIOInputs, 4U);
+  HOST_CHECK_EQ(testIO.numIOOutputs, 5U);
+  HOST_CHECK(testIO.ioInputs[1U].portx == GPIOA);
+  HOST_CHECK_EQ(testIO.ioInputs[1U].ioPinNo, IO_PIN_01);
+  HOST_CHECK_EQ(testIO.ioInputs[1U].ioPupdr, IO_PULL_DWN);
+  HOST_CHECK_EQ(testIO.ioInputs[1U].ioInInvert, IO_INVERT_ENABLE);
+  HOST_CHECK(testIO.ioOutputs[4U].portx == GPIOH);
+  HOST_CHECK_EQ(testIO.ioOutputs[4U].ioPinNo, IO_PIN_01);
+  HOST_CHECK_EQ(testIO.ioOutputs[4U].ioInitVal, SET);
+
+  // Port A: PA0 and PA1 inputs, PA5 open-drain output
+  const io_port_image_t *portA = &testIOPorts[0U];
+  HOST_CHECK(portA->portx == GPIOA);
+  HOST_CHECK_EQ(portA->ioClkEn, LL_AHB1_GRP1_PERIPH_GPIOA);
+  HOST_CHECK_EQ(portA->moderMsk, TEST_F2(0U, 3U) | TEST_F2(1U, 3U) |
+                                     TEST_F2(5U, 3U));
+  HOST_CHECK_EQ(portA->moderVal, TEST_F2(5U, LL_GPIO_MODE_OUTPUT));
+  HOST_CHECK_EQ(portA->pupdrMsk, TEST_F2(0U, 3U) | TEST_F2(1U, 3U));
+  HOST_CHECK_EQ(portA->pupdrVal, TEST_F2(0U, LL_GPIO_PULL_UP) |
+                                     TEST_F2(1U, LL_GPIO_PULL_DOWN));
+  HOST_CHECK_EQ(portA->ospeedrMsk, TEST_F2(5U, 3U));
+  HOST_CHECK_EQ(portA->ospeedrVal, TEST_F2(5U, LL_GPIO_SPEED_FREQ_HIGH));
+  HOST_CHECK_EQ(portA->otyperMsk, LL_GPIO_PIN_5);
+  HOST_CHECK_EQ(portA->otyperVal, LL_GPIO_PIN_5);
+  HOST_CHECK_EQ(portA->bsrrVal, LL_GPIO_PIN_5);
+
+  // Port B: outputs only, PB3 reset and PB10 set
+  const io_port_image_t *portB = &testIOPorts[1U];
+  HOST_CHECK_EQ(portB->pupdrMsk, 0U);
+  HOST_CHECK_EQ(portB->otyperMsk, LL_GPIO_PIN_3 | LL_GPIO_PIN_10);
+  HOST_CHECK_EQ(portB->otyperVal, 0U);
+  HOST_CHECK_EQ(portB->bsrrVal, (LL_GPIO_PIN_3 << 16U) | LL_GPIO_PIN_10);
+
+  // Ports D and E are not in the list and keep their clock off
+  HOST_CHECK_EQ(testIOPorts[3U].ioClkEn, 0U);
+  HOST_CHECK_EQ(testIOPorts[3U].moderMsk, 0U);
+  HOST_CHECK_EQ(testIOPorts[4U].ioClkEn, 0U);
+  HOST_CHECK(testIOPorts[5U].portx == GPIOH);
+  HOST_CHECK_EQ(testIOPorts[5U].ioClkEn, LL_AHB1_GRP1_PERIPH_GPIOH);
+}
+
+/**
+ * @brief: Port A and B after init, worked out from the reset state. The
+ *         pins outside the list keep their reset settings (the debug pins
+ *         PA13/PA14 and PB3/PB4 among them, until PB3 is taken).
+ **/
+static void test_expected(const test_regs_t *portRegs) {
+  const test_regs_t *regsA = &portRegs[0U];
+  const test_regs_t *regsB = &portRegs[1U];
+
+  HOST_CHECK_EQ(regsA->portModer,
+                (resetRegs[0U].portModer &
+                 ~(TEST_F2(0U, 3U) | TEST_F2(1U, 3U) | TEST_F2(5U, 3U))) |
+                    TEST_F2(5U, LL_GPIO_MODE_OUTPUT));
+  HOST_CHECK_EQ(regsA->portPupdr,
+                (resetRegs[0U].portPupdr &
+                 ~(TEST_F2(0U, 3U) | TEST_F2(1U, 3U))) |
+                    TEST_F2(0U, LL_GPIO_PULL_UP) |
+                    TEST_F2(1U, LL_GPIO_PULL_DOWN));
+  HOST_CHECK_EQ(regsA->portOspeedr,
+                (resetRegs[0U].portOspeedr & ~TEST_F2(5U, 3U)) |
+                    TEST_F2(5U, LL_GPIO_SPEED_FREQ_HIGH));
+  HOST_CHECK_EQ(regsA->portOtyper, LL_GPIO_PIN_5);
+  HOST_CHECK_EQ(regsA->portOdr, LL_GPIO_PIN_5);
+
+  HOST_CHECK_EQ(regsB->portModer,
+                (resetRegs[1U].portModer &
+                 ~(TEST_F2(3U, 3U) | TEST_F2(10U, 3U))) |
+                    TEST_F2(3U, LL_GPIO_MODE_OUTPUT) |
+                    TEST_F2(10U, LL_GPIO_MODE_OUTPUT));
+  HOST_CHECK_EQ(regsB->portPupdr, resetRegs[1U].portPupdr);
+  HOST_CHECK_EQ(regsB->portOspeedr,
+                (resetRegs[1U].portOspeedr &
+                 ~(TEST_F2(3U, 3U) | TEST_F2(10U, 3U))) |
+                    TEST_F2(3U, LL_GPIO_SPEED_FREQ_VERY_HIGH) |
+                    TEST_F2(10U, LL_GPIO_SPEED_FREQ_MEDIUM));
+  HOST_CHECK_EQ(regsB->portOdr, LL_GPIO_PIN_10);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  test_regs_t staticRegs[TEST_NUM_PORTS];
+  test_regs_t dynRegs[TEST_NUM_PORTS];
+
+  test_read(resetRegs);
+  resetClocks = READ_REG(RCC->AHB1ENR);
+
+  test_images();
+
+  // The precomputed images
+  HOST_CHECK_EQ(IO_STATIC_INIT(testIO), EXIT_SUCCESS);
+  test_read(staticRegs);
+  HOST_CHECK_EQ(READ_REG(RCC->AHB1ENR) & ~resetClocks,
+                LL_AHB1_GRP1_PERIPH_GPIOA | LL_AHB1_GRP1_PERIPH_GPIOB |
+                    LL_AHB1_GRP1_PERIPH_GPIOC | LL_AHB1_GRP1_PERIPH_GPIOH);
+  test_expected(staticRegs);
+
+  // The same list folded at run time
+  test_reset();
+  HOST_CHECK_EQ(io_init(&testIO), EXIT_SUCCESS);
+  test_read(dynRegs);
+  test_expected(dynRegs);
+
+  for (uint32_t portIdx = 0U; portIdx < TEST_NUM_PORTS; portIdx++) {
+    HOST_CHECK_EQ(staticRegs[portIdx].portModer, dynRegs[portIdx].portModer);
+    HOST_CHECK_EQ(staticRegs[portIdx].portPupdr, dynRegs[portIdx].portPupdr);
+    HOST_CHECK_EQ(staticRegs[portIdx].portOspeedr,
+                  dynRegs[portIdx].portOspeedr);
+    HOST_CHECK_EQ(staticRegs[portIdx].portOtyper,
+                  dynRegs[portIdx].portOtyper);
+    HOST_CHECK_EQ(staticRegs[portIdx].portOdr, dynRegs[portIdx].portOdr);
+  }
+
+  // Ports D and E untouched
+  HOST_CHECK(memcmp(&dynRegs[3U], &resetRegs[3U], 2U * sizeof(test_regs_t)) ==
+             0);
+
+  // The config drives the rest of the API as usual
+  sim_gpio_drive(GPIOC, LL_GPIO_PIN_13, false);
+  HOST_CHECK_EQ(io_get_val(2U), 1U);
+  HOST_CHECK_EQ(io_set_val(4U, 0U), EXIT_SUCCESS);
+  HOST_CHECK_EQ(io_get_output_val(4U), 0U);
+
+  HOST_DONE();
+}
@@ -0,0 +1,56 @@
+/**
+ * @file test_gpio_static_fail.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Board lists gpio_static.h must refuse at compile time, one per
+ * TEST_FAIL_x define. Each is a ctest that builds this file and passes only
+ * if the build stops on the expected _Static_assert (see CMakeLists.txt).
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <gpio_static.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(TEST_FAIL_DUP)
+// PA5 as an input and as an output
+#define TEST_IO(IN, OUT, X)                              \
+  IN(X, A, IO_PIN_04, IO_PULL_UP, IO_INVERT_DISABLE)     \
+  IN(X, A, IO_PIN_05, IO_PULL_UP, IO_INVERT_DISABLE)     \
+  OUT(X, A, IO_PIN_05, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, RESET)
+#elif defined(TEST_FAIL_RANGE)
+// Pin 16, past the end of the port
+#define TEST_IO(IN, OUT, X) \
+  IN(X, B, (IO_PIN_15 << 1U), IO_PULL_NO, IO_INVERT_DISABLE)
+#elif defined(TEST_FAIL_MASK)
+// Two pins in one entry
+#define TEST_IO(IN, OUT, X) \
+  OUT(X, C, (IO_PIN_01 | IO_PIN_02), IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, SET)
+#elif defined(TEST_FAIL_SETTING)
+// A pull value PUPDR reserves
+#define TEST_IO(IN, OUT, X) IN(X, C, IO_PIN_03, 3U, IO_INVERT_DISABLE)
+#else
+#error "test: define one of the TEST_FAIL_x cases"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+IO_STATIC_CONFIG(testIO, TEST_IO);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) { return (int)IO_STATIC_INIT(testIO); }
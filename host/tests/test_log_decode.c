@@ -0,0 +1,155 @@
+/**
+ * @file test_log_decode.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Records statements with LOG(), streams them with log_dump() over
+ * ttys and formats them back with the host decoder reading this binary's
+ * ELF. Every line must read as printf() of the same statement would print
+ * it, with the timestamps the records were written at.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <log.h>
+
+/* Tool includes */
+#include <host_decode.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_DUMP_MAX 512U
+#define TEST_LINE_MAX 64U
+#define TEST_NUM_RECORDS 7U
+
+// Between two records
+#define TEST_GAP_CYCLES 1000U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t testTtysConfig = {
+    .ttysBaud = 2000000U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_8,
+};
+
+static uint8_t testDump[TEST_DUMP_MAX];
+static uint32_t testDumpLen;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_dump_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  if (testDumpLen < TEST_DUMP_MAX) testDump[testDumpLen] = txData;
+  testDumpLen++;
+}
+
+static char *test_decode(const uint8_t *dumpData, size_t dumpLen,
+                         const elf_file_t *elfFile, uint32_t *decodeRet) {
+  char *testReport = NULL;
+  size_t reportLen = 0U;
+
+  FILE *reportStream = open_memstream(&testReport, &reportLen);
+  *decodeRet = log_decode(reportStream, dumpData, dumpLen, elfFile);
+  (void)fclose(reportStream);
+
+  return testReport;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  elf_file_t elfFile;
+  uint32_t logTimes[TEST_NUM_RECORDS];
+  char testLines[TEST_NUM_RECORDS][TEST_LINE_MAX];
+  uint32_t decodeRet = EXIT_SUCCESS;
+  uint32_t recIdx = 0U;
+
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+
+  // What printf() makes of each statement, next to its record
+#define TEST_LOG(fmt, ...)                                          \
+  do {                                                              \
+    logTimes[recIdx] = DWT->CYCCNT;                                 \
+    LOG(fmt, ##__VA_ARGS__);                                        \
+    (void)snprintf(testLines[recIdx++], TEST_LINE_MAX, fmt,         \
+                   ##__VA_ARGS__);                                  \
+    sim_advance(TEST_GAP_CYCLES);                                   \
+  } while (0)
+
+  TEST_LOG("boot");
+  TEST_LOG("adc %u mV on ch %u", 3300U, 5U);
+  TEST_LOG("temp %d C, offset %+d", -12, 3);
+  TEST_LOG("%s ready on %s", "shell", "ttys2");
+  TEST_LOG("reg %08lx|%-4lu|%c|100%%", 0xBEEFUL, 42UL, 'k');
+  TEST_LOG("pad [%*u] [%.3x]", 6, 31U, 0xAU);
+  TEST_LOG("four %X %o %i %u", 0xCAFEU, 8U, -1, 4000000000U);
+#undef TEST_LOG
+
+  // Dump over ttys, as the host would capture it
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testTtysConfig), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_dump_hook, NULL);
+  HOST_CHECK_EQ(log_dump(TTYS_INSTANCE_2, LOG_NUM_RECORDS), TEST_NUM_RECORDS);
+  while (!LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+  HOST_CHECK(testDumpLen <= TEST_DUMP_MAX);
+  HOST_CHECK_EQ(log_dump(TTYS_INSTANCE_2, LOG_NUM_RECORDS), 0U);
+
+  // Decoded with this binary's format strings and .rodata
+  HOST_CHECK_EQ(elf_open(&elfFile, "/proc/self/exe"), EXIT_SUCCESS);
+  char *testReport = test_decode(testDump, testDumpLen, &elfFile, &decodeRet);
+  HOST_CHECK_EQ(decodeRet, EXIT_SUCCESS);
+  printf("%s", testReport);
+
+  const char *reportLine = testReport;
+  for (recIdx = 0U; recIdx < TEST_NUM_RECORDS; recIdx++) {
+    char expLine[TEST_LINE_MAX + 16U];
+    size_t expLen = (size_t)snprintf(expLine, sizeof(expLine), "[%10u] %s\n",
+                                     logTimes[recIdx], testLines[recIdx]);
+
+    HOST_CHECK(strncmp(reportLine, expLine, expLen) == 0);
+    if (strncmp(reportLine, expLine, expLen) != 0) {
+      printf("expected: %s", expLine);
+      break;
+    }
+    reportLine += expLen;
+  }
+  HOST_CHECK_EQ(*reportLine, '\0');
+  free(testReport);
+
+  // An ID outside the format section, e.g. from another image
+  const uint8_t badDump[] = {0x01U, 0x00U, 0x00U, 0x00U, 0x05U, 0x00U,
+                             0x00U, 0x00U, 0x00U};
+  testReport = test_decode(badDump, sizeof(badDump), &elfFile, &decodeRet);
+  HOST_CHECK_EQ(decodeRet, EXIT_SUCCESS);
+  HOST_CHECK(strcmp(testReport, "[         5] <bad format 00000001>\n") == 0);
+  free(testReport);
+
+  // A cut dump is refused
+  testReport = test_decode(testDump, testDumpLen - 1U, &elfFile, &decodeRet);
+  HOST_CHECK_EQ(decodeRet, HOST_DECODE_ERR_FORMAT);
+  free(testReport);
+
+  elf_close(&elfFile);
+
+  HOST_DONE();
+}
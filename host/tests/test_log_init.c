@@ -0,0 +1,193 @@
+/**
+ * @file test_log_init.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Runs log_init() again over the ring the previous "boot" left in
+ * RAM, as after a reset: a valid ring keeps its records, a corrupted header
+ * or a ring written by another image is discarded, and slots reserved but
+ * never published come back as lost records. A fault capture goes through
+ * NVIC_SystemReset(), which the simulator's reset hook turns into a jump
+ * back to boot.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <setjmp.h>
+
+/* Module includes. The source, for the ring and its header CRC, the library
+ * copy is then never pulled in */
+#include <log.c>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_NUM_RECORDS 3U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t testTtysConfig = {
+    .ttysBaud = 2000000U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_8,
+};
+
+static jmp_buf testBoot;
+static uint32_t testDumpLen;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_reset(void) { longjmp(testBoot, 1); }
+
+static void test_dump_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  (void)txData;
+  testDumpLen++;
+}
+
+static uint32_t test_pending(void) {
+  return logRing.logHead - logRing.logTail;
+}
+
+static const char *test_fmt(uint32_t recIdx) {
+  return logRing.logRecords[(logRing.logTail + recIdx) &
+                            (LOG_NUM_RECORDS - 1U)]
+      .logFmt;
+}
+
+// A few records from the "previous boot", the ring otherwise valid
+static void test_fill(void) {
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  (void)log_dump(TTYS_INSTANCE_2, LOG_NUM_RECORDS);
+  for (uint32_t recIdx = 0U; recIdx < TEST_NUM_RECORDS; recIdx++) {
+    LOG("test: record %u", recIdx);
+  }
+  HOST_CHECK_EQ(test_pending(), TEST_NUM_RECORDS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  const uint32_t faultFrame[8U] = {0U, 0U, 0U, 0U, 0U, 0x08001235U,
+                                   0x08000F10U, 0x21000000U};
+  log_fault_t logFault;
+
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testTtysConfig), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_dump_hook, NULL);
+
+  // Cold boot, RAM holds whatever it powered up with
+  (void)memset(&logRing, 0xA5, sizeof(logRing));
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(logRing.logMagic, LOG_RING_MAGIC);
+  HOST_CHECK_EQ(logRing.logCrc, log_header_crc());
+  HOST_CHECK_EQ(test_pending(), 0U);
+  HOST_CHECK_EQ(log_get_drops(), 0U);
+  HOST_CHECK_EQ(log_get_fault(&logFault), LOG_ERR_NO_FAULT);
+
+  // Valid ring: the records and their format pointers are kept
+  test_fill();
+  const char *keptFmt = test_fmt(0U);
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(test_pending(), TEST_NUM_RECORDS);
+  for (uint32_t recIdx = 0U; recIdx < TEST_NUM_RECORDS; recIdx++) {
+    HOST_CHECK(test_fmt(recIdx) == keptFmt);
+  }
+
+  // Corrupted header: a bit flipped after the CRC was taken
+  test_fill();
+  logRing.logFault.faultBfar ^= 1U << 7U;
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(test_pending(), 0U);
+  HOST_CHECK_EQ(logRing.logFault.faultBfar, 0U);
+  HOST_CHECK_EQ(logRing.logCrc, log_header_crc());
+
+  // Written by another image: the header is intact but its ID differs
+  test_fill();
+  logRing.logImageId ^= 1U;
+  logRing.logCrc = log_header_crc();
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(test_pending(), 0U);
+  HOST_CHECK_EQ(logRing.logImageId, logImageId);
+
+  // More records than the ring holds cannot be right either
+  test_fill();
+  logRing.logHead = logRing.logTail + LOG_NUM_RECORDS + 1U;
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(test_pending(), 0U);
+
+  // Reset between reserving a slot and publishing it: one slot still NULL,
+  // one holding a stale pointer from an earlier lap
+  test_fill();
+  logRing.logRecords[logRing.logHead++ & (LOG_NUM_RECORDS - 1U)].logFmt =
+      NULL;
+  log_record_t *staleRec =
+      &logRing.logRecords[logRing.logHead++ & (LOG_NUM_RECORDS - 1U)];
+  staleRec->logFmt = (const char *)(uintptr_t)0x20001000U;
+  staleRec->logNumArgs = 3U;
+  LOG("test: after the lost ones");
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(test_pending(), TEST_NUM_RECORDS + 3U);
+  HOST_CHECK(test_fmt(0U) == keptFmt);
+  HOST_CHECK(test_fmt(TEST_NUM_RECORDS) == logLostFmt);
+  HOST_CHECK(test_fmt(TEST_NUM_RECORDS + 1U) == logLostFmt);
+  HOST_CHECK_EQ(staleRec->logNumArgs, 0U);
+  HOST_CHECK(log_fmt_is_valid(test_fmt(TEST_NUM_RECORDS + 2U)));
+  HOST_CHECK(test_fmt(TEST_NUM_RECORDS + 2U) != logLostFmt);
+
+  // None of them stops the dump any more
+  HOST_CHECK_EQ(log_dump(TTYS_INSTANCE_2, LOG_NUM_RECORDS),
+                TEST_NUM_RECORDS + 3U);
+
+  // Fault: captured, reset, and reported once on the next boot
+  test_fill();
+  sim_set_reset_hook(test_reset);
+  if (setjmp(testBoot) == 0) {
+    log_fault_capture(faultFrame);
+    HOST_CHECK(false);
+  }
+  sim_set_reset_hook(NULL);
+
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(test_pending(), TEST_NUM_RECORDS);
+  HOST_CHECK_EQ(log_get_fault(&logFault), EXIT_SUCCESS);
+  HOST_CHECK_EQ(logFault.faultPc, faultFrame[6U]);
+  HOST_CHECK_EQ(logFault.faultLr, faultFrame[5U]);
+  HOST_CHECK_EQ(logFault.faultPsr, faultFrame[7U]);
+
+  while (!LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+  testDumpLen = 0U;
+  HOST_CHECK_EQ(log_postmortem(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  while (!LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+  HOST_CHECK_EQ(testDumpLen, sizeof(log_fault_t) + 4U +
+                                 TEST_NUM_RECORDS * (9U + 4U));
+  HOST_CHECK_EQ(test_pending(), 0U);
+
+  // The capture is cleared and the ring stays valid over the next reset
+  HOST_CHECK_EQ(log_get_fault(&logFault), LOG_ERR_NO_FAULT);
+  HOST_CHECK_EQ(log_postmortem(TTYS_INSTANCE_2), LOG_ERR_NO_FAULT);
+  LOG("test: after the report");
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(test_pending(), 1U);
+
+  HOST_DONE();
+}
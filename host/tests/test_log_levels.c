@@ -0,0 +1,229 @@
+/**
+ * @file test_log_levels.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief The same levelled call sites, built once per LOG_LEVEL setting
+ * (see CMakeLists.txt). Statements above a module's max level must leave
+ * neither a record nor a format string in the binary, statements above its
+ * default level are recorded only while log_set_verbose() has the module's
+ * bit set. The records are read back through log_dump() and the host
+ * decoder.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+// memmem()
+#define _GNU_SOURCE
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <log.h>
+
+/* Tool includes */
+#include <host_decode.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_DUMP_MAX 512U
+#define TEST_EXP_MAX 256U
+
+// "[timestamp] " in front of every decoded record
+#define TEST_TIME_LEN 13U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) types
+////////////////////////////////////////////////////////////////////////////////
+
+/* One call site of test_sites() */
+typedef struct {
+  uint32_t logMod;
+  uint32_t logLevel;
+  const char *logText;
+
+} test_site_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t testTtysConfig = {
+    .ttysBaud = 2000000U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_8,
+};
+
+static const uint32_t testMax[LOG_NUM_MODULES] = {
+    LOG_LEVEL_MAX_APP, LOG_LEVEL_MAX_TMR, LOG_LEVEL_MAX_TTYS,
+    LOG_LEVEL_MAX_GPIO};
+static const uint32_t testDefault[LOG_NUM_MODULES] = {
+    LOG_LEVEL_DEFAULT_APP, LOG_LEVEL_DEFAULT_TMR, LOG_LEVEL_DEFAULT_TTYS,
+    LOG_LEVEL_DEFAULT_GPIO};
+
+// Must list test_sites() in order
+static const test_site_t testSites[] = {
+    {LOG_MOD_APP, LOG_LEVEL_ERROR, "test: app error"},
+    {LOG_MOD_APP, LOG_LEVEL_WARN, "test: app warning"},
+    {LOG_MOD_APP, LOG_LEVEL_INFO, "test: app info"},
+    {LOG_MOD_APP, LOG_LEVEL_DEBUG, "test: app debug"},
+    {LOG_MOD_APP, LOG_LEVEL_TRACE, "test: app trace"},
+    {LOG_MOD_TMR, LOG_LEVEL_ERROR, "test: tmr error"},
+    {LOG_MOD_TMR, LOG_LEVEL_INFO, "test: tmr info"},
+    {LOG_MOD_TMR, LOG_LEVEL_TRACE, "test: tmr trace"},
+};
+
+#define TEST_NUM_SITES (sizeof(testSites) / sizeof(testSites[0]))
+
+static elf_file_t elfFile;
+static uint8_t testDump[TEST_DUMP_MAX];
+static uint32_t testDumpLen;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_sites(void) {
+  LOG_ERR(APP, "test: app error");
+  LOG_WRN(APP, "test: app warning");
+  LOG_INF(APP, "test: app info");
+  LOG_DBG(APP, "test: app debug");
+  LOG_TRC(APP, "test: app trace");
+  LOG_ERR(TMR, "test: tmr error");
+  LOG_INF(TMR, "test: tmr info");
+  LOG_TRC(TMR, "test: tmr trace");
+}
+
+static void test_dump_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  if (testDumpLen < TEST_DUMP_MAX) testDump[testDumpLen] = txData;
+  testDumpLen++;
+}
+
+/**
+ * @brief: Runs the call sites and checks that exactly the statements
+ *         enabled for the verbose mask were recorded, in order.
+ **/
+static void test_run(uint32_t verboseMsk) {
+  char expText[TEST_EXP_MAX] = "";
+  char *testReport = NULL;
+  size_t reportLen = 0U;
+
+  for (uint32_t siteIdx = 0U; siteIdx < TEST_NUM_SITES; siteIdx++) {
+    const test_site_t *testSite = &testSites[siteIdx];
+    uint32_t siteMax = testDefault[testSite->logMod];
+
+    if (verboseMsk & (1U << testSite->logMod)) {
+      siteMax = testMax[testSite->logMod];
+    }
+    if (siteMax > testMax[testSite->logMod]) {
+      siteMax = testMax[testSite->logMod];
+    }
+
+    if (testSite->logLevel <= siteMax) {
+      (void)strcat(expText, testSite->logText);
+      (void)strcat(expText, "\n");
+    }
+  }
+
+  HOST_CHECK_EQ(logVerboseMsk, verboseMsk);
+  test_sites();
+
+  testDumpLen = 0U;
+  (void)log_dump(TTYS_INSTANCE_2, LOG_NUM_RECORDS);
+  while (!LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+  HOST_CHECK(testDumpLen <= TEST_DUMP_MAX);
+
+  FILE *reportStream = open_memstream(&testReport, &reportLen);
+  HOST_CHECK_EQ(log_decode(reportStream, testDump, testDumpLen, &elfFile),
+                EXIT_SUCCESS);
+  (void)fclose(reportStream);
+
+  // Without the timestamps
+  char *reportIn = testReport;
+  char *reportOut = testReport;
+  while (*reportIn != '\0') {
+    char *lineEnd = strchr(reportIn, '\n');
+
+    if (lineEnd == NULL || lineEnd - reportIn < (ptrdiff_t)TEST_TIME_LEN) {
+      break;
+    }
+    size_t lineLen = (size_t)(lineEnd - reportIn) + 1U - TEST_TIME_LEN;
+    (void)memmove(reportOut, reportIn + TEST_TIME_LEN, lineLen);
+    reportOut += lineLen;
+    reportIn = lineEnd + 1U;
+  }
+  *reportOut = '\0';
+
+  HOST_CHECK(strcmp(testReport, expText) == 0);
+  if (strcmp(testReport, expText) != 0) {
+    printf("mask %u, recorded:\n%sexpected:\n%s", verboseMsk, testReport,
+           expText);
+  }
+  free(testReport);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  elf_section_t fmtSection;
+
+  printf("levels max %u/%u, default %u/%u (app/tmr)\n", LOG_LEVEL_MAX_APP,
+         LOG_LEVEL_MAX_TMR, LOG_LEVEL_DEFAULT_APP, LOG_LEVEL_DEFAULT_TMR);
+
+  // Format strings are in the binary only for the statements compiled in
+  HOST_CHECK_EQ(elf_open(&elfFile, "/proc/self/exe"), EXIT_SUCCESS);
+  HOST_CHECK_EQ(elf_find_section(&elfFile, "log_fmt", &fmtSection),
+                EXIT_SUCCESS);
+  for (uint32_t siteIdx = 0U; siteIdx < TEST_NUM_SITES; siteIdx++) {
+    const test_site_t *testSite = &testSites[siteIdx];
+    bool isCompiled = testSite->logLevel <= testMax[testSite->logMod];
+    bool isInElf = memmem(fmtSection.secData, fmtSection.secSize,
+                          testSite->logText,
+                          strlen(testSite->logText) + 1U) != NULL;
+
+    HOST_CHECK_EQ(isInElf, isCompiled);
+  }
+
+  HOST_CHECK_EQ(log_init(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testTtysConfig), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_dump_hook, NULL);
+
+  // Default levels, then each module raised and restored in turn
+  test_run(0U);
+  HOST_CHECK_EQ(log_set_verbose(LOG_MOD_APP, true), EXIT_SUCCESS);
+  test_run(1U << LOG_MOD_APP);
+  HOST_CHECK_EQ(log_set_verbose(LOG_MOD_TMR, true), EXIT_SUCCESS);
+  test_run((1U << LOG_MOD_APP) | (1U << LOG_MOD_TMR));
+  HOST_CHECK_EQ(log_set_verbose(LOG_MOD_APP, false), EXIT_SUCCESS);
+  test_run(1U << LOG_MOD_TMR);
+  HOST_CHECK_EQ(log_set_verbose(LOG_MOD_TMR, false), EXIT_SUCCESS);
+  test_run(0U);
+
+  // Unknown module, and PRIMASK left as the caller had it
+  HOST_CHECK_EQ(log_set_verbose(LOG_NUM_MODULES, true), LOG_ERR_MOD);
+  HOST_CHECK_EQ(logVerboseMsk, 0U);
+  __disable_irq();
+  HOST_CHECK_EQ(log_set_verbose(LOG_MOD_GPIO, true), EXIT_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  __enable_irq();
+  HOST_CHECK_EQ(logVerboseMsk, 1U << LOG_MOD_GPIO);
+
+  HOST_CHECK_EQ(log_get_drops(), 0U);
+  elf_close(&elfFile);
+
+  HOST_DONE();
+}
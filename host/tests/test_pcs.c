@@ -0,0 +1,183 @@
+/**
+ * @file test_pcs.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Feeds synthetic exception frames through the PC sampler and checks
+ * the binning, the outside count and the binary dump sent over ttys.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <pcs.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// 64 KiB of code in 512 bins, 128 bytes each
+#define TEST_TEXT_START 0x08000000U
+#define TEST_TEXT_END 0x08010000U
+#define TEST_SHIFT 7U
+
+#define TEST_DUMP_MAX 256U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const pcs_config_t testPcsConfig = {
+    .tmrIdx = TMR_INSTANCE2,
+    .pcsStart = TEST_TEXT_START,
+    .pcsEnd = TEST_TEXT_END,
+    .pcsPeriodUs = 200U,
+};
+
+static const ttys_config_t testTtysConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+};
+
+// Synthetic PCs and the bin each one must land in, -1 for outside
+static const struct {
+  uint32_t framePc;
+  int32_t binIdx;
+} testSamples[] = {
+    {TEST_TEXT_START, 0},
+    {TEST_TEXT_START + 0x7EU, 0},
+    {TEST_TEXT_START + 0x80U, 1},
+    {TEST_TEXT_START + 0x1234U, 0x24},
+    {TEST_TEXT_START + 0x1236U, 0x24},
+    {TEST_TEXT_START + 0x12FEU, 0x25},
+    {TEST_TEXT_END - 2U, 511},
+    {TEST_TEXT_END, -1},
+    {TEST_TEXT_START - 2U, -1},
+    {0x20000100U, -1},
+};
+
+#define TEST_NUM_SAMPLES (sizeof(testSamples) / sizeof(testSamples[0]))
+
+static uint8_t testDump[TEST_DUMP_MAX];
+static uint32_t testDumpLen;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_dump_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  if (testDumpLen < TEST_DUMP_MAX) testDump[testDumpLen] = txData;
+  testDumpLen++;
+}
+
+static uint32_t test_get_u32(const uint8_t *dumpPtr) {
+  return (uint32_t)dumpPtr[0] | ((uint32_t)dumpPtr[1] << 8U) |
+         ((uint32_t)dumpPtr[2] << 16U) | ((uint32_t)dumpPtr[3] << 24U);
+}
+
+/**
+ * @brief: Each period the sampler bins the PC the simulator stacked for the
+ *         tmr IRQ.
+ **/
+static void test_binning(uint32_t *expBins) {
+  pcs_status_t pcsStatus;
+
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
+  HOST_CHECK_EQ(pcs_init(&testPcsConfig), EXIT_SUCCESS);
+  HOST_CHECK_EQ(pcs_start(), EXIT_SUCCESS);
+
+  // The period the tmr module actually programmed
+  uint64_t tmrPeriod = (uint64_t)(LL_TIM_GetPrescaler(TIM2) + 1U) *
+                       (LL_TIM_GetAutoReload(TIM2) + 1U);
+
+  for (uint32_t sampleIdx = 0U; sampleIdx < TEST_NUM_SAMPLES; sampleIdx++) {
+    sim_set_pc(testSamples[sampleIdx].framePc);
+    sim_advance(tmrPeriod);
+
+    if (testSamples[sampleIdx].binIdx >= 0) {
+      expBins[testSamples[sampleIdx].binIdx]++;
+    }
+  }
+
+  HOST_CHECK_EQ(pcs_stop(), EXIT_SUCCESS);
+
+  // Stopped, no more samples are taken
+  sim_advance(10U * tmrPeriod);
+
+  HOST_CHECK_EQ(pcs_get_status(&pcsStatus), EXIT_SUCCESS);
+  HOST_CHECK_EQ(pcsStatus.numSamples, TEST_NUM_SAMPLES);
+  HOST_CHECK_EQ(pcsStatus.numOutside, 3U);
+  HOST_CHECK_EQ(pcsStatus.pcsShift, TEST_SHIFT);
+  HOST_CHECK(!pcsStatus.isRunning);
+  HOST_CHECK(pcsStatus.maxCycles <= pcsStatus.totalCycles);
+}
+
+/**
+ * @brief: The dump carries the header and one entry per bin that was hit,
+ *         in bin order, counts as LEB128 varints.
+ **/
+static void test_dump(const uint32_t *expBins) {
+  pcs_status_t pcsStatus;
+  uint32_t binIdx = 0U;
+  uint32_t numUsed = 0U;
+
+  for (binIdx = 0U; binIdx < PCS_NUM_BINS; binIdx++) {
+    if (expBins[binIdx] != 0U) numUsed++;
+  }
+
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testTtysConfig), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_dump_hook, NULL);
+
+  HOST_CHECK_EQ(pcs_dump(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  while (!LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+
+  (void)pcs_get_status(&pcsStatus);
+
+  // "PCS", version, start, shift, period, samples, outside, max, ppm, used
+  HOST_CHECK_EQ(testDumpLen, 31U + 3U * numUsed);
+  HOST_CHECK(testDump[0] == 'P' && testDump[1] == 'C' && testDump[2] == 'S');
+  HOST_CHECK_EQ(testDump[3], PCS_DUMP_VERSION);
+  HOST_CHECK_EQ(test_get_u32(&testDump[4]), TEST_TEXT_START);
+  HOST_CHECK_EQ(testDump[8], TEST_SHIFT);
+  HOST_CHECK_EQ(test_get_u32(&testDump[9]), testPcsConfig.pcsPeriodUs);
+  HOST_CHECK_EQ(test_get_u32(&testDump[13]), TEST_NUM_SAMPLES);
+  HOST_CHECK_EQ(test_get_u32(&testDump[17]), 3U);
+  HOST_CHECK_EQ(test_get_u32(&testDump[21]), pcsStatus.maxCycles);
+  HOST_CHECK_EQ(test_get_u32(&testDump[25]), pcsStatus.overheadPpm);
+  HOST_CHECK_EQ(testDump[29] | (testDump[30] << 8U), numUsed);
+
+  // Every count here is below 0x80, so each varint is a single byte
+  const uint8_t *dumpPtr = &testDump[31];
+  for (binIdx = 0U; binIdx < PCS_NUM_BINS; binIdx++) {
+    if (expBins[binIdx] == 0U) continue;
+
+    HOST_CHECK_EQ(dumpPtr[0] | (dumpPtr[1] << 8U), binIdx);
+    HOST_CHECK_EQ(dumpPtr[2], expBins[binIdx]);
+    dumpPtr += 3U;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  static uint32_t expBins[PCS_NUM_BINS];
+
+  test_binning(expBins);
+  test_dump(expBins);
+
+  HOST_DONE();
+}
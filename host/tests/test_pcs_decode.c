@@ -0,0 +1,178 @@
+/**
+ * @file test_pcs_decode.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Samples PCs inside two functions of this very binary, dumps the
+ * histogram over ttys and maps it back to the functions with the host
+ * decoder reading this binary's ELF.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <pcs.h>
+
+/* Tool includes */
+#include <host_decode.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_DUMP_MAX 256U
+
+#define TEST_NUM_HOT 6U
+#define TEST_NUM_COLD 2U
+#define TEST_NUM_OUTSIDE 2U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t testTtysConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+};
+
+static uint8_t testDump[TEST_DUMP_MAX];
+static uint32_t testDumpLen;
+
+static volatile uint32_t testSink;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// The two functions the samples land in, large enough for a few bins each
+__attribute__((noinline)) static void test_hot(void) {
+  for (uint32_t loopIdx = 0U; loopIdx < 64U; loopIdx++) {
+    testSink += loopIdx * 3U;
+    testSink ^= loopIdx;
+  }
+}
+
+__attribute__((noinline)) static void test_cold(void) {
+  for (uint32_t loopIdx = 0U; loopIdx < 64U; loopIdx++) {
+    testSink -= loopIdx * 5U;
+    testSink ^= loopIdx << 2U;
+  }
+}
+
+static void test_dump_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  if (testDumpLen < TEST_DUMP_MAX) testDump[testDumpLen] = txData;
+  testDumpLen++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  elf_file_t elfFile;
+  elf_section_t elfText;
+  pcs_status_t pcsStatus;
+  char *testReport = NULL;
+  size_t reportLen = 0U;
+
+  test_hot();
+  test_cold();
+
+  uint32_t hotAddr = (uint32_t)(uintptr_t)test_hot;
+  uint32_t coldAddr = (uint32_t)(uintptr_t)test_cold;
+  uint32_t textStart = ((hotAddr < coldAddr) ? hotAddr : coldAddr) & ~15U;
+  uint32_t textEnd = ((hotAddr > coldAddr) ? hotAddr : coldAddr) + 256U;
+
+  // The ELF of this test
+  HOST_CHECK_EQ(elf_open(&elfFile, "/proc/self/exe"), EXIT_SUCCESS);
+  HOST_CHECK_EQ(elf_find_section(&elfFile, ".text", &elfText), EXIT_SUCCESS);
+  HOST_CHECK(elfText.secAddr <= hotAddr &&
+             hotAddr < elfText.secAddr + elfText.secSize);
+  HOST_CHECK(strcmp(elf_find_sym(&elfFile, hotAddr)->symName, "test_hot") ==
+             0);
+  HOST_CHECK(strcmp(elf_find_sym(&elfFile, coldAddr + 4U)->symName,
+                    "test_cold") == 0);
+  HOST_CHECK_EQ(elf_find_section(&elfFile, ".no_such", &elfText),
+                HOST_DECODE_ERR_NOT_FOUND);
+
+  // Sampling PCs one bin into each function, so the bin starts inside it
+  const pcs_config_t pcsConfig = {
+      .tmrIdx = TMR_INSTANCE2,
+      .pcsStart = textStart,
+      .pcsEnd = textEnd,
+      .pcsPeriodUs = 200U,
+  };
+
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
+  HOST_CHECK_EQ(pcs_init(&pcsConfig), EXIT_SUCCESS);
+  HOST_CHECK_EQ(pcs_get_status(&pcsStatus), EXIT_SUCCESS);
+  HOST_CHECK(pcsStatus.pcsShift <= 2U);
+  HOST_CHECK_EQ(pcs_start(), EXIT_SUCCESS);
+
+  uint64_t tmrPeriod = (uint64_t)(LL_TIM_GetPrescaler(TIM2) + 1U) *
+                       (LL_TIM_GetAutoReload(TIM2) + 1U);
+  uint32_t binSize = 1U << pcsStatus.pcsShift;
+
+  for (uint32_t sampleIdx = 0U; sampleIdx < TEST_NUM_HOT; sampleIdx++) {
+    sim_set_pc(hotAddr + binSize * (1U + sampleIdx % 3U));
+    sim_advance(tmrPeriod);
+  }
+  for (uint32_t sampleIdx = 0U; sampleIdx < TEST_NUM_COLD; sampleIdx++) {
+    sim_set_pc(coldAddr + binSize);
+    sim_advance(tmrPeriod);
+  }
+  for (uint32_t sampleIdx = 0U; sampleIdx < TEST_NUM_OUTSIDE; sampleIdx++) {
+    sim_set_pc(textEnd + 0x1000U);
+    sim_advance(tmrPeriod);
+  }
+  HOST_CHECK_EQ(pcs_stop(), EXIT_SUCCESS);
+
+  // Dump over ttys, as the host would capture it
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testTtysConfig), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_dump_hook, NULL);
+  HOST_CHECK_EQ(pcs_dump(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  while (!LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+  HOST_CHECK(testDumpLen <= TEST_DUMP_MAX);
+
+  // Decoded by function, hottest first
+  FILE *reportStream = open_memstream(&testReport, &reportLen);
+  HOST_CHECK_EQ(pcs_decode(reportStream, testDump, testDumpLen, &elfFile),
+                EXIT_SUCCESS);
+  (void)fclose(reportStream);
+  printf("%s", testReport);
+
+  const char *hotRow = strstr(testReport, "6,60.00,test_hot\n");
+  const char *coldRow = strstr(testReport, "2,20.00,test_cold\n");
+  HOST_CHECK(hotRow != NULL);
+  HOST_CHECK(coldRow != NULL);
+  HOST_CHECK(hotRow < coldRow);
+  HOST_CHECK(strstr(testReport, "10 samples every 200 us, 2 outside") !=
+             NULL);
+
+  // A truncated dump is refused
+  reportStream = fopen("/dev/null", "w");
+  HOST_CHECK_EQ(pcs_decode(reportStream, testDump, testDumpLen - 1U,
+                           &elfFile),
+                HOST_DECODE_ERR_FORMAT);
+  HOST_CHECK_EQ(pcs_decode(reportStream, testDump, 10U, &elfFile),
+                HOST_DECODE_ERR_FORMAT);
+  (void)fclose(reportStream);
+
+  free(testReport);
+  elf_close(&elfFile);
+
+  HOST_DONE();
+}
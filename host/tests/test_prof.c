@@ -0,0 +1,224 @@
+/**
+ * @file test_prof.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Drives nested interrupts through the simulated NVIC with the prof
+ * hooks built in (PROF_ENABLE, see CMakeLists.txt). A slow low-priority
+ * timer callback lets a fast high-priority timer preempt it, and the main
+ * loop sleeps in prof_idle(). Checks that each vector is charged its own
+ * cycles only, the nested frames going to the one they interrupted, and that
+ * idle is the window minus the ISRs.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <prof.h>
+#include <tmr.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#if !PROF_ENABLE
+#error "test: build with PROF_ENABLE=1"
+#endif
+
+// Fast timer and its cost, slow timer and its cost
+#define TEST_FAST_US 100U
+#define TEST_FAST_COST_US 5U
+#define TEST_SLOW_MS 1U
+#define TEST_SLOW_COST_US 250U
+
+#define TEST_WINDOW_MS 20U
+
+// Cycles the hooks and the handlers may add per interrupt
+#define TEST_HOOK_CYCLES 64U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static tmr_config_t testFastConfig = {
+    .tmrInstancesId = TMR_INSTANCE2,
+    .tmrBaseUnit = TMR_BASE_1US,
+    .tmrPriority = TMR_PRIORITY_HIGH,
+};
+
+static tmr_config_t testSlowConfig = {
+    .tmrInstancesId = TMR_INSTANCE3,
+    .tmrBaseUnit = TMR_BASE_1MS,
+    .tmrPriority = TMR_PRIORITY_LOW,
+};
+
+static bool testInSlow;
+static uint32_t testFastIrqs;
+static uint32_t testFastNested;
+static uint32_t testSlowIrqs;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_fast_cb(void) {
+  testFastIrqs++;
+  if (testInSlow) testFastNested++;
+  sim_advance(SIM_US(TEST_FAST_COST_US));
+}
+
+// A long callback that lets the more urgent timer through while it works
+static void test_slow_cb(void) {
+  testSlowIrqs++;
+  testInSlow = true;
+  __enable_irq();
+  sim_advance(SIM_US(TEST_SLOW_COST_US));
+  __disable_irq();
+  testInSlow = false;
+}
+
+static bool test_near(uint64_t testVal, uint64_t testExp, uint64_t testTol) {
+  return testVal + testTol >= testExp && testVal <= testExp + testTol;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  prof_vec_stats_t fastStats;
+  prof_vec_stats_t slowStats;
+  prof_vec_stats_t idleStats;
+
+  HOST_CHECK_EQ(prof_init(0U, SIM_CORE_CLOCK), PROF_ERR_CONFIG);
+  HOST_CHECK_EQ(prof_init(TEST_WINDOW_MS, SIM_CORE_CLOCK), EXIT_SUCCESS);
+  HOST_CHECK_EQ(prof_get_stats(PROF_NUM_VECS, &idleStats), PROF_ERR_VEC);
+
+  // Frames opened and closed by hand: the inner frame is charged to the
+  // outer one, not to its vector
+  prof_enter();
+  sim_advance(100U);
+  prof_enter();
+  sim_advance(30U);
+  prof_enter();
+  sim_advance(7U);
+  prof_exit(PROF_VEC_USART2);
+  prof_exit(PROF_VEC_USART1);
+  sim_advance(50U);
+  prof_exit(PROF_VEC_USART6);
+
+  HOST_CHECK_EQ(prof_get_stats(PROF_VEC_USART6, &slowStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(prof_get_stats(PROF_VEC_USART1, &fastStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(prof_get_stats(PROF_VEC_USART2, &idleStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(slowStats.profCount, 1U);
+  HOST_CHECK_EQ(slowStats.profCycles, 150U);
+  HOST_CHECK_EQ(fastStats.profCycles, 30U);
+  HOST_CHECK_EQ(idleStats.profCycles, 7U);
+  HOST_CHECK_EQ(idleStats.profMaxCycles, 7U);
+
+  // Deeper than the stack: the frames past it are not charged, the ones
+  // that fit still are
+  for (uint32_t nestIdx = 0U; nestIdx < PROF_MAX_NEST + 2U; nestIdx++) {
+    prof_enter();
+    sim_advance(10U);
+  }
+  for (uint32_t nestIdx = 0U; nestIdx < PROF_MAX_NEST + 2U; nestIdx++) {
+    prof_exit(PROF_VEC_CAP_DMA);
+  }
+  HOST_CHECK_EQ(prof_get_stats(PROF_VEC_CAP_DMA, &idleStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(idleStats.profCount, PROF_MAX_NEST);
+  HOST_CHECK_EQ(idleStats.profCycles, 10U * (PROF_MAX_NEST + 2U));
+  HOST_CHECK_EQ(idleStats.profMaxCycles, 30U);
+
+  // The timers, settled for a period before the window starts
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2 |
+                           LL_APB1_GRP1_PERIPH_TIM3);
+  HOST_CHECK_EQ(tmr_init(&testFastConfig), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_init(&testSlowConfig), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE2, test_fast_cb, TEST_FAST_US),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE3, test_slow_cb, TEST_SLOW_MS),
+                TMR_RETURN_SUCCESS);
+
+  // tmr sets the priorities as sub-priorities, which never preempt each
+  // other. The slow timer gets a lower preemption level for TIM2 to nest in.
+  NVIC_SetPriority(TIM3_IRQn, 1U);
+  sim_advance(SIM_MS(TEST_SLOW_MS));
+
+  HOST_CHECK_EQ(prof_init(TEST_WINDOW_MS, SIM_CORE_CLOCK), EXIT_SUCCESS);
+  testFastIrqs = 0U;
+  testFastNested = 0U;
+  testSlowIrqs = 0U;
+
+  uint32_t windowStart = DWT->CYCCNT;
+  while (DWT->CYCCNT - windowStart < SIM_MS(TEST_WINDOW_MS)) {
+    prof_idle();
+  }
+  uint32_t profWindow = DWT->CYCCNT - windowStart;
+
+  HOST_CHECK_EQ(prof_get_stats(PROF_VEC_TIM2, &fastStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(prof_get_stats(PROF_VEC_TIM3, &slowStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(prof_get_stats(PROF_VEC_IDLE, &idleStats), EXIT_SUCCESS);
+  printf("window %u: TIM2 %u/%llu/%u, TIM3 %u/%llu/%u, IDLE %u/%llu/%u, "
+         "%u of %u TIM2 nested\n",
+         profWindow, fastStats.profCount,
+         (unsigned long long)fastStats.profCycles, fastStats.profMaxCycles,
+         slowStats.profCount, (unsigned long long)slowStats.profCycles,
+         slowStats.profMaxCycles, idleStats.profCount,
+         (unsigned long long)idleStats.profCycles, idleStats.profMaxCycles,
+         testFastNested, testFastIrqs);
+
+  // Every interrupt was counted, and some TIM2 ran inside TIM3
+  HOST_CHECK_EQ(fastStats.profCount, testFastIrqs);
+  HOST_CHECK_EQ(slowStats.profCount, testSlowIrqs);
+  HOST_CHECK(test_near(testFastIrqs, TEST_WINDOW_MS * 1000U / TEST_FAST_US,
+                       TEST_WINDOW_MS * 1000U / TEST_FAST_US / 20U));
+  HOST_CHECK(test_near(testSlowIrqs, TEST_WINDOW_MS / TEST_SLOW_MS, 1U));
+  HOST_CHECK(testFastNested >= testSlowIrqs);
+
+  // Self cycles. A TIM3 frame lasts its callback's TEST_SLOW_COST_US, the
+  // TIM2 frames nested in it take part of that and are charged to TIM2 only.
+  uint64_t slowFrames = (uint64_t)testSlowIrqs * SIM_US(TEST_SLOW_COST_US);
+  uint64_t nestedCycles =
+      (uint64_t)testFastNested * SIM_US(TEST_FAST_COST_US);
+
+  HOST_CHECK(test_near(fastStats.profCycles,
+                       (uint64_t)testFastIrqs * SIM_US(TEST_FAST_COST_US),
+                       (uint64_t)testFastIrqs * TEST_HOOK_CYCLES));
+  HOST_CHECK(test_near(slowStats.profCycles, slowFrames - nestedCycles,
+                       (uint64_t)testSlowIrqs * TEST_HOOK_CYCLES));
+  HOST_CHECK(fastStats.profMaxCycles <
+             SIM_US(TEST_FAST_COST_US) + TEST_HOOK_CYCLES);
+  HOST_CHECK(slowStats.profMaxCycles <
+             SIM_US(TEST_SLOW_COST_US) + TEST_HOOK_CYCLES);
+  HOST_CHECK(slowStats.profMaxCycles <=
+             SIM_US(TEST_SLOW_COST_US) - SIM_US(TEST_FAST_COST_US) +
+                 TEST_HOOK_CYCLES);
+
+  // Idle is the rest of the window: the ISRs that woke the core nested in
+  // the idle frame and are not counted in it, and the main loop is short
+  uint64_t isrCycles = fastStats.profCycles + slowStats.profCycles;
+  HOST_CHECK(idleStats.profCycles + isrCycles <= profWindow);
+  HOST_CHECK(profWindow - idleStats.profCycles - isrCycles <
+             (uint64_t)idleStats.profCount * TEST_HOOK_CYCLES);
+  HOST_CHECK(idleStats.profMaxCycles <= SIM_US(TEST_FAST_US));
+  HOST_CHECK(idleStats.profCount <= testFastIrqs + testSlowIrqs + 1U);
+
+  // The report starts a new window once the interval is up
+  HOST_CHECK_EQ(prof_poll(), 1U);
+  HOST_CHECK_EQ(prof_get_stats(PROF_VEC_IDLE, &idleStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(idleStats.profCount, 0U);
+  HOST_CHECK_EQ(prof_poll(), 0U);
+
+  HOST_CHECK_EQ(__get_PRIMASK(), 0U);
+
+  HOST_DONE();
+}
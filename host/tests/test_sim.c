@@ -0,0 +1,273 @@
+/**
+ * @file test_sim.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Checks the simulated peripherals against the reference manual
+ * behaviour the modules rely on, through the LL accessors only.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Simulator includes */
+#include <stm32f4xx_ll_bus.h>
+#include <stm32f4xx_ll_cortex.h>
+#include <stm32f4xx_ll_exti.h>
+#include <stm32f4xx_ll_gpio.h>
+#include <stm32f4xx_ll_tim.h>
+#include <stm32f4xx_ll_usart.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t tim3Irqs;
+static uint32_t tim4Irqs;
+static uint32_t tim4Nested;
+static uint32_t exti0Irqs;
+static uint32_t usartRxCount;
+static uint8_t usartRxData[8];
+static uint32_t usartTxCount;
+static uint64_t usartTxTime;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+void TIM3_IRQHandler(void) {
+  LL_TIM_ClearFlag_UPDATE(TIM3);
+  tim3Irqs++;
+}
+
+// Lower priority than TIM3, which preempts it when raised inside
+void TIM4_IRQHandler(void) {
+  LL_TIM_ClearFlag_UPDATE(TIM4);
+  tim4Irqs++;
+
+  uint32_t tim3Before = tim3Irqs;
+  NVIC_SetPendingIRQ(TIM3_IRQn);
+  if (tim3Irqs == tim3Before + 1U) tim4Nested++;
+}
+
+void EXTI0_IRQHandler(void) {
+  LL_EXTI_ClearFlag_0_31(LL_EXTI_LINE_0);
+  exti0Irqs++;
+}
+
+void USART1_IRQHandler(void) {
+  if (LL_USART_ReadReg(USART1, SR) & LL_USART_SR_RXNE) {
+    uint8_t rxData = LL_USART_ReceiveData8(USART1);
+    if (usartRxCount < sizeof(usartRxData)) usartRxData[usartRxCount] = rxData;
+    usartRxCount++;
+  }
+}
+
+static void usart_tx_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  (void)txData;
+  usartTxCount++;
+  usartTxTime = sim_now();
+}
+
+/**
+ * @brief: A 1 ms time base raises its IRQ once per period, and DWT->CYCCNT
+ *         follows the virtual clock.
+ **/
+static void test_tim_time_base(void) {
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM3);
+  LL_TIM_SetPrescaler(TIM3, 83U);
+  LL_TIM_SetAutoReload(TIM3, 999U);
+  LL_TIM_SetUpdateSource(TIM3, LL_TIM_UPDATESOURCE_COUNTER);
+  LL_TIM_GenerateEvent_UPDATE(TIM3);
+  LL_TIM_EnableIT_UPDATE(TIM3);
+  NVIC_SetPriority(TIM3_IRQn, 1U);
+  NVIC_EnableIRQ(TIM3_IRQn);
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  uint32_t cycStart = DWT->CYCCNT;
+
+  LL_TIM_EnableCounter(TIM3);
+  sim_advance(SIM_MS(10) + SIM_US(500));
+
+  HOST_CHECK_EQ(tim3Irqs, 10U);
+  HOST_CHECK_EQ(LL_TIM_GetCounter(TIM3), 500U);
+  HOST_CHECK(DWT->CYCCNT - cycStart >= (uint32_t)SIM_MS(10));
+
+  // Masked, the IRQ waits for PRIMASK to clear
+  __disable_irq();
+  sim_advance(SIM_MS(1));
+  HOST_CHECK_EQ(tim3Irqs, 10U);
+  __enable_irq();
+  HOST_CHECK_EQ(tim3Irqs, 11U);
+
+  // WFI sleeps to the next update
+  uint64_t wfiStart = sim_now();
+  __WFI();
+  HOST_CHECK_EQ(tim3Irqs, 12U);
+  HOST_CHECK(sim_now() - wfiStart <= SIM_MS(1));
+}
+
+/**
+ * @brief: A higher priority IRQ raised inside a handler preempts it.
+ **/
+static void test_nvic_nesting(void) {
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM4);
+  LL_TIM_SetPrescaler(TIM4, 0U);
+  LL_TIM_SetAutoReload(TIM4, 8399U);
+  LL_TIM_EnableIT_UPDATE(TIM4);
+  NVIC_SetPriority(TIM4_IRQn, 5U);
+  NVIC_EnableIRQ(TIM4_IRQn);
+  LL_TIM_EnableCounter(TIM4);
+
+  sim_advance(SIM_US(250));
+  LL_TIM_DisableCounter(TIM4);
+
+  HOST_CHECK_EQ(tim4Irqs, 2U);
+  HOST_CHECK_EQ(tim4Nested, 2U);
+}
+
+/**
+ * @brief: Frames take their BRR time, and RTS holds the peer while DR is
+ *         unread instead of overrunning.
+ **/
+static void test_usart_line(void) {
+  sim_usart_stats_t usartStats;
+
+  LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_USART1);
+  LL_USART_WriteReg(USART1, BRR, 729U);  // 115200 baud from 84 MHz
+  LL_USART_SetTransferDirection(USART1, LL_USART_DIRECTION_TX_RX);
+  LL_USART_Enable(USART1);
+  sim_usart_set_tx_hook(USART1, usart_tx_hook, NULL);
+
+  uint64_t txStart = sim_now();
+  LL_USART_TransmitData8(USART1, 'A');
+  HOST_CHECK(LL_USART_IsActiveFlag_TXE(USART1));  // Moved to the shifter
+  LL_USART_TransmitData8(USART1, 'B');
+  HOST_CHECK(!LL_USART_IsActiveFlag_TXE(USART1));
+
+  while (!LL_USART_IsActiveFlag_TC(USART1)) {
+  }
+
+  HOST_CHECK_EQ(usartTxCount, 2U);
+  HOST_CHECK_EQ(usartTxTime - txStart, 2U * 10U * 729U);
+
+  // Unread DR with RTS flow control, the peer waits
+  LL_USART_SetHWFlowCtrl(USART1, LL_USART_HWCONTROL_RTS_CTS);
+  static const uint8_t rxData[] = {'x', 'y', 'z'};
+  sim_usart_rx_push(USART1, rxData, sizeof(rxData));
+  sim_advance(SIM_MS(1));
+
+  sim_usart_get_stats(USART1, &usartStats);
+  HOST_CHECK_EQ(usartStats.rxBytes, 1U);
+  HOST_CHECK_EQ(usartStats.rxOverruns, 0U);
+  HOST_CHECK(usartStats.rtsHolds >= 1U);
+  HOST_CHECK_EQ(sim_usart_rx_queued(USART1), 2U);
+
+  // Reading from the ISR releases it
+  LL_USART_EnableIT_RXNE(USART1);
+  NVIC_EnableIRQ(USART1_IRQn);
+  sim_advance(SIM_MS(1));
+
+  HOST_CHECK_EQ(usartRxCount, 3U);
+  HOST_CHECK(usartRxData[0] == 'x' && usartRxData[2] == 'z');
+
+  // Without flow control an unread DR overruns
+  NVIC_DisableIRQ(USART1_IRQn);
+  LL_USART_SetHWFlowCtrl(USART1, LL_USART_HWCONTROL_NONE);
+  sim_usart_rx_push(USART1, rxData, sizeof(rxData));
+  sim_advance(SIM_MS(1));
+
+  sim_usart_get_stats(USART1, &usartStats);
+  HOST_CHECK_EQ(usartStats.rxOverruns, 2U);
+  HOST_CHECK(LL_USART_ReadReg(USART1, SR) & LL_USART_SR_ORE);
+  HOST_CHECK_EQ(LL_USART_ReceiveData8(USART1), 'x');
+}
+
+/**
+ * @brief: Pins follow modes, pulls and drivers; writes to a gated port are
+ *         lost; edges on an EXTI line raise its IRQ.
+ **/
+static void test_gpio_exti(void) {
+  LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOC);
+  LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_5, LL_GPIO_MODE_OUTPUT);
+  LL_GPIO_SetOutputPin(GPIOC, LL_GPIO_PIN_5);
+  HOST_CHECK(LL_GPIO_IsInputPinSet(GPIOC, LL_GPIO_PIN_5));
+
+  LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_6, LL_GPIO_MODE_INPUT);
+  LL_GPIO_SetPinPull(GPIOC, LL_GPIO_PIN_6, LL_GPIO_PULL_UP);
+  HOST_CHECK(LL_GPIO_IsInputPinSet(GPIOC, LL_GPIO_PIN_6));
+  sim_gpio_drive(GPIOC, LL_GPIO_PIN_6, false);
+  HOST_CHECK(!LL_GPIO_IsInputPinSet(GPIOC, LL_GPIO_PIN_6));
+
+  LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_6, LL_GPIO_MODE_ANALOG);
+  sim_gpio_drive(GPIOC, LL_GPIO_PIN_6, true);
+  HOST_CHECK(!LL_GPIO_IsInputPinSet(GPIOC, LL_GPIO_PIN_6));
+
+  // Gated, the write is dropped and counted
+  LL_AHB1_GRP1_DisableClock(LL_AHB1_GRP1_PERIPH_GPIOC);
+  HOST_CHECK_EQ(LL_GPIO_ReadInputPort(GPIOC), 0U);
+  LL_GPIO_SetPinMode(GPIOC, LL_GPIO_PIN_7, LL_GPIO_MODE_OUTPUT);
+  HOST_CHECK_EQ(sim_gpio_gated_writes(GPIOC), 1U);
+  HOST_CHECK_EQ(LL_GPIO_GetPinMode(GPIOC, LL_GPIO_PIN_7), LL_GPIO_MODE_INPUT);
+  LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOC);
+  HOST_CHECK(LL_GPIO_IsOutputPinSet(GPIOC, LL_GPIO_PIN_5));
+  HOST_CHECK_EQ(sim_gpio_gated_writes(GPIOC), 1U);
+
+  // PA0 rising edge on EXTI0 (EXTICR routes line 0 to port A at reset)
+  LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOA);
+  LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_0, LL_GPIO_MODE_INPUT);
+  LL_GPIO_SetPinPull(GPIOA, LL_GPIO_PIN_0, LL_GPIO_PULL_DOWN);
+  LL_EXTI_EnableRisingTrig_0_31(LL_EXTI_LINE_0);
+  LL_EXTI_EnableIT_0_31(LL_EXTI_LINE_0);
+  NVIC_EnableIRQ(EXTI0_IRQn);
+
+  sim_gpio_drive(GPIOA, LL_GPIO_PIN_0, true);
+  sim_gpio_drive(GPIOA, LL_GPIO_PIN_0, false);
+  sim_gpio_drive(GPIOA, LL_GPIO_PIN_0, true);
+  HOST_CHECK_EQ(exti0Irqs, 2U);
+}
+
+/**
+ * @brief: An encoder counts both ways and wraps with an update.
+ **/
+static void test_tim_encoder(void) {
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
+  LL_TIM_SetAutoReload(TIM2, 99U);
+  LL_TIM_SetEncoderMode(TIM2, LL_TIM_ENCODERMODE_X4_TI12);
+  LL_TIM_EnableCounter(TIM2);
+
+  sim_tim_encoder(TIM2, 10);
+  HOST_CHECK_EQ(LL_TIM_GetCounter(TIM2), 10U);
+  sim_tim_encoder(TIM2, -15);
+  HOST_CHECK_EQ(LL_TIM_GetCounter(TIM2), 95U);
+  HOST_CHECK(LL_TIM_GetDirection(TIM2) == LL_TIM_COUNTERDIRECTION_DOWN);
+  HOST_CHECK(LL_TIM_IsActiveFlag_UPDATE(TIM2));
+
+  // Inverted TI1 reverses the count
+  LL_TIM_IC_SetPolarity(TIM2, LL_TIM_CHANNEL_CH1, LL_TIM_IC_POLARITY_FALLING);
+  sim_tim_encoder(TIM2, 5);
+  HOST_CHECK_EQ(LL_TIM_GetCounter(TIM2), 90U);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  test_tim_time_base();
+  test_nvic_nesting();
+  test_usart_line();
+  test_gpio_exti();
+  test_tim_encoder();
+
+  HOST_DONE();
+}
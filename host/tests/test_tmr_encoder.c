@@ -0,0 +1,248 @@
+/**
+ * @file test_tmr_encoder.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Quadrature encoder instances on the simulated TIM: the counter is
+ * stepped with sim_tim_encoder() through sequences that wrap the 16-bit
+ * counter many times in both directions, and the extended position from
+ * tmr_enc_read() must follow them, past the 32-bit range of the wrap base.
+ * Also covers a wrap the IRQ has not handled yet, the velocity sampled by
+ * tmr_enc_sample() and the open errors.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes. The source, for tmr_enc_wrap_delta() and the wrap base,
+ * the library copy is then never pulled in */
+#include <tmr.c>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_PERIOD_US 1000U
+
+// Largest step taken at once, less than half a wrap so no wrap is missed
+#define TEST_MAX_STEP 30000
+
+// Steps of the long runs
+#define TEST_NUM_STEPS 5000U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static tmr_config_t testEncConfig = {
+    .tmrInstancesId = TMR_INSTANCE3,
+    .tmrBaseUnit = TMR_BASE_1US,
+    .tmrPriority = TMR_PRIORITY_HIGH,
+};
+
+static tmr_config_t testTickConfig = {
+    .tmrInstancesId = TMR_INSTANCE4,
+    .tmrBaseUnit = TMR_BASE_1MS,
+    .tmrPriority = TMR_PRIORITY_LOW,
+};
+
+static const tmr_enc_config_t testEnc = {
+    .encMode = TMR_ENC_MODE_TI12,
+    .encFilter = 3U,
+    .encPeriodUs = TEST_PERIOD_US,
+    .isInverted = false,
+};
+
+// Where the position should be
+static int64_t testPos;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_tick_cb(void) {}
+
+static int64_t test_read(void) {
+  int64_t encPos = 0;
+
+  HOST_CHECK_EQ(tmr_enc_read(TMR_INSTANCE3, &encPos), TMR_RETURN_SUCCESS);
+  return encPos;
+}
+
+static void test_step(int32_t encSteps) {
+  sim_tim_encoder(TIM3, encSteps);
+  testPos += encSteps;
+}
+
+// Moves the wrap base by whole wraps, as if the axis had travelled there
+static void test_rebase(int64_t newPos) {
+  int64_t baseDelta =
+      ((newPos - testPos) / (int64_t)TMR_ENC_WRAP) * (int64_t)TMR_ENC_WRAP;
+
+  __disable_irq();
+  tmr[TMR_INSTANCE3].encWrapBase += baseDelta;
+  testPos += baseDelta;
+  __enable_irq();
+  HOST_CHECK_EQ(test_read(), testPos);
+}
+
+/**
+ * @brief: Steps through a sequence of sizes up to TEST_MAX_STEP, drifting
+ *         one way, and checks the position after each step.
+ *
+ * @param[in]: stepSign. 1 or -1
+ **/
+static void test_run(int32_t stepSign) {
+  uint32_t stepSeed = 12345U;
+  uint32_t numBad = 0U;
+
+  for (uint32_t stepIdx = 0U; stepIdx < TEST_NUM_STEPS; stepIdx++) {
+    stepSeed = stepSeed * 1103515245U + 12345U;
+
+    // Three steps forward for one back
+    int32_t encSteps = (int32_t)((stepSeed >> 8U) % TEST_MAX_STEP);
+    if ((stepIdx & 3U) == 3U) encSteps = -encSteps / 2;
+
+    test_step(stepSign * encSteps);
+    if (test_read() != testPos) numBad++;
+  }
+
+  HOST_CHECK_EQ(numBad, 0U);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  tmr_enc_config_t badEnc = testEnc;
+  int32_t encVelocity = 0;
+  int64_t encPos = 0;
+
+  // The direction comes from the half the counter is in after the wrap
+  HOST_CHECK_EQ(tmr_enc_wrap_delta(0U), (int32_t)TMR_ENC_WRAP);
+  HOST_CHECK_EQ(tmr_enc_wrap_delta(TMR_ENC_WRAP / 2U - 1U),
+                (int32_t)TMR_ENC_WRAP);
+  HOST_CHECK_EQ(tmr_enc_wrap_delta(TMR_ENC_WRAP / 2U),
+                -(int32_t)TMR_ENC_WRAP);
+  HOST_CHECK_EQ(tmr_enc_wrap_delta(TMR_ENC_ARR), -(int32_t)TMR_ENC_WRAP);
+
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM3 |
+                           LL_APB1_GRP1_PERIPH_TIM4);
+
+  // Open errors
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_NUM_INSTANCES, &testEnc),
+                TMR_INVALID_IDX);
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_INSTANCE3, NULL), TMR_CONFIG_NULL);
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_INSTANCE3, &testEnc), TMR_CONFIG_NULL);
+  HOST_CHECK_EQ(tmr_init(&testEncConfig), TMR_RETURN_SUCCESS);
+  badEnc.encMode = TMR_ENC_NUM_MODES;
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_INSTANCE3, &badEnc),
+                TMR_INVALID_ENC_CONFIG);
+  badEnc = testEnc;
+  badEnc.encFilter = TMR_ENC_FILTER_MAX + 1U;
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_INSTANCE3, &badEnc),
+                TMR_INVALID_ENC_CONFIG);
+  badEnc = testEnc;
+  badEnc.encPeriodUs = 0U;
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_INSTANCE3, &badEnc),
+                TMR_INVALID_ENC_CONFIG);
+  HOST_CHECK_EQ(tmr_enc_read(TMR_INSTANCE3, &encPos), TMR_INST_NOTOPEN);
+
+  // A timer instance is not an encoder
+  HOST_CHECK_EQ(tmr_init(&testTickConfig), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE4, test_tick_cb, 1U),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_enc_read(TMR_INSTANCE4, &encPos), TMR_INST_NOT_ENCODER);
+  HOST_CHECK_EQ(tmr_enc_get_velocity(TMR_INSTANCE4, &encVelocity),
+                TMR_INST_NOT_ENCODER);
+
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_INSTANCE3, &testEnc),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_INSTANCE3, &testEnc),
+                TMR_INST_ALREADY_OPEN);
+  HOST_CHECK_EQ(LL_TIM_GetAutoReload(TIM3), TMR_ENC_ARR);
+  HOST_CHECK_EQ(test_read(), 0);
+
+  // Below 0 and back, one wrap each way
+  test_step(-5);
+  HOST_CHECK_EQ(LL_TIM_GetCounter(TIM3), TMR_ENC_ARR - 4U);
+  HOST_CHECK_EQ(test_read(), -5);
+  test_step(12);
+  HOST_CHECK_EQ(test_read(), 7);
+
+  // Long runs forward then back, many wraps each
+  test_run(1);
+  HOST_CHECK(testPos > 100 * (int64_t)TMR_ENC_WRAP);
+  test_run(-1);
+  test_run(-1);
+  HOST_CHECK(testPos < -100 * (int64_t)TMR_ENC_WRAP);
+
+  // A wrap the IRQ has not carried yet is counted once, by the read
+  test_step(1000 - (int32_t)LL_TIM_GetCounter(TIM3));
+  __disable_irq();
+  test_step(-2000);
+  HOST_CHECK(LL_TIM_IsActiveFlag_UPDATE(TIM3));
+  HOST_CHECK_EQ(test_read(), testPos);
+  __enable_irq();
+  sim_advance(1U);
+  HOST_CHECK(!LL_TIM_IsActiveFlag_UPDATE(TIM3));
+  HOST_CHECK_EQ(test_read(), testPos);
+
+  // Across the 32-bit boundaries of the wrap base, both ways
+  test_rebase((int64_t)INT32_MAX - 1000000);
+  test_run(1);
+  HOST_CHECK(testPos > (int64_t)INT32_MAX);
+  test_rebase((int64_t)UINT32_MAX - 1000000);
+  test_run(1);
+  HOST_CHECK(testPos > (int64_t)UINT32_MAX);
+  test_rebase((int64_t)INT32_MIN + 1000000);
+  test_run(-1);
+  HOST_CHECK(testPos < (int64_t)INT32_MIN);
+  test_rebase(-(int64_t)UINT32_MAX + 1000000);
+  test_run(-1);
+  HOST_CHECK(testPos < -(int64_t)UINT32_MAX);
+
+  // Velocity over one sample period, in counts per second, across wraps
+  HOST_CHECK_EQ(tmr_enc_sample(TMR_INSTANCE3), TMR_RETURN_SUCCESS);
+  test_step(TEST_MAX_STEP);
+  test_step(TEST_MAX_STEP);
+  test_step(TEST_MAX_STEP);
+  HOST_CHECK_EQ(tmr_enc_sample(TMR_INSTANCE3), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_enc_get_velocity(TMR_INSTANCE3, &encVelocity),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(encVelocity,
+                3 * TEST_MAX_STEP * (int32_t)(1000000U / TEST_PERIOD_US));
+
+  test_step(-250);
+  HOST_CHECK_EQ(tmr_enc_sample(TMR_INSTANCE3), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_enc_get_velocity(TMR_INSTANCE3, &encVelocity),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(encVelocity, -250 * (int32_t)(1000000U / TEST_PERIOD_US));
+
+  HOST_CHECK_EQ(tmr_enc_sample(TMR_INSTANCE3), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_enc_get_velocity(TMR_INSTANCE3, &encVelocity),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(encVelocity, 0);
+
+  // Inverted, the same steps count the other way from a fresh open
+  HOST_CHECK_EQ(tmr_close(TMR_INSTANCE3), TMR_RETURN_SUCCESS);
+  badEnc = testEnc;
+  badEnc.isInverted = true;
+  HOST_CHECK_EQ(tmr_open_encoder(TMR_INSTANCE3, &badEnc),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(test_read(), 0);
+  sim_tim_encoder(TIM3, 40);
+  HOST_CHECK_EQ(test_read(), -40);
+
+  HOST_CHECK_EQ(__get_PRIMASK(), 0U);
+
+  HOST_DONE();
+}
@@ -0,0 +1,242 @@
+/**
+ * @file test_tmr_sleep.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief tmr_sleep_until() on the virtual clock. The main loop does nothing
+ * but sleep while two timers run, so every callback must still land on its
+ * deadline and the idle cycles must be the window less the callbacks' time.
+ * Also covers the busy hooks, a deadline closer than minSleepUs and that
+ * the hooks and the sleep leave PRIMASK as the caller had it.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <tmr.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// A 1 ms tick with 40 us of work and a 250 us tick with 5 us
+#define TEST_SLOW_US 1000U
+#define TEST_SLOW_COST_US 40U
+#define TEST_FAST_US 250U
+#define TEST_FAST_COST_US 5U
+
+#define TEST_WINDOW_MS 50U
+
+// Cycles the sleep and wake path may add per sleep
+#define TEST_SLEEP_CYCLES 64U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) types
+////////////////////////////////////////////////////////////////////////////////
+
+/* Callback entries of one instance */
+typedef struct {
+  uint64_t tickPeriod;
+  uint64_t tickFirst;
+  uint64_t tickMaxLate;  // Entry after its deadline, worst case
+  uint32_t numTicks;
+
+} test_tick_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static tmr_config_t testSlowConfig = {
+    .tmrInstancesId = TMR_INSTANCE2,
+    .tmrBaseUnit = TMR_BASE_1US,
+    .tmrPriority = TMR_PRIORITY_MED,
+};
+
+static tmr_config_t testFastConfig = {
+    .tmrInstancesId = TMR_INSTANCE3,
+    .tmrBaseUnit = TMR_BASE_1US,
+    .tmrPriority = TMR_PRIORITY_HIGH,
+};
+
+static test_tick_t testSlow;
+static test_tick_t testFast;
+
+static bool testIsBusy;
+static uint32_t testHookCalls;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Records a callback entry. Its deadline is a whole number of
+ *         periods after the first entry.
+ **/
+static void test_tick(test_tick_t *testTick) {
+  uint64_t tickNow = sim_now();
+
+  if (testTick->numTicks == 0U) testTick->tickFirst = tickNow;
+
+  uint64_t tickLate = tickNow - testTick->tickFirst -
+                      (uint64_t)testTick->numTicks * testTick->tickPeriod;
+  if (tickLate > testTick->tickMaxLate) testTick->tickMaxLate = tickLate;
+  testTick->numTicks++;
+}
+
+static void test_slow_cb(void) {
+  test_tick(&testSlow);
+  sim_advance(SIM_US(TEST_SLOW_COST_US));
+}
+
+static void test_fast_cb(void) {
+  test_tick(&testFast);
+  sim_advance(SIM_US(TEST_FAST_COST_US));
+}
+
+// The update period the timer was programmed with, in core cycles
+static uint64_t test_period(const TIM_TypeDef *tmrReg) {
+  return ((uint64_t)tmrReg->PSC + 1U) * ((uint64_t)tmrReg->ARR + 1U);
+}
+
+static bool test_near(uint64_t testVal, uint64_t testExp, uint64_t testTol) {
+  return testVal + testTol >= testExp && testVal <= testExp + testTol;
+}
+
+static bool test_busy(uint32_t busyArg) {
+  testHookCalls++;
+  return (busyArg == 1U) && testIsBusy;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  tmr_sleep_stats_t sleepStats;
+  uint32_t deadlineUs = 0U;
+  uint32_t hookIdx = 0U;
+
+  // Nothing to wake up for yet
+  HOST_CHECK_EQ(tmr_next_deadline(&deadlineUs), TMR_INST_NOTOPEN);
+
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2 |
+                           LL_APB1_GRP1_PERIPH_TIM3);
+  HOST_CHECK_EQ(tmr_init(&testSlowConfig), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_init(&testFastConfig), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE2, test_slow_cb, TEST_SLOW_US),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE3, test_fast_cb, TEST_FAST_US),
+                TMR_RETURN_SUCCESS);
+
+  // tmr_open() does not load the prescaler early, one period settles it
+  sim_advance(SIM_US(TEST_SLOW_US));
+  testSlow = (test_tick_t){.tickPeriod = test_period(TIM2)};
+  testFast = (test_tick_t){.tickPeriod = test_period(TIM3)};
+
+  // Only sleeping: the timers alone wake the CPU, on time every time
+  HOST_CHECK_EQ(tmr_get_sleep_stats(&sleepStats), TMR_RETURN_SUCCESS);
+  uint64_t idleStart = sleepStats.idleCycles;
+  uint32_t sleepsStart = sleepStats.numSleeps;
+  uint64_t windowStart = sim_now();
+  uint32_t numSlept = 0U;
+
+  while (sim_now() - windowStart < SIM_MS(TEST_WINDOW_MS)) {
+    if (tmr_sleep_until(0U) == TMR_RETURN_SUCCESS) numSlept++;
+  }
+  uint64_t testWindow = sim_now() - windowStart;
+
+  HOST_CHECK_EQ(tmr_get_sleep_stats(&sleepStats), TMR_RETURN_SUCCESS);
+  uint64_t idleCycles = sleepStats.idleCycles - idleStart;
+  uint64_t busyCycles =
+      (uint64_t)testSlow.numTicks * SIM_US(TEST_SLOW_COST_US) +
+      (uint64_t)testFast.numTicks * SIM_US(TEST_FAST_COST_US);
+
+  printf("window %llu: %u sleeps, idle %llu, callbacks %llu, "
+         "ticks %u/%u, late %llu/%llu, latency %u/%u us\n",
+         (unsigned long long)testWindow, numSlept,
+         (unsigned long long)idleCycles, (unsigned long long)busyCycles,
+         testSlow.numTicks, testFast.numTicks,
+         (unsigned long long)testSlow.tickMaxLate,
+         (unsigned long long)testFast.tickMaxLate, sleepStats.wakeLatUs,
+         sleepStats.wakeLatMaxUs);
+
+  // Deadlines met: none missed, and none entered later than the other
+  // instance's callback can hold it off (the two never preempt each other)
+  HOST_CHECK(test_near(testSlow.numTicks, testWindow / testSlow.tickPeriod,
+                       1U));
+  HOST_CHECK(test_near(testFast.numTicks, testWindow / testFast.tickPeriod,
+                       1U));
+  HOST_CHECK(testSlow.tickMaxLate <= SIM_US(TEST_FAST_COST_US));
+  HOST_CHECK(testFast.tickMaxLate <= SIM_US(TEST_SLOW_COST_US));
+  HOST_CHECK(sleepStats.wakeLatMaxUs <= TEST_SLOW_COST_US);
+
+  // The next deadline is the fast tick's, in timer ticks
+  uint64_t nextFast = testFast.tickFirst +
+                      (uint64_t)testFast.numTicks * testFast.tickPeriod;
+  HOST_CHECK_EQ(tmr_next_deadline(&deadlineUs), TMR_RETURN_SUCCESS);
+  HOST_CHECK(test_near(deadlineUs, (nextFast - sim_now()) / (TIM3->PSC + 1U),
+                       1U));
+
+  // Idle is the window less the callbacks, each sleep counted
+  HOST_CHECK_EQ(sleepStats.numSleeps - sleepsStart, numSlept);
+  HOST_CHECK(idleCycles + busyCycles <= testWindow);
+  HOST_CHECK(testWindow - idleCycles - busyCycles <
+             (uint64_t)numSlept * TEST_SLEEP_CYCLES);
+  HOST_CHECK_EQ(sleepStats.numSkipped, 0U);
+
+  // A deadline closer than minSleepUs keeps the CPU awake
+  HOST_CHECK_EQ(tmr_sleep_until(TEST_SLOW_US + 1U), TMR_SLEEP_SHORT);
+
+  // Busy hooks: the first is asked with busyArg 1, the rest always idle.
+  // Registering leaves PRIMASK set if the caller had it set.
+  HOST_CHECK_EQ(tmr_sleep_add_hook(NULL, 0U), TMR_INVALID_CBFUNC);
+  HOST_CHECK_EQ(tmr_sleep_add_hook(test_busy, 1U), TMR_RETURN_SUCCESS);
+  __disable_irq();
+  for (hookIdx = 1U; hookIdx < TMR_SLEEP_MAX_HOOKS; hookIdx++) {
+    HOST_CHECK_EQ(tmr_sleep_add_hook(test_busy, 0U), TMR_RETURN_SUCCESS);
+    HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  }
+  HOST_CHECK_EQ(tmr_sleep_add_hook(test_busy, 0U), TMR_SLEEP_NO_HOOK);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  __enable_irq();
+  HOST_CHECK_EQ(tmr_sleep_add_hook(test_busy, 0U), TMR_SLEEP_NO_HOOK);
+  HOST_CHECK_EQ(__get_PRIMASK(), 0U);
+
+  testIsBusy = true;
+  testHookCalls = 0U;
+  uint64_t busyStart = sim_now();
+  HOST_CHECK_EQ(tmr_sleep_until(0U), TMR_SLEEP_BUSY);
+  HOST_CHECK_EQ(sim_now(), busyStart);
+  HOST_CHECK_EQ(testHookCalls, 1U);
+
+  testIsBusy = false;
+  testHookCalls = 0U;
+  HOST_CHECK_EQ(tmr_sleep_until(0U), TMR_RETURN_SUCCESS);
+  HOST_CHECK(sim_now() > busyStart);
+  HOST_CHECK_EQ(testHookCalls, TMR_SLEEP_MAX_HOOKS);
+
+  HOST_CHECK_EQ(tmr_get_sleep_stats(&sleepStats), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(sleepStats.numSkipped, 2U);
+
+  // Called with interrupts disabled the sleep still wakes, and the callback
+  // runs once PRIMASK is cleared by the caller
+  uint32_t fastTicks = testFast.numTicks + testSlow.numTicks;
+  __disable_irq();
+  HOST_CHECK_EQ(tmr_sleep_until(0U), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  HOST_CHECK_EQ(testFast.numTicks + testSlow.numTicks, fastTicks);
+  __enable_irq();
+  sim_advance(1U);
+  HOST_CHECK(testFast.numTicks + testSlow.numTicks > fastTicks);
+
+  HOST_DONE();
+}
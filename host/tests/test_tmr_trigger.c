@@ -0,0 +1,194 @@
+/**
+ * @file test_tmr_trigger.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Drives the TRGO/ITR network of TIM2-4 through tmr_group_start(),
+ * tmr_cascade() and tmr_close(): group members count in lockstep, a cascade
+ * calls back every cascCount master periods, closing either end of a
+ * cascade releases both, and the instances can be opened again afterwards.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <tmr.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_PERIOD_US 100U
+#define TEST_CASC_COUNT 5U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static tmr_config_t testConfigs[TMR_NUM_INSTANCES] = {
+    {TMR_INSTANCE2, TMR_BASE_1US, TMR_PRIORITY_HIGH},
+    {TMR_INSTANCE3, TMR_BASE_1US, TMR_PRIORITY_MED},
+    {TMR_INSTANCE4, TMR_BASE_1US, TMR_PRIORITY_LOW},
+};
+
+static TIM_TypeDef *const testRegs[TMR_NUM_INSTANCES] = {TIM2, TIM3, TIM4};
+
+static uint32_t testCalls[TMR_NUM_INSTANCES];
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_cb2(void) { testCalls[TMR_INSTANCE2]++; }
+static void test_cb3(void) { testCalls[TMR_INSTANCE3]++; }
+static void test_cb4(void) { testCalls[TMR_INSTANCE4]++; }
+
+static const tmr_cb_func testCbs[TMR_NUM_INSTANCES] = {test_cb2, test_cb3,
+                                                        test_cb4};
+
+// Period of one instance in CPU cycles, as programmed by tmr_open()
+static uint64_t test_period(uint32_t tmrIdx) {
+  return (uint64_t)(LL_TIM_GetPrescaler(testRegs[tmrIdx]) + 1U) *
+         (LL_TIM_GetAutoReload(testRegs[tmrIdx]) + 1U);
+}
+
+static void test_open_all(void) {
+  for (uint32_t tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+    HOST_CHECK_EQ(tmr_open(tmrIdx, testCbs[tmrIdx], TEST_PERIOD_US),
+                  TMR_RETURN_SUCCESS);
+
+    // Out of step before the group restarts them
+    sim_advance(SIM_US(17U));
+  }
+
+  // tmr_open() loads PSC at the first update, not counted
+  sim_advance(SIM_US(TEST_PERIOD_US));
+  (void)memset(testCalls, 0, sizeof(testCalls));
+}
+
+static void test_close_all(void) {
+  for (uint32_t tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+    (void)tmr_close(tmrIdx);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  tmr_info_t tmrInfo;
+
+  LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2 |
+                           LL_APB1_GRP1_PERIPH_TIM3 |
+                           LL_APB1_GRP1_PERIPH_TIM4);
+  for (uint32_t tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+    HOST_CHECK_EQ(tmr_init(&testConfigs[tmrIdx]), TMR_RETURN_SUCCESS);
+  }
+
+  // Indexes past the last instance
+  HOST_CHECK_EQ(tmr_open(TMR_NUM_INSTANCES, test_cb2, TEST_PERIOD_US),
+                TMR_INVALID_IDX);
+  HOST_CHECK_EQ(tmr_write(TMR_NUM_INSTANCES, TEST_PERIOD_US), TMR_INVALID_IDX);
+  HOST_CHECK_EQ(tmr_close(TMR_NUM_INSTANCES), TMR_INVALID_IDX);
+  HOST_CHECK_EQ(tmr_read(TMR_NUM_INSTANCES), TMR_INVALID_IDX);
+
+  // Closing a closed instance leaves PRIMASK as it was
+  HOST_CHECK_EQ(tmr_close(TMR_INSTANCE2), TMR_INST_NOTOPEN);
+  HOST_CHECK_EQ(__get_PRIMASK(), 0U);
+  __disable_irq();
+  HOST_CHECK_EQ(tmr_close(TMR_INSTANCE2), TMR_INST_NOTOPEN);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  __enable_irq();
+
+  // Group: TIM2 starts TIM3 and TIM4 on the same edge
+  test_open_all();
+  HOST_CHECK_EQ(tmr_group_start(TMR_INSTANCE2, (1U << TMR_INSTANCE3) |
+                                                   (1U << TMR_INSTANCE4)),
+                TMR_RETURN_SUCCESS);
+  for (uint32_t tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+    HOST_CHECK_EQ(LL_TIM_GetUpdateSource(testRegs[tmrIdx]),
+                  LL_TIM_UPDATESOURCE_REGULAR);
+    HOST_CHECK_EQ(testCalls[tmrIdx], 0U);
+  }
+
+  uint64_t tmrPeriod = test_period(TMR_INSTANCE2);
+  sim_advance(10U * tmrPeriod + tmrPeriod / 2U);
+  for (uint32_t tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+    HOST_CHECK_EQ(testCalls[tmrIdx], 10U);
+    HOST_CHECK_EQ(LL_TIM_GetCounter(testRegs[tmrIdx]),
+                  LL_TIM_GetCounter(TIM2));
+  }
+
+  // tmr_write() on a group member still updates its period
+  HOST_CHECK_EQ(tmr_write(TMR_INSTANCE3, 2U * TEST_PERIOD_US),
+                TMR_RETURN_SUCCESS);
+  testCalls[TMR_INSTANCE3] = 0U;
+  sim_advance(10U * test_period(TMR_INSTANCE3));
+  HOST_CHECK(testCalls[TMR_INSTANCE3] >= 9U);
+  HOST_CHECK(testCalls[TMR_INSTANCE3] <= 10U);
+
+  test_close_all();
+  for (uint32_t tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+    HOST_CHECK(!LL_TIM_IsEnabledCounter(testRegs[tmrIdx]));
+    HOST_CHECK_EQ(READ_BIT(testRegs[tmrIdx]->SMCR, TIM_SMCR_SMS), 0U);
+  }
+
+  // Cascade: TIM3 counts the updates of TIM2
+  test_open_all();
+  tmrPeriod = test_period(TMR_INSTANCE2);
+  HOST_CHECK_EQ(tmr_cascade(TMR_INSTANCE2, TMR_INSTANCE3, TEST_CASC_COUNT),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_write(TMR_INSTANCE2, TEST_PERIOD_US),
+                TMR_INST_IS_CASCADED);
+  HOST_CHECK_EQ(tmr_write(TMR_INSTANCE3, TEST_PERIOD_US),
+                TMR_INST_IS_CASCADED);
+
+  testCalls[TMR_INSTANCE2] = 0U;
+  testCalls[TMR_INSTANCE3] = 0U;
+  sim_advance(4U * TEST_CASC_COUNT * tmrPeriod + tmrPeriod / 2U);
+  HOST_CHECK_EQ(testCalls[TMR_INSTANCE2], 0U);
+  HOST_CHECK_EQ(testCalls[TMR_INSTANCE3], 4U);
+
+  // Closing the slave takes the master down with it
+  HOST_CHECK_EQ(tmr_close(TMR_INSTANCE3), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_get_info(TMR_INSTANCE2, &tmrInfo), TMR_INST_NOTOPEN);
+  HOST_CHECK_EQ(tmr_get_info(TMR_INSTANCE3, &tmrInfo), TMR_INST_NOTOPEN);
+  HOST_CHECK(!LL_TIM_IsEnabledCounter(TIM2));
+  HOST_CHECK(!LL_TIM_IsEnabledCounter(TIM3));
+  HOST_CHECK_EQ(READ_BIT(TIM3->SMCR, TIM_SMCR_SMS), 0U);
+  HOST_CHECK_EQ(tmr_close(TMR_INSTANCE2), TMR_INST_NOTOPEN);
+
+  sim_advance(4U * TEST_CASC_COUNT * tmrPeriod);
+  HOST_CHECK_EQ(testCalls[TMR_INSTANCE2], 0U);
+  HOST_CHECK_EQ(testCalls[TMR_INSTANCE3], 4U);
+
+  // Both open again as plain timers on their own clock
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE2, test_cb2, TEST_PERIOD_US),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_open(TMR_INSTANCE3, test_cb3, TEST_PERIOD_US),
+                TMR_RETURN_SUCCESS);
+  sim_advance(SIM_US(TEST_PERIOD_US));
+  testCalls[TMR_INSTANCE2] = 0U;
+  testCalls[TMR_INSTANCE3] = 0U;
+  sim_advance(10U * tmrPeriod);
+  HOST_CHECK_EQ(testCalls[TMR_INSTANCE2], 10U);
+  HOST_CHECK_EQ(testCalls[TMR_INSTANCE3], 10U);
+
+  // Closing the master of a new cascade releases the slave
+  HOST_CHECK_EQ(tmr_cascade(TMR_INSTANCE2, TMR_INSTANCE3, TEST_CASC_COUNT),
+                TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_close(TMR_INSTANCE2), TMR_RETURN_SUCCESS);
+  HOST_CHECK_EQ(tmr_get_info(TMR_INSTANCE3, &tmrInfo), TMR_INST_NOTOPEN);
+  HOST_CHECK_EQ(tmr_get_info(TMR_INSTANCE4, &tmrInfo), TMR_RETURN_SUCCESS);
+
+  HOST_DONE();
+}
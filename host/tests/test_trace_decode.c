@@ -0,0 +1,161 @@
+/**
+ * @file test_trace_decode.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Records trace events on the virtual clock, one gap too long for a
+ * 16-bit delta among them, dumps the ring over ttys and converts it to
+ * Chrome trace JSON with the host decoder reading this binary's ELF. Also
+ * checks that trace_start() leaves PRIMASK as the caller had it.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <trace.h>
+#include <ttys.h>
+
+/* Tool includes */
+#include <host_decode.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_DUMP_MAX 256U
+
+// Header and the records: start, end, overflow, rx, user, unmatched end
+#define TEST_NUM_RECORDS 6U
+#define TEST_DUMP_LEN (13U + 8U * TEST_NUM_RECORDS)
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t testTtysConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+};
+
+static uint8_t testDump[TEST_DUMP_MAX];
+static uint32_t testDumpLen;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// The callback the slice is named after
+__attribute__((noinline)) static void test_cb(void) { __NOP(); }
+
+static void test_dump_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  if (testDumpLen < TEST_DUMP_MAX) testDump[testDumpLen] = txData;
+  testDumpLen++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  elf_file_t elfFile;
+  char *testReport = NULL;
+  size_t reportLen = 0U;
+
+  test_cb();
+  HOST_CHECK_EQ(elf_open(&elfFile, "/proc/self/exe"), EXIT_SUCCESS);
+
+  // Started with interrupts disabled, they stay disabled
+  HOST_CHECK_EQ(trace_init(), EXIT_SUCCESS);
+  __disable_irq();
+  HOST_CHECK_EQ(trace_start(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  __enable_irq();
+  HOST_CHECK_EQ(trace_start(), EXIT_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 0U);
+
+  // Gaps of whole ticks, 8 us and 20 ms at 84 MHz
+  trace_event(TRACE_EVT_TMR_CB_START, 2U, (uint32_t)(uintptr_t)test_cb);
+  sim_advance(SIM_US(8U));
+  trace_event(TRACE_EVT_TMR_CB_END, 2U, 0U);
+  sim_advance(SIM_MS(20U));
+  trace_event(TRACE_EVT_TTYS_RX, 1U, 'A');
+  trace_event(TRACE_EVT_USER + 3U, 7U, 0x1234U);
+  trace_event(TRACE_EVT_TMR_CB_END, 3U, 0U);
+  HOST_CHECK_EQ(traceRing.traceHead, TEST_NUM_RECORDS);
+  HOST_CHECK_EQ(trace_dump(TTYS_INSTANCE_2), TRACE_ERR_RUNNING);
+  HOST_CHECK_EQ(trace_stop(), EXIT_SUCCESS);
+
+  // Dump over ttys, as the host would capture it
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testTtysConfig), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_dump_hook, NULL);
+  HOST_CHECK_EQ(trace_dump(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  while (!LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+  HOST_CHECK_EQ(testDumpLen, TEST_DUMP_LEN);
+
+  FILE *reportStream = open_memstream(&testReport, &reportLen);
+  HOST_CHECK_EQ(trace_decode(reportStream, testDump, testDumpLen, &elfFile),
+                EXIT_SUCCESS);
+  (void)fclose(reportStream);
+  printf("%s", testReport);
+
+  // The slice, named after the callback, then the events after the gap
+  const char *cbStart = strstr(testReport,
+                               "{\"name\":\"test_cb\",\"cat\":\"tmr\","
+                               "\"ph\":\"B\",\"ts\":0.000,\"pid\":1,"
+                               "\"tid\":2}");
+  const char *cbEnd = strstr(testReport,
+                             "{\"ph\":\"E\",\"ts\":8.000,\"pid\":1,"
+                             "\"tid\":2}");
+  const char *ttysRx = strstr(testReport,
+                              "{\"name\":\"ttys_rx\",\"cat\":\"ttys\","
+                              "\"ph\":\"i\",\"s\":\"t\",\"ts\":20008.000,"
+                              "\"pid\":2,\"tid\":1,"
+                              "\"args\":{\"payload\":\"0x00000041\"}}");
+  const char *userEvt = strstr(testReport,
+                               "{\"name\":\"user_3\",\"cat\":\"user\","
+                               "\"ph\":\"i\",\"s\":\"t\",\"ts\":20008.000,"
+                               "\"pid\":4,\"tid\":7,"
+                               "\"args\":{\"payload\":\"0x00001234\"}}");
+  HOST_CHECK(cbStart != NULL);
+  HOST_CHECK(cbEnd != NULL && cbEnd > cbStart);
+  HOST_CHECK(ttysRx != NULL && ttysRx > cbEnd);
+  HOST_CHECK(userEvt != NULL && userEvt > ttysRx);
+
+  // One JSON object, the end without a start and the overflow left out
+  HOST_CHECK(strncmp(testReport, "{\"traceEvents\":[\n", 17U) == 0);
+  HOST_CHECK(strstr(testReport, "\"tid\":3") == NULL);
+  HOST_CHECK(strstr(testReport, "dt_overflow") == NULL);
+  HOST_CHECK(strstr(testReport,
+                    "\n],\"otherData\":{\"clock_hz\":84000000,"
+                    "\"tick_cycles\":16,\"records\":6}}\n") != NULL);
+
+  // A truncated or foreign dump is refused
+  reportStream = fopen("/dev/null", "w");
+  HOST_CHECK_EQ(trace_decode(reportStream, testDump, testDumpLen - 1U,
+                             &elfFile),
+                HOST_DECODE_ERR_FORMAT);
+  HOST_CHECK_EQ(trace_decode(reportStream, testDump, 10U, &elfFile),
+                HOST_DECODE_ERR_FORMAT);
+  testDump[0U] = 'P';
+  HOST_CHECK_EQ(trace_decode(reportStream, testDump, testDumpLen, &elfFile),
+                HOST_DECODE_ERR_FORMAT);
+  (void)fclose(reportStream);
+
+  free(testReport);
+  elf_close(&elfFile);
+
+  HOST_DONE();
+}
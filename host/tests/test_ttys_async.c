@@ -0,0 +1,315 @@
+/**
+ * @file test_ttys_async.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Ordering and cancellation of the ttys async requests on the
+ * simulated USART: ring bytes go out before an async write, writes chained
+ * from the completion callback follow in order, async reads take the ring
+ * first, cancels report the bytes moved, and none of the calls turn
+ * interrupts on inside a critical section.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <ttys.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_WIRE_SIZE 128U
+#define TEST_MAX_CBS 8U
+
+// Upper bound for a test step, far more than the bytes need at 115200
+#define TEST_MAX_MS 50U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t testConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+};
+
+// What left the TX pin
+static char testWire[TEST_WIRE_SIZE];
+static uint32_t testWireLen;
+
+// Completions, in the order the callbacks ran
+static struct {
+  uintptr_t cbCtx;
+  uint32_t cbStatus;
+  uint32_t cbLen;
+  uint32_t cbIpsr;
+  uint32_t wireLen;  // Bytes on the wire when the callback ran
+} testCbs[TEST_MAX_CBS];
+static uint32_t testNumCbs;
+
+static const char testChain[] = "GH";
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_tx_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  if (testWireLen < TEST_WIRE_SIZE) testWire[testWireLen] = (char)txData;
+  testWireLen++;
+}
+
+static void test_cb(void *asyncCtx, uint32_t asyncStatus, uint32_t asyncLen) {
+  if (testNumCbs >= TEST_MAX_CBS) return;
+
+  testCbs[testNumCbs].cbCtx = (uintptr_t)asyncCtx;
+  testCbs[testNumCbs].cbStatus = asyncStatus;
+  testCbs[testNumCbs].cbLen = asyncLen;
+  testCbs[testNumCbs].cbIpsr = __get_IPSR();
+  testCbs[testNumCbs].wireLen = testWireLen;
+  testNumCbs++;
+}
+
+// Completion of the first write, starts the next one from the ISR
+static void test_chain_cb(void *asyncCtx, uint32_t asyncStatus,
+                          uint32_t asyncLen) {
+  test_cb(asyncCtx, asyncStatus, asyncLen);
+  HOST_CHECK_EQ(ttys_write_async(TTYS_INSTANCE_2, testChain, 2U, test_cb,
+                                 (void *)2U),
+                EXIT_SUCCESS);
+}
+
+static void test_reset(void) {
+  testWireLen = 0U;
+  testNumCbs = 0U;
+  (void)memset(testWire, 0, sizeof(testWire));
+  (void)memset(testCbs, 0, sizeof(testCbs));
+}
+
+// Runs the virtual clock until the TX line is idle
+static void test_drain(void) {
+  for (uint32_t numMs = 0U; numMs < TEST_MAX_MS; numMs++) {
+    if (!ttys_is_busy(TTYS_INSTANCE_2) && LL_USART_IsActiveFlag_TC(USART2)) {
+      return;
+    }
+    sim_advance(SIM_MS(1));
+  }
+}
+
+/**
+ * @brief: Bytes queued with ttys_putc() go out first, then the async write,
+ *         then the write chained from its callback. A second write while one
+ *         is pending is refused.
+ **/
+static void test_write_order(void) {
+  static const char testWrite[] = "CDEF";
+
+  test_reset();
+
+  HOST_CHECK_EQ(ttys_putc(TTYS_INSTANCE_2, 'a'), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_putc(TTYS_INSTANCE_2, 'b'), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_write_async(TTYS_INSTANCE_2, testWrite, 4U,
+                                 test_chain_cb, (void *)1U),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_write_async(TTYS_INSTANCE_2, testWrite, 4U, test_cb,
+                                 (void *)9U),
+                TTYS_ERR_BUSY);
+
+  // Nothing completes before the bytes are handed over
+  HOST_CHECK_EQ(testNumCbs, 0U);
+
+  test_drain();
+
+  HOST_CHECK_EQ(testWireLen, 8U);
+  HOST_CHECK(memcmp(testWire, "abCDEFGH", 8U) == 0);
+
+  HOST_CHECK_EQ(testNumCbs, 2U);
+  HOST_CHECK_EQ(testCbs[0].cbCtx, 1U);
+  HOST_CHECK_EQ(testCbs[0].cbStatus, EXIT_SUCCESS);
+  HOST_CHECK_EQ(testCbs[0].cbLen, 4U);
+  HOST_CHECK_EQ(testCbs[1].cbCtx, 2U);
+  HOST_CHECK_EQ(testCbs[1].cbStatus, EXIT_SUCCESS);
+  HOST_CHECK_EQ(testCbs[1].cbLen, 2U);
+
+  // From the USART ISR, once the last byte was in DR: "F" is then still on
+  // its way, behind "E"
+  HOST_CHECK_EQ(testCbs[0].cbIpsr, USART2_IRQn + 16U);
+  HOST_CHECK(testCbs[0].wireLen >= 4U && testCbs[0].wireLen < 6U);
+  HOST_CHECK(testCbs[1].wireLen < 8U);
+}
+
+/**
+ * @brief: An async read takes the bytes already in the RX ring first, then
+ *         the ISR stores the rest. A read the ring satisfies completes in
+ *         the caller.
+ **/
+static void test_read_order(void) {
+  char readBuf[8];
+
+  test_reset();
+  (void)memset(readBuf, 0, sizeof(readBuf));
+
+  HOST_CHECK_EQ(sim_usart_rx_push(USART2, (const uint8_t *)"xyz", 3U), 3U);
+  sim_advance(SIM_MS(1));
+
+  HOST_CHECK_EQ(ttys_read_async(TTYS_INSTANCE_2, readBuf, 5U, test_cb,
+                                (void *)3U),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_read_async(TTYS_INSTANCE_2, readBuf, 5U, test_cb,
+                                (void *)9U),
+                TTYS_ERR_BUSY);
+  HOST_CHECK_EQ(testNumCbs, 0U);
+
+  HOST_CHECK_EQ(sim_usart_rx_push(USART2, (const uint8_t *)"12!", 3U), 3U);
+  sim_advance(SIM_MS(1));
+
+  HOST_CHECK_EQ(testNumCbs, 1U);
+  HOST_CHECK_EQ(testCbs[0].cbCtx, 3U);
+  HOST_CHECK_EQ(testCbs[0].cbStatus, EXIT_SUCCESS);
+  HOST_CHECK_EQ(testCbs[0].cbLen, 5U);
+  HOST_CHECK_EQ(testCbs[0].cbIpsr, USART2_IRQn + 16U);
+  HOST_CHECK(memcmp(readBuf, "xyz12", 5U) == 0);
+
+  // The byte after the request went to the ring
+  HOST_CHECK_EQ(ttys_read_async(TTYS_INSTANCE_2, readBuf, 1U, test_cb,
+                                (void *)4U),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(testNumCbs, 2U);
+  HOST_CHECK_EQ(testCbs[1].cbCtx, 4U);
+  HOST_CHECK_EQ(testCbs[1].cbIpsr, 0U);
+  HOST_CHECK_EQ(readBuf[0], '!');
+}
+
+/**
+ * @brief: A cancel ends the request at once with TTYS_ERR_CANCELLED and the
+ *         bytes moved so far; nothing more of the write is sent and later
+ *         RX bytes go to the ring. Cancelling an idle request does nothing.
+ **/
+static void test_cancel(void) {
+  static char testLong[64];
+  char readBuf[8];
+
+  test_reset();
+  (void)memset(testLong, 'L', sizeof(testLong));
+
+  HOST_CHECK_EQ(ttys_write_async(TTYS_INSTANCE_2, testLong, sizeof(testLong),
+                                 test_cb, (void *)5U),
+                EXIT_SUCCESS);
+
+  // About 11 frames
+  sim_advance(SIM_MS(1));
+  HOST_CHECK_EQ(ttys_cancel_async(TTYS_INSTANCE_2, TTYS_ASYNC_TX),
+                EXIT_SUCCESS);
+
+  HOST_CHECK_EQ(testNumCbs, 1U);
+  HOST_CHECK_EQ(testCbs[0].cbCtx, 5U);
+  HOST_CHECK_EQ(testCbs[0].cbStatus, TTYS_ERR_CANCELLED);
+  HOST_CHECK_EQ(testCbs[0].cbIpsr, 0U);
+  HOST_CHECK(testCbs[0].cbLen > 0U && testCbs[0].cbLen < sizeof(testLong));
+
+  // What was handed to the USART still finishes, nothing after it
+  test_drain();
+  HOST_CHECK_EQ(testWireLen, testCbs[0].cbLen);
+
+  // A second cancel, and one of an idle read, have no callback
+  HOST_CHECK_EQ(ttys_cancel_async(TTYS_INSTANCE_2,
+                                  TTYS_ASYNC_RX | TTYS_ASYNC_TX),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(testNumCbs, 1U);
+
+  // A read cancelled part way
+  HOST_CHECK_EQ(ttys_read_async(TTYS_INSTANCE_2, readBuf, 5U, test_cb,
+                                (void *)6U),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(sim_usart_rx_push(USART2, (const uint8_t *)"pq", 2U), 2U);
+  sim_advance(SIM_MS(1));
+  HOST_CHECK_EQ(ttys_cancel_async(TTYS_INSTANCE_2, TTYS_ASYNC_RX),
+                EXIT_SUCCESS);
+
+  HOST_CHECK_EQ(testNumCbs, 2U);
+  HOST_CHECK_EQ(testCbs[1].cbCtx, 6U);
+  HOST_CHECK_EQ(testCbs[1].cbStatus, TTYS_ERR_CANCELLED);
+  HOST_CHECK_EQ(testCbs[1].cbLen, 2U);
+  HOST_CHECK(memcmp(readBuf, "pq", 2U) == 0);
+
+  HOST_CHECK_EQ(sim_usart_rx_push(USART2, (const uint8_t *)"r", 1U), 1U);
+  sim_advance(SIM_MS(1));
+  HOST_CHECK_EQ(ttys_getc(TTYS_INSTANCE_2), 'r');
+  HOST_CHECK_EQ(testNumCbs, 2U);
+}
+
+/**
+ * @brief: Called with interrupts masked (from a tmr callback, or a critical
+ *         section of the caller) the calls leave them masked: the USART ISR
+ *         only runs once the caller unmasks.
+ **/
+static void test_primask(void) {
+  char readBuf[4];
+
+  test_reset();
+
+  uint32_t numIrqs = sim_irq_count(USART2_IRQn);
+
+  __disable_irq();
+
+  HOST_CHECK_EQ(ttys_write_async(TTYS_INSTANCE_2, "mask", 4U, test_cb,
+                                 (void *)7U),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  HOST_CHECK_EQ(ttys_read_async(TTYS_INSTANCE_2, readBuf, 4U, test_cb,
+                                (void *)8U),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  HOST_CHECK_EQ(ttys_cancel_async(TTYS_INSTANCE_2, TTYS_ASYNC_RX),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  HOST_CHECK_EQ(ttys_set_rx_hook(TTYS_INSTANCE_2, NULL, NULL), EXIT_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+  HOST_CHECK_EQ(ttys_reset_stats(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(__get_PRIMASK(), 1U);
+
+  // TXE was pending all along
+  HOST_CHECK_EQ(sim_irq_count(USART2_IRQn), numIrqs);
+
+  __enable_irq();
+
+  HOST_CHECK(sim_irq_count(USART2_IRQn) > numIrqs);
+  test_drain();
+
+  HOST_CHECK_EQ(testWireLen, 4U);
+  HOST_CHECK(memcmp(testWire, "mask", 4U) == 0);
+  HOST_CHECK_EQ(testNumCbs, 2U);
+  HOST_CHECK_EQ(testCbs[0].cbCtx, 8U);
+  HOST_CHECK_EQ(testCbs[0].cbStatus, TTYS_ERR_CANCELLED);
+  HOST_CHECK_EQ(testCbs[1].cbCtx, 7U);
+  HOST_CHECK_EQ(testCbs[1].cbStatus, EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testConfig), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_start(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_tx_hook, NULL);
+
+  test_write_order();
+  test_read_order();
+  test_cancel();
+  test_primask();
+
+  HOST_DONE();
+}
@@ -0,0 +1,218 @@
+/**
+ * @file test_ttys_baud.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Sweeps ttys_baud_solve() over standard and custom baud rates on the
+ * APB1 and APB2 clocks. The BRR it returns is decoded the way the USART
+ * divides the clock, and the resulting error must be the one reported, the
+ * lowest any divider gives, and within TTYS_BAUD_MAX_ERR_PPM wherever
+ * ttys_init() accepts the rate.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <ttys.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_PCLK1 (SIM_CORE_CLOCK / SIM_APB1_DIV)
+#define TEST_PCLK2 SIM_CORE_CLOCK
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t testBauds[] = {
+    // Standard
+    1200U, 2400U, 4800U, 9600U, 19200U, 38400U, 57600U, 115200U, 230400U,
+    460800U, 921600U, 1000000U, 2000000U, 3000000U, 4000000U,
+    // Custom: MIDI, DMX, ESP boot ROM, odd rates and the OVER8 limit
+    31250U, 250000U, 74880U, 12345U, 777777U, 1843200U, 5250000U,
+    10500000U,
+};
+
+#define TEST_NUM_BAUDS (sizeof(testBauds) / sizeof(testBauds[0]))
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: The clock divider a BRR value gives, in 1/16ths (OVER16) or 1/8ths
+ *         (OVER8) of a bit, as in RM0368 19.3.4.
+ **/
+static uint32_t test_brr_div(uint32_t ttysBrr, uint32_t ttysOverSampling) {
+  if (ttysOverSampling == LL_USART_OVERSAMPLING_16) return ttysBrr;
+
+  return ((ttysBrr >> 4U) << 3U) | (ttysBrr & 7U);
+}
+
+static uint32_t test_err_ppm(uint32_t ttysPclk, uint32_t ttysBaud,
+                             uint32_t ttysDiv) {
+  uint64_t divBaud = (uint64_t)ttysDiv * ttysBaud;
+  uint64_t errAbs = (divBaud > ttysPclk) ? divBaud - ttysPclk
+                                         : ttysPclk - divBaud;
+
+  return (uint32_t)((errAbs * 1000000U) / divBaud);
+}
+
+/**
+ * @brief: One clock, every rate, with both oversampling modes and AUTO.
+ **/
+static void test_sweep(uint32_t ttysPclk) {
+  static const uint32_t testModes[] = {LL_USART_OVERSAMPLING_16,
+                                       LL_USART_OVERSAMPLING_8,
+                                       TTYS_OVERSAMPLING_AUTO};
+  ttys_baud_t ttysBaud;
+
+  printf("# pclk %u\nbaud,over8,brr,actual,err_ppm\n", ttysPclk);
+
+  for (uint32_t baudIdx = 0U; baudIdx < TEST_NUM_BAUDS; baudIdx++) {
+    uint32_t baudReq = testBauds[baudIdx];
+
+    for (uint32_t modeIdx = 0U; modeIdx < 3U; modeIdx++) {
+      uint32_t overSampling = testModes[modeIdx];
+      uint32_t minDiv = (overSampling == LL_USART_OVERSAMPLING_16) ? 16U : 8U;
+      uint32_t maxDiv = (overSampling == LL_USART_OVERSAMPLING_8) ? 0x7FFFU
+                                                                  : 0xFFFFU;
+      uint32_t ttysRet =
+          ttys_baud_solve(ttysPclk, baudReq, overSampling, &ttysBaud);
+
+      // Out of reach: the closest divider does not fit the mantissa
+      uint32_t idealDiv = (ttysPclk + baudReq / 2U) / baudReq;
+      if (overSampling == TTYS_OVERSAMPLING_AUTO) minDiv = 8U;
+      if (idealDiv < minDiv || idealDiv > maxDiv) {
+        HOST_CHECK_EQ(ttysRet, TTYS_ERR_BAUD);
+        continue;
+      }
+      HOST_CHECK_EQ(ttysRet, EXIT_SUCCESS);
+      if (ttysRet != EXIT_SUCCESS) continue;
+
+      // AUTO keeps OVER16, the noise tolerant mode, whenever it can
+      if (overSampling == TTYS_OVERSAMPLING_AUTO) {
+        HOST_CHECK_EQ(ttysBaud.ttysOverSampling,
+                      (idealDiv >= 16U) ? LL_USART_OVERSAMPLING_16
+                                        : LL_USART_OVERSAMPLING_8);
+        printf("%u,%u,0x%04X,%u,%u\n", baudReq,
+               ttysBaud.ttysOverSampling == LL_USART_OVERSAMPLING_8,
+               ttysBaud.ttysBrr, ttysBaud.ttysActualBaud,
+               ttysBaud.ttysErrPpm);
+      } else {
+        HOST_CHECK_EQ(ttysBaud.ttysOverSampling, overSampling);
+      }
+
+      // OVER8 keeps BRR[3] cleared
+      if (ttysBaud.ttysOverSampling == LL_USART_OVERSAMPLING_8) {
+        HOST_CHECK_EQ(ttysBaud.ttysBrr & 8U, 0U);
+      }
+
+      // The error the USART will have is the one reported...
+      uint32_t brrDiv =
+          test_brr_div(ttysBaud.ttysBrr, ttysBaud.ttysOverSampling);
+      uint32_t errPpm = test_err_ppm(ttysPclk, baudReq, brrDiv);
+      HOST_CHECK_EQ(ttysBaud.ttysErrPpm, errPpm);
+      HOST_CHECK_EQ(ttysBaud.ttysActualBaud,
+                    (ttysPclk + brrDiv / 2U) / brrDiv);
+
+      // ...and no neighbouring divider does better
+      HOST_CHECK(test_err_ppm(ttysPclk, baudReq, brrDiv + 1U) >= errPpm);
+      if (brrDiv > minDiv) {
+        HOST_CHECK(test_err_ppm(ttysPclk, baudReq, brrDiv - 1U) >= errPpm);
+      }
+
+      // Half a divider step at most
+      HOST_CHECK((uint64_t)errPpm * brrDiv * 2U <= 1000000U + brrDiv);
+    }
+  }
+}
+
+/**
+ * @brief: ttys_init() programs the solution into the USART and refuses
+ *         rates whose error exceeds TTYS_BAUD_MAX_ERR_PPM.
+ **/
+static void test_init(uint32_t ttysInstIdx, USART_TypeDef *ttysPort,
+                      uint32_t ttysPclk) {
+  ttys_config_t ttysConfig = {
+      .ttysParity = LL_USART_PARITY_NONE,
+      .ttysStopBits = LL_USART_STOPBITS_1,
+      .ttysOverSampling = TTYS_OVERSAMPLING_AUTO,
+  };
+  ttys_baud_t ttysSolved;
+  ttys_baud_t ttysApplied;
+
+  HOST_CHECK_EQ(ttys_def_init(ttysInstIdx), EXIT_SUCCESS);
+
+  for (uint32_t baudIdx = 0U; baudIdx < TEST_NUM_BAUDS; baudIdx++) {
+    ttysConfig.ttysBaud = testBauds[baudIdx];
+
+    uint32_t solveRet = ttys_baud_solve(ttysPclk, ttysConfig.ttysBaud,
+                                        TTYS_OVERSAMPLING_AUTO, &ttysSolved);
+    uint32_t initRet = ttys_init(ttysInstIdx, &ttysConfig);
+
+    if (solveRet != EXIT_SUCCESS ||
+        ttysSolved.ttysErrPpm > TTYS_BAUD_MAX_ERR_PPM) {
+      HOST_CHECK_EQ(initRet, TTYS_ERR_BAUD);
+      continue;
+    }
+
+    HOST_CHECK_EQ(initRet, EXIT_SUCCESS);
+    HOST_CHECK_EQ(LL_USART_ReadReg(ttysPort, BRR), ttysSolved.ttysBrr);
+    HOST_CHECK_EQ(LL_USART_GetOverSampling(ttysPort),
+                  ttysSolved.ttysOverSampling);
+
+    HOST_CHECK_EQ(ttys_get_baud(ttysInstIdx, &ttysApplied), EXIT_SUCCESS);
+    HOST_CHECK_EQ(ttysApplied.ttysActualBaud, ttysSolved.ttysActualBaud);
+    HOST_CHECK_EQ(ttysApplied.ttysErrPpm, ttysSolved.ttysErrPpm);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  ttys_baud_t ttysBaud;
+
+  test_sweep(TEST_PCLK1);
+  test_sweep(TEST_PCLK2);
+
+  // The documented limits: fPCLK / 16 with OVER16, fPCLK / 8 with OVER8
+  HOST_CHECK_EQ(ttys_baud_solve(TEST_PCLK2, 5250000U,
+                                LL_USART_OVERSAMPLING_16, &ttysBaud),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_baud_solve(TEST_PCLK2, 10500000U,
+                                LL_USART_OVERSAMPLING_8, &ttysBaud),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttysBaud.ttysErrPpm, 0U);
+  HOST_CHECK_EQ(ttys_baud_solve(TEST_PCLK2, 12000000U,
+                                LL_USART_OVERSAMPLING_8, &ttysBaud),
+                TTYS_ERR_BAUD);
+
+  // Invalid arguments
+  HOST_CHECK_EQ(ttys_baud_solve(TEST_PCLK1, 0U, LL_USART_OVERSAMPLING_16,
+                                &ttysBaud),
+                TTYS_ERR_BAUD);
+  HOST_CHECK_EQ(ttys_baud_solve(TEST_PCLK1, 9600U, 0x1234U, &ttysBaud),
+                TTYS_ERR_CONFIG);
+  HOST_CHECK_EQ(ttys_baud_solve(TEST_PCLK1, 9600U, LL_USART_OVERSAMPLING_16,
+                                NULL),
+                TTYS_ERR_NULL);
+
+  // USART1 on APB2, USART2 on APB1
+  test_init(TTYS_INSTANCE_1, USART1, TEST_PCLK2);
+  test_init(TTYS_INSTANCE_2, USART2, TEST_PCLK1);
+
+  HOST_DONE();
+}
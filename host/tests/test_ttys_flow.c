@@ -0,0 +1,279 @@
+/**
+ * @file test_ttys_flow.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Runs ttys flow control against a slow consumer on the simulated
+ * USARTs. The peer sends faster than the application reads, the RX ring must
+ * apply backpressure at its high mark, release it at its low mark and lose no
+ * byte, while TX traffic keeps flowing on the same instance. Marks that
+ * would invert the hysteresis are refused.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <ttys.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_HIGH_MARK 40U
+#define TEST_LOW_MARK 10U
+
+// Bytes sent by the peer, and the consumer's pace (the line carries ~11/ms)
+#define TEST_RX_BYTES 400U
+#define TEST_READS_PER_MS 4U
+
+// Bytes the application sends while it is being flooded
+#define TEST_TX_BYTES 120U
+
+#define TEST_MAX_MS 1000U
+
+// Bytes never equal to XON or XOFF
+#define TEST_RX_BYTE(byteIdx) ((char)('A' + ((byteIdx) % 26U)))
+#define TEST_TX_BYTE(byteIdx) ((char)('a' + ((byteIdx) % 26U)))
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static ttys_config_t testConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+    .rxHighMark = TEST_HIGH_MARK,
+    .rxLowMark = TEST_LOW_MARK,
+};
+
+// What the peer saw on our TX line
+static uint32_t testTxData;
+static uint32_t testTxCtrl;
+static uint32_t testNumXoff;
+static uint32_t testNumXon;
+static bool testTxInOrder;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_tx_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+
+  if (txData == TTYS_XOFF || txData == TTYS_XON) {
+    // XOFF and XON must alternate, starting with XOFF
+    if ((txData == TTYS_XOFF) != (testNumXoff == testNumXon)) {
+      testTxInOrder = false;
+    }
+    if (txData == TTYS_XOFF) testNumXoff++;
+    if (txData == TTYS_XON) testNumXon++;
+    testTxCtrl++;
+    return;
+  }
+
+  if ((char)txData != TEST_TX_BYTE(testTxData)) testTxInOrder = false;
+  testTxData++;
+}
+
+/**
+ * @brief: Floods a ttys instance through a consumer reading
+ *         TEST_READS_PER_MS bytes per ms, checks the data and the
+ *         backpressure it observes. With RTS/CTS the throttle is visible as
+ *         RXNEIE being off.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: ttysPort
+ * @return[out]: uint32_t. Number of times the backpressure was released
+ **/
+static uint32_t test_slow_consumer(uint32_t ttysInstIdx,
+                                   USART_TypeDef *ttysPort) {
+  static char rxData[TEST_RX_BYTES];
+  ttys_stats_t ttysStats;
+  uint32_t numRead = 0U;
+  uint32_t numSent = 0U;
+  uint32_t numReleased = 0U;
+  uint32_t numMs = 0U;
+  bool wasThrottled = false;
+  bool isRts = (testConfig.ttysFlowCtrl == TTYS_FLOW_RTS_CTS);
+
+  testTxData = 0U;
+  testTxCtrl = 0U;
+  testNumXoff = 0U;
+  testNumXon = 0U;
+  testTxInOrder = true;
+
+  HOST_CHECK_EQ(ttys_def_init(ttysInstIdx), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(ttysInstIdx, &testConfig), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_start(ttysInstIdx), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(ttysPort, test_tx_hook, NULL);
+
+  for (uint32_t byteIdx = 0U; byteIdx < TEST_RX_BYTES; byteIdx++) {
+    rxData[byteIdx] = TEST_RX_BYTE(byteIdx);
+  }
+  HOST_CHECK_EQ(sim_usart_rx_push(ttysPort, (const uint8_t *)rxData,
+                                  TEST_RX_BYTES),
+                TEST_RX_BYTES);
+
+  while (numRead < TEST_RX_BYTES && numMs < TEST_MAX_MS) {
+    sim_advance(SIM_MS(1));
+    numMs++;
+
+    // Some TX traffic every ms, while RX is throttled as well
+    for (uint32_t txIdx = 0U; txIdx < 2U && numSent < TEST_TX_BYTES; txIdx++) {
+      (void)ttys_putc(ttysInstIdx, TEST_TX_BYTE(numSent));
+      numSent++;
+    }
+
+    (void)ttys_get_stats(ttysInstIdx, &ttysStats);
+    uint32_t rxLevel = ttysStats.bytesIn - numRead;
+
+    // RTS/CTS: throttled exactly when the ring reached the high mark
+    bool isThrottled = isRts && !LL_USART_IsEnabledIT_RXNE(ttysPort);
+    if (isThrottled && !wasThrottled) {
+      HOST_CHECK_EQ(rxLevel, TEST_HIGH_MARK);
+    }
+    if (isRts && !isThrottled) {
+      HOST_CHECK(rxLevel < TEST_HIGH_MARK);
+    }
+
+    for (uint32_t readIdx = 0U; readIdx < TEST_READS_PER_MS; readIdx++) {
+      wasThrottled = isRts && !LL_USART_IsEnabledIT_RXNE(ttysPort);
+
+      char dataRec = ttys_getc(ttysInstIdx);
+      if (dataRec == 0) break;
+
+      if (dataRec != rxData[numRead]) {
+        HOST_CHECK_EQ(dataRec, rxData[numRead]);
+        return numReleased;
+      }
+      numRead++;
+
+      // Released at the low mark, not before; the byte held in DR is then
+      // taken at once
+      if (wasThrottled) {
+        (void)ttys_get_stats(ttysInstIdx, &ttysStats);
+        rxLevel = ttysStats.bytesIn - numRead;
+
+        if (LL_USART_IsEnabledIT_RXNE(ttysPort)) {
+          HOST_CHECK(rxLevel <= TEST_LOW_MARK + 1U);
+          numReleased++;
+        } else {
+          HOST_CHECK(rxLevel > TEST_LOW_MARK);
+        }
+      }
+    }
+    wasThrottled = isRts && !LL_USART_IsEnabledIT_RXNE(ttysPort);
+  }
+
+  // Letting the last TX bytes out
+  while (ttys_is_busy(ttysInstIdx) || !LL_USART_IsActiveFlag_TC(ttysPort)) {
+  }
+
+  (void)ttys_get_stats(ttysInstIdx, &ttysStats);
+  HOST_CHECK_EQ(numRead, TEST_RX_BYTES);
+  HOST_CHECK_EQ(ttysStats.bytesIn, TEST_RX_BYTES);
+  HOST_CHECK_EQ(ttysStats.rxDrops, 0U);
+  HOST_CHECK_EQ(ttysStats.oreErrs, 0U);
+  HOST_CHECK(ttysStats.rxHighWater >= TEST_HIGH_MARK);
+  HOST_CHECK(ttysStats.rxHighWater < MAX_BUFFER_SIZE - 1U);
+
+  HOST_CHECK_EQ(testTxData, TEST_TX_BYTES);
+  HOST_CHECK(testTxInOrder);
+
+  return numReleased;
+}
+
+/**
+ * @brief: RTS/CTS: DR is left unread at the high mark, the peer holds off on
+ *         RTS, and no byte overruns DR even though TXE keeps interrupting.
+ **/
+static void test_rts_cts(void) {
+  sim_usart_stats_t simStats;
+
+  testConfig.ttysFlowCtrl = TTYS_FLOW_RTS_CTS;
+  uint32_t numReleased = test_slow_consumer(TTYS_INSTANCE_2, USART2);
+
+  sim_usart_get_stats(USART2, &simStats);
+  HOST_CHECK(numReleased >= 2U);
+  HOST_CHECK(simStats.rtsHolds >= numReleased);
+  HOST_CHECK_EQ(simStats.rxOverruns, 0U);
+  HOST_CHECK_EQ(testTxCtrl, 0U);
+}
+
+/**
+ * @brief: XON/XOFF: an XOFF goes out at the high mark and an XON at the low
+ *         mark, alternating; the bytes already on their way fit in the ring.
+ **/
+static void test_xon_xoff(void) {
+  sim_usart_stats_t simStats;
+
+  testConfig.ttysFlowCtrl = TTYS_FLOW_XON_XOFF;
+  sim_usart_set_peer_xonxoff(USART1, true);
+  (void)test_slow_consumer(TTYS_INSTANCE_1, USART1);
+
+  sim_usart_get_stats(USART1, &simStats);
+  HOST_CHECK(testNumXoff >= 2U);
+  HOST_CHECK_EQ(testNumXon, testNumXoff);
+  HOST_CHECK(simStats.xoffHolds >= 1U);
+  HOST_CHECK_EQ(simStats.rxOverruns, 0U);
+}
+
+/**
+ * @brief: The marks are checked as they apply, after 0 picked the default:
+ *         the low mark must stay below the high mark either way.
+ **/
+static void test_marks(void) {
+  static const struct {
+    uint32_t highMark;
+    uint32_t lowMark;
+    uint32_t expRet;
+  } testMarks[] = {
+      {0U, 0U, EXIT_SUCCESS},
+      {TEST_HIGH_MARK, TEST_LOW_MARK, EXIT_SUCCESS},
+      {TTYS_RX_LOW_MARK_DEF + 1U, 0U, EXIT_SUCCESS},
+      {0U, TTYS_RX_HIGH_MARK_DEF - 1U, EXIT_SUCCESS},
+      {MAX_BUFFER_SIZE - 2U, 1U, EXIT_SUCCESS},
+      // The default low mark (20) above the given high mark
+      {10U, 0U, TTYS_ERR_CONFIG},
+      // The given low mark above the default high mark (60)
+      {0U, 70U, TTYS_ERR_CONFIG},
+      {0U, TTYS_RX_HIGH_MARK_DEF, TTYS_ERR_CONFIG},
+      {TEST_LOW_MARK, TEST_LOW_MARK, TTYS_ERR_CONFIG},
+      {MAX_BUFFER_SIZE - 1U, TEST_LOW_MARK, TTYS_ERR_CONFIG},
+  };
+  const uint32_t numMarks = sizeof(testMarks) / sizeof(testMarks[0]);
+  ttys_config_t markConfig = testConfig;
+
+  markConfig.ttysFlowCtrl = TTYS_FLOW_XON_XOFF;
+
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_3), EXIT_SUCCESS);
+  for (uint32_t markIdx = 0U; markIdx < numMarks; markIdx++) {
+    markConfig.rxHighMark = testMarks[markIdx].highMark;
+    markConfig.rxLowMark = testMarks[markIdx].lowMark;
+
+    HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_3, &markConfig),
+                  testMarks[markIdx].expRet);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  test_marks();
+  test_rts_cts();
+  test_xon_xoff();
+
+  HOST_DONE();
+}
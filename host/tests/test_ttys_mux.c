@@ -0,0 +1,286 @@
+/**
+ * @file test_ttys_mux.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Framing of the ttys multiplexer on the simulated USART, in
+ * half-duplex so every frame sent comes back to the demux. Payloads holding
+ * the sync and escape bytes survive the round trip, frames with a bad CRC,
+ * channel or length, or cut short, are dropped and counted, and a frame the
+ * ttys instance refused stays queued until the next pump.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <ttys_mux.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Upper bound for a test step, far more than the frames need at 115200
+#define TEST_MAX_MS 100U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t testConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+    .isHalfDuplex = true,  // Our own frames are received back
+};
+
+static const uint8_t testWeights[TTYS_MUX_NUM_CHANNELS] = {1U, 1U, 1U, 1U};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// CRC-16/CCITT-FALSE, written out the textbook way
+static uint16_t test_crc(const uint8_t *crcData, uint32_t crcLen) {
+  uint16_t testCrc = 0xFFFFU;
+
+  for (uint32_t crcIdx = 0U; crcIdx < crcLen; crcIdx++) {
+    testCrc ^= (uint16_t)(crcData[crcIdx] << 8U);
+    for (uint32_t crcBit = 0U; crcBit < 8U; crcBit++) {
+      if (testCrc & 0x8000U) {
+        testCrc = (uint16_t)((testCrc << 1U) ^ 0x1021U);
+      } else {
+        testCrc = (uint16_t)(testCrc << 1U);
+      }
+    }
+  }
+
+  return testCrc;
+}
+
+static uint32_t test_stuff(uint8_t *frameBuf, uint32_t frameLen,
+                           uint8_t frameByte) {
+  if (frameByte == TTYS_MUX_SYNC || frameByte == TTYS_MUX_ESC) {
+    frameBuf[frameLen++] = TTYS_MUX_ESC;
+    frameByte ^= TTYS_MUX_ESC_XOR;
+  }
+  frameBuf[frameLen++] = frameByte;
+
+  return frameLen;
+}
+
+/**
+ * @brief: Builds a frame the way the peer sends it, crcFlip is XORed into
+ *         the CRC to corrupt it.
+ **/
+static uint32_t test_frame(uint8_t *frameBuf, uint8_t muxChan,
+                           const uint8_t *muxData, uint8_t muxLen,
+                           uint16_t crcFlip) {
+  uint8_t crcData[2U + 0xFFU];
+  uint32_t frameLen = 0U;
+
+  crcData[0U] = muxChan;
+  crcData[1U] = muxLen;
+  (void)memcpy(&crcData[2U], muxData, muxLen);
+
+  uint16_t frameCrc = test_crc(crcData, 2U + muxLen) ^ crcFlip;
+
+  frameBuf[frameLen++] = TTYS_MUX_SYNC;
+  for (uint32_t dataIdx = 0U; dataIdx < 2U + muxLen; dataIdx++) {
+    frameLen = test_stuff(frameBuf, frameLen, crcData[dataIdx]);
+  }
+  frameLen = test_stuff(frameBuf, frameLen, (uint8_t)(frameCrc >> 8U));
+  frameLen = test_stuff(frameBuf, frameLen, (uint8_t)frameCrc);
+
+  return frameLen;
+}
+
+// Runs the virtual clock until the line is idle both ways
+static void test_drain(void) {
+  for (uint32_t numMs = 0U; numMs < TEST_MAX_MS; numMs++) {
+    if (!ttys_is_busy(TTYS_INSTANCE_2) &&
+        sim_usart_rx_queued(USART2) == 0U &&
+        LL_USART_IsActiveFlag_TC(USART2)) {
+      break;
+    }
+    sim_advance(SIM_MS(1));
+  }
+  sim_advance(SIM_MS(1));
+}
+
+static void test_push(const uint8_t *rxData, uint32_t rxLen) {
+  HOST_CHECK_EQ(sim_usart_rx_push(USART2, rxData, rxLen), rxLen);
+  test_drain();
+}
+
+/**
+ * @brief: Every byte value, on every channel, comes back unchanged, and the
+ *         frames on the wire hold no sync byte but the first.
+ **/
+static void test_round_trip(void) {
+  uint8_t txData[256U];
+  uint8_t rxData[256U];
+  ttys_mux_stats_t muxStats;
+
+  for (uint32_t dataIdx = 0U; dataIdx < 256U; dataIdx++) {
+    txData[dataIdx] = (uint8_t)(dataIdx * 7U + 0x7EU);
+  }
+
+  for (uint32_t muxChan = 0U; muxChan < TTYS_MUX_NUM_CHANNELS; muxChan++) {
+    uint32_t txDone = 0U;
+    uint32_t rxDone = 0U;
+
+    // More than a ring, fed as it drains
+    while (rxDone < sizeof(rxData)) {
+      if (txDone < sizeof(txData)) {
+        txDone += ttys_mux_write(muxChan, &txData[txDone],
+                                 sizeof(txData) - txDone);
+      }
+      test_drain();
+
+      uint32_t rxLen =
+          ttys_mux_read(muxChan, &rxData[rxDone], sizeof(rxData) - rxDone);
+      if (rxLen == 0U && txDone == sizeof(txData)) break;
+      rxDone += rxLen;
+    }
+
+    HOST_CHECK_EQ(rxDone, sizeof(rxData));
+    HOST_CHECK(memcmp(txData, rxData, sizeof(rxData)) == 0);
+
+    HOST_CHECK_EQ(ttys_mux_get_stats(muxChan, &muxStats), EXIT_SUCCESS);
+    HOST_CHECK_EQ(muxStats.txBytes, sizeof(txData));
+    HOST_CHECK_EQ(muxStats.rxBytes, sizeof(rxData));
+    HOST_CHECK_EQ(muxStats.txFrames,
+                  (sizeof(txData) + TTYS_MUX_MAX_PAYLOAD - 1U) /
+                      TTYS_MUX_MAX_PAYLOAD);
+  }
+
+  HOST_CHECK_EQ(ttys_mux_get_rx_errors(), 0U);
+}
+
+/**
+ * @brief: Frames from the peer: good ones are stored, bad ones dropped,
+ *         counted, and the next frame is found again.
+ **/
+static void test_bad_frames(void) {
+  static const uint8_t testCheck[] = "123456789";
+  static const uint8_t testPayload[] = {0x7EU, 0x7DU, 0x5EU, 0x00U, 0xFFU};
+  static const uint8_t testNoise[] = {0x00U, 0x7DU, 0x55U, 0x5EU};
+  uint8_t frameBuf[2U * TTYS_MUX_FRAME_MAX];
+  uint8_t rxData[16U];
+  uint32_t frameLen = 0U;
+  uint32_t numErrors = ttys_mux_get_rx_errors();
+
+  // The reference the test frames are checked against
+  HOST_CHECK_EQ(test_crc(testCheck, 9U), 0x29B1U);
+
+  // Good frame, the sync and escape bytes in the payload are stuffed
+  frameLen = test_frame(frameBuf, TTYS_MUX_LOG, testPayload, 5U, 0U);
+  HOST_CHECK_EQ(frameLen, 1U + 2U + 5U + 2U + 2U);
+  test_push(frameBuf, frameLen);
+  HOST_CHECK_EQ(ttys_mux_read(TTYS_MUX_LOG, rxData, sizeof(rxData)), 5U);
+  HOST_CHECK(memcmp(rxData, testPayload, 5U) == 0);
+  HOST_CHECK_EQ(ttys_mux_get_rx_errors(), numErrors);
+
+  // Noise between frames is skipped without an error
+  test_push(testNoise, sizeof(testNoise));
+  HOST_CHECK_EQ(ttys_mux_get_rx_errors(), numErrors);
+
+  // A flipped bit anywhere fails the CRC
+  for (uint32_t flipIdx = 0U; flipIdx < 16U; flipIdx++) {
+    frameLen = test_frame(frameBuf, TTYS_MUX_LOG, testPayload, 5U,
+                          (uint16_t)(1U << flipIdx));
+    test_push(frameBuf, frameLen);
+  }
+  numErrors += 16U;
+  HOST_CHECK_EQ(ttys_mux_get_rx_errors(), numErrors);
+  HOST_CHECK_EQ(ttys_mux_read(TTYS_MUX_LOG, rxData, sizeof(rxData)), 0U);
+
+  // Bad channel, length over the maximum
+  frameLen = test_frame(frameBuf, TTYS_MUX_NUM_CHANNELS, testPayload, 5U, 0U);
+  test_push(frameBuf, frameLen);
+  frameBuf[0U] = TTYS_MUX_SYNC;
+  frameBuf[1U] = TTYS_MUX_CONSOLE;
+  frameBuf[2U] = TTYS_MUX_MAX_PAYLOAD + 1U;
+  test_push(frameBuf, 3U);
+  numErrors += 2U;
+  HOST_CHECK_EQ(ttys_mux_get_rx_errors(), numErrors);
+
+  // A frame cut short by the next one, which still gets through
+  frameLen = test_frame(frameBuf, TTYS_MUX_CONSOLE, testPayload, 5U, 0U);
+  frameLen = 6U;
+  frameLen += test_frame(&frameBuf[frameLen], TTYS_MUX_CONSOLE,
+                         (const uint8_t *)"ok", 2U, 0U);
+  test_push(frameBuf, frameLen);
+  numErrors++;
+  HOST_CHECK_EQ(ttys_mux_get_rx_errors(), numErrors);
+  HOST_CHECK_EQ(ttys_mux_read(TTYS_MUX_CONSOLE, rxData, sizeof(rxData)), 2U);
+  HOST_CHECK(memcmp(rxData, "ok", 2U) == 0);
+
+  // An empty frame is valid
+  frameLen = test_frame(frameBuf, TTYS_MUX_UPDATE, testPayload, 0U, 0U);
+  test_push(frameBuf, frameLen);
+  HOST_CHECK_EQ(ttys_mux_get_rx_errors(), numErrors);
+}
+
+/**
+ * @brief: A frame the ttys instance refused leaves the data queued and the
+ *         counters alone, the next pump sends it.
+ **/
+static void test_refused(void) {
+  static const char testOther[] = "xxxxxxxx";
+  uint8_t rxData[8U];
+  ttys_mux_stats_t muxStats;
+  ttys_mux_stats_t muxBefore;
+
+  HOST_CHECK_EQ(ttys_mux_get_stats(TTYS_MUX_TELEMETRY, &muxBefore),
+                EXIT_SUCCESS);
+
+  // Someone else holds the async write
+  HOST_CHECK_EQ(ttys_write_async(TTYS_INSTANCE_2, testOther, 8U, NULL, NULL),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_mux_write(TTYS_MUX_TELEMETRY, "abc", 3U), 3U);
+
+  HOST_CHECK_EQ(ttys_mux_get_stats(TTYS_MUX_TELEMETRY, &muxStats),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(muxStats.txBytes, muxBefore.txBytes);
+  HOST_CHECK_EQ(muxStats.txFrames, muxBefore.txFrames);
+
+  test_drain();
+  HOST_CHECK_EQ(ttys_mux_read(TTYS_MUX_TELEMETRY, rxData, sizeof(rxData)), 0U);
+
+  HOST_CHECK_EQ(ttys_mux_pump(), 3U);
+  test_drain();
+
+  HOST_CHECK_EQ(ttys_mux_read(TTYS_MUX_TELEMETRY, rxData, sizeof(rxData)), 3U);
+  HOST_CHECK(memcmp(rxData, "abc", 3U) == 0);
+  HOST_CHECK_EQ(ttys_mux_get_stats(TTYS_MUX_TELEMETRY, &muxStats),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(muxStats.txBytes, muxBefore.txBytes + 3U);
+  HOST_CHECK_EQ(muxStats.txFrames, muxBefore.txFrames + 1U);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testConfig), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_start(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_mux_init(TTYS_INSTANCE_2, testWeights), EXIT_SUCCESS);
+
+  test_round_trip();
+  test_bad_frames();
+  test_refused();
+
+  HOST_DONE();
+}
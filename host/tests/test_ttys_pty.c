@@ -0,0 +1,198 @@
+/**
+ * @file test_ttys_pty.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Echo through a pty backed ttys instance. A client thread writes to
+ * the slave side and reads the echo back, the firmware loop echoes with
+ * ttys_getc()/ttys_putc() and sleeps in __WFI(). Every byte has to come
+ * back, in order, through the RX ISR and ring and the TX ISR.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Module includes */
+#include <ttys_pty.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// More than the wire queue holds, so the reader has to hold back
+#define TEST_BYTES 6000U
+#define TEST_CHUNK 64U
+
+// Wall clock bounds, generous for a loaded machine
+#define TEST_READ_MS 2000
+#define TEST_MAX_MS 20000U
+
+// Never 0, which ttys_getc() returns for an empty ring
+#define TEST_BYTE(byteIdx) ((char)(((byteIdx) % 255U) + 1U))
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const ttys_config_t testConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+    .ttysFlowCtrl = TTYS_FLOW_RTS_CTS,
+    .rxHighMark = 60U,
+    .rxLowMark = 20U,
+};
+
+static char testSlave[64];
+
+// Filled in by the client thread
+static uint32_t testNumSent;
+static uint32_t testNumEchoed;
+static bool testEchoInOrder;
+static atomic_bool testClientDone;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t test_ms(void) {
+  struct timespec testTs;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &testTs);
+  return (uint64_t)testTs.tv_sec * 1000U + (uint64_t)testTs.tv_nsec / 1000000U;
+}
+
+/**
+ * @brief: The terminal. Writes in chunks and reads whatever echo is there
+ *         in between, until everything came back or the echo stalls.
+ **/
+static void *test_client(void *testArg) {
+  char txChunk[TEST_CHUNK];
+  char rxChunk[TEST_CHUNK];
+  (void)testArg;
+
+  testEchoInOrder = true;
+
+  // Non-blocking, a client stuck in write() would stop reading the echo
+  int slaveFd = open(testSlave, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (slaveFd < 0) {
+    testEchoInOrder = false;
+    atomic_store(&testClientDone, true);
+    return NULL;
+  }
+
+  while (testNumEchoed < TEST_BYTES) {
+    struct pollfd testPoll = {.fd = slaveFd, .events = POLLIN};
+
+    if (testNumSent < TEST_BYTES) {
+      uint32_t txLen = TEST_BYTES - testNumSent;
+
+      if (txLen > TEST_CHUNK) txLen = TEST_CHUNK;
+      for (uint32_t byteIdx = 0U; byteIdx < txLen; byteIdx++) {
+        txChunk[byteIdx] = TEST_BYTE(testNumSent + byteIdx);
+      }
+
+      ssize_t txDone = write(slaveFd, txChunk, txLen);
+      if (txDone > 0) testNumSent += (uint32_t)txDone;
+      testPoll.events |= POLLOUT;
+    }
+
+    if (poll(&testPoll, 1U, TEST_READ_MS) <= 0) break;
+    if ((testPoll.revents & POLLIN) == 0) continue;
+
+    ssize_t rxLen = read(slaveFd, rxChunk, sizeof(rxChunk));
+    if (rxLen <= 0) break;
+
+    for (ssize_t byteIdx = 0; byteIdx < rxLen; byteIdx++) {
+      if (rxChunk[byteIdx] != TEST_BYTE(testNumEchoed)) testEchoInOrder = false;
+      testNumEchoed++;
+    }
+  }
+
+  (void)close(slaveFd);
+  atomic_store(&testClientDone, true);
+  return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  ttys_pty_stats_t ptyStats;
+  ttys_stats_t ttysStats;
+  pthread_t testThread;
+  uint32_t numEchoed = 0U;
+
+  // Not set up yet
+  HOST_CHECK_EQ(ttys_pty_open(TTYS_NUM_INSTANCES, NULL, 0U),
+                TTYS_PTY_ERR_IDX);
+  HOST_CHECK_EQ(ttys_pty_close(TTYS_INSTANCE_2), TTYS_PTY_ERR_NOT_OPEN);
+
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testConfig), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_start(TTYS_INSTANCE_2), EXIT_SUCCESS);
+
+  HOST_CHECK_EQ(ttys_pty_open(TTYS_INSTANCE_2, testSlave, sizeof(testSlave)),
+                EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_pty_open(TTYS_INSTANCE_2, NULL, 0U), TTYS_PTY_ERR_OPEN);
+  HOST_CHECK(strncmp(testSlave, "/dev/pts/", 9U) == 0);
+
+  HOST_CHECK_EQ(pthread_create(&testThread, NULL, test_client, NULL), 0);
+
+  // The firmware: echo what arrives, sleep when there is nothing
+  uint64_t testEnd = test_ms() + TEST_MAX_MS;
+  while (!atomic_load(&testClientDone) && test_ms() < testEnd) {
+    char dataRec = 0;
+
+    while ((dataRec = ttys_getc(TTYS_INSTANCE_2)) != 0) {
+      while (ttys_tx_free(TTYS_INSTANCE_2) == 0U) __WFI();
+      (void)ttys_putc(TTYS_INSTANCE_2, dataRec);
+      numEchoed++;
+    }
+    __WFI();
+  }
+
+  // Letting the last TX bytes out
+  while (ttys_is_busy(TTYS_INSTANCE_2) || !LL_USART_IsActiveFlag_TC(USART2)) {
+  }
+
+  (void)pthread_join(testThread, NULL);
+
+  HOST_CHECK_EQ(testNumSent, TEST_BYTES);
+  HOST_CHECK_EQ(numEchoed, TEST_BYTES);
+  HOST_CHECK_EQ(testNumEchoed, TEST_BYTES);
+  HOST_CHECK(testEchoInOrder);
+
+  HOST_CHECK_EQ(ttys_get_stats(TTYS_INSTANCE_2, &ttysStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttysStats.bytesIn, TEST_BYTES);
+  HOST_CHECK_EQ(ttysStats.rxDrops, 0U);
+  HOST_CHECK_EQ(ttysStats.oreErrs, 0U);
+
+  HOST_CHECK_EQ(ttys_pty_get_stats(TTYS_INSTANCE_2, &ptyStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ptyStats.rxBytes, TEST_BYTES);
+  HOST_CHECK_EQ(ptyStats.txBytes, TEST_BYTES);
+  HOST_CHECK_EQ(ptyStats.txDrops, 0U);
+
+  HOST_CHECK_EQ(ttys_pty_close(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttys_pty_close(TTYS_INSTANCE_2), TTYS_PTY_ERR_NOT_OPEN);
+
+  HOST_DONE();
+}
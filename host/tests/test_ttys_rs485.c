@@ -0,0 +1,212 @@
+/**
+ * @file test_ttys_rs485.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief RS-485 on the simulated USART: the DE pin is left alone by a config
+ * that fails validation, it is up for every frame on the wire, it drops at
+ * TC once the last stop bit is out and not a frame earlier, and the echo
+ * received while it is up is not counted.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Module includes */
+#include <gpio.h>
+#include <ttys.h>
+
+/* Test includes */
+#include "host_test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define TEST_DE_IDX 0U
+#define TEST_MAX_FRAMES 16U
+
+// The TC interrupt runs within this of the stop bit, the poll step included
+#define TEST_DE_LATENCY SIM_US(2)
+
+// 10 bits at 115200
+#define TEST_FRAME_CYCLES ((SIM_CORE_CLOCK * 10U) / 115200U)
+
+// Upper bound for the polling loops, far more than the frames need
+#define TEST_MAX_US 5000U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const io_out_handler_t testOutputs[] = {
+    {IO_PORT_C, IO_PIN_08, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, SET},
+};
+
+static io_confg_handler_t testConfg = {
+    0U, NULL, sizeof(testOutputs) / sizeof(testOutputs[0]), testOutputs};
+
+static const ttys_config_t testConfig = {
+    .ttysBaud = 115200U,
+    .ttysParity = LL_USART_PARITY_NONE,
+    .ttysStopBits = LL_USART_STOPBITS_1,
+    .ttysOverSampling = LL_USART_OVERSAMPLING_16,
+    .isRs485 = true,
+    .rs485DeIdx = TEST_DE_IDX,
+    .isHalfDuplex = true,  // The transceiver echoes every byte sent
+};
+
+// Frame ends seen on the wire, with the DE level at that instant
+static struct {
+  uint64_t endAt;
+  uint32_t deVal;
+} testFrames[TEST_MAX_FRAMES];
+static uint32_t testNumFrames;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_tx_hook(void *hookCtx, uint8_t txData) {
+  (void)hookCtx;
+  (void)txData;
+
+  if (testNumFrames >= TEST_MAX_FRAMES) return;
+
+  testFrames[testNumFrames].endAt = sim_now();
+  testFrames[testNumFrames].deVal = io_get_output_val(TEST_DE_IDX);
+  testNumFrames++;
+}
+
+/**
+ * @brief: A config rejected by any of the checks leaves the DE pin as it
+ *         was, a valid one releases it.
+ **/
+static void test_config_order(void) {
+  ttys_config_t badConfig;
+
+  HOST_CHECK_EQ(ttys_def_init(TTYS_INSTANCE_2), EXIT_SUCCESS);
+
+  // Invalid stop bits
+  badConfig = testConfig;
+  badConfig.ttysStopBits = 0x1234U;
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &badConfig), TTYS_ERR_CONFIG);
+  HOST_CHECK_EQ(io_get_output_val(TEST_DE_IDX), 1U);
+
+  // Marks that leave no room
+  badConfig = testConfig;
+  badConfig.rxHighMark = 10U;
+  badConfig.rxLowMark = 20U;
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &badConfig), TTYS_ERR_CONFIG);
+  HOST_CHECK_EQ(io_get_output_val(TEST_DE_IDX), 1U);
+
+  // Baud out of reach
+  badConfig = testConfig;
+  badConfig.ttysBaud = 0U;
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &badConfig), TTYS_ERR_BAUD);
+  HOST_CHECK_EQ(io_get_output_val(TEST_DE_IDX), 1U);
+
+  // No such DE pin
+  badConfig = testConfig;
+  badConfig.rs485DeIdx = 5U;
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &badConfig), TTYS_ERR_CONFIG);
+  HOST_CHECK_EQ(io_get_output_val(TEST_DE_IDX), 1U);
+
+  // Nothing above reached the USART
+  HOST_CHECK_EQ(LL_USART_IsEnabled(USART2), 0U);
+
+  HOST_CHECK_EQ(ttys_init(TTYS_INSTANCE_2, &testConfig), EXIT_SUCCESS);
+  HOST_CHECK_EQ(io_get_output_val(TEST_DE_IDX), 0U);
+  HOST_CHECK_EQ(LL_USART_IsEnabled(USART2), 1U);
+}
+
+/**
+ * @brief: DE is up for every frame and drops at TC, right after the stop bit
+ *         of the last one.
+ **/
+static void test_de_burst(const char *txData, uint32_t txLen) {
+  uint64_t deLowAt = 0U;
+
+  testNumFrames = 0U;
+
+  for (uint32_t txIdx = 0U; txIdx < txLen; txIdx++) {
+    HOST_CHECK_EQ(ttys_putc(TTYS_INSTANCE_2, txData[txIdx]), EXIT_SUCCESS);
+  }
+
+  for (uint32_t numUs = 0U; numUs < TEST_MAX_US; numUs++) {
+    sim_advance(SIM_US(1));
+    if (testNumFrames == txLen && io_get_output_val(TEST_DE_IDX) == 0U) {
+      deLowAt = sim_now();
+      break;
+    }
+    // Released before the last frame is out
+    HOST_CHECK(testNumFrames == txLen ||
+               io_get_output_val(TEST_DE_IDX) == 1U);
+  }
+
+  HOST_CHECK_EQ(testNumFrames, txLen);
+  for (uint32_t frameIdx = 0U; frameIdx < testNumFrames; frameIdx++) {
+    HOST_CHECK_EQ(testFrames[frameIdx].deVal, 1U);
+  }
+
+  // Not before the last stop bit, and not much later
+  uint64_t lastEndAt = testFrames[txLen - 1U].endAt;
+  HOST_CHECK(deLowAt >= lastEndAt);
+  HOST_CHECK(deLowAt - lastEndAt <= TEST_DE_LATENCY);
+
+  // The frames went out back to back, DE did not drop in between
+  for (uint32_t frameIdx = 1U; frameIdx < testNumFrames; frameIdx++) {
+    uint64_t frameGap =
+        testFrames[frameIdx].endAt - testFrames[frameIdx - 1U].endAt;
+    HOST_CHECK(frameGap <= TEST_FRAME_CYCLES + TEST_DE_LATENCY);
+  }
+}
+
+/**
+ * @brief: The echo of our own frames is dropped while DE is up, the peer's
+ *         bytes are received once it is released.
+ **/
+static void test_de_timing(void) {
+  static const char testBurst[] = "RS485";
+  static const uint8_t testReply[] = {'o', 'k'};
+  ttys_stats_t ttysStats;
+
+  HOST_CHECK_EQ(ttys_start(TTYS_INSTANCE_2), EXIT_SUCCESS);
+  sim_usart_set_tx_hook(USART2, test_tx_hook, NULL);
+
+  test_de_burst(testBurst, 5U);
+
+  HOST_CHECK_EQ(ttys_get_stats(TTYS_INSTANCE_2, &ttysStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttysStats.bytesOut, 5U);
+  HOST_CHECK_EQ(ttysStats.bytesIn, 0U);
+  HOST_CHECK_EQ(ttys_read_buf(TTYS_INSTANCE_2), 0U);
+
+  // A single byte, TC comes one frame after TXE
+  test_de_burst("x", 1U);
+
+  // The peer answers on the released bus
+  HOST_CHECK_EQ(sim_usart_rx_push(USART2, testReply, 2U), 2U);
+  sim_advance(SIM_MS(1));
+  HOST_CHECK_EQ(ttys_get_stats(TTYS_INSTANCE_2, &ttysStats), EXIT_SUCCESS);
+  HOST_CHECK_EQ(ttysStats.bytesIn, 2U);
+  HOST_CHECK_EQ(ttys_getc(TTYS_INSTANCE_2), 'o');
+  HOST_CHECK_EQ(ttys_getc(TTYS_INSTANCE_2), 'k');
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+  HOST_CHECK_EQ(io_init(&testConfg), EXIT_SUCCESS);
+  HOST_CHECK_EQ(io_get_output_val(TEST_DE_IDX), 1U);
+
+  test_config_order();
+  test_de_timing();
+
+  HOST_DONE();
+}
@@ -0,0 +1,358 @@
+/**
+ * @file elf_file.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Minimal ELF reader for the host decoders: the function symbols,
+ * sorted for address lookups, sections by name and strings by address.
+ * Little-endian ELF32 and ELF64 only.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Tool includes */
+#include "host_decode.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Section header fields, whichever the class
+#define ELF_SHDR(elfFile, secIdx, field)                          \
+  ((elfFile)->is64 ? (uint64_t)elf_shdr64(elfFile, secIdx)->field \
+                   : (uint64_t)elf_shdr32(elfFile, secIdx)->field)
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function declarations
+////////////////////////////////////////////////////////////////////////////////
+static const Elf32_Shdr *elf_shdr32(const elf_file_t *elfFile,
+                                    uint32_t secIdx);
+static const Elf64_Shdr *elf_shdr64(const elf_file_t *elfFile,
+                                    uint32_t secIdx);
+static uint32_t elf_num_sections(const elf_file_t *elfFile);
+static bool elf_in_file(const elf_file_t *elfFile, uint64_t fileOff,
+                        uint64_t fileLen);
+static uint32_t elf_load_syms(elf_file_t *elfFile);
+static int elf_sym_cmp(const void *symA, const void *symB);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Loads an ELF file and its function symbols.
+ *
+ * @param[out]: elfFile
+ * @param[in]: elfPath
+ * @return[out]: uint32_t
+ **/
+uint32_t elf_open(elf_file_t *elfFile, const char *elfPath) {
+  FILE *elfStream = fopen(elfPath, "rb");
+  long elfSize = 0;
+
+  (void)memset(elfFile, 0, sizeof(*elfFile));
+  if (elfStream == NULL) return HOST_DECODE_ERR_FILE;
+
+  if (fseek(elfStream, 0, SEEK_END) != 0 || (elfSize = ftell(elfStream)) < 0 ||
+      fseek(elfStream, 0, SEEK_SET) != 0) {
+    (void)fclose(elfStream);
+    return HOST_DECODE_ERR_FILE;
+  }
+
+  elfFile->elfData = malloc((size_t)elfSize + 1U);
+  elfFile->elfSize = (size_t)elfSize;
+  if (elfFile->elfData == NULL ||
+      fread(elfFile->elfData, 1U, elfFile->elfSize, elfStream) !=
+          elfFile->elfSize) {
+    (void)fclose(elfStream);
+    elf_close(elfFile);
+    return HOST_DECODE_ERR_FILE;
+  }
+  (void)fclose(elfStream);
+
+  const uint8_t *elfIdent = elfFile->elfData;
+  if (elfFile->elfSize < sizeof(Elf64_Ehdr) ||
+      memcmp(elfIdent, ELFMAG, SELFMAG) != 0 ||
+      elfIdent[EI_DATA] != ELFDATA2LSB ||
+      (elfIdent[EI_CLASS] != ELFCLASS32 && elfIdent[EI_CLASS] != ELFCLASS64)) {
+    elf_close(elfFile);
+    return HOST_DECODE_ERR_ELF;
+  }
+
+  elfFile->is64 = (elfIdent[EI_CLASS] == ELFCLASS64);
+  elfFile->elfMachine =
+      elfFile->is64 ? ((const Elf64_Ehdr *)elfIdent)->e_machine
+                    : ((const Elf32_Ehdr *)elfIdent)->e_machine;
+
+  uint32_t elfRet = elf_load_syms(elfFile);
+  if (elfRet != EXIT_SUCCESS) elf_close(elfFile);
+
+  return elfRet;
+}
+
+/**
+ * @brief: Frees what elf_open() loaded.
+ *
+ * @param[in]: elfFile
+ * @return[out]: void
+ **/
+void elf_close(elf_file_t *elfFile) {
+  free(elfFile->elfSyms);
+  free(elfFile->elfData);
+  (void)memset(elfFile, 0, sizeof(*elfFile));
+}
+
+/**
+ * @brief: The function containing an address. An address past the end of
+ *         the closest function below it (e.g. a symbol without a size) is
+ *         still given to that function.
+ *
+ * @param[in]: elfFile
+ * @param[in]: symAddr
+ * @return[out]: const elf_sym_t*. NULL below the first function
+ **/
+const elf_sym_t *elf_find_sym(const elf_file_t *elfFile, uint64_t symAddr) {
+  uint32_t symLo = 0U;
+  uint32_t symHi = elfFile->numSyms;
+
+  // Last symbol at or below the address
+  while (symLo < symHi) {
+    uint32_t symMid = symLo + (symHi - symLo) / 2U;
+
+    if (elfFile->elfSyms[symMid].symAddr <= symAddr) {
+      symLo = symMid + 1U;
+    } else {
+      symHi = symMid;
+    }
+  }
+
+  return (symLo != 0U) ? &elfFile->elfSyms[symLo - 1U] : NULL;
+}
+
+/**
+ * @brief: Finds a section by name.
+ *
+ * @param[in]: elfFile
+ * @param[in]: secName
+ * @param[out]: elfSection
+ * @return[out]: uint32_t
+ **/
+uint32_t elf_find_section(const elf_file_t *elfFile, const char *secName,
+                          elf_section_t *elfSection) {
+  uint32_t numSections = elf_num_sections(elfFile);
+  uint32_t strIdx = elfFile->is64
+                        ? ((const Elf64_Ehdr *)elfFile->elfData)->e_shstrndx
+                        : ((const Elf32_Ehdr *)elfFile->elfData)->e_shstrndx;
+
+  if (strIdx >= numSections) return HOST_DECODE_ERR_ELF;
+
+  uint64_t strOff = ELF_SHDR(elfFile, strIdx, sh_offset);
+  uint64_t strSize = ELF_SHDR(elfFile, strIdx, sh_size);
+  if (!elf_in_file(elfFile, strOff, strSize)) return HOST_DECODE_ERR_ELF;
+
+  for (uint32_t secIdx = 0U; secIdx < numSections; secIdx++) {
+    uint64_t nameOff = ELF_SHDR(elfFile, secIdx, sh_name);
+
+    if (nameOff >= strSize ||
+        strncmp((const char *)&elfFile->elfData[strOff + nameOff], secName,
+                strSize - nameOff) != 0) {
+      continue;
+    }
+
+    uint64_t secOff = ELF_SHDR(elfFile, secIdx, sh_offset);
+
+    elfSection->secAddr = ELF_SHDR(elfFile, secIdx, sh_addr);
+    elfSection->secSize = ELF_SHDR(elfFile, secIdx, sh_size);
+    elfSection->secData = NULL;
+
+    if (ELF_SHDR(elfFile, secIdx, sh_type) != SHT_NOBITS) {
+      if (!elf_in_file(elfFile, secOff, elfSection->secSize)) {
+        return HOST_DECODE_ERR_ELF;
+      }
+      elfSection->secData = &elfFile->elfData[secOff];
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  return HOST_DECODE_ERR_NOT_FOUND;
+}
+
+/**
+ * @brief: The NUL-terminated string at an address of the loaded image, e.g.
+ *         a format string or a %s argument.
+ *
+ * @param[in]: elfFile
+ * @param[in]: strAddr
+ * @return[out]: const char*. NULL outside the sections with file contents,
+ *               or if the string runs past the end of its section
+ **/
+const char *elf_find_str(const elf_file_t *elfFile, uint64_t strAddr) {
+  uint32_t numSections = elf_num_sections(elfFile);
+
+  for (uint32_t secIdx = 0U; secIdx < numSections; secIdx++) {
+    uint64_t secAddr = ELF_SHDR(elfFile, secIdx, sh_addr);
+    uint64_t secSize = ELF_SHDR(elfFile, secIdx, sh_size);
+    uint64_t secOff = ELF_SHDR(elfFile, secIdx, sh_offset);
+
+    if (!(ELF_SHDR(elfFile, secIdx, sh_flags) & SHF_ALLOC) ||
+        ELF_SHDR(elfFile, secIdx, sh_type) == SHT_NOBITS ||
+        strAddr < secAddr || strAddr - secAddr >= secSize ||
+        !elf_in_file(elfFile, secOff, secSize)) {
+      continue;
+    }
+
+    const char *secStr =
+        (const char *)&elfFile->elfData[secOff + (strAddr - secAddr)];
+    size_t strMax = (size_t)(secSize - (strAddr - secAddr));
+
+    return (memchr(secStr, '\0', strMax) != NULL) ? secStr : NULL;
+  }
+
+  return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static const Elf32_Shdr *elf_shdr32(const elf_file_t *elfFile,
+                                    uint32_t secIdx) {
+  const Elf32_Ehdr *elfHdr = (const Elf32_Ehdr *)elfFile->elfData;
+
+  return (const Elf32_Shdr *)&elfFile
+      ->elfData[elfHdr->e_shoff + (uint64_t)secIdx * elfHdr->e_shentsize];
+}
+
+static const Elf64_Shdr *elf_shdr64(const elf_file_t *elfFile,
+                                    uint32_t secIdx) {
+  const Elf64_Ehdr *elfHdr = (const Elf64_Ehdr *)elfFile->elfData;
+
+  return (const Elf64_Shdr *)&elfFile
+      ->elfData[elfHdr->e_shoff + (uint64_t)secIdx * elfHdr->e_shentsize];
+}
+
+/**
+ * @brief: Number of section headers, 0 if the table is not in the file.
+ **/
+static uint32_t elf_num_sections(const elf_file_t *elfFile) {
+  uint64_t shOff = 0U;
+  uint64_t shEntSize = 0U;
+  uint64_t shNum = 0U;
+
+  if (elfFile->is64) {
+    const Elf64_Ehdr *elfHdr = (const Elf64_Ehdr *)elfFile->elfData;
+
+    shOff = elfHdr->e_shoff;
+    shEntSize = elfHdr->e_shentsize;
+    shNum = elfHdr->e_shnum;
+    if (shEntSize < sizeof(Elf64_Shdr)) return 0U;
+  } else {
+    const Elf32_Ehdr *elfHdr = (const Elf32_Ehdr *)elfFile->elfData;
+
+    shOff = elfHdr->e_shoff;
+    shEntSize = elfHdr->e_shentsize;
+    shNum = elfHdr->e_shnum;
+    if (shEntSize < sizeof(Elf32_Shdr)) return 0U;
+  }
+
+  return elf_in_file(elfFile, shOff, shEntSize * shNum) ? (uint32_t)shNum
+                                                         : 0U;
+}
+
+static bool elf_in_file(const elf_file_t *elfFile, uint64_t fileOff,
+                        uint64_t fileLen) {
+  return fileOff <= elfFile->elfSize && fileLen <= elfFile->elfSize - fileOff;
+}
+
+/**
+ * @brief: Collects the function symbols of .symtab and sorts them. On ARM
+ *         bit 0 of a function address only marks Thumb code.
+ **/
+static uint32_t elf_load_syms(elf_file_t *elfFile) {
+  uint32_t numSections = elf_num_sections(elfFile);
+
+  for (uint32_t secIdx = 0U; secIdx < numSections; secIdx++) {
+    if (ELF_SHDR(elfFile, secIdx, sh_type) != SHT_SYMTAB) continue;
+
+    uint64_t symOff = ELF_SHDR(elfFile, secIdx, sh_offset);
+    uint64_t symSize = ELF_SHDR(elfFile, secIdx, sh_size);
+    uint64_t symEntSize = ELF_SHDR(elfFile, secIdx, sh_entsize);
+    uint32_t strIdx = (uint32_t)ELF_SHDR(elfFile, secIdx, sh_link);
+
+    if (symEntSize == 0U || strIdx >= numSections ||
+        !elf_in_file(elfFile, symOff, symSize)) {
+      return HOST_DECODE_ERR_ELF;
+    }
+
+    uint64_t strOff = ELF_SHDR(elfFile, strIdx, sh_offset);
+    uint64_t strSize = ELF_SHDR(elfFile, strIdx, sh_size);
+    if (!elf_in_file(elfFile, strOff, strSize)) return HOST_DECODE_ERR_ELF;
+
+    uint64_t numEntries = symSize / symEntSize;
+    elfFile->elfSyms = calloc(numEntries + 1U, sizeof(elf_sym_t));
+    if (elfFile->elfSyms == NULL) return HOST_DECODE_ERR_FILE;
+
+    for (uint64_t symIdx = 0U; symIdx < numEntries; symIdx++) {
+      const uint8_t *symEnt = &elfFile->elfData[symOff + symIdx * symEntSize];
+      uint64_t symAddr = 0U;
+      uint64_t symLen = 0U;
+      uint32_t symName = 0U;
+      uint32_t symType = 0U;
+      uint32_t symShndx = 0U;
+
+      if (elfFile->is64) {
+        const Elf64_Sym *elfSym = (const Elf64_Sym *)symEnt;
+
+        symAddr = elfSym->st_value;
+        symLen = elfSym->st_size;
+        symName = elfSym->st_name;
+        symType = ELF64_ST_TYPE(elfSym->st_info);
+        symShndx = elfSym->st_shndx;
+      } else {
+        const Elf32_Sym *elfSym = (const Elf32_Sym *)symEnt;
+
+        symAddr = elfSym->st_value;
+        symLen = elfSym->st_size;
+        symName = elfSym->st_name;
+        symType = ELF32_ST_TYPE(elfSym->st_info);
+        symShndx = elfSym->st_shndx;
+      }
+
+      if (symType != STT_FUNC || symShndx == SHN_UNDEF ||
+          symName >= strSize) {
+        continue;
+      }
+
+      if (elfFile->elfMachine == EM_ARM) symAddr &= ~(uint64_t)1U;
+
+      elf_sym_t *elfSym = &elfFile->elfSyms[elfFile->numSyms++];
+      elfSym->symAddr = symAddr;
+      elfSym->symSize = symLen;
+      elfSym->symName = (const char *)&elfFile->elfData[strOff + symName];
+    }
+
+    qsort(elfFile->elfSyms, elfFile->numSyms, sizeof(elf_sym_t), elf_sym_cmp);
+    return EXIT_SUCCESS;
+  }
+
+  // Stripped, the lookups find nothing
+  return EXIT_SUCCESS;
+}
+
+static int elf_sym_cmp(const void *symA, const void *symB) {
+  uint64_t addrA = ((const elf_sym_t *)symA)->symAddr;
+  uint64_t addrB = ((const elf_sym_t *)symB)->symAddr;
+
+  return (addrA > addrB) - (addrA < addrB);
+}
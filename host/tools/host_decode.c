@@ -0,0 +1,138 @@
+/**
+ * @file host_decode.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Command line front end of the dump decoders:
+ *
+ *   host_decode pcs <firmware.elf> <dump.bin>
+ *   host_decode log <firmware.elf> <dump.bin>
+ *   host_decode trace <firmware.elf> <dump.bin> > trace.json
+ *
+ * The dump is the raw byte stream captured from the ttys instance.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdlib.h>
+#include <string.h>
+
+/* Tool includes */
+#include "host_decode.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) types
+////////////////////////////////////////////////////////////////////////////////
+
+typedef uint32_t (*decode_func_t)(FILE *decodeOut, const uint8_t *dumpData,
+                                  size_t dumpLen, const elf_file_t *elfFile);
+
+/* A subcommand */
+typedef struct {
+  const char *decodeName;
+  decode_func_t decodeFunc;
+
+} decode_cmd_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const decode_cmd_t decodeCmds[] = {
+    {"pcs", pcs_decode},
+    {"log", log_decode},
+    {"trace", trace_decode},
+};
+
+#define DECODE_NUM_CMDS (sizeof(decodeCmds) / sizeof(decodeCmds[0]))
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Reads a whole file, "-" is stdin.
+ **/
+static uint8_t *decode_read(const char *dumpPath, size_t *dumpLen) {
+  FILE *dumpStream = (strcmp(dumpPath, "-") == 0) ? stdin
+                                                  : fopen(dumpPath, "rb");
+  uint8_t *dumpData = NULL;
+  size_t dumpCap = 0U;
+
+  *dumpLen = 0U;
+  if (dumpStream == NULL) return NULL;
+
+  for (;;) {
+    if (*dumpLen == dumpCap) {
+      dumpCap = (dumpCap != 0U) ? 2U * dumpCap : 4096U;
+
+      uint8_t *dumpGrown = realloc(dumpData, dumpCap);
+      if (dumpGrown == NULL) break;
+      dumpData = dumpGrown;
+    }
+
+    size_t numRead =
+        fread(&dumpData[*dumpLen], 1U, dumpCap - *dumpLen, dumpStream);
+    if (numRead == 0U) break;
+    *dumpLen += numRead;
+  }
+
+  if (dumpStream != stdin) (void)fclose(dumpStream);
+
+  return dumpData;
+}
+
+static int decode_usage(void) {
+  fprintf(stderr,
+          "usage: host_decode pcs|log|trace <firmware.elf> <dump.bin>\n");
+  return EXIT_FAILURE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv) {
+  elf_file_t elfFile;
+  size_t dumpLen = 0U;
+  uint32_t decodeRet = EXIT_SUCCESS;
+  uint32_t cmdIdx = 0U;
+
+  if (argc != 4) return decode_usage();
+
+  while (cmdIdx < DECODE_NUM_CMDS &&
+         strcmp(argv[1], decodeCmds[cmdIdx].decodeName) != 0) {
+    cmdIdx++;
+  }
+  if (cmdIdx == DECODE_NUM_CMDS) return decode_usage();
+
+  if (elf_open(&elfFile, argv[2]) != EXIT_SUCCESS) {
+    fprintf(stderr, "host_decode: cannot read %s as ELF\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  uint8_t *dumpData = decode_read(argv[3], &dumpLen);
+  if (dumpData == NULL) {
+    fprintf(stderr, "host_decode: cannot read %s\n", argv[3]);
+    elf_close(&elfFile);
+    return EXIT_FAILURE;
+  }
+
+  decodeRet =
+      decodeCmds[cmdIdx].decodeFunc(stdout, dumpData, dumpLen, &elfFile);
+  if (decodeRet != EXIT_SUCCESS) {
+    fprintf(stderr, "host_decode: %s is not a valid %s dump\n", argv[3],
+            argv[1]);
+  }
+
+  free(dumpData);
+  elf_close(&elfFile);
+
+  return (decodeRet == EXIT_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
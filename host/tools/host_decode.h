@@ -0,0 +1,89 @@
+/**
+ * @file host_decode.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Host-side decoders for the binary dumps the modules stream over
+ * ttys. The firmware ELF supplies the symbols and strings the dumps only
+ * refer to by address. Both ELF32 (the target) and ELF64 (the host build)
+ * are read, so the decoders can be tested on the host test binaries.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef HOST_DECODE_H
+#define HOST_DECODE_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Error Codes */
+typedef enum {
+
+  HOST_DECODE_ERR_FILE = 0x70U,
+  HOST_DECODE_ERR_ELF,
+  HOST_DECODE_ERR_FORMAT,
+  HOST_DECODE_ERR_NOT_FOUND,
+
+} host_decode_errors_t;
+
+/* One function symbol */
+typedef struct {
+  uint64_t symAddr;  // Thumb bit cleared
+  uint64_t symSize;
+  const char *symName;
+
+} elf_sym_t;
+
+/* An ELF file loaded into memory */
+typedef struct {
+  uint8_t *elfData;
+  size_t elfSize;
+  bool is64;
+  uint32_t elfMachine;
+
+  elf_sym_t *elfSyms;  // Functions, sorted by address
+  uint32_t numSyms;
+
+} elf_file_t;
+
+/* A section of an ELF file */
+typedef struct {
+  const uint8_t *secData;  // NULL for NOBITS sections
+  uint64_t secAddr;
+  uint64_t secSize;
+
+} elf_section_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* ELF */
+uint32_t elf_open(elf_file_t *elfFile, const char *elfPath);
+void elf_close(elf_file_t *elfFile);
+const elf_sym_t *elf_find_sym(const elf_file_t *elfFile, uint64_t symAddr);
+uint32_t elf_find_section(const elf_file_t *elfFile, const char *secName,
+                          elf_section_t *elfSection);
+const char *elf_find_str(const elf_file_t *elfFile, uint64_t strAddr);
+
+/* Decoders, each writes its report to decodeOut */
+uint32_t pcs_decode(FILE *decodeOut, const uint8_t *dumpData,
+                    size_t dumpLen, const elf_file_t *elfFile);
+uint32_t log_decode(FILE *decodeOut, const uint8_t *dumpData,
+                    size_t dumpLen, const elf_file_t *elfFile);
+uint32_t trace_decode(FILE *decodeOut, const uint8_t *dumpData,
+                      size_t dumpLen, const elf_file_t *elfFile);
+
+#endif  // host_decode.h
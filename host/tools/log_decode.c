@@ -0,0 +1,249 @@
+/**
+ * @file log_decode.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Formats the records of a log_dump() or log_postmortem() stream on
+ * the host. The format strings, and the strings %s arguments point at, are
+ * read from the firmware ELF the dump came from.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdlib.h>
+#include <string.h>
+
+/* Tool includes */
+#include "host_decode.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Must match log.h
+#define LOG_MAX_ARGS 4U
+#define LOG_FAULT_MAGIC 0x4C4F4746U  // "LOGF"
+
+// Format ID, timestamp and number of arguments
+#define LOG_DUMP_HDR_SIZE 9U
+
+// log_postmortem(): the eight words of log_fault_t and the record count
+#define LOG_FAULT_SIZE 36U
+
+// Longest conversion specification rebuilt for fprintf()
+#define LOG_SPEC_SIZE 32U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+// The target's format section, and the host build's (see host/CMakeLists.txt)
+static const char *const logFmtSections[] = {".rodata.log", "log_fmt"};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t log_get_le(const uint8_t *dumpData) {
+  return (uint32_t)dumpData[0U] | (uint32_t)dumpData[1U] << 8U |
+         (uint32_t)dumpData[2U] << 16U | (uint32_t)dumpData[3U] << 24U;
+}
+
+static const char *log_sym_name(const elf_file_t *elfFile, uint32_t symAddr) {
+  const elf_sym_t *elfSym = elf_find_sym(elfFile, symAddr);
+
+  return (elfSym != NULL) ? elfSym->symName : "?";
+}
+
+/**
+ * @brief: Prints one record the way the target's printf() would. Every
+ *         argument is 32 bits wide there, so the length modifiers are
+ *         dropped and each conversion is printed on its own with a host
+ *         type of the same width. Arguments past the recorded ones are 0,
+ *         as log_flush() passes them.
+ **/
+static void log_print(FILE *decodeOut, const char *logFmt,
+                      const uint32_t *logArgs, const elf_file_t *elfFile) {
+  uint32_t argIdx = 0U;
+
+  while (*logFmt != '\0') {
+    char logSpec[LOG_SPEC_SIZE];
+    size_t specLen = 0U;
+    const char *specStart = logFmt;
+
+    if (*logFmt != '%') {
+      fputc(*logFmt++, decodeOut);
+      continue;
+    }
+
+    logSpec[specLen++] = *logFmt++;
+
+    // Flags, width and precision, '*' takes an argument
+    while (*logFmt != '\0' && strchr("-+ #0123456789.*", *logFmt) != NULL &&
+           specLen < LOG_SPEC_SIZE - 16U) {
+      if (*logFmt == '*') {
+        int32_t specWidth = (argIdx < LOG_MAX_ARGS)
+                                ? (int32_t)logArgs[argIdx++]
+                                : 0;
+        specLen += (size_t)snprintf(&logSpec[specLen],
+                                    LOG_SPEC_SIZE - specLen, "%d",
+                                    (int)specWidth);
+      } else {
+        logSpec[specLen++] = *logFmt;
+      }
+      logFmt++;
+    }
+
+    // Length modifiers, every argument is 32 bits on the target
+    while (*logFmt != '\0' && strchr("hlLqjzt", *logFmt) != NULL) logFmt++;
+
+    char specConv = *logFmt;
+    if (specConv == '\0') {
+      fputs(specStart, decodeOut);
+      break;
+    }
+    logFmt++;
+
+    uint32_t logArg = (argIdx < LOG_MAX_ARGS) ? logArgs[argIdx] : 0U;
+
+    switch (specConv) {
+      case '%':
+        fputc('%', decodeOut);
+        continue;
+
+      case 'd':
+      case 'i':
+        logSpec[specLen++] = 'd';
+        logSpec[specLen] = '\0';
+        fprintf(decodeOut, logSpec, (int)(int32_t)logArg);
+        break;
+
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+      case 'c':
+        logSpec[specLen++] = specConv;
+        logSpec[specLen] = '\0';
+        fprintf(decodeOut, logSpec, (unsigned int)logArg);
+        break;
+
+      case 'p':
+        fprintf(decodeOut, "0x%08x", (unsigned int)logArg);
+        break;
+
+      case 's': {
+        const char *logStr = elf_find_str(elfFile, logArg);
+
+        if (logStr != NULL) {
+          logSpec[specLen++] = 's';
+          logSpec[specLen] = '\0';
+          fprintf(decodeOut, logSpec, logStr);
+        } else {
+          fprintf(decodeOut, "<str %08x>", (unsigned int)logArg);
+        }
+        break;
+      }
+
+      default:
+        // Doubles and the rest cannot be recorded, shown as written
+        fprintf(decodeOut, "%.*s", (int)(logFmt - specStart), specStart);
+        break;
+    }
+    argIdx++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Decodes a log dump, one line per record as log_flush() prints
+ *         them. A log_postmortem() stream starts with the fault block,
+ *         which is printed first with the functions PC and LR are in.
+ *
+ * @param[in]: decodeOut
+ * @param[in]: dumpData
+ * @param[in]: dumpLen
+ * @param[in]: elfFile
+ * @return[out]: uint32_t. HOST_DECODE_ERR_NOT_FOUND if the ELF has no
+ *               format section, HOST_DECODE_ERR_FORMAT if the dump is cut
+ **/
+uint32_t log_decode(FILE *decodeOut, const uint8_t *dumpData,
+                    size_t dumpLen, const elf_file_t *elfFile) {
+  elf_section_t fmtSection;
+  uint32_t secIdx = 0U;
+  size_t dumpPos = 0U;
+
+  for (secIdx = 0U; secIdx < sizeof(logFmtSections) / sizeof(char *);
+       secIdx++) {
+    if (elf_find_section(elfFile, logFmtSections[secIdx], &fmtSection) ==
+        EXIT_SUCCESS) {
+      break;
+    }
+  }
+  if (secIdx == sizeof(logFmtSections) / sizeof(char *)) {
+    return HOST_DECODE_ERR_NOT_FOUND;
+  }
+
+  if (dumpLen >= 4U && log_get_le(dumpData) == LOG_FAULT_MAGIC) {
+    if (dumpLen < LOG_FAULT_SIZE) return HOST_DECODE_ERR_FORMAT;
+
+    uint32_t faultPc = log_get_le(&dumpData[20U]);
+    uint32_t faultLr = log_get_le(&dumpData[24U]);
+
+    fprintf(decodeOut, "# fault: pc 0x%08X (%s) lr 0x%08X (%s) xpsr 0x%08X\n",
+            faultPc, log_sym_name(elfFile, faultPc), faultLr,
+            log_sym_name(elfFile, faultLr), log_get_le(&dumpData[28U]));
+    fprintf(decodeOut,
+            "# fault: cfsr 0x%08X hfsr 0x%08X mmfar 0x%08X bfar 0x%08X, "
+            "%u records\n",
+            log_get_le(&dumpData[4U]), log_get_le(&dumpData[8U]),
+            log_get_le(&dumpData[12U]), log_get_le(&dumpData[16U]),
+            log_get_le(&dumpData[32U]));
+    dumpPos = LOG_FAULT_SIZE;
+  }
+
+  while (dumpPos < dumpLen) {
+    uint32_t logArgs[LOG_MAX_ARGS] = {0U};
+
+    if (dumpLen - dumpPos < LOG_DUMP_HDR_SIZE) return HOST_DECODE_ERR_FORMAT;
+
+    uint32_t logId = log_get_le(&dumpData[dumpPos]);
+    uint32_t logTime = log_get_le(&dumpData[dumpPos + 4U]);
+    uint32_t logNumArgs = dumpData[dumpPos + 8U];
+    dumpPos += LOG_DUMP_HDR_SIZE;
+
+    if (logNumArgs > LOG_MAX_ARGS || dumpLen - dumpPos < 4U * logNumArgs) {
+      return HOST_DECODE_ERR_FORMAT;
+    }
+    for (uint32_t argIdx = 0U; argIdx < logNumArgs; argIdx++) {
+      logArgs[argIdx] = log_get_le(&dumpData[dumpPos]);
+      dumpPos += 4U;
+    }
+
+    // Only IDs inside the format section, as log_flush() checks
+    const char *logFmt = NULL;
+    if (logId >= fmtSection.secAddr &&
+        logId - fmtSection.secAddr < fmtSection.secSize) {
+      logFmt = elf_find_str(elfFile, logId);
+    }
+
+    fprintf(decodeOut, "[%10u] ", logTime);
+    if (logFmt != NULL) {
+      log_print(decodeOut, logFmt, logArgs, elfFile);
+    } else {
+      fprintf(decodeOut, "<bad format %08x>", logId);
+    }
+    fputc('\n', decodeOut);
+  }
+
+  return EXIT_SUCCESS;
+}
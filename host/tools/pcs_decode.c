@@ -0,0 +1,162 @@
+/**
+ * @file pcs_decode.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Maps a pcs_dump() histogram to the functions of the firmware ELF
+ * and prints a flat profile, hottest function first.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdlib.h>
+#include <string.h>
+
+/* Tool includes */
+#include "host_decode.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Must match pcs.h
+#define PCS_DUMP_MAGIC "PCS"
+#define PCS_DUMP_VERSION 1U
+#define PCS_DUMP_HDR_SIZE 31U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) types
+////////////////////////////////////////////////////////////////////////////////
+
+/* Samples per function */
+typedef struct {
+  const char *funcName;
+  uint64_t funcSamples;
+
+} pcs_func_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t pcs_get_le(const uint8_t *dumpData, uint32_t numBytes) {
+  uint32_t dumpVal = 0U;
+
+  for (uint32_t byteIdx = 0U; byteIdx < numBytes; byteIdx++) {
+    dumpVal |= (uint32_t)dumpData[byteIdx] << (8U * byteIdx);
+  }
+
+  return dumpVal;
+}
+
+static int pcs_func_cmp(const void *funcA, const void *funcB) {
+  uint64_t samplesA = ((const pcs_func_t *)funcA)->funcSamples;
+  uint64_t samplesB = ((const pcs_func_t *)funcB)->funcSamples;
+
+  return (samplesA < samplesB) - (samplesA > samplesB);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Decodes a pcs dump. A bin goes to the function containing its
+ *         first address, so keep the bins small (shift 4 or less) for a
+ *         profile by function.
+ *
+ * @param[in]: decodeOut
+ * @param[in]: dumpData
+ * @param[in]: dumpLen
+ * @param[in]: elfFile
+ * @return[out]: uint32_t
+ **/
+uint32_t pcs_decode(FILE *decodeOut, const uint8_t *dumpData,
+                    size_t dumpLen, const elf_file_t *elfFile) {
+  if (dumpLen < PCS_DUMP_HDR_SIZE ||
+      memcmp(dumpData, PCS_DUMP_MAGIC, 3U) != 0 ||
+      dumpData[3U] != PCS_DUMP_VERSION) {
+    return HOST_DECODE_ERR_FORMAT;
+  }
+
+  uint32_t pcsStart = pcs_get_le(&dumpData[4U], 4U);
+  uint32_t pcsShift = dumpData[8U];
+  uint32_t pcsPeriodUs = pcs_get_le(&dumpData[9U], 4U);
+  uint32_t numSamples = pcs_get_le(&dumpData[13U], 4U);
+  uint32_t numOutside = pcs_get_le(&dumpData[17U], 4U);
+  uint32_t maxCycles = pcs_get_le(&dumpData[21U], 4U);
+  uint32_t overheadPpm = pcs_get_le(&dumpData[25U], 4U);
+  uint32_t numBins = pcs_get_le(&dumpData[29U], 2U);
+
+  // One slot per function, the last one for code no symbol covers
+  pcs_func_t *pcsFuncs = calloc(elfFile->numSyms + 1U, sizeof(pcs_func_t));
+  if (pcsFuncs == NULL) return HOST_DECODE_ERR_FILE;
+
+  for (uint32_t symIdx = 0U; symIdx < elfFile->numSyms; symIdx++) {
+    pcsFuncs[symIdx].funcName = elfFile->elfSyms[symIdx].symName;
+  }
+  pcsFuncs[elfFile->numSyms].funcName = "<unknown>";
+
+  size_t dumpPos = PCS_DUMP_HDR_SIZE;
+  for (uint32_t binNum = 0U; binNum < numBins; binNum++) {
+    uint64_t binCount = 0U;
+    uint32_t varShift = 0U;
+
+    if (dumpLen - dumpPos < 3U) break;
+
+    uint32_t binIdx = pcs_get_le(&dumpData[dumpPos], 2U);
+    dumpPos += 2U;
+
+    // LEB128 count
+    while (dumpPos < dumpLen && varShift < 35U) {
+      uint8_t varByte = dumpData[dumpPos++];
+
+      binCount |= (uint64_t)(varByte & 0x7FU) << varShift;
+      varShift += 7U;
+      if (!(varByte & 0x80U)) break;
+    }
+
+    uint64_t binAddr = (uint64_t)pcsStart + ((uint64_t)binIdx << pcsShift);
+    const elf_sym_t *elfSym = elf_find_sym(elfFile, binAddr);
+    uint32_t funcIdx = elfFile->numSyms;
+
+    // Past the end of a sized function is not that function
+    if (elfSym != NULL &&
+        (elfSym->symSize == 0U ||
+         binAddr < elfSym->symAddr + elfSym->symSize)) {
+      funcIdx = (uint32_t)(elfSym - elfFile->elfSyms);
+    }
+    pcsFuncs[funcIdx].funcSamples += binCount;
+  }
+
+  qsort(pcsFuncs, elfFile->numSyms + 1U, sizeof(pcs_func_t), pcs_func_cmp);
+
+  fprintf(decodeOut,
+          "# pcs: %u samples every %u us, %u outside, bins of %u bytes at "
+          "0x%08X\n",
+          numSamples, pcsPeriodUs, numOutside, 1U << pcsShift, pcsStart);
+  fprintf(decodeOut, "# sampler: %u cycles max, %u ppm of the CPU\n",
+          maxCycles, overheadPpm);
+  fprintf(decodeOut, "samples,percent,function\n");
+
+  for (uint32_t funcIdx = 0U; funcIdx <= elfFile->numSyms; funcIdx++) {
+    if (pcsFuncs[funcIdx].funcSamples == 0U) break;
+
+    fprintf(decodeOut, "%llu,%.2f,%s\n",
+            (unsigned long long)pcsFuncs[funcIdx].funcSamples,
+            (numSamples != 0U)
+                ? 100.0 * (double)pcsFuncs[funcIdx].funcSamples / numSamples
+                : 0.0,
+            pcsFuncs[funcIdx].funcName);
+  }
+
+  free(pcsFuncs);
+
+  return (dumpPos == dumpLen) ? EXIT_SUCCESS : HOST_DECODE_ERR_FORMAT;
+}
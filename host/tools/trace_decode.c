@@ -0,0 +1,212 @@
+/**
+ * @file trace_decode.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Converts a trace_dump() stream to the Chrome trace event format
+ * (JSON), which chrome://tracing and https://ui.perfetto.dev open. tmr
+ * callbacks become slices named after the callback in the firmware ELF, the
+ * other events instant events.
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+/* Standard C includes */
+#include <stdlib.h>
+#include <string.h>
+
+/* Tool includes */
+#include "host_decode.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Must match trace.h
+#define TRACE_DUMP_MAGIC "TRC"
+#define TRACE_DUMP_VERSION 1U
+#define TRACE_DUMP_HDR_SIZE 13U
+#define TRACE_RECORD_SIZE 8U
+
+#define TRACE_EVT_DT_OVERFLOW 0U
+#define TRACE_EVT_TMR_CB_START 1U
+#define TRACE_EVT_TMR_CB_END 2U
+#define TRACE_EVT_USER 0x80U
+
+// One Chrome process per module, the instance (or input) is the thread
+#define TRACE_PID_TMR 1U
+#define TRACE_PID_TTYS 2U
+#define TRACE_PID_GPIO 3U
+#define TRACE_PID_USER 4U
+
+#define TRACE_MAX_ARG 256U
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) types
+////////////////////////////////////////////////////////////////////////////////
+
+/* How an event ID is shown */
+typedef struct {
+  const char *evtName;
+  uint32_t evtPid;
+
+} trace_evt_info_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+// Indexed by trace_evt_t, up to TRACE_EVT_GPIO_EDGE
+static const trace_evt_info_t traceEvts[] = {
+    {"dt_overflow", TRACE_PID_USER},   {"tmr_cb", TRACE_PID_TMR},
+    {"tmr_cb", TRACE_PID_TMR},         {"ttys_rx", TRACE_PID_TTYS},
+    {"ttys_rx_ovf", TRACE_PID_TTYS},   {"ttys_tx_start", TRACE_PID_TTYS},
+    {"ttys_tx_done", TRACE_PID_TTYS},  {"gpio_edge", TRACE_PID_GPIO},
+};
+
+#define TRACE_NUM_EVTS (sizeof(traceEvts) / sizeof(traceEvts[0]))
+
+// Process names, indexed by pid
+static const char *const tracePids[] = {NULL, "tmr", "ttys", "gpio", "user"};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t trace_get_le(const uint8_t *dumpData, uint32_t numBytes) {
+  uint32_t dumpVal = 0U;
+
+  for (uint32_t byteIdx = 0U; byteIdx < numBytes; byteIdx++) {
+    dumpVal |= (uint32_t)dumpData[byteIdx] << (8U * byteIdx);
+  }
+
+  return dumpVal;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Decodes a trace dump into one JSON object. The time of a record
+ *         is the sum of the deltas (and overflow payloads) up to it, from 0
+ *         at the first record kept, in microseconds. A callback end whose
+ *         start was overwritten in the ring is dropped, as it closes no
+ *         slice.
+ *
+ * @param[in]: decodeOut
+ * @param[in]: dumpData
+ * @param[in]: dumpLen
+ * @param[in]: elfFile
+ * @return[out]: uint32_t
+ **/
+uint32_t trace_decode(FILE *decodeOut, const uint8_t *dumpData,
+                      size_t dumpLen, const elf_file_t *elfFile) {
+  uint32_t cbDepth[TRACE_MAX_ARG] = {0U};
+  uint64_t traceTicks = 0U;
+  const char *evtSep = "";
+
+  if (dumpLen < TRACE_DUMP_HDR_SIZE ||
+      memcmp(dumpData, TRACE_DUMP_MAGIC, 3U) != 0 ||
+      dumpData[3U] != TRACE_DUMP_VERSION) {
+    return HOST_DECODE_ERR_FORMAT;
+  }
+
+  uint32_t traceShift = dumpData[4U];
+  uint32_t traceClock = trace_get_le(&dumpData[5U], 4U);
+  uint32_t numRecords = trace_get_le(&dumpData[9U], 4U);
+
+  if (traceShift >= 32U || traceClock == 0U ||
+      (dumpLen - TRACE_DUMP_HDR_SIZE) / TRACE_RECORD_SIZE != numRecords ||
+      (dumpLen - TRACE_DUMP_HDR_SIZE) % TRACE_RECORD_SIZE != 0U) {
+    return HOST_DECODE_ERR_FORMAT;
+  }
+
+  double tickUs = (double)(1U << traceShift) * 1e6 / (double)traceClock;
+
+  fprintf(decodeOut, "{\"traceEvents\":[\n");
+
+  for (uint32_t pidIdx = 1U; pidIdx < sizeof(tracePids) / sizeof(char *);
+       pidIdx++) {
+    fprintf(decodeOut,
+            "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+            "\"args\":{\"name\":\"%s\"}}",
+            evtSep, pidIdx, tracePids[pidIdx]);
+    evtSep = ",\n";
+  }
+
+  for (uint32_t recIdx = 0U; recIdx < numRecords; recIdx++) {
+    const uint8_t *traceRec =
+        &dumpData[TRACE_DUMP_HDR_SIZE + recIdx * TRACE_RECORD_SIZE];
+    uint32_t traceEvt = traceRec[2U];
+    uint32_t traceArg = traceRec[3U];
+    uint32_t tracePayload = trace_get_le(&traceRec[4U], 4U);
+
+    traceTicks += trace_get_le(traceRec, 2U);
+
+    // Only carries the time to the record after it
+    if (traceEvt == TRACE_EVT_DT_OVERFLOW) {
+      traceTicks += tracePayload;
+      continue;
+    }
+
+    double traceUs = (double)traceTicks * tickUs;
+
+    if (traceEvt == TRACE_EVT_TMR_CB_START) {
+      const elf_sym_t *elfSym = elf_find_sym(elfFile, tracePayload);
+
+      cbDepth[traceArg]++;
+      if (elfSym != NULL) {
+        fprintf(decodeOut,
+                "%s{\"name\":\"%s\",\"cat\":\"tmr\",\"ph\":\"B\","
+                "\"ts\":%.3f,\"pid\":%u,\"tid\":%u}",
+                evtSep, elfSym->symName, traceUs, TRACE_PID_TMR, traceArg);
+      } else {
+        fprintf(decodeOut,
+                "%s{\"name\":\"0x%08X\",\"cat\":\"tmr\",\"ph\":\"B\","
+                "\"ts\":%.3f,\"pid\":%u,\"tid\":%u}",
+                evtSep, tracePayload, traceUs, TRACE_PID_TMR, traceArg);
+      }
+    } else if (traceEvt == TRACE_EVT_TMR_CB_END) {
+      if (cbDepth[traceArg] == 0U) continue;
+
+      cbDepth[traceArg]--;
+      fprintf(decodeOut,
+              "%s{\"ph\":\"E\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u}", evtSep,
+              traceUs, TRACE_PID_TMR, traceArg);
+    } else if (traceEvt < TRACE_NUM_EVTS) {
+      const trace_evt_info_t *evtInfo = &traceEvts[traceEvt];
+
+      fprintf(decodeOut,
+              "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\","
+              "\"ts\":%.3f,\"pid\":%u,\"tid\":%u,"
+              "\"args\":{\"payload\":\"0x%08X\"}}",
+              evtSep, evtInfo->evtName, tracePids[evtInfo->evtPid], traceUs,
+              evtInfo->evtPid, traceArg, tracePayload);
+    } else {
+      // Application events by their offset from TRACE_EVT_USER, IDs no
+      // module uses by their number
+      fprintf(decodeOut,
+              "%s{\"name\":\"%s%u\",\"cat\":\"user\",\"ph\":\"i\","
+              "\"s\":\"t\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u,"
+              "\"args\":{\"payload\":\"0x%08X\"}}",
+              evtSep, (traceEvt >= TRACE_EVT_USER) ? "user_" : "evt_",
+              (traceEvt >= TRACE_EVT_USER) ? traceEvt - TRACE_EVT_USER
+                                           : traceEvt,
+              traceUs, TRACE_PID_USER, traceArg, tracePayload);
+    }
+    evtSep = ",\n";
+  }
+
+  fprintf(decodeOut,
+          "\n],\"otherData\":{\"clock_hz\":%u,\"tick_cycles\":%u,"
+          "\"records\":%u}}\n",
+          traceClock, 1U << traceShift, numRecords);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,548 @@
+/**
+ * @file bench.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Cycle-counting microbenchmarks for the module hot paths
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <bench.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function declarations
+////////////////////////////////////////////////////////////////////////////////
+static void bench_empty(void *benchCtx);
+static void bench_io_set_val(void *benchCtx);
+static void bench_io_get_val(void *benchCtx);
+static void bench_io_snapshot(void *benchCtx);
+static void bench_ttys_putc(void *benchCtx);
+static void bench_ttys_getc(void *benchCtx);
+static void bench_ttys_irq(void *benchCtx);
+static void bench_tmr_write(void *benchCtx);
+static void bench_tmr_irq(void *benchCtx);
+static void bench_trace_event(void *benchCtx);
+static uint32_t bench_ttys_run(uint32_t ttysInstIdx, uint32_t reqBaud,
+                               uint32_t benchBytes,
+                               bench_ttys_result_t *benchResult);
+
+// IRQ handlers of the tmr and ttys modules
+extern void TIM2_IRQHandler(void);
+extern void TIM3_IRQHandler(void);
+extern void TIM4_IRQHandler(void);
+extern void USART2_IRQHandler(void);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+
+// Cost of timing an empty call, removed from every sample
+static uint32_t benchOverhead;
+static bool benchIsInit;
+
+static uint32_t benchOutVal;
+
+static const uint32_t benchTtysBauds[] = {115200U, 460800U, 921600U, 2000000U,
+                                          4000000U};
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Starts the DWT cycle counter and measures the cost of timing an
+ *         empty call
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t bench_init(void) {
+  bench_result_t benchResult;
+  const bench_case_t benchCase = {"empty", bench_empty, NULL, BENCH_DEF_ITERS};
+
+  // Enabling the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  // Calibrating
+  benchOverhead = 0U;
+  benchIsInit = true;
+  (void)bench_run(&benchCase, &benchResult);
+  benchOverhead = benchResult.cyclesMin;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Times each call of a benchmark case
+ *
+ * @param[in]: benchCase
+ * @param[out]: benchResult
+ * @return[out]: uint32_t
+ **/
+uint32_t bench_run(const bench_case_t *benchCase, bench_result_t *benchResult) {
+  uint32_t iterIdx = 0U;
+
+  if (benchCase == NULL || benchCase->benchFunc == NULL ||
+      benchResult == NULL || benchCase->benchIters == 0U) {
+    return BENCH_ERR_CONFIG;
+  }
+  if (!benchIsInit) return BENCH_ERR_NOT_INIT;
+
+  benchResult->benchName = benchCase->benchName;
+  benchResult->benchIters = benchCase->benchIters;
+  benchResult->cyclesMin = UINT32_MAX;
+  benchResult->cyclesMax = 0U;
+  benchResult->cyclesTotal = 0U;
+
+  for (iterIdx = 0U; iterIdx < benchCase->benchIters; iterIdx++) {
+    uint32_t benchStart = bench_cycles();
+    benchCase->benchFunc(benchCase->benchCtx);
+    uint32_t benchCycles = bench_cycles() - benchStart;
+
+    // Removing the measurement overhead
+    benchCycles = (benchCycles > benchOverhead) ? benchCycles - benchOverhead
+                                                : 0U;
+
+    if (benchCycles < benchResult->cyclesMin) {
+      benchResult->cyclesMin = benchCycles;
+    }
+    if (benchCycles > benchResult->cyclesMax) {
+      benchResult->cyclesMax = benchCycles;
+    }
+    benchResult->cyclesTotal += benchCycles;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Writes the results as CSV, one line per case, so reports from two
+ *         firmware versions can be diffed. benchOut can be stdout (which goes
+ *         out over ttys through _write()) or a file. The unit is
+ *         BENCH_UNIT, ns on host builds.
+ *
+ *         # bench v1, cycles
+ *         name,iters,min,avg,max
+ *
+ * @param[in]: benchOut
+ * @param[in]: benchResults
+ * @param[in]: numResults
+ * @return[out]: uint32_t
+ **/
+uint32_t bench_report(FILE *benchOut, const bench_result_t *benchResults,
+                      uint32_t numResults) {
+  uint32_t resultIdx = 0U;
+
+  if (benchOut == NULL || benchResults == NULL) return BENCH_ERR_CONFIG;
+
+  fprintf(benchOut, "# bench v%u, %s\n\r", BENCH_REPORT_VERSION, BENCH_UNIT);
+  fprintf(benchOut, "name,iters,min,avg,max\n\r");
+
+  for (resultIdx = 0U; resultIdx < numResults; resultIdx++) {
+    const bench_result_t *benchResult = &benchResults[resultIdx];
+
+    fprintf(benchOut, "%s,%lu,%lu,%lu,%lu\n\r", benchResult->benchName,
+            (unsigned long)benchResult->benchIters,
+            (unsigned long)benchResult->cyclesMin,
+            (unsigned long)(benchResult->cyclesTotal / benchResult->benchIters),
+            (unsigned long)benchResult->cyclesMax);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Benchmarks the gpio, ttys and tmr hot paths and writes the report.
+ *         The instances in benchTargets must be initialised (and the tmr
+ *         instance opened) beforehand. ttys_putc() only queues into the TX
+ *         ring, which the TXE interrupt drains. Once the ring is full each
+ *         call waits for the ISR to free a slot, so min is the enqueue cost
+ *         while avg and max include character times at the configured baud.
+ *         trace_event() is timed while recording. A stopped trace ring is
+ *         restarted for the run and stopped again, it then holds the run's
+ *         records.
+ *
+ * @param[in]: benchTargets
+ * @param[in]: benchOut
+ * @return[out]: uint32_t
+ **/
+uint32_t bench_modules(const bench_targets_t *benchTargets, FILE *benchOut) {
+  bench_result_t benchResults[BENCH_MAX_RESULTS];
+  uint32_t numResults = 0U;
+  uint32_t caseIdx = 0U;
+
+  if (benchTargets == NULL) return BENCH_ERR_CONFIG;
+  if (!benchIsInit) return BENCH_ERR_NOT_INIT;
+
+  void *benchCtx = (void *)benchTargets;
+  const bench_case_t benchCases[] = {
+      {"io_set_val", bench_io_set_val, benchCtx, BENCH_DEF_ITERS},
+      {"io_get_val", bench_io_get_val, benchCtx, BENCH_DEF_ITERS},
+      {"io_snapshot", bench_io_snapshot, benchCtx, BENCH_DEF_ITERS},
+      {"ttys_putc", bench_ttys_putc, benchCtx, BENCH_DEF_ITERS / 10U},
+      {"ttys_getc", bench_ttys_getc, benchCtx, BENCH_DEF_ITERS},
+      {"USART2_IRQHandler", bench_ttys_irq, benchCtx, BENCH_DEF_ITERS},
+      {"tmr_write", bench_tmr_write, benchCtx, BENCH_DEF_ITERS},
+      {"TIMx_IRQHandler", bench_tmr_irq, benchCtx, BENCH_DEF_ITERS},
+      {"trace_event", bench_trace_event, benchCtx, BENCH_DEF_ITERS},
+  };
+
+  bool traceWasOn = traceRing.traceIsOn;
+  if (!traceWasOn) (void)trace_start();
+
+  for (caseIdx = 0U; caseIdx < sizeof(benchCases) / sizeof(benchCases[0U]) &&
+                     numResults < BENCH_MAX_RESULTS;
+       caseIdx++) {
+    if (bench_run(&benchCases[caseIdx], &benchResults[numResults]) ==
+        EXIT_SUCCESS) {
+      numResults++;
+    }
+  }
+
+  if (!traceWasOn) (void)trace_stop();
+
+  return bench_report(benchOut, benchResults, numResults);
+}
+
+/**
+ * @brief: Measures sustained ttys throughput at each baud rate. The instance
+ *         is set to single-wire half-duplex, so the USART receives every
+ *         byte it sends without a cable. The main loop keeps the TX ring
+ *         topped up with ttys_putc() while reading back with ttys_getc(),
+ *         and WFIs when there is nothing to do, so TX ISR, RX ISR and the
+ *         reader run concurrently with whatever tmr instances are open.
+ *         Results are written as a table and as JSON.
+ *
+ *         The instance must be open (ttys_def_init()), and its TX pin
+ *         in its alternate function mode
+ *         (open-drain with a pull-up, or push-pull with nothing attached).
+ *         A periodic interrupt (a tmr instance or SysTick) must be running
+ *         for the timeout to be seen if the loopback is broken. The instance
+ *         is left in half-duplex at the last rate, ttys_init() it again.
+ *
+ * @param[in]: benchConfig
+ * @param[out]: benchResults. BENCH_TTYS_MAX_BAUDS entries
+ * @param[in]: benchOut. Can be NULL to skip the report
+ * @return[out]: uint32_t
+ **/
+uint32_t bench_ttys(const bench_ttys_config_t *benchConfig,
+                    bench_ttys_result_t *benchResults, FILE *benchOut) {
+  uint32_t baudIdx = 0U;
+
+  if (benchConfig == NULL || benchResults == NULL ||
+      benchConfig->ttysInstIdx >= TTYS_NUM_INSTANCES) {
+    return BENCH_ERR_CONFIG;
+  }
+  if (!benchIsInit) return BENCH_ERR_NOT_INIT;
+
+  const uint32_t *benchBauds = benchConfig->benchBauds;
+  uint32_t numBauds = benchConfig->numBauds;
+  uint32_t benchBytes = (benchConfig->benchBytes != 0U)
+                            ? benchConfig->benchBytes
+                            : BENCH_TTYS_BYTES;
+
+  if (benchBauds == NULL) {
+    benchBauds = benchTtysBauds;
+    numBauds = sizeof(benchTtysBauds) / sizeof(benchTtysBauds[0U]);
+  }
+  if (numBauds == 0U || numBauds > BENCH_TTYS_MAX_BAUDS) {
+    return BENCH_ERR_CONFIG;
+  }
+
+  for (baudIdx = 0U; baudIdx < numBauds; baudIdx++) {
+    (void)bench_ttys_run(benchConfig->ttysInstIdx, benchBauds[baudIdx],
+                         benchBytes, &benchResults[baudIdx]);
+  }
+
+  if (benchOut == NULL) return EXIT_SUCCESS;
+
+  return bench_ttys_report(benchOut, benchResults, numBauds);
+}
+
+/**
+ * @brief: Writes ttys throughput results as a table, then as one JSON
+ *         object for scripts:
+ *
+ *         {"bench":"ttys","version":1,"results":[{"baud":115200,...},...]}
+ *
+ * @param[in]: benchOut
+ * @param[in]: benchResults
+ * @param[in]: numResults
+ * @return[out]: uint32_t
+ **/
+uint32_t bench_ttys_report(FILE *benchOut,
+                           const bench_ttys_result_t *benchResults,
+                           uint32_t numResults) {
+  uint32_t resultIdx = 0U;
+
+  if (benchOut == NULL || benchResults == NULL) return BENCH_ERR_CONFIG;
+
+  fprintf(benchOut, "# bench ttys v%u\n\r", BENCH_TTYS_REPORT_VERSION);
+  fprintf(benchOut,
+          "%8s %8s %8s %7s %8s %5s %6s %7s %7s %5s %5s %5s %5s\n\r", "baud",
+          "actual", "bytes/s", "cyc/B", "lat avg", "max", "sent", "recv",
+          "drops", "errs", "rxhw", "txhw", "err");
+
+  for (resultIdx = 0U; resultIdx < numResults; resultIdx++) {
+    const bench_ttys_result_t *benchResult = &benchResults[resultIdx];
+
+    fprintf(benchOut,
+            "%8lu %8lu %8lu %7lu %8lu %5lu %6lu %7lu %7lu %5lu %5lu %5lu "
+            "%5lx\n\r",
+            (unsigned long)benchResult->reqBaud,
+            (unsigned long)benchResult->actualBaud,
+            (unsigned long)benchResult->bytesPerSec,
+            (unsigned long)benchResult->cyclesPerByte,
+            (unsigned long)benchResult->latAvgUs,
+            (unsigned long)benchResult->latMaxUs,
+            (unsigned long)benchResult->bytesSent,
+            (unsigned long)benchResult->bytesRecv,
+            (unsigned long)benchResult->rxDrops,
+            (unsigned long)benchResult->lineErrs,
+            (unsigned long)benchResult->rxHighWater,
+            (unsigned long)benchResult->txHighWater,
+            (unsigned long)benchResult->benchErr);
+  }
+
+  fprintf(benchOut, "{\"bench\":\"ttys\",\"version\":%u,\"results\":[",
+          BENCH_TTYS_REPORT_VERSION);
+
+  for (resultIdx = 0U; resultIdx < numResults; resultIdx++) {
+    const bench_ttys_result_t *benchResult = &benchResults[resultIdx];
+
+    fprintf(benchOut,
+            "%s{\"baud\":%lu,\"actual_baud\":%lu,\"error\":%lu,"
+            "\"bytes_per_sec\":%lu,\"cycles_per_byte\":%lu,"
+            "\"latency_avg_us\":%lu,\"latency_max_us\":%lu,"
+            "\"sent\":%lu,\"received\":%lu,\"rx_drops\":%lu,"
+            "\"line_errors\":%lu,\"rx_high_water\":%lu,"
+            "\"tx_high_water\":%lu}",
+            (resultIdx == 0U) ? "" : ",",
+            (unsigned long)benchResult->reqBaud,
+            (unsigned long)benchResult->actualBaud,
+            (unsigned long)benchResult->benchErr,
+            (unsigned long)benchResult->bytesPerSec,
+            (unsigned long)benchResult->cyclesPerByte,
+            (unsigned long)benchResult->latAvgUs,
+            (unsigned long)benchResult->latMaxUs,
+            (unsigned long)benchResult->bytesSent,
+            (unsigned long)benchResult->bytesRecv,
+            (unsigned long)benchResult->rxDrops,
+            (unsigned long)benchResult->lineErrs,
+            (unsigned long)benchResult->rxHighWater,
+            (unsigned long)benchResult->txHighWater);
+  }
+
+  fprintf(benchOut, "]}\n\r");
+
+  return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Benchmark cases, benchCtx is the bench_targets_t */
+static void bench_empty(void *benchCtx) { (void)benchCtx; }
+
+static void bench_io_set_val(void *benchCtx) {
+  const bench_targets_t *benchTargets = benchCtx;
+
+  benchOutVal ^= 1U;
+  (void)io_set_val(benchTargets->ioOutIdx, benchOutVal);
+}
+
+static void bench_io_get_val(void *benchCtx) {
+  const bench_targets_t *benchTargets = benchCtx;
+
+  (void)io_get_val(benchTargets->ioInIdx);
+}
+
+static void bench_io_snapshot(void *benchCtx) {
+  (void)benchCtx;
+  (void)io_snapshot();
+}
+
+static void bench_ttys_putc(void *benchCtx) {
+  const bench_targets_t *benchTargets = benchCtx;
+
+  (void)ttys_putc(benchTargets->ttysInstIdx, 'U');
+}
+
+static void bench_ttys_getc(void *benchCtx) {
+  const bench_targets_t *benchTargets = benchCtx;
+
+  (void)ttys_getc(benchTargets->ttysInstIdx);
+}
+
+static void bench_ttys_irq(void *benchCtx) {
+  (void)benchCtx;
+  USART2_IRQHandler();
+}
+
+static void bench_tmr_write(void *benchCtx) {
+  const bench_targets_t *benchTargets = benchCtx;
+
+  (void)tmr_write(benchTargets->tmrIdx, benchTargets->tmrTime);
+}
+
+static void bench_tmr_irq(void *benchCtx) {
+  const bench_targets_t *benchTargets = benchCtx;
+
+  switch (benchTargets->tmrIdx) {
+    case TMR_INSTANCE2:
+      TIM2_IRQHandler();
+      break;
+
+    case TMR_INSTANCE3:
+      TIM3_IRQHandler();
+      break;
+
+    case TMR_INSTANCE4:
+      TIM4_IRQHandler();
+      break;
+  }
+}
+
+static void bench_trace_event(void *benchCtx) {
+  (void)benchCtx;
+  trace_event(TRACE_EVT_USER, 0U, 0U);
+}
+
+/**
+ * @brief: Loops benchBytes bytes through a half-duplex instance at one baud
+ *         rate. Bytes are numbered 1 to 255 so that none reads as the 0
+ *         that ttys_getc() returns for an empty ring. The run ends when
+ *         every byte came back or was counted lost by ttys, or after twice
+ *         the wire time plus 10 ms. The rate is taken at the last byte
+ *         received, so the wait for lost bytes does not lower it.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: reqBaud
+ * @param[in]: benchBytes
+ * @param[out]: benchResult
+ * @return[out]: uint32_t
+ **/
+static uint32_t bench_ttys_run(uint32_t ttysInstIdx, uint32_t reqBaud,
+                               uint32_t benchBytes,
+                               bench_ttys_result_t *benchResult) {
+  ttys_config_t ttysConfig;
+  ttys_baud_t ttysBaud;
+  ttys_stats_t ttysStats;
+  uint64_t latTotal = 0U;
+  uint32_t idleCycles = 0U;
+  uint32_t numSent = 0U;
+  uint32_t numRecv = 0U;
+  uint32_t recvElapsed = 0U;
+  uint32_t recvIdx = 0U;
+
+  (void)memset(benchResult, 0U, sizeof(bench_ttys_result_t));
+  benchResult->reqBaud = reqBaud;
+
+  (void)memset(&ttysConfig, 0U, sizeof(ttysConfig));
+  ttysConfig.ttysBaud = reqBaud;
+  ttysConfig.ttysParity = LL_USART_PARITY_NONE;
+  ttysConfig.ttysStopBits = LL_USART_STOPBITS_1;
+  ttysConfig.ttysOverSampling = TTYS_OVERSAMPLING_AUTO;
+  ttysConfig.ttysFlowCtrl = TTYS_FLOW_NONE;
+  ttysConfig.isHalfDuplex = true;
+
+  benchResult->benchErr = ttys_init(ttysInstIdx, &ttysConfig);
+  if (benchResult->benchErr != EXIT_SUCCESS) return benchResult->benchErr;
+
+  (void)ttys_start(ttysInstIdx);
+  (void)ttys_get_baud(ttysInstIdx, &ttysBaud);
+  benchResult->actualBaud = ttysBaud.ttysActualBaud;
+
+  uint32_t charCycles = (uint32_t)(((uint64_t)SystemCoreClock *
+                                    BENCH_TTYS_BITS_PER_CHAR) /
+                                   ttysBaud.ttysActualBaud);
+  uint64_t maxCycles =
+      (uint64_t)charCycles * benchBytes * 2U + (SystemCoreClock / 100U);
+  uint32_t benchStart = bench_core_cycles();
+  uint32_t benchElapsed = 0U;
+
+  while (numRecv < benchBytes) {
+    // Keeping the TX ring topped up, without waiting in ttys_putc()
+    while (numSent < benchBytes && ttys_tx_free(ttysInstIdx) != 0U) {
+      (void)ttys_putc(ttysInstIdx, (char)((numSent % 255U) + 1U));
+      numSent++;
+    }
+
+    // Checked with interrupts disabled, so a byte arriving in between ends
+    // the WFI instead of being slept through
+    __disable_irq();
+
+    char ttysData = ttys_getc(ttysInstIdx);
+    uint32_t benchNow = bench_core_cycles();
+    benchElapsed = benchNow - benchStart;
+
+    if (ttysData == 0) {
+      (void)ttys_get_stats(ttysInstIdx, &ttysStats);
+
+      uint32_t numLost = ttysStats.rxDrops + ttysStats.oreErrs +
+                         ttysStats.feErrs + ttysStats.neErrs;
+
+      if (benchElapsed > maxCycles ||
+          (numSent == benchBytes && numRecv + numLost >= benchBytes)) {
+        __enable_irq();
+        break;
+      }
+      if (numSent == benchBytes || ttys_tx_free(ttysInstIdx) == 0U) {
+        __DSB();
+        __WFI();
+        idleCycles += bench_core_cycles() - benchNow;
+      }
+      __enable_irq();
+      continue;
+    }
+
+    __enable_irq();
+
+    // The byte's number skips the bytes lost before it, so a loss does not
+    // push the ideal arrival of every later byte back
+    recvIdx += ((uint8_t)ttysData + 254U - (recvIdx % 255U)) % 255U;
+
+    // Latency past the arrival of the byte at full line rate
+    uint32_t benchIdeal = (recvIdx + 1U) * charCycles;
+    if (benchElapsed > benchIdeal) {
+      uint32_t benchLat = benchElapsed - benchIdeal;
+
+      latTotal += benchLat;
+      if (benchLat > benchResult->latMaxUs) benchResult->latMaxUs = benchLat;
+    }
+    numRecv++;
+    recvIdx++;
+    recvElapsed = benchElapsed;
+  }
+
+  benchElapsed = bench_core_cycles() - benchStart;
+
+  // Converting cycles to the reported units
+  uint32_t cyclesPerUs = SystemCoreClock / 1000000U;
+
+  benchResult->bytesSent = numSent;
+  benchResult->bytesRecv = numRecv;
+  benchResult->latMaxUs /= cyclesPerUs;
+  if (numRecv != 0U) {
+    benchResult->latAvgUs = (uint32_t)(latTotal / numRecv / cyclesPerUs);
+    benchResult->cyclesPerByte = (benchElapsed - idleCycles) / numRecv;
+  }
+  if (recvElapsed != 0U) {
+    benchResult->bytesPerSec =
+        (uint32_t)(((uint64_t)numRecv * SystemCoreClock) / recvElapsed);
+  }
+
+  (void)ttys_get_stats(ttysInstIdx, &ttysStats);
+  benchResult->rxDrops = ttysStats.rxDrops + ttysStats.oreErrs;
+  benchResult->lineErrs = ttysStats.feErrs + ttysStats.neErrs;
+  benchResult->rxHighWater = ttysStats.rxHighWater;
+  benchResult->txHighWater = ttysStats.txHighWater;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file bench.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Cycle-counting microbenchmarks for the module hot paths
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(__arm__)
+#include <time.h>
+#endif
+
+/* MCU includes */
+#include <stm32f4xx_ll_cortex.h>
+
+/* Module includes */
+#include <gpio.h>
+#include <tmr.h>
+#include <trace.h>
+#include <ttys.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+#ifndef BENCH_DEF_ITERS
+#define BENCH_DEF_ITERS 1000U
+#endif
+
+// Maximum number of results kept by bench_modules()
+#define BENCH_MAX_RESULTS 16U
+
+// Report format version, bumped whenever the columns change
+#define BENCH_REPORT_VERSION 1U
+
+// What bench_cycles() counts, named in the report
+#if defined(__arm__)
+#define BENCH_UNIT "cycles"
+#else
+#define BENCH_UNIT "ns"
+#endif
+
+// ttys throughput: bytes looped back per baud rate, and most rates per run
+#ifndef BENCH_TTYS_BYTES
+#define BENCH_TTYS_BYTES 4096U
+#endif
+#define BENCH_TTYS_MAX_BAUDS 8U
+
+// 8N1, start + 8 data + stop bits
+#define BENCH_TTYS_BITS_PER_CHAR 10U
+
+// ttys report format version, bumped whenever the fields change
+#define BENCH_TTYS_REPORT_VERSION 1U
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+typedef void (*bench_func_t)(void *benchCtx);
+
+/* Error Codes */
+typedef enum {
+
+  BENCH_ERR_CONFIG = 0x90U,
+  BENCH_ERR_NOT_INIT,
+
+} bench_errors_t;
+
+/* A benchmark case: benchFunc(benchCtx) is timed benchIters times */
+typedef struct {
+  const char *benchName;
+  bench_func_t benchFunc;
+  void *benchCtx;
+  uint32_t benchIters;
+
+} bench_case_t;
+
+/* Per-call cost in CPU cycles, with the measurement overhead removed */
+typedef struct {
+  const char *benchName;
+  uint32_t benchIters;
+  uint32_t cyclesMin;
+  uint32_t cyclesMax;
+  uint64_t cyclesTotal;
+
+} bench_result_t;
+
+/* Instances and indexes used by bench_modules() */
+typedef struct {
+  uint32_t ioInIdx;
+  uint32_t ioOutIdx;
+  uint32_t ttysInstIdx;
+  uint32_t tmrIdx;  // Must be open, its callback runs in the IRQ case
+  uint32_t tmrTime;
+
+} bench_targets_t;
+
+/* ttys throughput run */
+typedef struct {
+  uint32_t ttysInstIdx;  // Not the stdout instance, it is reconfigured
+  const uint32_t *benchBauds;  // NULL: 115200 to 4000000
+  uint32_t numBauds;
+  uint32_t benchBytes;  // Bytes per rate, 0: BENCH_TTYS_BYTES
+
+} bench_ttys_config_t;
+
+/* ttys throughput at one baud rate */
+typedef struct {
+  uint32_t reqBaud;
+  uint32_t actualBaud;
+  uint32_t benchErr;  // ttys_init() result, the fields below are 0 if set
+  uint32_t bytesSent;
+  uint32_t bytesRecv;
+  uint32_t rxDrops;   // Ring full drops and USART overruns
+  uint32_t lineErrs;  // Framing and noise errors
+  uint32_t bytesPerSec;
+  uint32_t cyclesPerByte;  // CPU cycles not spent in WFI, per byte looped
+  uint32_t latAvgUs;  // Reception by the reader after the byte's ideal
+  uint32_t latMaxUs;  // arrival at full line rate
+  uint32_t rxHighWater;
+  uint32_t txHighWater;
+
+} bench_ttys_result_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Core API */
+uint32_t bench_init(void);
+uint32_t bench_run(const bench_case_t *benchCase, bench_result_t *benchResult);
+uint32_t bench_report(FILE *benchOut, const bench_result_t *benchResults,
+                      uint32_t numResults);
+
+/* Module hot paths */
+uint32_t bench_modules(const bench_targets_t *benchTargets, FILE *benchOut);
+
+/* ttys throughput */
+uint32_t bench_ttys(const bench_ttys_config_t *benchConfig,
+                    bench_ttys_result_t *benchResults, FILE *benchOut);
+uint32_t bench_ttys_report(FILE *benchOut,
+                           const bench_ttys_result_t *benchResults,
+                           uint32_t numResults);
+
+/**
+ * @brief: Reads the clock bench_run() times calls with. On target this is
+ *         the DWT cycle counter. Other builds (host/sim) read CLOCK_MONOTONIC
+ *         in nanoseconds instead, the simulated counter only follows virtual
+ *         time and would time most calls as 0.
+ *
+ * @return[out]: uint32_t
+ **/
+#if defined(__arm__)
+__STATIC_INLINE uint32_t bench_cycles(void) { return DWT->CYCCNT; }
+#else
+__STATIC_INLINE uint32_t bench_cycles(void) {
+  struct timespec benchTs;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &benchTs);
+  return (uint32_t)((uint64_t)benchTs.tv_sec * 1000000000U +
+                    (uint64_t)benchTs.tv_nsec);
+}
+#endif
+
+/**
+ * @brief: Reads the DWT cycle counter, core clock cycles on every build
+ *         (virtual time on host/sim). bench_ttys() runs on it, as its rates
+ *         and latencies are converted with SystemCoreClock.
+ *
+ * @return[out]: uint32_t
+ **/
+__STATIC_INLINE uint32_t bench_core_cycles(void) { return DWT->CYCCNT; }
+
+#endif  // bench.h
@@ -0,0 +1,404 @@
+/**
+ * @file cap.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Logic-analyzer style capture of GPIO inputs
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <cap.h>
+#include <prof.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function declarations
+////////////////////////////////////////////////////////////////////////////////
+static void cap_compress(const uint16_t *samples, uint32_t numSamples);
+static bool cap_emit(void);
+static void cap_flag_halves(void);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+static const cap_config_t *capConfig;
+static io_port *capPort;
+
+// Pins of interest and the pins that are inverted, as IDR bit masks
+static uint16_t capMask;
+static uint16_t capInvMask;
+
+// DMA ring, filled by hardware
+static uint16_t capRawBuf[CAP_RAW_BUF_SIZE];
+
+// Bit 0: first half ready, bit 1: second half ready (set in the DMA IRQ)
+static __vo uint32_t capHalfReady;
+static __vo uint32_t capRawOverruns;
+static uint32_t capNextHalf;
+
+// Compressed capture
+static cap_rle_t capRle[CAP_RLE_BUF_SIZE];
+static cap_rle_t capCur;
+static uint32_t capNumRecords;
+static uint32_t capNumSamples;
+static bool capHasCur;
+static bool capIsRunning;
+static bool capIsFull;
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Configures TIM1 and the DMA stream for sampling the port holding the
+ *         capture inputs. All the inputs must be on the same port.
+ *
+ * @param[in]: config. The capture configuration
+ * @return[out]: uint32_t
+ **/
+uint32_t cap_init(const cap_config_t *config) {
+  uint32_t capIdx = 0U;
+
+  if (config == NULL || config->capInputs == NULL ||
+      config->numCapInputs == 0U) {
+    return CAP_ERR_CONFIG;
+  }
+
+  if (capIsRunning) return CAP_ERR_RUNNING;
+
+  // Sample rates above CAP_TMR_CLK_HZ / 16 would starve the DMA controller
+  if (config->capSampleRate == 0U ||
+      config->capSampleRate > (CAP_TMR_CLK_HZ / 16U)) {
+    return CAP_ERR_RATE;
+  }
+
+  // Building the pin masks, all the inputs have to share one IDR
+  capPort = config->capInputs[0U].portx;
+  capMask = 0U;
+  capInvMask = 0U;
+
+  for (capIdx = 0U; capIdx < config->numCapInputs; capIdx++) {
+    const io_in_handler_t *capIn = &config->capInputs[capIdx];
+
+    if (capIn->portx != capPort) return CAP_ERR_PORT;
+
+    capMask |= (uint16_t)capIn->ioPinNo;
+    if (capIn->ioInInvert == ENABLE) capInvMask |= (uint16_t)capIn->ioPinNo;
+  }
+
+  capConfig = config;
+
+  // Splitting the period into a 16 bit prescaler and autoreload
+  uint32_t tmrTicks = CAP_TMR_CLK_HZ / config->capSampleRate;
+  uint32_t tmrPsc = (tmrTicks - 1U) / 65536U;
+  uint32_t tmrArr = (tmrTicks / (tmrPsc + 1U)) - 1U;
+
+  // Enabling the TIM1 and DMA2 clocks
+  LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM1);
+  LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+  // Setting up the sampling timer. The update event loads the prescaler
+  // before the DMA request is enabled, so no sample is taken here.
+  LL_TIM_DisableCounter(CAP_TMR);
+  LL_TIM_SetPrescaler(CAP_TMR, tmrPsc);
+  LL_TIM_SetAutoReload(CAP_TMR, tmrArr);
+  LL_TIM_GenerateEvent_UPDATE(CAP_TMR);
+  LL_TIM_ClearFlag_UPDATE(CAP_TMR);
+
+  // Setting up the DMA stream: IDR -> capRawBuf, half-words, circular
+  LL_DMA_DisableStream(CAP_DMA, CAP_DMA_STREAM);
+  LL_DMA_SetChannelSelection(CAP_DMA, CAP_DMA_STREAM, CAP_DMA_CHANNEL);
+  LL_DMA_ConfigTransfer(
+      CAP_DMA, CAP_DMA_STREAM,
+      LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_MODE_CIRCULAR |
+          LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+          LL_DMA_PDATAALIGN_HALFWORD | LL_DMA_MDATAALIGN_HALFWORD |
+          LL_DMA_PRIORITY_VERYHIGH);
+  LL_DMA_ConfigAddresses(CAP_DMA, CAP_DMA_STREAM,
+                         (uint32_t)(uintptr_t)&capPort->IDR,
+                         (uint32_t)(uintptr_t)capRawBuf,
+                         LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+  LL_DMA_SetDataLength(CAP_DMA, CAP_DMA_STREAM, CAP_RAW_BUF_SIZE);
+  LL_DMA_EnableIT_HT(CAP_DMA, CAP_DMA_STREAM);
+  LL_DMA_EnableIT_TC(CAP_DMA, CAP_DMA_STREAM);
+
+  NVIC_SetPriority(DMA2_Stream5_IRQn,
+                   NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0U, 0U));
+  NVIC_EnableIRQ(DMA2_Stream5_IRQn);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Starts a new capture, dropping any previously captured records
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t cap_start(void) {
+  if (capConfig == NULL) return CAP_ERR_CONFIG;
+  if (capIsRunning) return CAP_ERR_RUNNING;
+
+  // Resetting the capture state
+  capHalfReady = 0U;
+  capRawOverruns = 0U;
+  capNextHalf = 0U;
+  capNumRecords = 0U;
+  capNumSamples = 0U;
+  capHasCur = false;
+  capIsFull = false;
+
+  // cap_stop() leaves the stream's interrupts off and its flags clear
+  LL_DMA_ClearFlag_HT5(CAP_DMA);
+  LL_DMA_ClearFlag_TC5(CAP_DMA);
+  LL_DMA_EnableIT_HT(CAP_DMA, CAP_DMA_STREAM);
+  LL_DMA_EnableIT_TC(CAP_DMA, CAP_DMA_STREAM);
+
+  LL_DMA_SetDataLength(CAP_DMA, CAP_DMA_STREAM, CAP_RAW_BUF_SIZE);
+  LL_DMA_EnableStream(CAP_DMA, CAP_DMA_STREAM);
+
+  LL_TIM_SetCounter(CAP_TMR, 0U);
+  LL_TIM_EnableDMAReq_UPDATE(CAP_TMR);
+
+  capIsRunning = true;
+  LL_TIM_EnableCounter(CAP_TMR);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Stops the capture and compresses the samples still in the DMA ring
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t cap_stop(void) {
+  if (!capIsRunning) return CAP_ERR_NOT_RUNNING;
+
+  // Stopping the trigger first so the DMA write position is stable. The
+  // stream's interrupts go off before the stream does, a half completed on
+  // the way is picked up from the flags below instead of from an IRQ that
+  // could run after the partial half has been compressed.
+  LL_TIM_DisableCounter(CAP_TMR);
+  LL_TIM_DisableDMAReq_UPDATE(CAP_TMR);
+  LL_DMA_DisableIT_HT(CAP_DMA, CAP_DMA_STREAM);
+  LL_DMA_DisableIT_TC(CAP_DMA, CAP_DMA_STREAM);
+  LL_DMA_DisableStream(CAP_DMA, CAP_DMA_STREAM);
+  while (LL_DMA_IsEnabledStream(CAP_DMA, CAP_DMA_STREAM)) {
+  }
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  cap_flag_halves();
+  NVIC_ClearPendingIRQ(DMA2_Stream5_IRQn);
+  __set_PRIMASK(primask);
+
+  // Only the samples written so far, in circular mode NDTR reloads to the
+  // full size once the ring wraps
+  uint32_t rawPos =
+      CAP_RAW_BUF_SIZE - LL_DMA_GetDataLength(CAP_DMA, CAP_DMA_STREAM);
+
+  // Completed halves first, then the partial half the DMA was filling
+  (void)cap_process();
+
+  if (!capIsFull) {
+    uint32_t halfStart = capNextHalf * CAP_RAW_HALF_SIZE;
+
+    if (rawPos > halfStart && rawPos < halfStart + CAP_RAW_HALF_SIZE) {
+      cap_compress(&capRawBuf[halfStart], rawPos - halfStart);
+    }
+  }
+
+  // Storing the run in progress
+  if (capHasCur && !capIsFull && !cap_emit()) {
+    capNumSamples -= capCur.capRun;
+  }
+  capHasCur = false;
+  capIsRunning = false;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Run-length compresses the halves of the DMA ring that are ready.
+ *         This is meant to be called from the main loop while capturing.
+ *
+ * @return[out]: uint32_t. The number of halves processed
+ **/
+uint32_t cap_process(void) {
+  uint32_t numHalves = 0U;
+
+  while (!capIsFull && (capHalfReady & (1U << capNextHalf))) {
+    cap_compress(&capRawBuf[capNextHalf * CAP_RAW_HALF_SIZE],
+                 CAP_RAW_HALF_SIZE);
+
+    // Releasing the half back to the ISR
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    capHalfReady &= ~(1U << capNextHalf);
+    __set_PRIMASK(primask);
+
+    capNextHalf ^= 1U;
+    numHalves++;
+  }
+
+  // The record buffer is full, there is no point sampling any further
+  if (capIsFull && capIsRunning) {
+    LL_TIM_DisableCounter(CAP_TMR);
+    LL_TIM_DisableDMAReq_UPDATE(CAP_TMR);
+    LL_DMA_DisableStream(CAP_DMA, CAP_DMA_STREAM);
+    capIsRunning = false;
+  }
+
+  return numHalves;
+}
+
+/**
+ * @brief: Returns the current capture status
+ *
+ * @param[out]: capStatus
+ * @return[out]: uint32_t
+ **/
+uint32_t cap_get_status(cap_status_t *capStatus) {
+  if (capStatus == NULL) return CAP_ERR_CONFIG;
+
+  capStatus->numRecords = capNumRecords;
+  capStatus->numSamples = capNumSamples;
+  capStatus->rawOverruns = capRawOverruns;
+  capStatus->isRunning = capIsRunning;
+  capStatus->isFull = capIsFull;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Streams the compressed capture over a ttys instance. All values are
+ *         little-endian:
+ *
+ *         "CAP" | version u8 | sample rate u32 | pin mask u16 |
+ *         record count u32 | records...
+ *
+ *         Each record is the masked port value (u16) followed by its run
+ *         length as an unsigned LEB128 varint.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: uint32_t
+ **/
+uint32_t cap_dump(uint32_t ttysInstIdx) {
+  uint32_t capIdx = 0U;
+
+  if (capConfig == NULL) return CAP_ERR_CONFIG;
+  if (capIsRunning) return CAP_ERR_RUNNING;
+
+  const uint8_t capVersion = CAP_DUMP_VERSION;
+
+  // Header
+  (void)ttys_write(ttysInstIdx, CAP_DUMP_MAGIC, 3U);
+  (void)ttys_write(ttysInstIdx, &capVersion, 1U);
+  (void)ttys_write(ttysInstIdx, &capConfig->capSampleRate, 4U);
+  (void)ttys_write(ttysInstIdx, &capMask, 2U);
+  (void)ttys_write(ttysInstIdx, &capNumRecords, 4U);
+
+  // Records
+  for (capIdx = 0U; capIdx < capNumRecords; capIdx++) {
+    (void)ttys_write(ttysInstIdx, &capRle[capIdx].capVal, 2U);
+    (void)ttys_write_varint(ttysInstIdx, capRle[capIdx].capRun);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Folds raw IDR samples into the run-length records
+ *
+ * @param[in]: samples
+ * @param[in]: numSamples
+ * @return[out]: void
+ **/
+static void cap_compress(const uint16_t *samples, uint32_t numSamples) {
+  uint32_t sampleIdx = 0U;
+
+  for (sampleIdx = 0U; sampleIdx < numSamples; sampleIdx++) {
+    uint16_t capVal = (samples[sampleIdx] ^ capInvMask) & capMask;
+
+    // Extending the current run
+    if (capHasCur && capVal == capCur.capVal &&
+        capCur.capRun < CAP_RLE_RUN_MAX) {
+      capCur.capRun++;
+      continue;
+    }
+
+    // Closing the current run and starting a new one
+    if (capHasCur && !cap_emit()) {
+      // The run in progress is dropped, so its samples are not counted
+      capNumSamples += sampleIdx - capCur.capRun;
+      capHasCur = false;
+      return;
+    }
+
+    capCur.capVal = capVal;
+    capCur.capRun = 1U;
+    capHasCur = true;
+  }
+
+  capNumSamples += numSamples;
+}
+
+/**
+ * @brief: Stores the run in progress
+ *
+ * @return[out]: bool. false once the record buffer is full
+ **/
+static bool cap_emit(void) {
+  if (capNumRecords >= CAP_RLE_BUF_SIZE) {
+    capIsFull = true;
+    return false;
+  }
+
+  capRle[capNumRecords++] = capCur;
+  return true;
+}
+
+/**
+ * @brief: Flags the halves of the ring the DMA has filled and clears their
+ *         DMA flags. Called from the IRQ, and by cap_stop() with the IRQ off.
+ *
+ * @return[out]: void
+ **/
+static void cap_flag_halves(void) {
+  uint32_t capHalf = 0U;
+
+  if (LL_DMA_IsActiveFlag_HT5(CAP_DMA)) {
+    LL_DMA_ClearFlag_HT5(CAP_DMA);
+    capHalf |= 1U << 0U;
+  }
+
+  if (LL_DMA_IsActiveFlag_TC5(CAP_DMA)) {
+    LL_DMA_ClearFlag_TC5(CAP_DMA);
+    capHalf |= 1U << 1U;
+  }
+
+  // A half that is still pending has been overwritten
+  if (capHalfReady & capHalf) {
+    capRawOverruns++;
+  }
+  capHalfReady |= capHalf;
+}
+
+/**
+ * @brief: DMA2 Stream5 IRQHandler. Flags the half of the ring that was just
+ *         filled.
+ */
+void DMA2_Stream5_IRQHandler(void) {
+  PROF_ISR_ENTER();
+
+  cap_flag_halves();
+
+  PROF_ISR_EXIT(PROF_VEC_CAP_DMA);
+}
@@ -0,0 +1,123 @@
+/**
+ * @file cap.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Logic-analyzer style capture of GPIO inputs
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef CAP_H
+#define CAP_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* MCU includes */
+#include <stm32f4xx_ll_bus.h>
+#include <stm32f4xx_ll_dma.h>
+#include <stm32f4xx_ll_tim.h>
+
+/* Module includes */
+#include <gpio.h>
+#include <ttys.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+//
+// The sampling trigger is the TIM1 update event and the transfer is done by
+// DMA2 Stream5 Channel6 (TIM1_UP). DMA1 has no access to the AHB1 GPIO ports
+// on the STM32F401, so TIM2-4 (which only request DMA1) cannot be used here.
+//
+#define CAP_TMR (TIM1)
+#define CAP_DMA (DMA2)
+#define CAP_DMA_STREAM (LL_DMA_STREAM_5)
+#define CAP_DMA_CHANNEL (LL_DMA_CHANNEL_6)
+
+// TIM1 kernel clock (APB2 timer clock)
+#ifndef CAP_TMR_CLK_HZ
+#define CAP_TMR_CLK_HZ 84000000U
+#endif
+
+// Raw DMA ring, processed one half at a time
+#ifndef CAP_RAW_BUF_SIZE
+#define CAP_RAW_BUF_SIZE 512U
+#endif
+#define CAP_RAW_HALF_SIZE (CAP_RAW_BUF_SIZE / 2U)
+
+// Number of run-length records kept for the dump
+#ifndef CAP_RLE_BUF_SIZE
+#define CAP_RLE_BUF_SIZE 1024U
+#endif
+
+#define CAP_RLE_RUN_MAX 0xFFFFU
+
+// Dump header
+#define CAP_DUMP_MAGIC "CAP"
+#define CAP_DUMP_VERSION 1U
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Error Codes */
+typedef enum {
+
+  CAP_ERR_CONFIG = 150U,
+  CAP_ERR_PORT,
+  CAP_ERR_RATE,
+  CAP_ERR_RUNNING,
+  CAP_ERR_NOT_RUNNING,
+
+} cap_errors_t;
+
+/* Capture configuration */
+typedef struct {
+  const io_in_handler_t *capInputs;  // Pins to sample, all on the same port
+  uint32_t numCapInputs;
+  uint32_t capSampleRate;  // Sampling rate in Hz
+
+} cap_config_t;
+
+/* Run-length record: a masked port value and how many samples it held for */
+typedef struct {
+  uint16_t capVal;
+  uint16_t capRun;
+
+} cap_rle_t;
+
+/* Capture status */
+typedef struct {
+  uint32_t numRecords;
+  uint32_t numSamples;
+  uint32_t rawOverruns;  // DMA halves overwritten before cap_process() ran
+  bool isRunning;
+  bool isFull;  // Stopped because the record buffer filled up
+
+} cap_status_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Core API */
+uint32_t cap_init(const cap_config_t *capConfig);
+uint32_t cap_start(void);
+uint32_t cap_stop(void);
+uint32_t cap_process(void);
+
+/* Other API */
+uint32_t cap_get_status(cap_status_t *capStatus);
+uint32_t cap_dump(uint32_t ttysInstIdx);
+
+#endif  // cap.h
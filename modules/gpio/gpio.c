@@ -1,14 +1,58 @@
 #include <gpio.h>
+#include <trace.h>
 
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) macros
+////////////////////////////////////////////////////////////////////////////////
+
+// The GPIO ports are 0x400 apart on AHB1 and their AHB1ENR clock bits follow
+// the same order (A = 0 ... H = 7), F and G are not present on the F401
+#define IO_PORT_SLOTS 8U
+#define IO_PORT_SLOT(portx) \
+  ((((uint32_t)(uintptr_t)(portx)) - GPIOA_BASE) >> 10U)
+#define IO_PORT_SLOT_VALID(slot) ((slot) <= 4U || (slot) == 7U)
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (static) variables
+////////////////////////////////////////////////////////////////////////////////
 static io_confg_handler_t *IOconfig;
 
+// Register images of the ports, built by io_init()
+static io_port_image_t ioPortImg[IO_PORT_SLOTS];
+
+// Gather tables for io_snapshot(): the ports holding inputs, and for each
+// input the port it is on and its pin position in the IDR
+static io_port *ioSnapPorts[IO_PORT_SLOTS];
+static uint32_t ioSnapNumPorts;
+static uint32_t ioSnapNumInputs;
+static uint8_t ioSnapPortIdx[IO_SNAP_MAX_INPUTS];
+static uint8_t ioSnapPinPos[IO_SNAP_MAX_INPUTS];
+static uint32_t ioSnapInvMsk;
+#if TRACE_ENABLE
+static uint32_t ioSnapPrev;
+#endif
+
+// Power management: configured pins parked in analog mode per port, the
+// ports whose clock was gated by io_power_save(), and whether either is set
+static uint16_t ioPinParked[IO_PORT_SLOTS];
+static uint32_t ioPortGated;
+static bool ioPmActive;
+
 ////////////////////////////////////////////////////////////////////////////////
 // Private (static) function declarations
 ////////////////////////////////////////////////////////////////////////////////
-static void gpio_clock_enable(io_port *GPIOx);
+static io_port_image_t *gpio_port_image(io_port *GPIOx);
+static void gpio_port_apply(const io_port_image_t *ioPorts, uint32_t numPorts);
+static void gpio_snapshot_setup(void);
+static void gpio_pm_reset(void);
+static void gpio_pin_park(io_port *GPIOx, uint32_t ioPinNo);
+static void gpio_pin_wake(io_port *GPIOx, uint32_t ioPinNo);
+static uint32_t gpio_spread2(uint32_t ioPins);
 
 /**
- * @brief: Initialises the IO pins
+ * @brief: Initialises the IO pins. The whole config is first folded into one
+ *         register image per port, then every used port clock is enabled at
+ *         once and each register is written once per port.
  *
  * @param[in]: ioConfg
  * @return[out]: uint32_t
@@ -16,46 +60,102 @@ static void gpio_clock_enable(io_port *GPIOx);
 uint32_t io_init(io_confg_handler_t *ioConfg) {
   uint32_t ioIdx = 0U;
 
+  if (ioConfg == NULL) return IO_IN_CONFG_FAIL;
+
   // Setting the global io IOconfig structure
   IOconfig = ioConfg;
 
-  // Initialising the inputs
-  if (IOconfig->numIOInputs > 0U) {
-    for (ioIdx = 0U; ioIdx < ioConfg->numIOInputs; ioIdx++) {
-      // IO input handler to initialise the pins
-      const io_in_handler_t *ioIn = &IOconfig->ioInputs[ioIdx];
-      gpio_clock_enable(ioIn->portx);
-      LL_GPIO_SetPinMode(ioIn->portx, ioIn->ioPinNo, LL_GPIO_MODE_INPUT);
-      LL_GPIO_SetPinPull(ioIn->portx, ioIn->ioPinNo, ioIn->ioPupdr);
-    }
-  }
+  // Clearing the port images and the power management state
+  (void)memset(ioPortImg, 0U, sizeof(ioPortImg));
+  gpio_pm_reset();
 
-  if (IOconfig->ioOutputs > 0U) {
-    // Initialising the outputs
-    for (ioIdx = 0U; ioIdx < IOconfig->numIOOutputs; ioIdx++) {
-      // IO output handler to initialise the pins
-      const io_out_handler_t *ioOut = &IOconfig->ioOutputs[ioIdx];
+  // Folding the inputs into the port images
+  for (ioIdx = 0U; ioIdx < IOconfig->numIOInputs; ioIdx++) {
+    const io_in_handler_t *ioIn = &IOconfig->ioInputs[ioIdx];
+    io_port_image_t *ioImg = gpio_port_image(ioIn->portx);
+    uint32_t pin2 = ioIn->ioPinNo * ioIn->ioPinNo;
 
-      // Enabling the GPIO clock on the AHB bus
-      gpio_clock_enable(ioOut->portx);
+    if (ioImg == NULL) return IO_IN_CONFG_FAIL;
 
-      LL_GPIO_SetPinMode(ioOut->portx, ioOut->ioPinNo, LL_GPIO_MODE_OUTPUT);
-      LL_GPIO_SetPinSpeed(ioOut->portx, ioOut->ioPinNo, ioOut->ioSpeed);
-      LL_GPIO_SetPinOutputType(ioOut->portx, ioOut->ioPinNo, ioOut->ioOutType);
+    // Input mode is 0b00, so only the mask is needed
+    ioImg->moderMsk |= 3U * pin2;
+    ioImg->pupdrMsk |= 3U * pin2;
+    ioImg->pupdrVal |= ioIn->ioPupdr * pin2;
+  }
 
-      // Setting the initial values
-      if (ioOut->ioInitVal == SET) {
-        LL_GPIO_SetOutputPin(ioOut->portx, ioOut->ioPinNo);
-      } else {
-        LL_GPIO_ResetOutputPin(ioOut->portx, ioOut->ioPinNo);
-      }
+  // Folding the outputs into the port images
+  for (ioIdx = 0U; ioIdx < IOconfig->numIOOutputs; ioIdx++) {
+    const io_out_handler_t *ioOut = &IOconfig->ioOutputs[ioIdx];
+    io_port_image_t *ioImg = gpio_port_image(ioOut->portx);
+    uint32_t pin2 = ioOut->ioPinNo * ioOut->ioPinNo;
+
+    if (ioImg == NULL) return IO_OUT_CONFG_FAIL;
+
+    ioImg->moderMsk |= 3U * pin2;
+    ioImg->moderVal |= LL_GPIO_MODE_OUTPUT * pin2;
+    ioImg->ospeedrMsk |= 3U * pin2;
+    ioImg->ospeedrVal |= ioOut->ioSpeed * pin2;
+    ioImg->otyperMsk |= ioOut->ioPinNo;
+    ioImg->otyperVal |= ioOut->ioOutType * ioOut->ioPinNo;
+
+    // Setting the initial values
+    if (ioOut->ioInitVal == SET) {
+      ioImg->bsrrVal |= ioOut->ioPinNo;
+    } else {
+      ioImg->bsrrVal |= ioOut->ioPinNo << 16U;
     }
   }
 
+  // Writing the port registers
+  gpio_port_apply(ioPortImg, IO_PORT_SLOTS);
+
+  // Precomputing the input gather tables
+  gpio_snapshot_setup();
+
   // Return
   return EXIT_SUCCESS;
 }
 
+/**
+ * @brief: Initialises the IO pins from port images computed at compile time
+ *         (see gpio_static.h). Each register is written once per port.
+ *
+ * @param[in]: ioConfg. The config used by the read/write interfaces
+ * @param[in]: ioPorts. The port images
+ * @param[in]: numPorts
+ * @return[out]: uint32_t
+ **/
+uint32_t io_init_static(io_confg_handler_t *ioConfg,
+                        const io_port_image_t *ioPorts, uint32_t numPorts) {
+  uint32_t portIdx = 0U;
+
+  if (ioConfg == NULL || ioPorts == NULL) return IO_IN_CONFG_FAIL;
+
+  // Setting the global io IOconfig structure
+  IOconfig = ioConfg;
+
+  // Keeping a copy of the images, the power management restores pins from it
+  (void)memset(ioPortImg, 0U, sizeof(ioPortImg));
+  gpio_pm_reset();
+
+  for (portIdx = 0U; portIdx < numPorts; portIdx++) {
+    if (ioPorts[portIdx].ioClkEn == 0U) continue;
+
+    io_port_image_t *ioImg = gpio_port_image(ioPorts[portIdx].portx);
+    if (ioImg == NULL) return IO_IN_CONFG_FAIL;
+
+    *ioImg = ioPorts[portIdx];
+  }
+
+  // Writing the port registers
+  gpio_port_apply(ioPortImg, IO_PORT_SLOTS);
+
+  // Precomputing the input gather tables
+  gpio_snapshot_setup();
+
+  return EXIT_SUCCESS;
+}
+
 //
 // @TODO: Create a 'open' handler which enables an interrupt for the specified
 // input pin
@@ -72,10 +172,16 @@ uint32_t io_get_val(uint32_t ioInIdx) {
   uint8_t ioInVal = 0U;
 
   // Checking to see the ioInput index is valid
-  if (ioInIdx > IOconfig->numIOInputs) {
+  if (ioInIdx >= IOconfig->numIOInputs) {
     return IO_IN_SZE_ERR;
   }
 
+  // Reopening the pin if it was parked
+  if (ioPmActive) {
+    gpio_pin_wake(IOconfig->ioInputs[ioInIdx].portx,
+                  IOconfig->ioInputs[ioInIdx].ioPinNo);
+  }
+
   // Getting the input value
   if (IOconfig->ioInputs[ioInIdx].ioInInvert == ENABLE) {
     ioInVal = LL_GPIO_IsInputPinSet(IOconfig->ioInputs[ioInIdx].portx,
@@ -92,6 +198,60 @@ uint32_t io_get_val(uint32_t ioInIdx) {
   return ioInVal;
 }
 
+/**
+ * @brief: Reads every configured input at once. Each port holding inputs is
+ *         read once and the inputs are gathered into a bitmap, bit n being
+ *         ioInputs[n] with its inversion applied. Only the first
+ *         IO_SNAP_MAX_INPUTS inputs are included.
+ *
+ * @return[out]: uint32_t. The input bitmap
+ **/
+uint32_t io_snapshot(void) {
+  uint32_t ioIdr[IO_PORT_SLOTS];
+  uint32_t ioSnap = 0U;
+  uint32_t ioIdx = 0U;
+
+  // One IDR read per used port. Closed inputs are not reopened here, they
+  // read as inactive whatever their inversion.
+  for (ioIdx = 0U; ioIdx < ioSnapNumPorts; ioIdx++) {
+    if (ioPortGated & (1U << IO_PORT_SLOT(ioSnapPorts[ioIdx]))) {
+      ioIdr[ioIdx] = 0U;
+    } else {
+      ioIdr[ioIdx] = LL_GPIO_ReadInputPort(ioSnapPorts[ioIdx]);
+    }
+  }
+
+  // Gathering the input bits
+  for (ioIdx = 0U; ioIdx < ioSnapNumInputs; ioIdx++) {
+    ioSnap |= ((ioIdr[ioSnapPortIdx[ioIdx]] >> ioSnapPinPos[ioIdx]) & 1U)
+              << ioIdx;
+  }
+
+  ioSnap ^= ioSnapInvMsk;
+
+  // Masking the parked inputs (every input on a gated port is parked)
+  if (ioPmActive) {
+    for (ioIdx = 0U; ioIdx < ioSnapNumInputs; ioIdx++) {
+      uint32_t portSlot = IO_PORT_SLOT(ioSnapPorts[ioSnapPortIdx[ioIdx]]);
+
+      if ((ioPinParked[portSlot] >> ioSnapPinPos[ioIdx]) & 1U) {
+        ioSnap &= ~(1U << ioIdx);
+      }
+    }
+  }
+
+#if TRACE_ENABLE
+  // Recording the inputs that changed since the previous snapshot
+  uint32_t ioChg = io_changed(ioSnapPrev, ioSnap);
+  if (ioChg != 0U) {
+    TRACE(TRACE_EVT_GPIO_EDGE, io_next_changed(&ioChg), ioSnap);
+    ioSnapPrev = ioSnap;
+  }
+#endif
+
+  return ioSnap;
+}
+
 /**
  * @brief: Sets the value of the IO pin.
  *
@@ -101,7 +261,13 @@ uint32_t io_get_val(uint32_t ioInIdx) {
  **/
 uint32_t io_set_val(uint32_t ioOutIdx, uint32_t writeVal) {
   // Checking to see if the ioOutput index is valid
-  if (ioOutIdx > IOconfig->numIOOutputs) return IO_OUT_SZE_ERR;
+  if (ioOutIdx >= IOconfig->numIOOutputs) return IO_OUT_SZE_ERR;
+
+  // Reopening the pin if it was parked
+  if (ioPmActive) {
+    gpio_pin_wake(IOconfig->ioOutputs[ioOutIdx].portx,
+                  IOconfig->ioOutputs[ioOutIdx].ioPinNo);
+  }
 
   // Setting the pin HIGH
   if (writeVal) {
@@ -126,7 +292,13 @@ uint32_t io_set_val(uint32_t ioOutIdx, uint32_t writeVal) {
  * @return[out]: uint32_t
  **/
 uint32_t io_toggle_val(uint32_t ioOutIdx) {
-  if (ioOutIdx > IOconfig->numIOOutputs) return IO_OUT_SZE_ERR;
+  if (ioOutIdx >= IOconfig->numIOOutputs) return IO_OUT_SZE_ERR;
+
+  // Reopening the pin if it was parked
+  if (ioPmActive) {
+    gpio_pin_wake(IOconfig->ioOutputs[ioOutIdx].portx,
+                  IOconfig->ioOutputs[ioOutIdx].ioPinNo);
+  }
 
   LL_GPIO_TogglePin(IOconfig->ioOutputs[ioOutIdx].portx,
                     IOconfig->ioOutputs[ioOutIdx].ioPinNo);
@@ -142,75 +314,292 @@ uint32_t io_toggle_val(uint32_t ioOutIdx) {
  **/
 uint32_t io_get_output_val(uint32_t ioOutIdx) {
   // Checks to see if the output idx is valid
-  if (ioOutIdx > IOconfig->numIOOutputs) return IO_OUT_SZE_ERR;
+  if (ioOutIdx >= IOconfig->numIOOutputs) return IO_OUT_SZE_ERR;
+
+  // Reopening the pin if it was parked
+  if (ioPmActive) {
+    gpio_pin_wake(IOconfig->ioOutputs[ioOutIdx].portx,
+                  IOconfig->ioOutputs[ioOutIdx].ioPinNo);
+  }
 
   // Returns the current value of the output pin
   return LL_GPIO_IsOutputPinSet(IOconfig->ioOutputs[ioOutIdx].portx,
                                 IOconfig->ioOutputs[ioOutIdx].ioPinNo);
 }
 
+/**
+ * @brief: Closes an input pin by parking it in analog mode. The pin is
+ *         reopened with its configured settings on the next io_get_val().
+ *
+ * @param[in]: ioInIdx. The input index of the ioInputs[] array
+ * @return[out]: uint32_t
+ **/
+uint32_t io_close_input(uint32_t ioInIdx) {
+  if (ioInIdx >= IOconfig->numIOInputs) return IO_IN_SZE_ERR;
+
+  gpio_pin_park(IOconfig->ioInputs[ioInIdx].portx,
+                IOconfig->ioInputs[ioInIdx].ioPinNo);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Closes an output pin by parking it in analog mode. The pin is
+ *         reopened with its configured settings and last level on the next
+ *         access.
+ *
+ * @param[in]: ioOutIdx. The index of the output pin in the ioOutputs array
+ * @return[out]: uint32_t
+ **/
+uint32_t io_close_output(uint32_t ioOutIdx) {
+  if (ioOutIdx >= IOconfig->numIOOutputs) return IO_OUT_SZE_ERR;
+
+  gpio_pin_park(IOconfig->ioOutputs[ioOutIdx].portx,
+                IOconfig->ioOutputs[ioOutIdx].ioPinNo);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Puts the GPIO ports in their lowest power state. On every clocked
+ *         port the floating inputs that are not in use by this module are
+ *         parked in analog mode. Pins in output or alternate function mode,
+ *         pins with a pull resistor and pins on an enabled EXTI line are left
+ *         alone, since other modules (ttys, tmr, cap) may own them. A port
+ *         whose pins are then all analog has its AHB1 clock gated off until
+ *         one of its pins is accessed again.
+ *
+ * @return[out]: uint32_t. The AHB1ENR bits of the gated ports
+ **/
+uint32_t io_power_save(void) {
+  uint32_t portSlot = 0U;
+
+  for (portSlot = 0U; portSlot < IO_PORT_SLOTS; portSlot++) {
+    if (!IO_PORT_SLOT_VALID(portSlot)) continue;
+    if (!LL_AHB1_GRP1_IsEnabledClock(1U << portSlot)) continue;
+
+    io_port *GPIOx = (io_port *)(GPIOA_BASE + (portSlot << 10U));
+    uint32_t ioModer = READ_REG(GPIOx->MODER);
+
+    // Configured pins that are still open
+    uint32_t ioActive2 = ioPortImg[portSlot].moderMsk &
+                         ~(3U * gpio_spread2(ioPinParked[portSlot]));
+
+    // Inputs (0b00) with no pull resistor that nobody uses. Pulled pins may
+    // be straps or wake sources, and pins on an enabled EXTI line are kept
+    // whatever port the line is routed to.
+    uint32_t ioPupdr = READ_REG(GPIOx->PUPDR);
+    uint32_t ioIdle2 = ~ioModer & ~(ioModer >> 1U) & ~ioPupdr &
+                       ~(ioPupdr >> 1U) & 0x55555555U;
+    ioIdle2 &= ~gpio_spread2(READ_REG(EXTI->IMR) | READ_REG(EXTI->EMR));
+    ioIdle2 = (3U * ioIdle2) & ~ioActive2;
+
+    if (ioIdle2 != 0U) {
+      ioModer |= ioIdle2;
+      WRITE_REG(GPIOx->MODER, ioModer);
+    }
+
+    // Gating the port once every pin is analog
+    if (ioModer == 0xFFFFFFFFU) {
+      LL_AHB1_GRP1_DisableClock(1U << portSlot);
+      ioPortGated |= 1U << portSlot;
+      ioPmActive = true;
+    }
+  }
+
+  return ioPortGated;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Private (Static) Function Definitions
 ////////////////////////////////////////////////////////////////////////////////
 
 /**
- * @brief: This function enables the GPIO peripheral clock
+ * @brief: Returns the image of the port, setting it up on first use
  *
  * @param[in]: GPIOx
+ * @return[out]: io_port_image_t*. NULL if GPIOx is not a GPIO port
+ **/
+static io_port_image_t *gpio_port_image(io_port *GPIOx) {
+  uint32_t portSlot = IO_PORT_SLOT(GPIOx);
+
+  if (((uintptr_t)GPIOx & 0x3FFU) != 0U || portSlot >= IO_PORT_SLOTS ||
+      !IO_PORT_SLOT_VALID(portSlot)) {
+    return NULL;
+  }
+
+  io_port_image_t *ioImg = &ioPortImg[portSlot];
+  ioImg->portx = GPIOx;
+  ioImg->ioClkEn = 1U << portSlot;
+
+  return ioImg;
+}
+
+/**
+ * @brief: Builds the io_snapshot() gather tables from the current config
+ *
  * @return[out]: void
  **/
-static void gpio_clock_enable(io_port *GPIOx) {
-  // A temporay variable to determine the base address of the GPIO Register.
-  uint32_t tmpGPIORegAddr = (uint32_t)GPIOx;
+static void gpio_snapshot_setup(void) {
+  uint32_t ioIdx = 0U;
+  uint32_t portIdx = 0U;
 
-  // Uses the base address of the GPIO Register to enable the GPIO clock
-  switch (tmpGPIORegAddr) {
-    case GPIOA_BASE:
+  ioSnapNumPorts = 0U;
+  ioSnapInvMsk = 0U;
+  ioSnapNumInputs = IOconfig->numIOInputs;
 
-      if (LL_AHB1_GRP1_IsEnabledClock(GPIOA_BASE)) {
-        break;
-      } else {
-        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOA);
-        assert_param(
-            LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_ALL_GPIOA));
-      }
-      break;
-
-    case GPIOB_BASE:
-      if (LL_AHB1_GRP1_IsEnabledClock(GPIOB_BASE)) {
-        break;
-      } else {
-        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOB);
-        assert_param(
-            LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_ALL_GPIOB));
-      }
+  if (ioSnapNumInputs > IO_SNAP_MAX_INPUTS) {
+    ioSnapNumInputs = IO_SNAP_MAX_INPUTS;
+  }
+
+  for (ioIdx = 0U; ioIdx < ioSnapNumInputs; ioIdx++) {
+    const io_in_handler_t *ioIn = &IOconfig->ioInputs[ioIdx];
+
+    // Finding (or adding) the port in the list of ports to read
+    for (portIdx = 0U; portIdx < ioSnapNumPorts; portIdx++) {
+      if (ioSnapPorts[portIdx] == ioIn->portx) break;
+    }
+    if (portIdx == ioSnapNumPorts) {
+      ioSnapPorts[ioSnapNumPorts++] = ioIn->portx;
+    }
+
+    ioSnapPortIdx[ioIdx] = (uint8_t)portIdx;
+    ioSnapPinPos[ioIdx] = (uint8_t)(31U - __CLZ(ioIn->ioPinNo));
+
+    if (ioIn->ioInInvert == ENABLE) {
+      ioSnapInvMsk |= 1U << ioIdx;
+    }
+  }
+}
+
+/**
+ * @brief: Writes port images to the GPIO registers. The clocks of all the
+ *         ports are enabled together and each register is then written once
+ *         per port. The output levels are set before the pins are switched to
+ *         outputs so that they do not glitch.
+ *
+ * @param[in]: ioPorts
+ * @param[in]: numPorts
+ * @return[out]: void
+ **/
+static void gpio_port_apply(const io_port_image_t *ioPorts, uint32_t numPorts) {
+  uint32_t portIdx = 0U;
+  uint32_t ioClkEn = 0U;
 
-      break;
+  // Enabling the clocks of every used port on the AHB bus
+  for (portIdx = 0U; portIdx < numPorts; portIdx++) {
+    ioClkEn |= ioPorts[portIdx].ioClkEn;
+  }
 
-    case GPIOC_BASE:
+  if (ioClkEn != 0U) {
+    LL_AHB1_GRP1_EnableClock(ioClkEn);
+  }
 
-      LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOC);
-      assert_param(LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOC));
+  for (portIdx = 0U; portIdx < numPorts; portIdx++) {
+    const io_port_image_t *ioImg = &ioPorts[portIdx];
 
-      break;
+    // Unused port
+    if (ioImg->ioClkEn == 0U) continue;
 
-    case GPIOD_BASE:
+    if (ioImg->bsrrVal != 0U) {
+      WRITE_REG(ioImg->portx->BSRR, ioImg->bsrrVal);
+    }
+    if (ioImg->otyperMsk != 0U) {
+      MODIFY_REG(ioImg->portx->OTYPER, ioImg->otyperMsk, ioImg->otyperVal);
+    }
+    if (ioImg->ospeedrMsk != 0U) {
+      MODIFY_REG(ioImg->portx->OSPEEDR, ioImg->ospeedrMsk, ioImg->ospeedrVal);
+    }
+    if (ioImg->pupdrMsk != 0U) {
+      MODIFY_REG(ioImg->portx->PUPDR, ioImg->pupdrMsk, ioImg->pupdrVal);
+    }
+    if (ioImg->moderMsk != 0U) {
+      MODIFY_REG(ioImg->portx->MODER, ioImg->moderMsk, ioImg->moderVal);
+    }
+  }
+}
 
-      LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOD);
-      assert_param(LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOD));
-      break;
+/**
+ * @brief: Clears the power management state
+ *
+ * @return[out]: void
+ **/
+static void gpio_pm_reset(void) {
+  (void)memset(ioPinParked, 0U, sizeof(ioPinParked));
+  ioPortGated = 0U;
+  ioPmActive = false;
+}
 
-    case GPIOE_BASE:
+/**
+ * @brief: Parks a configured pin in analog mode with no pull resistor
+ *
+ * @param[in]: GPIOx
+ * @param[in]: ioPinNo
+ * @return[out]: void
+ **/
+static void gpio_pin_park(io_port *GPIOx, uint32_t ioPinNo) {
+  uint32_t portSlot = IO_PORT_SLOT(GPIOx);
 
-      LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOE);
-      assert_param(LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOE));
-      break;
+  // A gated port has every pin in analog mode already
+  if (!(ioPortGated & (1U << portSlot))) {
+    LL_GPIO_SetPinPull(GPIOx, ioPinNo, LL_GPIO_PULL_NO);
+    LL_GPIO_SetPinMode(GPIOx, ioPinNo, LL_GPIO_MODE_ANALOG);
+  }
 
-    case GPIOH_BASE:
+  ioPinParked[portSlot] |= (uint16_t)ioPinNo;
+  ioPmActive = true;
+}
 
-      LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOH);
-      assert_param(LL_AHB1_GRP1_IsEnabledClock(LL_AHB1_GRP1_PERIPH_GPIOH));
+/**
+ * @brief: Ungates the port clock and restores the pin from the port image if
+ *         it was parked
+ *
+ * @param[in]: GPIOx
+ * @param[in]: ioPinNo
+ * @return[out]: void
+ **/
+static void gpio_pin_wake(io_port *GPIOx, uint32_t ioPinNo) {
+  uint32_t portSlot = IO_PORT_SLOT(GPIOx);
+  uint32_t portIdx = 0U;
 
-      break;
+  if (ioPortGated & (1U << portSlot)) {
+    LL_AHB1_GRP1_EnableClock(1U << portSlot);
+    ioPortGated &= ~(1U << portSlot);
   }
+
+  if (ioPinParked[portSlot] & ioPinNo) {
+    const io_port_image_t *ioImg = &ioPortImg[portSlot];
+    uint32_t pinMsk2 = 3U * ioPinNo * ioPinNo;
+
+    // The ODR is kept while parked, so outputs come back at their last level
+    if (ioImg->pupdrMsk & pinMsk2) {
+      MODIFY_REG(GPIOx->PUPDR, pinMsk2, ioImg->pupdrVal & pinMsk2);
+    }
+    MODIFY_REG(GPIOx->MODER, pinMsk2, ioImg->moderVal & pinMsk2);
+
+    ioPinParked[portSlot] &= (uint16_t)~ioPinNo;
+  }
+
+  // Checking if anything is still parked or gated
+  ioPmActive = (ioPortGated != 0U);
+  for (portIdx = 0U; portIdx < IO_PORT_SLOTS && !ioPmActive; portIdx++) {
+    ioPmActive = (ioPinParked[portIdx] != 0U);
+  }
+}
+
+/**
+ * @brief: Spreads a 16 bit pin mask so pin n lands on bit 2n, the layout of
+ *         MODER, PUPDR and OSPEEDR
+ *
+ * @param[in]: ioPins
+ * @return[out]: uint32_t
+ **/
+static uint32_t gpio_spread2(uint32_t ioPins) {
+  ioPins &= 0xFFFFU;
+  ioPins = (ioPins | (ioPins << 8U)) & 0x00FF00FFU;
+  ioPins = (ioPins | (ioPins << 4U)) & 0x0F0F0F0FU;
+  ioPins = (ioPins | (ioPins << 2U)) & 0x33333333U;
+  ioPins = (ioPins | (ioPins << 1U)) & 0x55555555U;
+
+  return ioPins;
 }
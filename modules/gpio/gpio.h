@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* MCU includes */
 #include <stm32f4xx_ll_bus.h>
@@ -103,6 +104,9 @@ typedef enum {
 #define IO_INVERT_ENABLE ENABLE
 #define IO_INVERT_DISABLE DISABLE
 
+// Number of inputs covered by io_snapshot()
+#define IO_SNAP_MAX_INPUTS 32U
+
 ////////////////////////////////////////////////////////////////////////////////
 // Type Definitions
 ////////////////////////////////////////////////////////////////////////////////
@@ -134,12 +138,32 @@ typedef struct {
 
 } io_confg_handler_t;
 
+/* Register image of one port: the bits to modify and the values to write */
+typedef struct {
+  io_port *portx;
+  uint32_t ioClkEn;
+
+  uint32_t moderMsk;
+  uint32_t moderVal;
+  uint32_t otyperMsk;
+  uint32_t otyperVal;
+  uint32_t ospeedrMsk;
+  uint32_t ospeedrVal;
+  uint32_t pupdrMsk;
+  uint32_t pupdrVal;
+
+  uint32_t bsrrVal;
+
+} io_port_image_t;
+
 ////////////////////////////////////////////////////////////////////////////////
 // Module Interface
 ////////////////////////////////////////////////////////////////////////////////
 
 // Initialise/Open interface
 uint32_t io_init(io_confg_handler_t *ioConfg);
+uint32_t io_init_static(io_confg_handler_t *ioConfg,
+                        const io_port_image_t *ioPorts, uint32_t numPorts);
 
 // Write interfaces
 uint32_t io_set_val(uint32_t ioOutIdx, uint32_t writeVal);
@@ -148,5 +172,39 @@ uint32_t io_toggle_val(uint32_t ioOutIdx);
 // Read interfaces
 uint32_t io_get_val(uint32_t ioInIdx);
 uint32_t io_get_output_val(uint32_t ioOutIdx);
+uint32_t io_snapshot(void);
+
+// Power management interfaces
+uint32_t io_close_input(uint32_t ioInIdx);
+uint32_t io_close_output(uint32_t ioOutIdx);
+uint32_t io_power_save(void);
+
+/**
+ * @brief: Returns the inputs that differ between two snapshots
+ *
+ * @param[in]: ioPrev. The previous io_snapshot()
+ * @param[in]: ioCur. The current io_snapshot()
+ * @return[out]: uint32_t. Bitmap of the changed inputs
+ **/
+__STATIC_INLINE uint32_t io_changed(uint32_t ioPrev, uint32_t ioCur) {
+  return ioPrev ^ ioCur;
+}
+
+/**
+ * @brief: Pops the highest changed input from a changed bitmap, so only the
+ *         inputs that changed are visited:
+ *
+ *         uint32_t ioChg = io_changed(prev, cur);
+ *         while (ioChg) { uint32_t ioInIdx = io_next_changed(&ioChg); ... }
+ *
+ * @param[in/out]: ioChg. Must not be 0
+ * @return[out]: uint32_t. The input index
+ **/
+__STATIC_INLINE uint32_t io_next_changed(uint32_t *ioChg) {
+  uint32_t ioInIdx = 31U - __CLZ(*ioChg);
+
+  *ioChg &= ~(1U << ioInIdx);
+  return ioInIdx;
+}
 
 #endif  // gpio.h
\ No newline at end of file
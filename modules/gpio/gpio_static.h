@@ -0,0 +1,169 @@
+/**
+ * @file gpio_static.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Compile-time GPIO configuration
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef GPIO_STATIC_H
+#define GPIO_STATIC_H
+
+/*
+ * The board IO is described once as an X-macro list. Each entry names the
+ * port letter, the pin and its settings:
+ *
+ *   #define BOARD_IO(IN, OUT, X)                                          \
+ *     IN(X, A, IO_PIN_00, IO_PULL_UP, IO_INVERT_DISABLE)                  \
+ *     OUT(X, A, IO_PIN_05, IO_SPDR_FREQ_LOW, IO_OUPT_PUSHPULL, RESET)
+ *
+ *   IO_STATIC_CONFIG(boardIO, BOARD_IO);
+ *
+ *   IO_STATIC_INIT(boardIO);
+ *
+ * IO_STATIC_CONFIG() creates the input/output handler arrays and the
+ * io_confg_handler_t used by the rest of the gpio API, in list order. It
+ * also folds the list into one io_port_image_t per port, so the register
+ * values are computed by the compiler and io_init_static() writes each
+ * register once per port. Duplicate pins and invalid settings fail the
+ * build through _Static_assert.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <gpio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Pins are single bit masks (LL_GPIO_PIN_x), so pin * pin moves a 2 bit field
+// value to the pin's position in MODER, PUPDR and OSPEEDR
+#define IO_S_FIELD2(pin, val) ((uint32_t)(val) * (pin) * (pin))
+#define IO_S_FIELD1(pin, val) ((uint32_t)(val) * (pin))
+
+#define IO_S_PIN_VALID(pin) \
+  ((pin) != 0U && ((pin) & ((pin) - 1U)) == 0U && (pin) <= IO_PIN_15)
+
+// Contribution of an entry to the image of port X
+#define IO_S_ON(X, port, val) \
+  ((GPIO##port##_BASE == GPIO##X##_BASE) ? (uint32_t)(val) : 0U)
+
+#define IO_S_SKIP(...)
+
+/* Pin masks (the sum is only equal to the OR if there are no duplicates) */
+#define IO_S_IN_SUM(X, port, pin, pull, inv) +IO_S_ON(X, port, pin)
+#define IO_S_OUT_SUM(X, port, pin, spd, type, init) +IO_S_ON(X, port, pin)
+#define IO_S_IN_OR(X, port, pin, pull, inv) | IO_S_ON(X, port, pin)
+#define IO_S_OUT_OR(X, port, pin, spd, type, init) | IO_S_ON(X, port, pin)
+
+/* Setting checks */
+#define IO_S_IN_VALID(X, port, pin, pull, inv) \
+  &&IO_S_PIN_VALID(pin) && (pull) <= IO_PULL_DWN && (inv) <= ENABLE
+#define IO_S_OUT_VALID(X, port, pin, spd, type, init)               \
+  &&IO_S_PIN_VALID(pin) && (spd) <= IO_SPDR_FREQ_VHIGH &&          \
+      (type) <= IO_OUPT_OPNDRAIN && (init) <= SET
+
+/* Register fields */
+#define IO_S_IN_MSK2(X, port, pin, pull, inv) \
+  | IO_S_ON(X, port, IO_S_FIELD2(pin, 3U))
+#define IO_S_OUT_MSK2(X, port, pin, spd, type, init) \
+  | IO_S_ON(X, port, IO_S_FIELD2(pin, 3U))
+#define IO_S_OUT_MSK1(X, port, pin, spd, type, init) \
+  | IO_S_ON(X, port, IO_S_FIELD1(pin, 1U))
+
+#define IO_S_OUT_MODER(X, port, pin, spd, type, init) \
+  | IO_S_ON(X, port, IO_S_FIELD2(pin, LL_GPIO_MODE_OUTPUT))
+#define IO_S_IN_PUPDR(X, port, pin, pull, inv) \
+  | IO_S_ON(X, port, IO_S_FIELD2(pin, pull))
+#define IO_S_OUT_OSPEEDR(X, port, pin, spd, type, init) \
+  | IO_S_ON(X, port, IO_S_FIELD2(pin, spd))
+#define IO_S_OUT_OTYPER(X, port, pin, spd, type, init) \
+  | IO_S_ON(X, port, IO_S_FIELD1(pin, type))
+#define IO_S_OUT_BSRR(X, port, pin, spd, type, init) \
+  | IO_S_ON(X, port, ((init) == SET) ? (pin) : ((pin) << 16U))
+
+/* Handler array entries */
+#define IO_S_IN_COUNT(X, port, pin, pull, inv) +1U
+#define IO_S_OUT_COUNT(X, port, pin, spd, type, init) +1U
+#define IO_S_IN_HANDLER(X, port, pin, pull, inv) {GPIO##port, pin, pull, inv},
+#define IO_S_OUT_HANDLER(X, port, pin, spd, type, init) \
+  {GPIO##port, pin, spd, type, init},
+
+////////////////////////////////////////////////////////////////////////////////
+// Port Images
+////////////////////////////////////////////////////////////////////////////////
+#define IO_STATIC_NUM_PORTS 6U
+
+#define IO_STATIC_PORT_IMAGE(list, X)                                        \
+  {                                                                          \
+    .portx = GPIO##X,                                                        \
+    .ioClkEn = ((0U list(IO_S_IN_OR, IO_S_OUT_OR, X)) != 0U)                 \
+                   ? LL_AHB1_GRP1_PERIPH_GPIO##X                             \
+                   : 0U,                                                     \
+    .moderMsk = 0U list(IO_S_IN_MSK2, IO_S_OUT_MSK2, X),                     \
+    .moderVal = 0U list(IO_S_SKIP, IO_S_OUT_MODER, X),                       \
+    .otyperMsk = 0U list(IO_S_SKIP, IO_S_OUT_MSK1, X),                       \
+    .otyperVal = 0U list(IO_S_SKIP, IO_S_OUT_OTYPER, X),                     \
+    .ospeedrMsk = 0U list(IO_S_SKIP, IO_S_OUT_MSK2, X),                      \
+    .ospeedrVal = 0U list(IO_S_SKIP, IO_S_OUT_OSPEEDR, X),                   \
+    .pupdrMsk = 0U list(IO_S_IN_MSK2, IO_S_SKIP, X),                         \
+    .pupdrVal = 0U list(IO_S_IN_PUPDR, IO_S_SKIP, X),                        \
+    .bsrrVal = 0U list(IO_S_SKIP, IO_S_OUT_BSRR, X),                         \
+  }
+
+#define IO_STATIC_CHECK_PORT(list, X)                                  \
+  _Static_assert((0U list(IO_S_IN_SUM, IO_S_OUT_SUM, X)) ==            \
+                     (0U list(IO_S_IN_OR, IO_S_OUT_OR, X)),            \
+                 "gpio: pin configured more than once on port " #X)
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+// Number of inputs and outputs in the list
+#define IO_STATIC_NUM_INPUTS(list) (0U list(IO_S_IN_COUNT, IO_S_SKIP, A))
+#define IO_STATIC_NUM_OUTPUTS(list) (0U list(IO_S_SKIP, IO_S_OUT_COUNT, A))
+
+// Compile-time checks of the whole list
+#define IO_STATIC_CHECK(list)                                            \
+  _Static_assert(1 list(IO_S_IN_VALID, IO_S_OUT_VALID, A),               \
+                 "gpio: invalid pin or pin setting");                    \
+  IO_STATIC_CHECK_PORT(list, A);                                         \
+  IO_STATIC_CHECK_PORT(list, B);                                         \
+  IO_STATIC_CHECK_PORT(list, C);                                         \
+  IO_STATIC_CHECK_PORT(list, D);                                         \
+  IO_STATIC_CHECK_PORT(list, E);                                         \
+  IO_STATIC_CHECK_PORT(list, H)
+
+// Handler arrays, config and port images. The handler arrays carry one zeroed
+// entry at the end so that lists without inputs or outputs stay valid C.
+#define IO_STATIC_CONFIG(name, list)                                       \
+  IO_STATIC_CHECK(list);                                                   \
+  static const io_in_handler_t name##Inputs[IO_STATIC_NUM_INPUTS(list) +   \
+                                            1U] = {                        \
+      list(IO_S_IN_HANDLER, IO_S_SKIP, A)};                                \
+  static const io_out_handler_t name##Outputs[IO_STATIC_NUM_OUTPUTS(list) + \
+                                              1U] = {                      \
+      list(IO_S_SKIP, IO_S_OUT_HANDLER, A)};                               \
+  static io_confg_handler_t name = {                                       \
+      .numIOInputs = IO_STATIC_NUM_INPUTS(list),                           \
+      .ioInputs = name##Inputs,                                            \
+      .numIOOutputs = IO_STATIC_NUM_OUTPUTS(list),                         \
+      .ioOutputs = name##Outputs,                                          \
+  };                                                                       \
+  static const io_port_image_t name##Ports[IO_STATIC_NUM_PORTS] = {        \
+      IO_STATIC_PORT_IMAGE(list, A), IO_STATIC_PORT_IMAGE(list, B),        \
+      IO_STATIC_PORT_IMAGE(list, C), IO_STATIC_PORT_IMAGE(list, D),        \
+      IO_STATIC_PORT_IMAGE(list, E), IO_STATIC_PORT_IMAGE(list, H),        \
+  }
+
+// Registers the config and writes the precomputed port images
+#define IO_STATIC_INIT(name) \
+  io_init_static(&name, name##Ports, IO_STATIC_NUM_PORTS)
+
+#endif  // gpio_static.h
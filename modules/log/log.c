@@ -1 +1,415 @@
+/**
+ * @file log.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Deferred binary logger
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
 
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <log.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function declarations
+////////////////////////////////////////////////////////////////////////////////
+static void log_count_drop(void);
+static bool log_ring_is_valid(void);
+static uint32_t log_header_crc(void);
+static uint32_t log_image_id(void);
+static uint32_t log_crc32(uint32_t logCrc, const void *data, uint32_t len);
+static bool log_fmt_is_valid(const char *logFmt);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+static log_ring_t logRing __attribute__((section(LOG_RING_SECTION)));
+
+// Stands in for records that were being written when the reset happened
+static const char logLostFmt[] __attribute__((section(LOG_STR_SECTION))) =
+    "<record lost in reset>";
+
+// ID of the running image, computed by log_init()
+static uint32_t logImageId;
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) variables
+////////////////////////////////////////////////////////////////////////////////
+volatile uint32_t logVerboseMsk;
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Initialises the log ring and starts the DWT cycle counter used for
+ *         the timestamps. If the ring retained in RAM is still valid (after
+ *         a reset or a fault) its records and fault capture are kept, so they
+ *         can be sent out with log_postmortem().
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t log_init(void) {
+  uint32_t logIdx = 0U;
+
+  logImageId = log_image_id();
+
+  if (log_ring_is_valid()) {
+    // Records reserved but never published before the reset
+    for (logIdx = logRing.logTail; logIdx != logRing.logHead; logIdx++) {
+      log_record_t *logRec =
+          &logRing.logRecords[logIdx & (LOG_NUM_RECORDS - 1U)];
+
+      if (!log_fmt_is_valid(logRec->logFmt)) {
+        logRec->logNumArgs = 0U;
+        logRec->logFmt = logLostFmt;
+      }
+    }
+  } else {
+    // Cold boot, new image or corrupted ring, starting from scratch
+    (void)memset(&logRing, 0U, sizeof(logRing));
+    logRing.logMagic = LOG_RING_MAGIC;
+    logRing.logSize = LOG_NUM_RECORDS;
+    logRing.logImageId = logImageId;
+    logRing.logCrc = log_header_crc();
+  }
+
+  // Enabling the cycle counter. It is shared with prof, bench, trace and pcs,
+  // which all take deltas, so it is never reset here
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Stores a log record. This is called by the LOG() macro and is safe
+ *         from any context: the slot is reserved with LDREX/STREX and the
+ *         record is published by writing the format pointer last.
+ *
+ * @param[in]: logFmt. The format string (its address is the record ID)
+ * @param[in]: logNumArgs
+ * @param[in]: logArg0..logArg3
+ * @return[out]: void
+ **/
+void log_write(const char *logFmt, uint32_t logNumArgs, uint32_t logArg0,
+               uint32_t logArg1, uint32_t logArg2, uint32_t logArg3) {
+  uint32_t logHead = 0U;
+
+  // Reserving a slot, the record is dropped if the ring is full
+  do {
+    logHead = __LDREXW(&logRing.logHead);
+
+    if ((logHead - logRing.logTail) >= LOG_NUM_RECORDS) {
+      __CLREX();
+      log_count_drop();
+      return;
+    }
+  } while (__STREXW(logHead + 1U, &logRing.logHead));
+
+  log_record_t *logRec = &logRing.logRecords[logHead & (LOG_NUM_RECORDS - 1U)];
+
+  logRec->logTime = DWT->CYCCNT;
+  logRec->logNumArgs = logNumArgs;
+  logRec->logArgs[0U] = logArg0;
+  logRec->logArgs[1U] = logArg1;
+  logRec->logArgs[2U] = logArg2;
+  logRec->logArgs[3U] = logArg3;
+
+  // Publishing the record
+  __DMB();
+  logRec->logFmt = logFmt;
+}
+
+/**
+ * @brief: Formats and prints the pending records. Meant to be called from
+ *         the idle loop, since printf() blocks on the ttys port.
+ *
+ * @param[in]: maxRecords. The maximum number of records to print
+ * @return[out]: uint32_t. The number of records printed
+ **/
+uint32_t log_flush(uint32_t maxRecords) {
+  uint32_t numRecords = 0U;
+
+  while (numRecords < maxRecords && logRing.logTail != logRing.logHead) {
+    log_record_t *logRec =
+        &logRing.logRecords[logRing.logTail & (LOG_NUM_RECORDS - 1U)];
+
+    // The writer has reserved the slot but not published it yet
+    if (logRec->logFmt == NULL) break;
+    __DMB();
+
+    printf("[%10lu] ", (unsigned long)logRec->logTime);
+    if (log_fmt_is_valid(logRec->logFmt)) {
+      printf(logRec->logFmt, logRec->logArgs[0U], logRec->logArgs[1U],
+             logRec->logArgs[2U], logRec->logArgs[3U]);
+    } else {
+      printf("<bad format %08lx>", (unsigned long)(uintptr_t)logRec->logFmt);
+    }
+    printf("\n\r");
+
+    // Releasing the slot
+    logRec->logFmt = NULL;
+    __DMB();
+    logRing.logTail++;
+    numRecords++;
+  }
+
+  return numRecords;
+}
+
+/**
+ * @brief: Streams the pending records in binary over a ttys instance, to be
+ *         formatted on the host. Each record is little-endian:
+ *
+ *         format ID u32 | timestamp u32 | number of args u8 | args u32...
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: maxRecords. The maximum number of records to send
+ * @return[out]: uint32_t. The number of records sent
+ **/
+uint32_t log_dump(uint32_t ttysInstIdx, uint32_t maxRecords) {
+  uint32_t numRecords = 0U;
+
+  if (ttysInstIdx >= TTYS_NUM_INSTANCES) return LOG_ERR_IDX;
+
+  while (numRecords < maxRecords && logRing.logTail != logRing.logHead) {
+    log_record_t *logRec =
+        &logRing.logRecords[logRing.logTail & (LOG_NUM_RECORDS - 1U)];
+
+    if (logRec->logFmt == NULL) break;
+    __DMB();
+
+    uint32_t logId = (uint32_t)(uintptr_t)logRec->logFmt;
+    uint8_t logNumArgs = (uint8_t)logRec->logNumArgs;
+
+    (void)ttys_write(ttysInstIdx, &logId, 4U);
+    (void)ttys_write(ttysInstIdx, &logRec->logTime, 4U);
+    (void)ttys_write(ttysInstIdx, &logNumArgs, 1U);
+    (void)ttys_write(ttysInstIdx, logRec->logArgs, 4U * logNumArgs);
+
+    logRec->logFmt = NULL;
+    __DMB();
+    logRing.logTail++;
+    numRecords++;
+  }
+
+  return numRecords;
+}
+
+/**
+ * @brief: Returns the fault captured before the last reset
+ *
+ * @param[out]: logFault
+ * @return[out]: uint32_t. LOG_ERR_NO_FAULT if the last reset was not a fault
+ **/
+uint32_t log_get_fault(log_fault_t *logFault) {
+  if (logRing.logFault.faultMagic != LOG_FAULT_MAGIC) return LOG_ERR_NO_FAULT;
+
+  if (logFault != NULL) {
+    *logFault = logRing.logFault;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Sends the crash report after a fault reset: the fault registers
+ *         followed by every record still in the ring (see log_dump()). The
+ *         fault capture is cleared afterwards. Little-endian:
+ *
+ *         "LOGF" | CFSR | HFSR | MMFAR | BFAR | PC | LR | xPSR | count u32
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: uint32_t. LOG_ERR_NO_FAULT if the last reset was not a fault
+ **/
+uint32_t log_postmortem(uint32_t ttysInstIdx) {
+  if (ttysInstIdx >= TTYS_NUM_INSTANCES) return LOG_ERR_IDX;
+  if (logRing.logFault.faultMagic != LOG_FAULT_MAGIC) return LOG_ERR_NO_FAULT;
+
+  uint32_t numRecords = logRing.logHead - logRing.logTail;
+
+  // Fault block, the magic doubles as the block marker
+  (void)ttys_write(ttysInstIdx, &logRing.logFault, sizeof(log_fault_t));
+  (void)ttys_write(ttysInstIdx, &numRecords, 4U);
+
+  // Records, in bulk
+  (void)log_dump(ttysInstIdx, numRecords);
+
+  // Clearing the capture
+  (void)memset(&logRing.logFault, 0U, sizeof(log_fault_t));
+  logRing.logCrc = log_header_crc();
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Stores the fault registers and the stacked PC/LR/xPSR in the
+ *         retained ring and resets the MCU. Called from HardFault_Handler with
+ *         the exception frame.
+ *
+ * @param[in]: faultFrame. The stacked R0-R3, R12, LR, PC, xPSR
+ * @return[out]: void
+ **/
+void log_fault_capture(const uint32_t *faultFrame) {
+  logRing.logFault.faultCfsr = SCB->CFSR;
+  logRing.logFault.faultHfsr = SCB->HFSR;
+  logRing.logFault.faultMmfar = SCB->MMFAR;
+  logRing.logFault.faultBfar = SCB->BFAR;
+  logRing.logFault.faultLr = faultFrame[5U];
+  logRing.logFault.faultPc = faultFrame[6U];
+  logRing.logFault.faultPsr = faultFrame[7U];
+  logRing.logFault.faultMagic = LOG_FAULT_MAGIC;
+
+  // Keeping the ring valid over the reset
+  logRing.logMagic = LOG_RING_MAGIC;
+  logRing.logSize = LOG_NUM_RECORDS;
+  logRing.logImageId = logImageId;
+  logRing.logCrc = log_header_crc();
+
+  __DSB();
+  NVIC_SystemReset();
+}
+
+#if LOG_FAULT_HANDLER
+/**
+ * @brief: HardFault handler. Passes the exception frame (from MSP or PSP) to
+ *         log_fault_capture(). Weak, so an application handler replaces it.
+ */
+__attribute__((weak, naked)) void HardFault_Handler(void) {
+  __asm volatile(
+      "tst lr, #4            \n"
+      "ite eq                \n"
+      "mrseq r0, msp         \n"
+      "mrsne r0, psp         \n"
+      "b log_fault_capture   \n");
+}
+#endif
+
+/**
+ * @brief: Returns the number of records dropped because the ring was full
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t log_get_drops(void) { return logRing.logDrops; }
+
+/**
+ * @brief: Raises (or restores) the verbosity of a module at runtime. A
+ *         verbose module records every statement compiled in for it, up to
+ *         its LOG_LEVEL_MAX_x.
+ *
+ * @param[in]: logMod. LOG_MOD_x
+ * @param[in]: isVerbose
+ * @return[out]: uint32_t
+ **/
+uint32_t log_set_verbose(uint32_t logMod, bool isVerbose) {
+  if (logMod >= LOG_NUM_MODULES) return LOG_ERR_MOD;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (isVerbose) {
+    logVerboseMsk |= 1U << logMod;
+  } else {
+    logVerboseMsk &= ~(1U << logMod);
+  }
+  __set_PRIMASK(primask);
+
+  return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Increments the drop counter, safe from any context
+ *
+ * @return[out]: void
+ **/
+static void log_count_drop(void) {
+  uint32_t logDrops = 0U;
+
+  do {
+    logDrops = __LDREXW(&logRing.logDrops);
+  } while (__STREXW(logDrops + 1U, &logRing.logDrops));
+}
+
+/**
+ * @brief: Checks that the ring retained in RAM is intact
+ *
+ * @return[out]: bool
+ **/
+static bool log_ring_is_valid(void) {
+  if (logRing.logMagic != LOG_RING_MAGIC) return false;
+  if (logRing.logSize != LOG_NUM_RECORDS) return false;
+  if (logRing.logCrc != log_header_crc()) return false;
+
+  // The records point into the image that wrote them
+  if (logRing.logImageId != logImageId) return false;
+
+  return (logRing.logHead - logRing.logTail) <= LOG_NUM_RECORDS;
+}
+
+/**
+ * @brief: CRC-32 (IEEE, reflected) of the ring header, up to logCrc
+ *
+ * @return[out]: uint32_t
+ **/
+static uint32_t log_header_crc(void) {
+  return ~log_crc32(0xFFFFFFFFU, &logRing, offsetof(log_ring_t, logCrc));
+}
+
+/**
+ * @brief: ID of the running image: CRC-32 of the format string section, its
+ *         address and LOG_BUILD_ID. A reflash that moves or changes any
+ *         format string changes the ID.
+ *
+ * @return[out]: uint32_t
+ **/
+static uint32_t log_image_id(void) {
+  uint32_t logBounds[3U] = {(uint32_t)(uintptr_t)LOG_FMT_START,
+                            (uint32_t)(uintptr_t)LOG_FMT_END,
+                            (uint32_t)(LOG_BUILD_ID)};
+  uint32_t logCrc = log_crc32(0xFFFFFFFFU, logBounds, sizeof(logBounds));
+
+  return ~log_crc32(logCrc, LOG_FMT_START,
+                    (uint32_t)(LOG_FMT_END - LOG_FMT_START));
+}
+
+/**
+ * @brief: Checks that a record's format pointer is inside the format string
+ *         section of the running image
+ *
+ * @param[in]: logFmt
+ * @return[out]: bool
+ **/
+static bool log_fmt_is_valid(const char *logFmt) {
+  return logFmt >= LOG_FMT_START && logFmt < LOG_FMT_END;
+}
+
+/**
+ * @brief: Updates a CRC-32 (IEEE, reflected), without the final inversion
+ *
+ * @param[in]: logCrc
+ * @param[in]: data
+ * @param[in]: len
+ * @return[out]: uint32_t
+ **/
+static uint32_t log_crc32(uint32_t logCrc, const void *data, uint32_t len) {
+  const uint8_t *logBytes = (const uint8_t *)data;
+  uint32_t bitIdx = 0U;
+
+  while (len--) {
+    logCrc ^= *logBytes++;
+
+    for (bitIdx = 0U; bitIdx < 8U; bitIdx++) {
+      logCrc = (logCrc >> 1U) ^ (0xEDB88320U & (0U - (logCrc & 1U)));
+    }
+  }
+
+  return logCrc;
+}
@@ -1 +1,262 @@
+/**
+ * @file log.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Deferred binary logger
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
 
+#ifndef LOG_H
+#define LOG_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* MCU includes */
+#include <stm32f4xx_ll_cortex.h>
+
+/* Module includes */
+#include <ttys.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Number of records in the ring, must be a power of 2
+#ifndef LOG_NUM_RECORDS
+#define LOG_NUM_RECORDS 128U
+#endif
+
+#define LOG_MAX_ARGS 4U
+
+// Format strings are kept in their own flash section. The address of the
+// string is the ID recorded at the call site, so a host decoder only needs
+// the ELF to map IDs back to format strings.
+#ifndef LOG_STR_SECTION
+#define LOG_STR_SECTION ".rodata.log"
+#endif
+
+// Bounds of the format string section, from the linker script:
+//   .rodata.log : { __log_fmt_start = .; KEEP(*(.rodata.log))
+//                   __log_fmt_end = .; } > FLASH
+// Retained records are only replayed if the section is unchanged since they
+// were written, and only through pointers inside it.
+#ifndef LOG_FMT_START
+extern const char __log_fmt_start[];
+extern const char __log_fmt_end[];
+#define LOG_FMT_START (__log_fmt_start)
+#define LOG_FMT_END (__log_fmt_end)
+#endif
+
+// Mixed into the image ID, e.g. -DLOG_BUILD_ID=0x$(git rev-parse --short HEAD)
+#ifndef LOG_BUILD_ID
+#define LOG_BUILD_ID 0U
+#endif
+
+// The ring lives in a section that the startup code does not zero, so it
+// survives a reset. The linker script needs a NOLOAD .noinit output section.
+#define LOG_RING_SECTION ".noinit"
+#define LOG_RING_MAGIC 0x4C4F4752U  // "LOGR"
+#define LOG_FAULT_MAGIC 0x4C4F4746U // "LOGF"
+
+// The HardFault_Handler defined here is weak, so a handler defined by the
+// application (e.g. CubeMX's stm32f4xx_it.c) takes precedence and should call
+// log_fault_capture() itself. Define as 0 to leave it out altogether.
+#ifndef LOG_FAULT_HANDLER
+#define LOG_FAULT_HANDLER 1
+#endif
+
+// Argument counting (0 to LOG_MAX_ARGS, more fails the build)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+// Missing arguments are padded with 0. Through uintptr_t, so %s arguments
+// also build on 64 bit hosts.
+#define LOG_ARG(_x) ((uint32_t)(uintptr_t)(_x))
+#define LOG_ARGS_(_z, _a, _b, _c, _d, ...) \
+  LOG_ARG(_a), LOG_ARG(_b), LOG_ARG(_c), LOG_ARG(_d)
+#define LOG_ARGS(...) LOG_ARGS_(0, ##__VA_ARGS__, 0U, 0U, 0U, 0U)
+
+//
+// Levels and modules. Every statement carries a level and a module, and is
+// compiled in only if its level is at or below the module's LOG_LEVEL_MAX_x.
+// Statements above the module's LOG_LEVEL_DEFAULT_x are compiled in but only
+// recorded while the module's bit is set in the runtime verbose mask, so the
+// verbosity can be raised in the field without rebuilding. Filtering is done
+// with constant expressions, so disabled statements (including their format
+// strings) are removed by the compiler. The strings only go with -Og or
+// above: at -O0 GCC keeps unreferenced static consts.
+//
+#define LOG_LEVEL_NONE 0U
+#define LOG_LEVEL_ERROR 1U
+#define LOG_LEVEL_WARN 2U
+#define LOG_LEVEL_INFO 3U
+#define LOG_LEVEL_DEBUG 4U
+#define LOG_LEVEL_TRACE 5U
+
+#define LOG_MOD_APP 0U
+#define LOG_MOD_TMR 1U
+#define LOG_MOD_TTYS 2U
+#define LOG_MOD_GPIO 3U
+#define LOG_NUM_MODULES 4U
+
+// Highest level compiled in
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX LOG_LEVEL_DEBUG
+#endif
+#ifndef LOG_LEVEL_MAX_APP
+#define LOG_LEVEL_MAX_APP LOG_LEVEL_MAX
+#endif
+#ifndef LOG_LEVEL_MAX_TMR
+#define LOG_LEVEL_MAX_TMR LOG_LEVEL_MAX
+#endif
+#ifndef LOG_LEVEL_MAX_TTYS
+#define LOG_LEVEL_MAX_TTYS LOG_LEVEL_MAX
+#endif
+#ifndef LOG_LEVEL_MAX_GPIO
+#define LOG_LEVEL_MAX_GPIO LOG_LEVEL_MAX
+#endif
+
+// Highest level recorded without the runtime verbose override
+#ifndef LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_WARN
+#endif
+#ifndef LOG_LEVEL_DEFAULT_APP
+#define LOG_LEVEL_DEFAULT_APP LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_DEFAULT_TMR
+#define LOG_LEVEL_DEFAULT_TMR LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_DEFAULT_TTYS
+#define LOG_LEVEL_DEFAULT_TTYS LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_DEFAULT_GPIO
+#define LOG_LEVEL_DEFAULT_GPIO LOG_LEVEL_DEFAULT
+#endif
+
+#define LOG_IS_ENABLED(mod, lvl)                  \
+  ((lvl) <= LOG_LEVEL_MAX_##mod &&                 \
+   ((lvl) <= LOG_LEVEL_DEFAULT_##mod ||            \
+    (logVerboseMsk & (1U << LOG_MOD_##mod)) != 0U))
+
+//
+// Records a log statement. Only the format string ID, a cycle timestamp and
+// up to LOG_MAX_ARGS raw 32 bit arguments are stored, formatting is done
+// later by log_flush() or on the host. Arguments are cast to uint32_t, so
+// doubles are not supported and %s arguments must point at strings that
+// outlive the record (e.g. string literals).
+//
+#define LOG(fmt, ...)                                                       \
+  do {                                                                      \
+    _Static_assert(LOG_NARGS(__VA_ARGS__) <= LOG_MAX_ARGS,                  \
+                   "log: too many arguments");                              \
+    static const char logFmt[] __attribute__((section(LOG_STR_SECTION))) = \
+        fmt;                                                                \
+    log_write(logFmt, LOG_NARGS(__VA_ARGS__), LOG_ARGS(__VA_ARGS__));       \
+  } while (0)
+
+#define LOG_AT(mod, lvl, fmt, ...)          \
+  do {                                      \
+    if (LOG_IS_ENABLED(mod, lvl)) {         \
+      LOG(fmt, ##__VA_ARGS__);              \
+    }                                       \
+  } while (0)
+
+#define LOG_ERR(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_WRN(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_INF(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_DBG(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_TRC(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Error Codes */
+typedef enum {
+
+  LOG_ERR_IDX = 0x70U,
+  LOG_ERR_MOD,
+  LOG_ERR_NO_FAULT,
+
+} log_errors_t;
+
+/* Log record */
+typedef struct {
+  const char *volatile logFmt;  // Written last, NULL while the slot is filled
+  uint32_t logTime;
+  uint32_t logNumArgs;
+  uint32_t logArgs[LOG_MAX_ARGS];
+
+} log_record_t;
+
+/* Fault registers captured by the HardFault handler */
+typedef struct {
+  uint32_t faultMagic;  // LOG_FAULT_MAGIC when the capture is valid
+  uint32_t faultCfsr;
+  uint32_t faultHfsr;
+  uint32_t faultMmfar;
+  uint32_t faultBfar;
+  uint32_t faultPc;
+  uint32_t faultLr;
+  uint32_t faultPsr;
+
+} log_fault_t;
+
+/* Log ring, written by any context and read by log_flush()/log_dump() */
+typedef struct {
+  uint32_t logMagic;
+  uint32_t logSize;
+  uint32_t logImageId;  // Format section and build ID the records refer to
+  log_fault_t logFault;
+  uint32_t logCrc;  // CRC-32 of the fields above
+
+  volatile uint32_t logHead;
+  volatile uint32_t logTail;
+  volatile uint32_t logDrops;
+
+  log_record_t logRecords[LOG_NUM_RECORDS];
+
+} log_ring_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) variables
+////////////////////////////////////////////////////////////////////////////////
+
+// Bit n set: module n records up to its LOG_LEVEL_MAX_x
+extern volatile uint32_t logVerboseMsk;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Core API */
+uint32_t log_init(void);
+void log_write(const char *logFmt, uint32_t logNumArgs, uint32_t logArg0,
+               uint32_t logArg1, uint32_t logArg2, uint32_t logArg3);
+
+/* Deferred output */
+uint32_t log_flush(uint32_t maxRecords);
+uint32_t log_dump(uint32_t ttysInstIdx, uint32_t maxRecords);
+
+/* Crash persistence */
+uint32_t log_get_fault(log_fault_t *logFault);
+uint32_t log_postmortem(uint32_t ttysInstIdx);
+void log_fault_capture(const uint32_t *faultFrame);
+
+/* Other API */
+uint32_t log_get_drops(void);
+uint32_t log_set_verbose(uint32_t logMod, bool isVerbose);
+
+#endif  // log.h
@@ -0,0 +1,225 @@
+/**
+ * @file pcs.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Statistical PC-sampling profiler
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <pcs.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function declarations
+////////////////////////////////////////////////////////////////////////////////
+static void pcs_sample(void);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+static const pcs_config_t *pcsConfig;
+static tmr_config_t pcsTmrConfig;
+
+static uint32_t pcsShift;
+static uint32_t pcsBins[PCS_NUM_BINS];
+
+static volatile uint32_t pcsNumSamples;
+static volatile uint32_t pcsNumOutside;
+static volatile uint32_t pcsMaxCycles;
+static volatile uint64_t pcsTotalCycles;
+static bool pcsIsRunning;
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Sets up the sampler's tmr instance and picks the smallest bin size
+ *         that covers the code range with PCS_NUM_BINS bins
+ *
+ * @param[in]: pcsCfg
+ * @return[out]: uint32_t
+ **/
+uint32_t pcs_init(const pcs_config_t *pcsCfg) {
+  if (pcsCfg == NULL || pcsCfg->tmrIdx >= TMR_NUM_INSTANCES) {
+    return PCS_ERR_CONFIG;
+  }
+  if (pcsCfg->pcsEnd <= pcsCfg->pcsStart) return PCS_ERR_RANGE;
+  if (pcsCfg->pcsPeriodUs < PCS_MIN_PERIOD_US) return PCS_ERR_PERIOD;
+  if (pcsIsRunning) return PCS_ERR_RUNNING;
+
+  // The sampler preempts the code it profiles, including the other tmrs
+  pcsTmrConfig.tmrInstancesId = pcsCfg->tmrIdx;
+  pcsTmrConfig.tmrBaseUnit = TMR_BASE_1US;
+  pcsTmrConfig.tmrPriority = TMR_PRIORITY_HIGH;
+
+  if (tmr_init(&pcsTmrConfig) != TMR_RETURN_SUCCESS) return PCS_ERR_CONFIG;
+
+  pcsShift = 0U;
+  while (((pcsCfg->pcsEnd - pcsCfg->pcsStart - 1U) >> pcsShift) >=
+         PCS_NUM_BINS) {
+    pcsShift++;
+  }
+
+  // Enabling the cycle counter used for the overhead figures
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  pcsConfig = pcsCfg;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Clears the histogram and starts sampling
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t pcs_start(void) {
+  if (pcsConfig == NULL) return PCS_ERR_CONFIG;
+  if (pcsIsRunning) return PCS_ERR_RUNNING;
+
+  (void)memset(pcsBins, 0U, sizeof(pcsBins));
+  pcsNumSamples = 0U;
+  pcsNumOutside = 0U;
+  pcsMaxCycles = 0U;
+  pcsTotalCycles = 0U;
+
+  if (tmr_open(pcsConfig->tmrIdx, pcs_sample, pcsConfig->pcsPeriodUs) !=
+      TMR_RETURN_SUCCESS) {
+    return PCS_ERR_CONFIG;
+  }
+
+  pcsIsRunning = true;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Stops sampling, the histogram is kept for pcs_dump()
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t pcs_stop(void) {
+  if (!pcsIsRunning) return PCS_ERR_NOT_RUNNING;
+
+  (void)tmr_close(pcsConfig->tmrIdx);
+  pcsIsRunning = false;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Returns the sample counts and the sampler's own overhead
+ *
+ * @param[out]: pcsStatus
+ * @return[out]: uint32_t
+ **/
+uint32_t pcs_get_status(pcs_status_t *pcsStatus) {
+  if (pcsStatus == NULL || pcsConfig == NULL) return PCS_ERR_CONFIG;
+
+  __disable_irq();
+  pcsStatus->numSamples = pcsNumSamples;
+  pcsStatus->numOutside = pcsNumOutside;
+  pcsStatus->maxCycles = pcsMaxCycles;
+  pcsStatus->totalCycles = pcsTotalCycles;
+  __enable_irq();
+
+  pcsStatus->pcsShift = pcsShift;
+  pcsStatus->isRunning = pcsIsRunning;
+
+  // Elapsed cycles, derived from the number of sampling periods
+  uint64_t pcsElapsed = (uint64_t)pcsStatus->numSamples *
+                        pcsConfig->pcsPeriodUs * (SystemCoreClock / 1000000U);
+
+  pcsStatus->overheadPpm =
+      (pcsElapsed == 0U)
+          ? 0U
+          : (uint32_t)((pcsStatus->totalCycles * 1000000U) / pcsElapsed);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Streams the histogram over a ttys instance. Only the bins that
+ *         were hit are sent.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: uint32_t
+ **/
+uint32_t pcs_dump(uint32_t ttysInstIdx) {
+  pcs_status_t pcsStatus;
+  uint32_t binIdx = 0U;
+  uint16_t numUsed = 0U;
+
+  if (pcsConfig == NULL) return PCS_ERR_CONFIG;
+  if (pcsIsRunning) return PCS_ERR_RUNNING;
+
+  (void)pcs_get_status(&pcsStatus);
+
+  for (binIdx = 0U; binIdx < PCS_NUM_BINS; binIdx++) {
+    if (pcsBins[binIdx] != 0U) numUsed++;
+  }
+
+  const uint8_t pcsVersion = PCS_DUMP_VERSION;
+  const uint8_t pcsShiftByte = (uint8_t)pcsShift;
+
+  // Header
+  (void)ttys_write(ttysInstIdx, PCS_DUMP_MAGIC, 3U);
+  (void)ttys_write(ttysInstIdx, &pcsVersion, 1U);
+  (void)ttys_write(ttysInstIdx, &pcsConfig->pcsStart, 4U);
+  (void)ttys_write(ttysInstIdx, &pcsShiftByte, 1U);
+  (void)ttys_write(ttysInstIdx, &pcsConfig->pcsPeriodUs, 4U);
+  (void)ttys_write(ttysInstIdx, &pcsStatus.numSamples, 4U);
+  (void)ttys_write(ttysInstIdx, &pcsStatus.numOutside, 4U);
+  (void)ttys_write(ttysInstIdx, &pcsStatus.maxCycles, 4U);
+  (void)ttys_write(ttysInstIdx, &pcsStatus.overheadPpm, 4U);
+  (void)ttys_write(ttysInstIdx, &numUsed, 2U);
+
+  // Bins
+  for (binIdx = 0U; binIdx < PCS_NUM_BINS; binIdx++) {
+    if (pcsBins[binIdx] == 0U) continue;
+
+    const uint16_t pcsBinIdx = (uint16_t)binIdx;
+    (void)ttys_write(ttysInstIdx, &pcsBinIdx, 2U);
+    (void)ttys_write_varint(ttysInstIdx, pcsBins[binIdx]);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: tmr callback. Bins the PC stacked when the sampler's IRQ was taken.
+ *         Constant time, so its cost per sample is bounded.
+ *
+ * @return[out]: void
+ **/
+static void pcs_sample(void) {
+  uint32_t pcsEntry = DWT->CYCCNT;
+  const uint32_t *pcsFrame = tmr_get_frame(pcsConfig->tmrIdx);
+
+  if (pcsFrame != NULL) {
+    uint32_t pcsOffset = pcsFrame[PCS_FRAME_PC] - pcsConfig->pcsStart;
+
+    // PCs below the start wrap around and fail the check as well
+    if ((pcsOffset >> pcsShift) < PCS_NUM_BINS) {
+      pcsBins[pcsOffset >> pcsShift]++;
+    } else {
+      pcsNumOutside++;
+    }
+  }
+  pcsNumSamples++;
+
+  uint32_t pcsCycles = DWT->CYCCNT - pcsEntry;
+  pcsTotalCycles += pcsCycles;
+  if (pcsCycles > pcsMaxCycles) pcsMaxCycles = pcsCycles;
+}
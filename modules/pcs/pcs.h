@@ -0,0 +1,99 @@
+/**
+ * @file pcs.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Statistical PC-sampling profiler
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef PCS_H
+#define PCS_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* MCU includes */
+#include <stm32f4xx_ll_cortex.h>
+
+/* Module includes */
+#include <tmr.h>
+#include <ttys.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Number of histogram bins, each one covers (1 << pcsShift) bytes of code
+#ifndef PCS_NUM_BINS
+#define PCS_NUM_BINS 512U
+#endif
+
+// Fastest sampling period, bounds the sampler's share of the CPU
+#define PCS_MIN_PERIOD_US 100U
+
+// Index of the stacked PC in the exception frame
+#define PCS_FRAME_PC 6U
+
+// Dump header
+#define PCS_DUMP_MAGIC "PCS"
+#define PCS_DUMP_VERSION 1U
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Error Codes */
+typedef enum {
+
+  PCS_ERR_CONFIG = 0xB0U,
+  PCS_ERR_RANGE,
+  PCS_ERR_PERIOD,
+  PCS_ERR_RUNNING,
+  PCS_ERR_NOT_RUNNING,
+
+} pcs_errors_t;
+
+/* Sampler configuration */
+typedef struct {
+  uint32_t tmrIdx;       // Spare tmr instance, run at TMR_PRIORITY_HIGH
+  uint32_t pcsStart;     // Code range to bin, e.g. the linker's text section
+  uint32_t pcsEnd;
+  uint32_t pcsPeriodUs;  // Sampling period, at least PCS_MIN_PERIOD_US
+
+} pcs_config_t;
+
+/* Sampler status */
+typedef struct {
+  uint32_t numSamples;
+  uint32_t numOutside;    // Samples with a PC outside the binned range
+  uint32_t pcsShift;      // Bin size is (1 << pcsShift) bytes
+  uint32_t maxCycles;     // Longest sampler run
+  uint64_t totalCycles;   // Cycles spent in the sampler
+  uint32_t overheadPpm;   // Sampler cycles per million CPU cycles
+  bool isRunning;
+
+} pcs_status_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Core API */
+uint32_t pcs_init(const pcs_config_t *pcsConfig);
+uint32_t pcs_start(void);
+uint32_t pcs_stop(void);
+
+/* Other API */
+uint32_t pcs_get_status(pcs_status_t *pcsStatus);
+uint32_t pcs_dump(uint32_t ttysInstIdx);
+
+#endif  // pcs.h
@@ -0,0 +1,234 @@
+/**
+ * @file prof.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief IRQ load and CPU utilisation profiler
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <prof.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function declarations
+////////////////////////////////////////////////////////////////////////////////
+static void prof_reset_window(void);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+static prof_vec_stats_t profStats[PROF_NUM_VECS];
+
+// Nesting stack: start cycle of each active frame and the cycles spent in
+// the frames nested inside it
+static uint32_t profStart[PROF_MAX_NEST];
+static uint32_t profChild[PROF_MAX_NEST];
+static uint32_t profDepth;
+
+static uint32_t profWindowStart;
+static uint32_t profReportCycles;
+static uint32_t profCpuHz;
+
+static const char profVecName[PROF_NUM_VECS][10U] = {
+    "TIM2", "TIM3", "TIM4", "USART1", "USART2", "USART6", "CAP_DMA", "IDLE"};
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Starts the DWT cycle counter and the first measurement window
+ *
+ * @param[in]: reportMs. Interval of the table printed by prof_poll(), at most
+ *             (2^32 / cpuHz) seconds
+ * @param[in]: cpuHz. Core clock
+ * @return[out]: uint32_t
+ **/
+uint32_t prof_init(uint32_t reportMs, uint32_t cpuHz) {
+  uint64_t reportCycles = ((uint64_t)cpuHz * reportMs) / 1000U;
+
+  if (cpuHz == 0U || reportCycles == 0U || reportCycles > UINT32_MAX) {
+    return PROF_ERR_CONFIG;
+  }
+
+  profReportCycles = (uint32_t)reportCycles;
+  profCpuHz = cpuHz;
+
+  // Enabling the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  profDepth = 0U;
+  prof_reset_window();
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Opens a profiling frame, called first thing in an ISR
+ *
+ * @return[out]: void
+ **/
+void prof_enter(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (profDepth < PROF_MAX_NEST) {
+    profStart[profDepth] = DWT->CYCCNT;
+    profChild[profDepth] = 0U;
+  }
+  profDepth++;
+
+  __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Closes the current profiling frame and charges its cycles, minus
+ *         the cycles of nested frames, to a vector
+ *
+ * @param[in]: profVec
+ * @return[out]: void
+ **/
+void prof_exit(uint32_t profVec) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  uint32_t profNow = DWT->CYCCNT;
+
+  if (profDepth > 0U) {
+    profDepth--;
+  }
+
+  if (profDepth < PROF_MAX_NEST && profVec < PROF_NUM_VECS) {
+    uint32_t profTotal = profNow - profStart[profDepth];
+    uint32_t profSelf = profTotal - profChild[profDepth];
+    prof_vec_stats_t *profVecStats = &profStats[profVec];
+
+    profVecStats->profCount++;
+    profVecStats->profCycles += profSelf;
+    if (profSelf > profVecStats->profMaxCycles) {
+      profVecStats->profMaxCycles = profSelf;
+    }
+
+    // Charging the whole frame to the one it interrupted
+    if (profDepth > 0U) {
+      profChild[profDepth - 1U] += profTotal;
+    }
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Sleeps until the next interrupt and accounts the time as idle.
+ *         Call from the main loop when there is nothing to do. The ISR that
+ *         wakes the core nests inside the idle frame, so its cycles are not
+ *         counted as idle.
+ *
+ * @return[out]: void
+ **/
+void prof_idle(void) {
+  prof_enter();
+  __DSB();
+  __WFI();
+  prof_exit(PROF_VEC_IDLE);
+}
+
+/**
+ * @brief: Prints the table and starts a new window once the report interval
+ *         has elapsed. Call from the main loop.
+ *
+ * @return[out]: uint32_t. 1 if a report was printed
+ **/
+uint32_t prof_poll(void) {
+  if ((DWT->CYCCNT - profWindowStart) < profReportCycles) return 0U;
+
+  (void)prof_report();
+  return 1U;
+}
+
+/**
+ * @brief: Prints a top-like table of the current window and starts a new
+ *         one. The main loop line is whatever was not spent in a profiled ISR
+ *         or idle.
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t prof_report(void) {
+  prof_vec_stats_t profSnap[PROF_NUM_VECS];
+  uint32_t profVec = 0U;
+  uint64_t profBusy = 0U;
+
+  // Taking a consistent copy of the window
+  __disable_irq();
+  uint32_t profWindow = DWT->CYCCNT - profWindowStart;
+  (void)memcpy(profSnap, profStats, sizeof(profSnap));
+  prof_reset_window();
+  __enable_irq();
+
+  if (profWindow == 0U) return PROF_ERR_CONFIG;
+
+  printf("\n\rVector\t\tCount\tCycles\t\tMax\tCPU%%\n\r");
+  printf("======\t\t=====\t======\t\t===\t====\n\r");
+
+  for (profVec = 0U; profVec < PROF_NUM_VECS; profVec++) {
+    printf("%-8s\t%lu\t%-10llu\t%lu\t%3lu.%02lu\n\r", profVecName[profVec],
+           (unsigned long)profSnap[profVec].profCount,
+           (unsigned long long)profSnap[profVec].profCycles,
+           (unsigned long)profSnap[profVec].profMaxCycles,
+           (unsigned long)((profSnap[profVec].profCycles * 100U) / profWindow),
+           (unsigned long)(((profSnap[profVec].profCycles * 10000U) /
+                            profWindow) %
+                           100U));
+    profBusy += profSnap[profVec].profCycles;
+  }
+
+  // Everything else ran in thread mode
+  uint64_t profMain = (profBusy < profWindow) ? (profWindow - profBusy) : 0U;
+
+  printf("%-8s\t-\t%-10llu\t-\t%3lu.%02lu\n\r", "MAIN",
+         (unsigned long long)profMain,
+         (unsigned long)((profMain * 100U) / profWindow),
+         (unsigned long)(((profMain * 10000U) / profWindow) % 100U));
+  printf("Window: %lu ms\n\r",
+         (unsigned long)(((uint64_t)profWindow * 1000U) / profCpuHz));
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Returns the statistics of a vector for the current window
+ *
+ * @param[in]: profVec
+ * @param[out]: profVecStats
+ * @return[out]: uint32_t
+ **/
+uint32_t prof_get_stats(uint32_t profVec, prof_vec_stats_t *profVecStats) {
+  if (profVec >= PROF_NUM_VECS) return PROF_ERR_VEC;
+  if (profVecStats == NULL) return PROF_ERR_CONFIG;
+
+  __disable_irq();
+  *profVecStats = profStats[profVec];
+  __enable_irq();
+
+  return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Clears the statistics and restarts the window
+ *
+ * @return[out]: void
+ **/
+static void prof_reset_window(void) {
+  (void)memset(profStats, 0U, sizeof(profStats));
+  profWindowStart = DWT->CYCCNT;
+}
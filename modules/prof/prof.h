@@ -0,0 +1,102 @@
+/**
+ * @file prof.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief IRQ load and CPU utilisation profiler
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef PROF_H
+#define PROF_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* MCU includes */
+#include <stm32f4xx_ll_cortex.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Deepest interrupt nesting tracked (idle counts as one level)
+#define PROF_MAX_NEST 8U
+
+//
+// The module ISRs are wrapped with PROF_ISR_ENTER()/PROF_ISR_EXIT(). The
+// profiler is opt-in: unless PROF_ENABLE is defined to 1 the macros are empty
+// and cost nothing.
+//
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 0
+#endif
+
+#if PROF_ENABLE
+#define PROF_ISR_ENTER() prof_enter()
+#define PROF_ISR_EXIT(vec) prof_exit(vec)
+#else
+#define PROF_ISR_ENTER()
+#define PROF_ISR_EXIT(vec)
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Profiled vectors */
+typedef enum {
+
+  PROF_VEC_TIM2,
+  PROF_VEC_TIM3,
+  PROF_VEC_TIM4,
+  PROF_VEC_USART1,
+  PROF_VEC_USART2,
+  PROF_VEC_USART6,
+  PROF_VEC_CAP_DMA,
+  PROF_VEC_IDLE,
+
+  PROF_NUM_VECS
+} prof_vec_t;
+
+/* Error Codes */
+typedef enum {
+
+  PROF_ERR_CONFIG = 0xA0U,
+  PROF_ERR_VEC,
+
+} prof_errors_t;
+
+/* Per-vector statistics over the current window, cycles exclude nested ISRs */
+typedef struct {
+  uint32_t profCount;
+  uint32_t profMaxCycles;
+  uint64_t profCycles;
+
+} prof_vec_stats_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Core API */
+uint32_t prof_init(uint32_t reportMs, uint32_t cpuHz);
+void prof_enter(void);
+void prof_exit(uint32_t profVec);
+void prof_idle(void);
+
+/* Reporting */
+uint32_t prof_poll(void);
+uint32_t prof_report(void);
+uint32_t prof_get_stats(uint32_t profVec, prof_vec_stats_t *profStats);
+
+#endif  // prof.h
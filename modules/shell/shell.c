@@ -0,0 +1,461 @@
+/**
+ * @file shell.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Command shell over ttys with perfect-hash dispatch
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <shell.h>
+
+_Static_assert((SHELL_HASH_SIZE & (SHELL_HASH_SIZE - 1U)) == 0U,
+               "shell: SHELL_HASH_SIZE must be a power of 2");
+_Static_assert(SHELL_HASH_SIZE >= 8U, "shell: SHELL_HASH_SIZE too small");
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function declarations
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t shell_hash(const char *cmdName);
+static uint32_t shell_bucket(uint32_t cmdHash);
+static uint32_t shell_slot(uint32_t cmdHash, uint32_t cmdDisp);
+static bool shell_place_bucket(uint32_t bucketIdx);
+static bool shell_build(void);
+static uint32_t shell_cmd_help(uint32_t argc, char *argv[]);
+static uint32_t shell_cmd_tmr(uint32_t argc, char *argv[]);
+static uint32_t shell_cmd_io(uint32_t argc, char *argv[]);
+static uint32_t shell_cmd_ttys(uint32_t argc, char *argv[]);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) variables
+////////////////////////////////////////////////////////////////////////////////
+static const shell_cmd_t shellBuiltins[] = {
+    {"help", shell_cmd_help, "help: lists the commands"},
+    {"tmr", shell_cmd_tmr, "tmr <idx>: prints the state of a tmr instance"},
+    {"io", shell_cmd_io,
+     "io [<out> <0|1>]: prints the inputs, or sets an output"},
+    {"ttys", shell_cmd_ttys,
+     "ttys <idx>: prints the statistics of an instance"},
+};
+
+#define SHELL_NUM_BUILTINS (sizeof(shellBuiltins) / sizeof(shellBuiltins[0]))
+
+// All commands, built-ins first, and the hashes of their names
+static const shell_cmd_t *shellCmds[SHELL_MAX_CMDS];
+static uint32_t shellHashes[SHELL_MAX_CMDS];
+static uint32_t shellNumCmds;
+
+// Perfect hash: a name's bucket gives the displacement that moves it to its
+// own slot. A slot holds the index of its command plus 1, 0 if unused.
+static uint16_t shellDisp[SHELL_NUM_BUCKETS];
+static uint16_t shellSlots[SHELL_HASH_SIZE];
+
+// Line being typed, tokenised in place when it is run. The line is kept
+// here rather than in the ttys RX ring, since the ring wraps, is refilled by
+// the ISR while a command runs, and backspace edits the line.
+static char shellLine[SHELL_LINE_SIZE];
+static uint32_t shellLen;
+static bool shellLastCr;
+
+static uint32_t shellInst;
+static bool shellIsInit;
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Builds the command table from the built-ins and the application's
+ *         commands, and a perfect hash over their names (hash and
+ *         displace). Lookups then take one pass over the name and one
+ *         compare, however many commands there are.
+ *
+ * @param[in]: ttysInstIdx. Instance the shell reads and echoes on
+ * @param[in]: userCmds. May be NULL if numUserCmds is 0
+ * @param[in]: numUserCmds
+ * @return[out]: uint32_t
+ **/
+uint32_t shell_init(uint32_t ttysInstIdx, const shell_cmd_t *userCmds,
+                    uint32_t numUserCmds) {
+  uint32_t cmdIdx = 0U;
+  uint32_t cmpIdx = 0U;
+
+  if (ttysInstIdx >= TTYS_NUM_INSTANCES) return SHELL_ERR_CONFIG;
+  if (userCmds == NULL && numUserCmds != 0U) return SHELL_ERR_CONFIG;
+  if (SHELL_NUM_BUILTINS + numUserCmds > SHELL_MAX_CMDS) return SHELL_ERR_FULL;
+
+  shellNumCmds = 0U;
+  for (cmdIdx = 0U; cmdIdx < SHELL_NUM_BUILTINS; cmdIdx++) {
+    shellCmds[shellNumCmds++] = &shellBuiltins[cmdIdx];
+  }
+  for (cmdIdx = 0U; cmdIdx < numUserCmds; cmdIdx++) {
+    if (userCmds[cmdIdx].cmdName == NULL || userCmds[cmdIdx].cmdFunc == NULL) {
+      return SHELL_ERR_CONFIG;
+    }
+    shellCmds[shellNumCmds++] = &userCmds[cmdIdx];
+  }
+
+  for (cmdIdx = 0U; cmdIdx < shellNumCmds; cmdIdx++) {
+    shellHashes[cmdIdx] = shell_hash(shellCmds[cmdIdx]->cmdName);
+  }
+
+  // Two commands with the same name collide under every displacement
+  for (cmdIdx = 0U; cmdIdx < shellNumCmds; cmdIdx++) {
+    for (cmpIdx = cmdIdx + 1U; cmpIdx < shellNumCmds; cmpIdx++) {
+      if (strcmp(shellCmds[cmdIdx]->cmdName, shellCmds[cmpIdx]->cmdName) ==
+          0) {
+        return SHELL_ERR_CONFIG;
+      }
+    }
+  }
+
+  if (!shell_build()) return SHELL_ERR_HASH;
+
+  shellInst = ttysInstIdx;
+
+  shellLen = 0U;
+  shellLastCr = false;
+  shellIsInit = true;
+
+  shell_printf("\r\n" SHELL_PROMPT);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Handles the bytes received since the last call: echoes them, edits
+ *         the line and runs it on CR or LF. Call from the main loop.
+ *
+ * @return[out]: uint32_t. Number of lines run
+ **/
+uint32_t shell_poll(void) {
+  uint32_t numRun = 0U;
+  char data = 0;
+
+  if (!shellIsInit) return 0U;
+
+  while ((data = ttys_getc(shellInst)) != 0) {
+    // CR LF counts as one line end
+    if (data == '\n' && shellLastCr) {
+      shellLastCr = false;
+      continue;
+    }
+    shellLastCr = (data == '\r');
+
+    if (data == '\r' || data == '\n') {
+      shellLine[shellLen] = '\0';
+      shell_printf("\r\n");
+
+      (void)shell_exec(shellLine);
+      numRun++;
+
+      shellLen = 0U;
+      shell_printf(SHELL_PROMPT);
+    } else if (data == '\b' || data == 0x7F) {
+      if (shellLen > 0U) {
+        shellLen--;
+        (void)ttys_putc(shellInst, '\b');
+        (void)ttys_putc(shellInst, ' ');
+        (void)ttys_putc(shellInst, '\b');
+      }
+    } else if (data >= ' ' && shellLen < (SHELL_LINE_SIZE - 1U)) {
+      shellLine[shellLen++] = data;
+      (void)ttys_putc(shellInst, data);
+    }
+  }
+
+  return numRun;
+}
+
+/**
+ * @brief: Splits a line into arguments in place (the separators are
+ *         overwritten with NULs) and runs its command.
+ *
+ * @param[in]: cmdLine. Modified
+ * @return[out]: uint32_t. The command's result
+ **/
+uint32_t shell_exec(char *cmdLine) {
+  char *shellArgv[SHELL_MAX_ARGS];
+  uint32_t shellArgc = 0U;
+  char *shellPos = cmdLine;
+
+  if (cmdLine == NULL) return SHELL_ERR_CONFIG;
+
+  while (*shellPos != '\0') {
+    // Skipping the separators
+    while (*shellPos == ' ' || *shellPos == '\t') *shellPos++ = '\0';
+    if (*shellPos == '\0') break;
+
+    if (shellArgc == SHELL_MAX_ARGS) {
+      shell_printf("too many arguments\r\n");
+      return SHELL_ERR_ARGS;
+    }
+    shellArgv[shellArgc++] = shellPos;
+
+    while (*shellPos != '\0' && *shellPos != ' ' && *shellPos != '\t') {
+      shellPos++;
+    }
+  }
+
+  if (shellArgc == 0U) return EXIT_SUCCESS;
+
+  const shell_cmd_t *shellCmd = shell_find(shellArgv[0]);
+  if (shellCmd == NULL) {
+    shell_printf("%s: command not found\r\n", shellArgv[0]);
+    return SHELL_ERR_UNKNOWN;
+  }
+
+  uint32_t shellErr = shellCmd->cmdFunc(shellArgc, shellArgv);
+  if (shellErr != EXIT_SUCCESS) {
+    shell_printf("error 0x%lx\r\n", (unsigned long)shellErr);
+  }
+
+  return shellErr;
+}
+
+/**
+ * @brief: Formats a reply and writes it to the shell's ttys instance. Command
+ *         handlers use this instead of printf(), which goes to the instance
+ *         _write() uses.
+ *
+ * @param[in]: shellFmt
+ * @return[out]: void
+ **/
+void shell_printf(const char *shellFmt, ...) {
+  char shellOut[SHELL_OUT_SIZE];
+  va_list shellArgs;
+  uint32_t outIdx = 0U;
+
+  va_start(shellArgs, shellFmt);
+  int outLen = vsnprintf(shellOut, sizeof(shellOut), shellFmt, shellArgs);
+  va_end(shellArgs);
+
+  if (outLen < 0) return;
+  if ((uint32_t)outLen >= sizeof(shellOut)) outLen = sizeof(shellOut) - 1U;
+
+  for (outIdx = 0U; outIdx < (uint32_t)outLen; outIdx++) {
+    (void)ttys_putc(shellInst, shellOut[outIdx]);
+  }
+}
+
+/**
+ * @brief: Looks a command up by name.
+ *
+ * @param[in]: cmdName
+ * @return[out]: const shell_cmd_t*. NULL if there is no such command
+ **/
+const shell_cmd_t *shell_find(const char *cmdName) {
+  if (!shellIsInit || cmdName == NULL) return NULL;
+
+  uint32_t cmdHash = shell_hash(cmdName);
+  uint32_t shellSlot =
+      shellSlots[shell_slot(cmdHash, shellDisp[shell_bucket(cmdHash)])];
+  if (shellSlot == 0U) return NULL;
+
+  // Names that are not commands can still land on a used slot
+  const shell_cmd_t *shellCmd = shellCmds[shellSlot - 1U];
+  if (strcmp(shellCmd->cmdName, cmdName) != 0) return NULL;
+
+  return shellCmd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: FNV-1a of a name, both hash levels are derived from it.
+ *
+ * @param[in]: cmdName
+ * @return[out]: uint32_t
+ **/
+static uint32_t shell_hash(const char *cmdName) {
+  uint32_t cmdHash = 2166136261U;
+
+  while (*cmdName != '\0') {
+    cmdHash ^= (uint8_t)*cmdName++;
+    cmdHash *= 16777619U;
+  }
+
+  return cmdHash;
+}
+
+/**
+ * @brief: First level, the bucket of a name.
+ *
+ * @param[in]: cmdHash
+ * @return[out]: uint32_t
+ **/
+static uint32_t shell_bucket(uint32_t cmdHash) {
+  return (cmdHash ^ (cmdHash >> 16U)) & (SHELL_NUM_BUCKETS - 1U);
+}
+
+/**
+ * @brief: Second level, the slot of a name under a displacement. The
+ *         displacement is mixed in before a full avalanche (the murmur3
+ *         finaliser), so each one gives an independent placement.
+ *
+ * @param[in]: cmdHash
+ * @param[in]: cmdDisp
+ * @return[out]: uint32_t
+ **/
+static uint32_t shell_slot(uint32_t cmdHash, uint32_t cmdDisp) {
+  cmdHash ^= cmdDisp;
+  cmdHash *= 0x85EBCA6BU;
+  cmdHash ^= cmdHash >> 13U;
+  cmdHash *= 0xC2B2AE35U;
+  cmdHash ^= cmdHash >> 16U;
+
+  return cmdHash & (SHELL_HASH_SIZE - 1U);
+}
+
+/**
+ * @brief: Finds a displacement that puts every command of a bucket in a
+ *         free slot, and takes the slots.
+ *
+ * @param[in]: bucketIdx
+ * @return[out]: bool. false if no displacement fits
+ **/
+static bool shell_place_bucket(uint32_t bucketIdx) {
+  uint32_t cmdDisp = 0U;
+  uint32_t cmdIdx = 0U;
+  uint32_t undoIdx = 0U;
+
+  for (cmdDisp = 1U; cmdDisp <= SHELL_DISP_TRIES; cmdDisp++) {
+    for (cmdIdx = 0U; cmdIdx < shellNumCmds; cmdIdx++) {
+      if (shell_bucket(shellHashes[cmdIdx]) != bucketIdx) continue;
+
+      uint32_t shellSlot = shell_slot(shellHashes[cmdIdx], cmdDisp);
+      if (shellSlots[shellSlot] != 0U) break;
+      shellSlots[shellSlot] = (uint16_t)(cmdIdx + 1U);
+    }
+
+    if (cmdIdx == shellNumCmds) {
+      shellDisp[bucketIdx] = (uint16_t)cmdDisp;
+      return true;
+    }
+
+    // Releasing the slots taken before the collision
+    for (undoIdx = 0U; undoIdx < cmdIdx; undoIdx++) {
+      if (shell_bucket(shellHashes[undoIdx]) != bucketIdx) continue;
+
+      shellSlots[shell_slot(shellHashes[undoIdx], cmdDisp)] = 0U;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief: Builds the perfect hash, placing the fullest buckets first while
+ *         most slots are still free.
+ *
+ * @return[out]: bool. false if a bucket could not be placed
+ **/
+static bool shell_build(void) {
+  uint8_t bucketSize[SHELL_NUM_BUCKETS];
+  uint32_t bucketMax = 0U;
+  uint32_t bucketIdx = 0U;
+  uint32_t cmdIdx = 0U;
+
+  (void)memset(bucketSize, 0U, sizeof(bucketSize));
+  (void)memset(shellSlots, 0U, sizeof(shellSlots));
+  (void)memset(shellDisp, 0U, sizeof(shellDisp));
+
+  for (cmdIdx = 0U; cmdIdx < shellNumCmds; cmdIdx++) {
+    bucketIdx = shell_bucket(shellHashes[cmdIdx]);
+    bucketSize[bucketIdx]++;
+    if (bucketSize[bucketIdx] > bucketMax) bucketMax = bucketSize[bucketIdx];
+  }
+
+  for (; bucketMax > 0U; bucketMax--) {
+    for (bucketIdx = 0U; bucketIdx < SHELL_NUM_BUCKETS; bucketIdx++) {
+      if (bucketSize[bucketIdx] != bucketMax) continue;
+      if (!shell_place_bucket(bucketIdx)) return false;
+    }
+  }
+
+  return true;
+}
+
+/* Built-in commands */
+
+/**
+ * @brief: help, prints the help line of every command
+ **/
+static uint32_t shell_cmd_help(uint32_t argc, char *argv[]) {
+  uint32_t cmdIdx = 0U;
+
+  (void)argc;
+  (void)argv;
+
+  for (cmdIdx = 0U; cmdIdx < shellNumCmds; cmdIdx++) {
+    shell_printf("%s\r\n", (shellCmds[cmdIdx]->cmdHelp != NULL)
+                               ? shellCmds[cmdIdx]->cmdHelp
+                               : shellCmds[cmdIdx]->cmdName);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: tmr <idx>, prints the state of a tmr instance
+ **/
+static uint32_t shell_cmd_tmr(uint32_t argc, char *argv[]) {
+  tmr_info_t tmrInfo;
+
+  if (argc != 2U) return SHELL_ERR_ARGS;
+
+  uint32_t tmrIdx = (uint32_t)strtoul(argv[1], NULL, 0);
+  uint32_t tmrErr = tmr_get_info(tmrIdx, &tmrInfo);
+  if (tmrErr != TMR_RETURN_SUCCESS) return tmrErr;
+
+  shell_printf("tmr %lu time %lu running %u encoder %u cascaded %u\r\n",
+               (unsigned long)tmrIdx, (unsigned long)tmrInfo.tmrTime,
+               tmrInfo.isTmrRunning, tmrInfo.isEncoder, tmrInfo.isCascaded);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: io, prints the inputs as an io_snapshot() bitmap.
+ *         io <out> <0|1>, sets an output.
+ **/
+static uint32_t shell_cmd_io(uint32_t argc, char *argv[]) {
+  if (argc == 1U) {
+    shell_printf("inputs 0x%08lx\r\n", (unsigned long)io_snapshot());
+    return EXIT_SUCCESS;
+  }
+  if (argc != 3U) return SHELL_ERR_ARGS;
+
+  return io_set_val((uint32_t)strtoul(argv[1], NULL, 0),
+                    (uint32_t)strtoul(argv[2], NULL, 0));
+}
+
+/**
+ * @brief: ttys <idx>, prints the statistics of a ttys instance
+ **/
+static uint32_t shell_cmd_ttys(uint32_t argc, char *argv[]) {
+  ttys_stats_t ttysStats;
+
+  if (argc != 2U) return SHELL_ERR_ARGS;
+
+  uint32_t ttysErr =
+      ttys_get_stats((uint32_t)strtoul(argv[1], NULL, 0), &ttysStats);
+  if (ttysErr != EXIT_SUCCESS) return ttysErr;
+
+  shell_printf(
+      "in %lu out %lu drops %lu ore %lu fe %lu ne %lu rxhw %lu txhw %lu\r\n",
+      (unsigned long)ttysStats.bytesIn, (unsigned long)ttysStats.bytesOut,
+      (unsigned long)ttysStats.rxDrops, (unsigned long)ttysStats.oreErrs,
+      (unsigned long)ttysStats.feErrs, (unsigned long)ttysStats.neErrs,
+      (unsigned long)ttysStats.rxHighWater,
+      (unsigned long)ttysStats.txHighWater);
+
+  return EXIT_SUCCESS;
+}
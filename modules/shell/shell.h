@@ -0,0 +1,104 @@
+/**
+ * @file shell.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Command shell over ttys with perfect-hash dispatch
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef SHELL_H
+#define SHELL_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Module includes */
+#include <gpio.h>
+#include <tmr.h>
+#include <ttys.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Longest command line, including the terminating NUL
+#ifndef SHELL_LINE_SIZE
+#define SHELL_LINE_SIZE 80U
+#endif
+
+// Most arguments per command, including the command name
+#ifndef SHELL_MAX_ARGS
+#define SHELL_MAX_ARGS 8U
+#endif
+
+// Hash slots, must be a power of 2. Commands are limited to half the slots
+// and share SHELL_HASH_SIZE / 4 first-level buckets.
+#ifndef SHELL_HASH_SIZE
+#define SHELL_HASH_SIZE 64U
+#endif
+#define SHELL_MAX_CMDS (SHELL_HASH_SIZE / 2U)
+#define SHELL_NUM_BUCKETS (SHELL_HASH_SIZE / 4U)
+
+// Displacements tried per bucket by shell_init()
+#define SHELL_DISP_TRIES 0xFFFFU
+
+#define SHELL_PROMPT "> "
+
+// Longest reply line written by shell_printf(), longer ones are truncated
+#ifndef SHELL_OUT_SIZE
+#define SHELL_OUT_SIZE 128U
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Command handler, argv[0] is the command name */
+typedef uint32_t (*shell_cmd_func)(uint32_t argc, char *argv[]);
+
+/* Error Codes */
+typedef enum {
+
+  SHELL_ERR_CONFIG = 0xD0U,
+  SHELL_ERR_FULL,
+  SHELL_ERR_HASH,
+  SHELL_ERR_ARGS,
+  SHELL_ERR_UNKNOWN,
+
+} shell_errors_t;
+
+/* Command table entry */
+typedef struct {
+  const char *cmdName;
+  shell_cmd_func cmdFunc;
+  const char *cmdHelp;  // One line, shown by help
+
+} shell_cmd_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Core API */
+uint32_t shell_init(uint32_t ttysInstIdx, const shell_cmd_t *userCmds,
+                    uint32_t numUserCmds);
+uint32_t shell_poll(void);
+uint32_t shell_exec(char *cmdLine);
+
+/* Other API */
+const shell_cmd_t *shell_find(const char *cmdName);
+void shell_printf(const char *shellFmt, ...)
+    __attribute__((format(printf, 1, 2)));
+
+#endif  // shell.h
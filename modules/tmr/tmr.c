@@ -13,6 +13,8 @@
 // Includes
 ////////////////////////////////////////////////////////////////////////////////
 #include "tmr.h"
+#include "prof.h"
+#include "trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private (Static) function declarations
@@ -20,6 +22,17 @@
 __STATIC_INLINE void tmr_2_interrupt(void);
 __STATIC_INLINE void tmr_3_interrupt(void);
 __STATIC_INLINE void tmr_4_interrupt(void);
+void tmr_2_irq(void);
+void tmr_3_irq(void);
+void tmr_4_irq(void);
+static void tmr_enc_wrap(tmr_info_t* tmpTmr);
+static int64_t tmr_enc_pos(tmr_info_t* tmpTmr);
+static int32_t tmr_enc_wrap_delta(uint32_t encCnt);
+static uint32_t tmr_group_check(uint32_t tmrIdx);
+static void tmr_group_reset(tmrBase* tmrReg);
+static void tmr_close_inst(tmr_info_t* tmpTmr);
+static uint32_t tmr_next(uint32_t* deadlineUs);
+__STATIC_INLINE void tmr_sleep_wake(uint32_t tmrIdx);
 ////////////////////////////////////////////////////////////////////////////////
 // Private (Static) variables
 ////////////////////////////////////////////////////////////////////////////////
@@ -31,6 +44,48 @@ static uint32_t tmrPrescLookup[TMR_BASE_NUM] = {
 };
 
 static char tmrInstName[4U][7U] = {"Timer2", "Timer3", "Timer4"};
+
+static tmrBase* const tmrRegLookup[TMR_NUM_INSTANCES] = {
+	TMR_TIMER2, TMR_TIMER3, TMR_TIMER4
+};
+
+static const IRQn_Type tmrIrqLookup[TMR_NUM_INSTANCES] = {
+	TIM2_IRQn, TIM3_IRQn, TIM4_IRQn
+};
+
+static const uint32_t tmrEncModeLookup[TMR_ENC_NUM_MODES] = {
+	LL_TIM_ENCODERMODE_X2_TI1,
+	LL_TIM_ENCODERMODE_X2_TI2,
+	LL_TIM_ENCODERMODE_X4_TI12
+};
+
+// Length of one count of each base unit in microseconds (the 1ms base
+// counts in tenths of a millisecond)
+static const uint32_t tmrTickUsLookup[TMR_BASE_NUM] = {1U, 100U};
+
+// Internal trigger that connects a master's TRGO to a slave, indexed
+// [slave][master] (RM0368 TIMx internal trigger connection). The diagonal
+// is never used.
+static const uint32_t tmrItrLookup[TMR_NUM_INSTANCES][TMR_NUM_INSTANCES] = {
+	/* TIM2 slave */ {0U, LL_TIM_TS_ITR2, LL_TIM_TS_ITR3},
+	/* TIM3 slave */ {LL_TIM_TS_ITR1, 0U, LL_TIM_TS_ITR3},
+	/* TIM4 slave */ {LL_TIM_TS_ITR1, LL_TIM_TS_ITR2, 0U},
+};
+
+// Exception frame stacked when each instance's IRQ was taken, set by the
+// naked IRQ shims before the handler body runs
+__attribute__((used)) static const uint32_t* volatile
+	tmrIrqFrame[TMR_NUM_INSTANCES];
+
+// Idle
+static tmr_busy_func tmrBusyFunc[TMR_SLEEP_MAX_HOOKS];
+static uint32_t tmrBusyArg[TMR_SLEEP_MAX_HOOKS];
+static uint32_t tmrNumBusyHooks;
+static tmr_sleep_stats_t tmrSleepStats;
+
+// Instance whose deadline ended the last sleep, its callback measures the
+// wakeup latency. TMR_NUM_INSTANCES when not armed.
+static volatile uint32_t tmrWakeIdx = TMR_NUM_INSTANCES;
 ////////////////////////////////////////////////////////////////////////////////
 // Public (global) variables
 ////////////////////////////////////////////////////////////////////////////////
@@ -111,7 +166,7 @@ uint32_t tmr_init(tmr_config_t* tmrConfig) {
  **/
 uint32_t tmr_open(uint32_t tmrIdx, tmr_cb_func cbFunc, uint32_t time) {
 	/* Checking to see if the tmr idx is valid */
-	if (tmrIdx > TMR_NUM_INSTANCES) return TMR_INVALID_IDX;
+	if (tmrIdx >= TMR_NUM_INSTANCES) return TMR_INVALID_IDX;
 
 	/* Creating a temporary tmr instances, so its easier access the instance */
 	tmr_info_t* tmpTmr = &tmr[tmrIdx];
@@ -246,7 +301,7 @@ uint32_t tmr_open(uint32_t tmrIdx, tmr_cb_func cbFunc, uint32_t time) {
 uint32_t tmr_write(uint32_t tmrIdx, uint32_t time) {
 
 	// Checking to see if the index is valid
-	if (tmrIdx > TMR_NUM_INSTANCES) {
+	if (tmrIdx >= TMR_NUM_INSTANCES) {
 		return TMR_INVALID_IDX; 
 	}
 
@@ -258,6 +313,16 @@ uint32_t tmr_write(uint32_t tmrIdx, uint32_t time) {
 		return TMR_INST_NOTOPEN;
 	}
 
+	// Encoder instances have no time interval
+	if (tmpTmr->isEncoder) {
+		return TMR_INST_IS_ENCODER;
+	}
+
+	// Cascade members are timed by each other
+	if (tmpTmr->isCascaded) {
+		return TMR_INST_IS_CASCADED;
+	}
+
 	// Checking to see if the tmr is running, and then turning it off
 	if(tmpTmr->isTmrRunning){
 		__disable_irq();
@@ -311,37 +376,35 @@ uint32_t tmr_write(uint32_t tmrIdx, uint32_t time) {
 
 /********************** Close function *****************************/
 /**
- * @brief
+ * @brief: Stops an instance and releases it from any encoder, group or
+ *         cascade mode. A cascade is one timer made of two instances, so
+ *         closing either end closes both.
  *
  * @param[in]: tmrIdx
  * @return[out]: uint32_t
  **/
 uint32_t tmr_close(uint32_t tmrIdx) {
-	if (tmrIdx > TMR_NUM_INSTANCES || tmrIdx < 0U) {
+	if (tmrIdx >= TMR_NUM_INSTANCES) {
 		return TMR_INVALID_IDX; 
 	}
 
+	tmr_info_t* tmpTmr = &tmr[tmrIdx];
+
 	/* Disabling Interrutps */
+	uint32_t primask = __get_PRIMASK();
 	__disable_irq();
 
-	tmr_info_t* tmpTmr = &tmr[tmrIdx];
-	if (tmpTmr == NULL) return TMR_CONFIG_NULL;
-
 	if (!tmpTmr->isInstOpen) {
+		__set_PRIMASK(primask);
 		return TMR_INST_NOTOPEN;
 	}
 
-	/* Disabling the counter */
-	LL_TIM_DisableCounter(tmpTmr->tmrReg);
-
-	/* Turning off the interrupt */
-	LL_TIM_DisableIT_UPDATE(tmpTmr->tmrReg);
-
-	tmpTmr->cbFunc = NULL;
-	tmpTmr->isInstOpen = false;
-	tmpTmr->isTmrRunning = false;
+	if (tmpTmr->isCascaded) {
+		tmr_close_inst(&tmr[tmpTmr->cascPartner]);
+	}
+	tmr_close_inst(tmpTmr);
 
-	__enable_irq();
+	__set_PRIMASK(primask);
 
 	return TMR_RETURN_SUCCESS;
 }
@@ -353,7 +416,7 @@ uint32_t tmr_close(uint32_t tmrIdx) {
  * @return[out]: uint32_t
  **/
 uint32_t tmr_read(uint32_t tmrIdx) {
-	if (tmrIdx > TMR_NUM_INSTANCES) {
+	if (tmrIdx >= TMR_NUM_INSTANCES) {
 		return TMR_INVALID_IDX;
 	}
 
@@ -365,48 +428,805 @@ uint32_t tmr_read(uint32_t tmrIdx) {
 
 	printf("\n\rTmr\tOpen\tTime\n\r");
 	printf("===\t====\t====\n\n\r");
-	printf("%s\t%ld\t%ld\n\r", tmrInstName[tmrIdx], (uint32_t)tmpTmr->isInstOpen,
-			tmpTmr->tmrTime);
+	printf("%s\t%lu\t%lu\n\r", tmrInstName[tmrIdx],
+		   (unsigned long)tmpTmr->isInstOpen, (unsigned long)tmpTmr->tmrTime);
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Info Function */
+/**
+ * @brief: Copies the state of the specified tmr, for callers that print it
+ *         somewhere other than stdout
+ *
+ * @param[in]: tmrIdx
+ * @param[out]: tmrInfo
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_get_info(uint32_t tmrIdx, tmr_info_t* tmrInfo) {
+	if (tmrIdx >= TMR_NUM_INSTANCES || tmrInfo == NULL) {
+		return TMR_INVALID_IDX;
+	}
+
+	if (!tmr[tmrIdx].isInstOpen) {
+		return TMR_INST_NOTOPEN;
+	}
+
+	*tmrInfo = tmr[tmrIdx];
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Frame Function */
+/**
+ * @brief: Returns the exception frame stacked when the instance's IRQ was
+ *         taken (r0-r3, r12, lr, pc, xpsr), i.e. the state of the code the
+ *         tmr interrupted. Only valid while the instance's callback runs.
+ *
+ * @param[in]: tmrIdx
+ * @return[out]: const uint32_t*. NULL if the index is invalid
+ **/
+const uint32_t* tmr_get_frame(uint32_t tmrIdx) {
+	if (tmrIdx >= TMR_NUM_INSTANCES) {
+		return NULL;
+	}
+
+	return tmrIrqFrame[tmrIdx];
+}
+
+/* Encoder Open Function */
+/**
+ * @brief: Opens a tmr instance as a quadrature encoder counter. The counter
+ *         is clocked by the TI1/TI2 edges and its wraps are carried into a
+ *         64 bit position by the update IRQ, so no counts are lost however
+ *         fast the axis turns. The instance must have been through
+ *         tmr_init() (only the priority is used) and its CH1/CH2 pins set to
+ *         the timer's alternate function.
+ *
+ * @param[in]: tmrIdx
+ * @param[in]: encConfig
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_open_encoder(uint32_t tmrIdx, const tmr_enc_config_t* encConfig) {
+	/* Checking to see if the tmr idx and the encoder config are valid */
+	if (tmrIdx >= TMR_NUM_INSTANCES) return TMR_INVALID_IDX;
+	if (encConfig == NULL) return TMR_CONFIG_NULL;
+
+	if (encConfig->encMode >= TMR_ENC_NUM_MODES ||
+		encConfig->encFilter > TMR_ENC_FILTER_MAX ||
+		encConfig->encPeriodUs == 0U) {
+		return TMR_INVALID_ENC_CONFIG;
+	}
+
+	tmr_info_t* tmpTmr = &tmr[tmrIdx];
+
+	if (tmpTmr->usrConfig == NULL) return TMR_CONFIG_NULL;
+	if (tmpTmr->isInstOpen) return TMR_INST_ALREADY_OPEN;
+	if (tmpTmr->usrConfig->tmrPriority >= TMR_NUM_PRIORITIES) {
+		return TMR_INVALID_PRIORITY;
+	}
+
+	tmrBase* tmrReg = tmrRegLookup[tmrIdx];
+	IRQn_Type tmrIrq = tmrIrqLookup[tmrIdx];
+
+	tmpTmr->tmrReg = tmrReg;
+	tmpTmr->cbFunc = NULL;
+	tmpTmr->tmrTime = 0U;
+	tmpTmr->encWrapBase = 0;
+	tmpTmr->encLastPos = 0;
+	tmpTmr->encVelocity = 0;
+	tmpTmr->encPeriodUs = encConfig->encPeriodUs;
+	tmpTmr->isEncoder = true;
+
+	/* The encoder edges clock the counter directly */
+	LL_TIM_DisableCounter(tmrReg);
+	LL_TIM_SetPrescaler(tmrReg, 0U);
+	LL_TIM_SetAutoReload(tmrReg, TMR_ENC_ARR);
+	LL_TIM_SetEncoderMode(tmrReg, tmrEncModeLookup[encConfig->encMode]);
+
+	/* TI1 and TI2 from their own pins, through the same filter (the
+	 * LL_TIM_IC_FILTER_x values carry ICxF in their upper half) */
+	uint32_t encFilter = (encConfig->encFilter << TIM_CCMR1_IC1F_Pos) << 16U;
+
+	LL_TIM_IC_SetActiveInput(tmrReg, LL_TIM_CHANNEL_CH1,
+							 LL_TIM_ACTIVEINPUT_DIRECTTI);
+	LL_TIM_IC_SetActiveInput(tmrReg, LL_TIM_CHANNEL_CH2,
+							 LL_TIM_ACTIVEINPUT_DIRECTTI);
+	LL_TIM_IC_SetFilter(tmrReg, LL_TIM_CHANNEL_CH1, encFilter);
+	LL_TIM_IC_SetFilter(tmrReg, LL_TIM_CHANNEL_CH2, encFilter);
+
+	/* Inverting TI1 reverses the counting direction */
+	LL_TIM_IC_SetPolarity(tmrReg, LL_TIM_CHANNEL_CH1,
+						  encConfig->isInverted ? LL_TIM_IC_POLARITY_FALLING
+												: LL_TIM_IC_POLARITY_RISING);
+	LL_TIM_IC_SetPolarity(tmrReg, LL_TIM_CHANNEL_CH2, LL_TIM_IC_POLARITY_RISING);
+	LL_TIM_CC_EnableChannel(tmrReg, LL_TIM_CHANNEL_CH1 | LL_TIM_CHANNEL_CH2);
+
+	/* Counting from 0, the update IRQ fires on every wrap */
+	LL_TIM_SetCounter(tmrReg, 0U);
+	LL_TIM_ClearFlag_UPDATE(tmrReg);
+	LL_TIM_EnableIT_UPDATE(tmrReg);
+
+	NVIC_SetPriority(tmrIrq,
+					 NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0U,
+										 tmpTmr->usrConfig->tmrPriority));
+	NVIC_EnableIRQ(tmrIrq);
+
+	tmpTmr->isInstOpen = true;
+
+	/* Enabling the tmr counter */
+	LL_TIM_EnableCounter(tmrReg);
+
+	/* Setting the tmr running */
+	tmpTmr->isTmrRunning = true;
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Encoder Read Function */
+/**
+ * @brief: Reads the extended position of an encoder instance. Safe to call
+ *         from any context, including tmr callbacks.
+ *
+ * @param[in]: tmrIdx
+ * @param[out]: encPos. Counts since tmr_open_encoder()
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_enc_read(uint32_t tmrIdx, int64_t* encPos) {
+	if (tmrIdx >= TMR_NUM_INSTANCES) return TMR_INVALID_IDX;
+	if (encPos == NULL) return TMR_CONFIG_NULL;
+
+	tmr_info_t* tmpTmr = &tmr[tmrIdx];
+
+	if (!tmpTmr->isInstOpen) return TMR_INST_NOTOPEN;
+	if (!tmpTmr->isEncoder) return TMR_INST_NOT_ENCODER;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	*encPos = tmr_enc_pos(tmpTmr);
+
+	__set_PRIMASK(primask);
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Encoder Sample Function */
+/**
+ * @brief: Updates the velocity estimate from the position change since the
+ *         last call. Call it every encPeriodUs, e.g. from the callback of
+ *         another tmr instance opened with that period.
+ *
+ * @param[in]: tmrIdx
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_enc_sample(uint32_t tmrIdx) {
+	int64_t encPos = 0;
+	uint32_t encErr = tmr_enc_read(tmrIdx, &encPos);
+
+	if (encErr != TMR_RETURN_SUCCESS) return encErr;
+
+	tmr_info_t* tmpTmr = &tmr[tmrIdx];
+	int64_t encDelta = encPos - tmpTmr->encLastPos;
+
+	tmpTmr->encLastPos = encPos;
+	tmpTmr->encVelocity =
+		(int32_t)((encDelta * 1000000) / (int64_t)tmpTmr->encPeriodUs);
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Encoder Velocity Function */
+/**
+ * @brief: Returns the velocity computed by the last tmr_enc_sample().
+ *
+ * @param[in]: tmrIdx
+ * @param[out]: encVelocity. Counts per second, negative when counting down
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_enc_get_velocity(uint32_t tmrIdx, int32_t* encVelocity) {
+	if (tmrIdx >= TMR_NUM_INSTANCES) return TMR_INVALID_IDX;
+	if (encVelocity == NULL) return TMR_CONFIG_NULL;
+
+	tmr_info_t* tmpTmr = &tmr[tmrIdx];
+
+	if (!tmpTmr->isInstOpen) return TMR_INST_NOTOPEN;
+	if (!tmpTmr->isEncoder) return TMR_INST_NOT_ENCODER;
+
+	*encVelocity = tmpTmr->encVelocity;
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Group Start Function */
+/**
+ * @brief: Restarts a group of open instances so that their counters start
+ *         on the same timer clock edge. The master's counter enable is
+ *         routed to the slaves through TRGO/ITR, and the slaves are left in
+ *         trigger mode. Counters and prescalers restart from 0 without
+ *         calling the callbacks.
+ *
+ * @param[in]: masterIdx
+ * @param[in]: slaveMsk. Bit n set: instance n is a slave
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_group_start(uint32_t masterIdx, uint32_t slaveMsk) {
+	uint32_t tmrIdx = 0U;
+	uint32_t tmrErr = TMR_RETURN_SUCCESS;
+
+	/* Checking to see if the master and the slave mask are valid */
+	if (masterIdx >= TMR_NUM_INSTANCES) return TMR_INVALID_IDX;
+	if (slaveMsk == 0U || (slaveMsk >> TMR_NUM_INSTANCES) != 0U ||
+		(slaveMsk & (1U << masterIdx)) != 0U) {
+		return TMR_INVALID_GROUP;
+	}
+
+	uint32_t grpMsk = slaveMsk | (1U << masterIdx);
+
+	for (tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+		if ((grpMsk & (1U << tmrIdx)) == 0U) continue;
+
+		tmrErr = tmr_group_check(tmrIdx);
+		if (tmrErr != TMR_RETURN_SUCCESS) return tmrErr;
+	}
+
+	tmrBase* masterReg = tmr[masterIdx].tmrReg;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	/* Stopping and rewinding the whole group */
+	for (tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+		if ((grpMsk & (1U << tmrIdx)) == 0U) continue;
+
+		tmr_group_reset(tmr[tmrIdx].tmrReg);
+	}
+
+	/* The master's TRGO follows its CEN, MSM delays the master by the
+	 * slaves' trigger latency */
+	LL_TIM_SetTriggerOutput(masterReg, LL_TIM_TRGO_ENABLE);
+	LL_TIM_EnableMasterSlaveMode(masterReg);
+
+	/* The slaves set their own CEN on the rising edge of TRGO */
+	for (tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+		if ((slaveMsk & (1U << tmrIdx)) == 0U) continue;
+
+		LL_TIM_SetTriggerInput(tmr[tmrIdx].tmrReg,
+							   tmrItrLookup[tmrIdx][masterIdx]);
+		LL_TIM_SetSlaveMode(tmr[tmrIdx].tmrReg, LL_TIM_SLAVEMODE_TRIGGER);
+	}
+
+	/* Starting the group */
+	LL_TIM_EnableCounter(masterReg);
+
+	for (tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+		if ((grpMsk & (1U << tmrIdx)) == 0U) continue;
+
+		tmr[tmrIdx].isTmrRunning = true;
+	}
+
+	__set_PRIMASK(primask);
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Cascade Function */
+/**
+ * @brief: Chains two open instances so that the slave counts the master's
+ *         update events. The slave's callback then runs every cascCount
+ *         master periods, which gives periods far beyond 16 bits without
+ *         software overflow counting. The master's callback is no longer
+ *         called, and tmr_write() is refused on both. tmr_close() on either
+ *         instance closes both.
+ *
+ * @param[in]: masterIdx
+ * @param[in]: slaveIdx
+ * @param[in]: cascCount. Master periods per slave period, 1 to
+ *             TMR_CASCADE_MAX
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_cascade(uint32_t masterIdx, uint32_t slaveIdx, uint32_t cascCount) {
+	uint32_t tmrErr = TMR_RETURN_SUCCESS;
+
+	/* Checking to see if the pair and the count are valid */
+	if (masterIdx >= TMR_NUM_INSTANCES || slaveIdx >= TMR_NUM_INSTANCES) {
+		return TMR_INVALID_IDX;
+	}
+	if (masterIdx == slaveIdx || cascCount == 0U ||
+		cascCount > TMR_CASCADE_MAX) {
+		return TMR_INVALID_GROUP;
+	}
+
+	tmrErr = tmr_group_check(masterIdx);
+	if (tmrErr != TMR_RETURN_SUCCESS) return tmrErr;
+
+	tmrErr = tmr_group_check(slaveIdx);
+	if (tmrErr != TMR_RETURN_SUCCESS) return tmrErr;
+
+	tmr_info_t* masterTmr = &tmr[masterIdx];
+	tmr_info_t* slaveTmr = &tmr[slaveIdx];
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	/* The master only clocks the slave, one TRGO pulse per update */
+	LL_TIM_DisableCounter(masterTmr->tmrReg);
+	LL_TIM_DisableIT_UPDATE(masterTmr->tmrReg);
+	LL_TIM_SetTriggerOutput(masterTmr->tmrReg, LL_TIM_TRGO_UPDATE);
+
+	/* The slave counts the pulses (external clock mode 1 from ITR) */
+	LL_TIM_DisableCounter(slaveTmr->tmrReg);
+	LL_TIM_SetPrescaler(slaveTmr->tmrReg, 0U);
+	LL_TIM_SetAutoReload(slaveTmr->tmrReg, cascCount - 1U);
+	LL_TIM_SetTriggerInput(slaveTmr->tmrReg, tmrItrLookup[slaveIdx][masterIdx]);
+	LL_TIM_SetClockSource(slaveTmr->tmrReg, LL_TIM_CLOCKSOURCE_EXT_MODE1);
+
+	tmr_group_reset(masterTmr->tmrReg);
+	tmr_group_reset(slaveTmr->tmrReg);
+
+	masterTmr->isCascaded = true;
+	masterTmr->cascPartner = slaveIdx;
+	slaveTmr->isCascaded = true;
+	slaveTmr->cascPartner = masterIdx;
+	slaveTmr->tmrTime = cascCount;
+
+	/* The slave must be counting before the master's first update */
+	LL_TIM_EnableCounter(slaveTmr->tmrReg);
+	LL_TIM_EnableCounter(masterTmr->tmrReg);
+
+	masterTmr->isTmrRunning = true;
+	slaveTmr->isTmrRunning = true;
+
+	__set_PRIMASK(primask);
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Sleep Hook Function */
+/**
+ * @brief: Registers a function that tmr_sleep_until() asks before sleeping,
+ *         e.g. ttys_is_busy() with a ttys instance index. The CPU does not
+ *         sleep while any hook returns true. Hooks run with interrupts
+ *         disabled and must be short.
+ *
+ * @param[in]: busyFunc
+ * @param[in]: busyArg. Passed to busyFunc
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_sleep_add_hook(tmr_busy_func busyFunc, uint32_t busyArg) {
+	if (busyFunc == NULL) return TMR_INVALID_CBFUNC;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	// Checked with the slot taken, so two callers cannot both get the last
+	if (tmrNumBusyHooks >= TMR_SLEEP_MAX_HOOKS) {
+		__set_PRIMASK(primask);
+		return TMR_SLEEP_NO_HOOK;
+	}
+
+	tmrBusyFunc[tmrNumBusyHooks] = busyFunc;
+	tmrBusyArg[tmrNumBusyHooks] = busyArg;
+	tmrNumBusyHooks++;
+
+	__set_PRIMASK(primask);
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Next Deadline Function */
+/**
+ * @brief: Returns the time until the next callback of any running instance.
+ *         Encoder instances and cascades are not included.
+ *
+ * @param[out]: deadlineUs
+ * @return[out]: uint32_t. TMR_INST_NOTOPEN if no instance has a deadline
+ **/
+uint32_t tmr_next_deadline(uint32_t* deadlineUs) {
+	if (deadlineUs == NULL) return TMR_CONFIG_NULL;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t tmrIdx = tmr_next(deadlineUs);
+
+	__set_PRIMASK(primask);
+
+	return (tmrIdx < TMR_NUM_INSTANCES) ? TMR_RETURN_SUCCESS
+										: TMR_INST_NOTOPEN;
+}
+
+/* Sleep Function */
+/**
+ * @brief: Idles the CPU in WFI until the next interrupt, which at the latest
+ *         is the next tmr deadline. The busy hooks and the deadline are
+ *         checked with interrupts disabled, so an event that arrives in
+ *         between ends the WFI at once instead of being slept through. The
+ *         interrupt that woke the CPU runs before this returns.
+ *
+ * @param[in]: minSleepUs. The CPU stays awake if the next deadline is closer
+ *             than this, e.g. the worst wakeup latency seen so far
+ * @return[out]: uint32_t. TMR_RETURN_SUCCESS if the CPU slept
+ **/
+uint32_t tmr_sleep_until(uint32_t minSleepUs) {
+	uint32_t hookIdx = 0U;
+	uint32_t deadlineUs = UINT32_MAX;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	for (hookIdx = 0U; hookIdx < tmrNumBusyHooks; hookIdx++) {
+		if (tmrBusyFunc[hookIdx](tmrBusyArg[hookIdx])) {
+			tmrSleepStats.numSkipped++;
+			__set_PRIMASK(primask);
+			return TMR_SLEEP_BUSY;
+		}
+	}
+
+	uint32_t tmrIdx = tmr_next(&deadlineUs);
+	if (deadlineUs < minSleepUs) {
+		tmrSleepStats.numSkipped++;
+		__set_PRIMASK(primask);
+		return TMR_SLEEP_SHORT;
+	}
+
+	// The callback of the instance that is due measures the wakeup latency
+	tmrWakeIdx = tmrIdx;
+
+	if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U) {
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	}
+
+	uint32_t sleepStart = DWT->CYCCNT;
+
+	// With PRIMASK set, a pending interrupt still ends the WFI, it is then
+	// taken when PRIMASK is restored
+	PROF_ISR_ENTER();
+	__DSB();
+	__WFI();
+	PROF_ISR_EXIT(PROF_VEC_IDLE);
+
+	tmrSleepStats.idleCycles += DWT->CYCCNT - sleepStart;
+	tmrSleepStats.numSleeps++;
+
+	__set_PRIMASK(primask);
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/* Sleep Statistics Function */
+/**
+ * @brief: Copies the idle statistics. The idle share over a window is the
+ *         change in idleCycles divided by the cycles elapsed.
+ *
+ * @param[out]: sleepStats
+ * @return[out]: uint32_t
+ **/
+uint32_t tmr_get_sleep_stats(tmr_sleep_stats_t* sleepStats) {
+	if (sleepStats == NULL) return TMR_CONFIG_NULL;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	*sleepStats = tmrSleepStats;
+
+	__set_PRIMASK(primask);
 
 	return TMR_RETURN_SUCCESS;
 }
 ////////////////////////////////////////////////////////////////////////////////
 // Private (static) function definitions
 ////////////////////////////////////////////////////////////////////////////////
+/* Tmr idle helpers */
+
+/**
+ * @brief: Finds the running instance with the nearest callback. Must be
+ *         called with interrupts disabled.
+ *
+ * @param[out]: deadlineUs. Left unchanged if no instance has a deadline
+ * @return[out]: uint32_t. The instance, TMR_NUM_INSTANCES if none
+ **/
+static uint32_t tmr_next(uint32_t* deadlineUs) {
+	uint32_t tmrIdx = 0U;
+	uint32_t nextIdx = TMR_NUM_INSTANCES;
+
+	for (tmrIdx = 0U; tmrIdx < TMR_NUM_INSTANCES; tmrIdx++) {
+		tmr_info_t* tmpTmr = &tmr[tmrIdx];
+
+		if (!tmpTmr->isTmrRunning || tmpTmr->cbFunc == NULL ||
+			tmpTmr->isEncoder || tmpTmr->isCascaded) {
+			continue;
+		}
+
+		// Counts left until the update, then in microseconds
+		uint32_t tmrLeft = LL_TIM_GetAutoReload(tmpTmr->tmrReg) -
+						   LL_TIM_GetCounter(tmpTmr->tmrReg) + 1U;
+		uint32_t tmrLeftUs =
+			tmrLeft * tmrTickUsLookup[tmpTmr->usrConfig->tmrBaseUnit];
+
+		if (nextIdx == TMR_NUM_INSTANCES || tmrLeftUs < *deadlineUs) {
+			*deadlineUs = tmrLeftUs;
+			nextIdx = tmrIdx;
+		}
+	}
+
+	return nextIdx;
+}
+
+/**
+ * @brief: Measures the wakeup latency at the entry of the callback whose
+ *         deadline ended the last sleep. The counter restarted from 0 at
+ *         the deadline, so its value is the time since.
+ *
+ * @param[in]: tmrIdx
+ * @return[out]: void
+ **/
+__STATIC_INLINE void tmr_sleep_wake(uint32_t tmrIdx) {
+	if (tmrWakeIdx != tmrIdx) return;
+
+	tmr_info_t* tmpTmr = &tmr[tmrIdx];
+
+	tmrWakeIdx = TMR_NUM_INSTANCES;
+	tmrSleepStats.wakeLatUs =
+		LL_TIM_GetCounter(tmpTmr->tmrReg) *
+		tmrTickUsLookup[tmpTmr->usrConfig->tmrBaseUnit];
+
+	if (tmrSleepStats.wakeLatUs > tmrSleepStats.wakeLatMaxUs) {
+		tmrSleepStats.wakeLatMaxUs = tmrSleepStats.wakeLatUs;
+	}
+}
+
+/* Tmr group helpers */
+
+/**
+ * @brief: Checks that an instance can join a group or a cascade.
+ *
+ * @param[in]: tmrIdx
+ * @return[out]: uint32_t
+ **/
+static uint32_t tmr_group_check(uint32_t tmrIdx) {
+	tmr_info_t* tmpTmr = &tmr[tmrIdx];
+
+	if (!tmpTmr->isInstOpen) return TMR_INST_NOTOPEN;
+	if (tmpTmr->isEncoder) return TMR_INST_IS_ENCODER;
+	if (tmpTmr->isCascaded) return TMR_INST_IS_CASCADED;
+
+	return TMR_RETURN_SUCCESS;
+}
+
+/**
+ * @brief: Stops a counter and restarts its counter and prescaler from 0.
+ *         The update event is generated by software with URS set, so the
+ *         new PSC/ARR are loaded without setting UIF and no callback runs.
+ *         URS is then put back, tmr_write() and the slave mode reset rely
+ *         on the regular update source.
+ *
+ * @param[in]: tmrReg
+ * @return[out]: void
+ **/
+static void tmr_group_reset(tmrBase* tmrReg) {
+	uint32_t updSource = LL_TIM_GetUpdateSource(tmrReg);
+
+	LL_TIM_DisableCounter(tmrReg);
+	LL_TIM_SetUpdateSource(tmrReg, LL_TIM_UPDATESOURCE_COUNTER);
+	LL_TIM_GenerateEvent_UPDATE(tmrReg);
+	LL_TIM_SetUpdateSource(tmrReg, updSource);
+	LL_TIM_SetCounter(tmrReg, 0U);
+}
+
+/**
+ * @brief: Stops one instance and puts its registers back to a plain up
+ *         counter. Must be called with interrupts disabled.
+ *
+ * @param[in]: tmpTmr
+ * @return[out]: void
+ **/
+static void tmr_close_inst(tmr_info_t* tmpTmr) {
+	/* Disabling the counter */
+	LL_TIM_DisableCounter(tmpTmr->tmrReg);
+
+	/* Turning off the interrupt */
+	LL_TIM_DisableIT_UPDATE(tmpTmr->tmrReg);
+	LL_TIM_ClearFlag_UPDATE(tmpTmr->tmrReg);
+
+	/* Releasing the encoder inputs, so the instance can be opened as a tmr */
+	if (tmpTmr->isEncoder) {
+		LL_TIM_CC_DisableChannel(tmpTmr->tmrReg,
+								 LL_TIM_CHANNEL_CH1 | LL_TIM_CHANNEL_CH2);
+		tmpTmr->isEncoder = false;
+	}
+
+	/* Leaving any group, encoder or cascade mode, SMS = 0 is also the
+	 * internal clock */
+	LL_TIM_SetSlaveMode(tmpTmr->tmrReg, LL_TIM_SLAVEMODE_DISABLED);
+	LL_TIM_SetTriggerOutput(tmpTmr->tmrReg, LL_TIM_TRGO_RESET);
+	LL_TIM_DisableMasterSlaveMode(tmpTmr->tmrReg);
+	tmpTmr->isCascaded = false;
+
+	tmpTmr->cbFunc = NULL;
+	tmpTmr->isInstOpen = false;
+	tmpTmr->isTmrRunning = false;
+}
+
+/* Tmr encoder helpers */
+
+/**
+ * @brief: Counts carried by one counter wrap. The direction is taken from
+ *         the half the counter is in rather than from CR1.DIR, so a reversal
+ *         between the wrap and the IRQ is still counted the right way. Two
+ *         wraps before the IRQ runs (the axis dithering across 0) cannot be
+ *         told apart, the input filter and a high priority keep that out.
+ *
+ * @param[in]: encCnt. Counter value after the wrap
+ * @return[out]: int32_t
+ **/
+static int32_t tmr_enc_wrap_delta(uint32_t encCnt) {
+	return (encCnt < (TMR_ENC_WRAP / 2U)) ? (int32_t)TMR_ENC_WRAP
+										  : -(int32_t)TMR_ENC_WRAP;
+}
+
+/**
+ * @brief: Extended position, including a wrap the IRQ has not handled yet.
+ *         Must be called with interrupts disabled.
+ *
+ * @param[in]: tmpTmr
+ * @return[out]: int64_t
+ **/
+static int64_t tmr_enc_pos(tmr_info_t* tmpTmr) {
+	int64_t encPos = tmpTmr->encWrapBase;
+	uint32_t encCnt = LL_TIM_GetCounter(tmpTmr->tmrReg);
+
+	// The counter may have been read before the pending wrap, so it is read
+	// again to match the carried count
+	if (LL_TIM_IsActiveFlag_UPDATE(tmpTmr->tmrReg)) {
+		encCnt = LL_TIM_GetCounter(tmpTmr->tmrReg);
+		encPos += tmr_enc_wrap_delta(encCnt);
+	}
+
+	return encPos + (int64_t)encCnt;
+}
+
+/**
+ * @brief: Update IRQ of an encoder instance, carries the wrap.
+ *
+ * @param[in]: tmpTmr
+ * @return[out]: void
+ **/
+static void tmr_enc_wrap(tmr_info_t* tmpTmr) {
+	__disable_irq();
+
+	if (LL_TIM_IsActiveFlag_UPDATE(tmpTmr->tmrReg)) {
+		LL_TIM_ClearFlag_UPDATE(tmpTmr->tmrReg);
+		tmpTmr->encWrapBase +=
+			tmr_enc_wrap_delta(LL_TIM_GetCounter(tmpTmr->tmrReg));
+	}
+
+	__enable_irq();
+}
+
 /* Tmr interrupt handlers */
+
+//
+// The IRQ vectors are naked shims that record where the exception frame was
+// stacked (MSP or PSP, from bit 2 of EXC_RETURN) and tail-call the handler
+// body, so the callbacks can inspect the interrupted context. Nothing is
+// pushed before the frame is recorded, so it is the hardware frame itself.
+//
+// tmrSlot is the instance index as a literal, it is pasted into the asm
+//
+// The address is built with movw/movt, a naked function has no literal pool
+// for an ldr =sym to land in.
+#if defined(__arm__)
+#define TMR_IRQ_NAKED __attribute__((naked))
+#define TMR_IRQ_SHIM(tmrSlot, body)                  \
+	__asm volatile("tst lr, #4\n"                     \
+	               "ite eq\n"                         \
+	               "mrseq r0, msp\n"                  \
+	               "mrsne r0, psp\n"                  \
+	               "movw r1, #:lower16:tmrIrqFrame\n" \
+	               "movt r1, #:upper16:tmrIrqFrame\n" \
+	               "str r0, [r1, #(4 * " #tmrSlot ")]\n" \
+	               "b " #body "\n")
+#else
+// Host builds (host/sim) have no exception entry to read, the simulator
+// points the MSP at the frame it stacked for the handler
+#define TMR_IRQ_NAKED
+#define TMR_IRQ_SHIM(tmrSlot, body)                                        \
+	do {                                                                   \
+		tmrIrqFrame[tmrSlot] = (const uint32_t*)(uintptr_t)__get_MSP(); \
+		body();                                                            \
+	} while (0)
+#endif
+
+_Static_assert(TMR_INSTANCE2 == 0 && TMR_INSTANCE3 == 1 && TMR_INSTANCE4 == 2,
+               "tmr: IRQ shim slots out of sync with tmr_instances_t");
+
 __STATIC_INLINE void tmr_2_interrupt(void) { tmr[TMR_INSTANCE2].cbFunc(); }
 __STATIC_INLINE void tmr_3_interrupt(void) { tmr[TMR_INSTANCE3].cbFunc(); }
 __STATIC_INLINE void tmr_4_interrupt(void) { tmr[TMR_INSTANCE4].cbFunc(); }
 
 /* TIMER 2 IRQ */
-void TIM2_IRQHandler(void) {
+TMR_IRQ_NAKED void TIM2_IRQHandler(void) {
+	TMR_IRQ_SHIM(0, tmr_2_irq);
+}
+
+void tmr_2_irq(void) {
+	PROF_ISR_ENTER();
+
+	// Encoder instances have no callback, the update is a counter wrap
+	if (tmr[TMR_INSTANCE2].isEncoder) {
+		tmr_enc_wrap(&tmr[TMR_INSTANCE2]);
+		PROF_ISR_EXIT(PROF_VEC_TIM2);
+		return;
+	}
+
 	if (LL_TIM_IsActiveFlag_UPDATE(tmr[TMR_INSTANCE2].tmrReg)) {
 		LL_TIM_ClearFlag_UPDATE(tmr[TMR_INSTANCE2].tmrReg);
 	}
 
 	__disable_irq();
+	tmr_sleep_wake(TMR_INSTANCE2);
+	TRACE(TRACE_EVT_TMR_CB_START, TMR_INSTANCE2, tmr[TMR_INSTANCE2].cbFunc);
 	tmr_2_interrupt();
+	TRACE(TRACE_EVT_TMR_CB_END, TMR_INSTANCE2, 0U);
 	__enable_irq();
+
+	PROF_ISR_EXIT(PROF_VEC_TIM2);
 }
 
 /* TIMER 3 IRQ */
-void TIM3_IRQHandler(void) {
+TMR_IRQ_NAKED void TIM3_IRQHandler(void) {
+	TMR_IRQ_SHIM(1, tmr_3_irq);
+}
+
+void tmr_3_irq(void) {
+	PROF_ISR_ENTER();
+
+	// Encoder instances have no callback, the update is a counter wrap
+	if (tmr[TMR_INSTANCE3].isEncoder) {
+		tmr_enc_wrap(&tmr[TMR_INSTANCE3]);
+		PROF_ISR_EXIT(PROF_VEC_TIM3);
+		return;
+	}
+
 	if (LL_TIM_IsActiveFlag_UPDATE(tmr[TMR_INSTANCE3].tmrReg)) {
 		LL_TIM_ClearFlag_UPDATE(tmr[TMR_INSTANCE3].tmrReg);
 	}
 
 	__disable_irq();
+	tmr_sleep_wake(TMR_INSTANCE3);
+	TRACE(TRACE_EVT_TMR_CB_START, TMR_INSTANCE3, tmr[TMR_INSTANCE3].cbFunc);
 	tmr_3_interrupt();
+	TRACE(TRACE_EVT_TMR_CB_END, TMR_INSTANCE3, 0U);
 	__enable_irq();
+
+	PROF_ISR_EXIT(PROF_VEC_TIM3);
 }
 
 /* TIMER 4 IRQ */
-void TIM4_IRQHandler(void) {
+TMR_IRQ_NAKED void TIM4_IRQHandler(void) {
+	TMR_IRQ_SHIM(2, tmr_4_irq);
+}
+
+void tmr_4_irq(void) {
+	PROF_ISR_ENTER();
+
+	// Encoder instances have no callback, the update is a counter wrap
+	if (tmr[TMR_INSTANCE4].isEncoder) {
+		tmr_enc_wrap(&tmr[TMR_INSTANCE4]);
+		PROF_ISR_EXIT(PROF_VEC_TIM4);
+		return;
+	}
+
 	if (LL_TIM_IsActiveFlag_UPDATE(tmr[TMR_INSTANCE4].tmrReg)) {
 		LL_TIM_ClearFlag_UPDATE(tmr[TMR_INSTANCE4].tmrReg);
 	}
 
 	__disable_irq();
+	tmr_sleep_wake(TMR_INSTANCE4);
+	TRACE(TRACE_EVT_TMR_CB_START, TMR_INSTANCE4, tmr[TMR_INSTANCE4].cbFunc);
 	tmr_4_interrupt();
+	TRACE(TRACE_EVT_TMR_CB_END, TMR_INSTANCE4, 0U);
 	__enable_irq();
+
+	PROF_ISR_EXIT(PROF_VEC_TIM4);
 }
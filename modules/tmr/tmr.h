@@ -9,6 +9,9 @@
  *
  **/
 
+#ifndef TMR_H
+#define TMR_H
+
 ////////////////////////////////////////////////////////////////////////////////
 // Includes
 ////////////////////////////////////////////////////////////////////////////////
@@ -44,10 +47,24 @@
 #define __SHORT_MAX__ 65535U
 #define TMR_ARR_MAX(var) (var = (var > __SHORT_MAX__) ? (__SHORT_MAX__) : (var))
 
+/* Encoder mode, the counter wraps over the full 16 bits on all instances */
+#define TMR_ENC_ARR 0xFFFFU
+#define TMR_ENC_WRAP (TMR_ENC_ARR + 1U)
+#define TMR_ENC_FILTER_MAX 15U
+
+/* Cascade, the slave counts up to this many master periods */
+#define TMR_CASCADE_MAX 65536U
+
+/* Idle, number of busy hooks checked before sleeping */
+#ifndef TMR_SLEEP_MAX_HOOKS
+#define TMR_SLEEP_MAX_HOOKS 4U
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // Type definitions
 ////////////////////////////////////////////////////////////////////////////////
 typedef void (*tmr_cb_func)(void);
+typedef bool (*tmr_busy_func)(uint32_t busyArg);
 
 typedef TIM_TypeDef tmrBase;
 
@@ -95,7 +112,15 @@ typedef enum {
 	TMR_INVALID_CBFUNC,
 	TMR_INVALID_PRIORITY,
 	TMR_INST_ALREADY_OPEN,
-	TMR_INST_NOTOPEN
+	TMR_INST_NOTOPEN,
+	TMR_INVALID_ENC_CONFIG,
+	TMR_INST_IS_ENCODER,
+	TMR_INST_NOT_ENCODER,
+	TMR_INVALID_GROUP,
+	TMR_INST_IS_CASCADED,
+	TMR_SLEEP_BUSY,
+	TMR_SLEEP_SHORT,
+	TMR_SLEEP_NO_HOOK
 
 }tmr_func_results_t;
 
@@ -106,6 +131,36 @@ typedef struct {
   uint32_t tmrPriority;
 
 } tmr_config_t;
+
+// Encoder counting mode
+typedef enum {
+
+	TMR_ENC_MODE_TI1,	/* x2, counts the edges of TI1 */
+	TMR_ENC_MODE_TI2,	/* x2, counts the edges of TI2 */
+	TMR_ENC_MODE_TI12,	/* x4, counts the edges of both */
+
+	TMR_ENC_NUM_MODES
+} tmr_enc_mode_t;
+
+/* Encoder config struct */
+typedef struct {
+  uint32_t encMode;
+  uint32_t encFilter;    // Input filter (ICxF, 0 to TMR_ENC_FILTER_MAX)
+  uint32_t encPeriodUs;  // Interval at which tmr_enc_sample() is called
+  bool isInverted;       // Reverses the counting direction
+
+} tmr_enc_config_t;
+
+/* Idle statistics */
+typedef struct {
+  uint64_t idleCycles;    // CPU cycles spent in WFI
+  uint32_t numSleeps;     // Sleeps entered
+  uint32_t numSkipped;    // Sleeps refused by a busy hook or a close deadline
+  uint32_t wakeLatUs;     // Deadline to callback entry, last measured
+  uint32_t wakeLatMaxUs;  // Deadline to callback entry, worst case
+
+} tmr_sleep_stats_t;
+
 /* Instance handler */
 typedef struct {
 	tmr_config_t* usrConfig;
@@ -116,6 +171,17 @@ typedef struct {
 	bool isTmrRunning;
 	bool isInstOpen;
 
+	/* Encoder mode */
+	bool isEncoder;
+	volatile int64_t encWrapBase;  // Counts carried by counter wraps
+	int64_t encLastPos;            // Position at the last tmr_enc_sample()
+	int32_t encVelocity;           // Counts per second
+	uint32_t encPeriodUs;
+
+	/* Master or slave of a cascade */
+	bool isCascaded;
+	uint32_t cascPartner;  // Index of the other end of the cascade
+
 } tmr_info_t;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -129,5 +195,25 @@ uint32_t tmr_open(uint32_t tmrIdx, tmr_cb_func cbFunc, uint32_t time);
 uint32_t tmr_write(uint32_t tmrIdx, uint32_t time);
 uint32_t tmr_close(uint32_t tmrIdx);
 
+/* Encoder */
+uint32_t tmr_open_encoder(uint32_t tmrIdx, const tmr_enc_config_t* encConfig);
+uint32_t tmr_enc_read(uint32_t tmrIdx, int64_t* encPos);
+uint32_t tmr_enc_sample(uint32_t tmrIdx);
+uint32_t tmr_enc_get_velocity(uint32_t tmrIdx, int32_t* encVelocity);
+
+/* Groups */
+uint32_t tmr_group_start(uint32_t masterIdx, uint32_t slaveMsk);
+uint32_t tmr_cascade(uint32_t masterIdx, uint32_t slaveIdx, uint32_t cascCount);
+
+/* Idle */
+uint32_t tmr_sleep_add_hook(tmr_busy_func busyFunc, uint32_t busyArg);
+uint32_t tmr_next_deadline(uint32_t* deadlineUs);
+uint32_t tmr_sleep_until(uint32_t minSleepUs);
+uint32_t tmr_get_sleep_stats(tmr_sleep_stats_t* sleepStats);
+
 /* Other */
 uint32_t tmr_read(uint32_t tmrIdx);
+uint32_t tmr_get_info(uint32_t tmrIdx, tmr_info_t* tmrInfo);
+const uint32_t* tmr_get_frame(uint32_t tmrIdx);
+
+#endif  // tmr.h
@@ -0,0 +1,129 @@
+/**
+ * @file trace.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Event trace recorder
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <trace.h>
+#include <ttys.h>
+
+_Static_assert((TRACE_NUM_RECORDS & (TRACE_NUM_RECORDS - 1U)) == 0U,
+               "trace: TRACE_NUM_RECORDS must be a power of 2");
+_Static_assert(sizeof(trace_record_t) == 8U, "trace: record is not 8 bytes");
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) variables
+////////////////////////////////////////////////////////////////////////////////
+trace_ring_t traceRing;
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) function definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Starts the DWT cycle counter and clears the ring
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t trace_init(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  (void)memset(&traceRing, 0U, sizeof(traceRing));
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Starts recording, the ring is cleared first
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t trace_start(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  traceRing.traceHead = 0U;
+  traceRing.traceLast = DWT->CYCCNT;
+  traceRing.traceIsOn = true;
+
+  __set_PRIMASK(primask);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Stops recording and freezes the ring, e.g. right after a latency
+ *         spike was detected
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t trace_stop(void) {
+  traceRing.traceIsOn = false;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Streams the ring over a ttys instance, oldest record first.
+ *         Recording must be stopped.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: uint32_t
+ **/
+uint32_t trace_dump(uint32_t ttysInstIdx) {
+  uint32_t traceIdx = 0U;
+
+  if (traceRing.traceIsOn) return TRACE_ERR_RUNNING;
+
+  uint32_t traceCount = (traceRing.traceHead < TRACE_NUM_RECORDS)
+                            ? traceRing.traceHead
+                            : TRACE_NUM_RECORDS;
+  uint32_t traceFirst = traceRing.traceHead - traceCount;
+
+  const uint8_t traceVersion = TRACE_DUMP_VERSION;
+  const uint8_t traceShift = TRACE_TS_SHIFT;
+
+  // Header
+  (void)ttys_write(ttysInstIdx, TRACE_DUMP_MAGIC, 3U);
+  (void)ttys_write(ttysInstIdx, &traceVersion, 1U);
+  (void)ttys_write(ttysInstIdx, &traceShift, 1U);
+  (void)ttys_write(ttysInstIdx, &SystemCoreClock, 4U);
+  (void)ttys_write(ttysInstIdx, &traceCount, 4U);
+
+  // Records
+  for (traceIdx = 0U; traceIdx < traceCount; traceIdx++) {
+    (void)ttys_write(ttysInstIdx,
+                     &traceRing.traceRecords[(traceFirst + traceIdx) &
+                                             (TRACE_NUM_RECORDS - 1U)],
+                     sizeof(trace_record_t));
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Writes the record carrying a delta that does not fit in 16 bits.
+ *         Called by trace_event() with interrupts disabled.
+ *
+ * @param[in]: traceTicks
+ * @return[out]: void
+ **/
+void trace_dt_overflow(uint32_t traceTicks) {
+  trace_record_t *traceRec =
+      &traceRing.traceRecords[traceRing.traceHead++ &
+                              (TRACE_NUM_RECORDS - 1U)];
+
+  traceRec->traceDt = 0U;
+  traceRec->traceEvt = TRACE_EVT_DT_OVERFLOW;
+  traceRec->traceArg = 0U;
+  traceRec->tracePayload = traceTicks;
+}
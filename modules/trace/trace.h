@@ -0,0 +1,164 @@
+/**
+ * @file trace.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Event trace recorder
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+/* Standard includes */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* MCU includes */
+#include <stm32f4xx_ll_cortex.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common Macros
+////////////////////////////////////////////////////////////////////////////////
+
+//
+// The recorder is opt-in: unless TRACE_ENABLE is defined to 1 the TRACE()
+// statements in the modules compile to nothing.
+//
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 0
+#endif
+
+// Number of records in the ring, must be a power of 2. The ring keeps the
+// most recent records, older ones are overwritten.
+#ifndef TRACE_NUM_RECORDS
+#define TRACE_NUM_RECORDS 256U
+#endif
+
+// Timestamps are CPU cycles >> TRACE_TS_SHIFT. With 4 a tick is 16 cycles
+// (190 ns at 84 MHz) and a 16 bit delta covers 12 ms.
+#ifndef TRACE_TS_SHIFT
+#define TRACE_TS_SHIFT 4U
+#endif
+
+#define TRACE_DT_MAX 0xFFFFU
+
+// Dump header
+#define TRACE_DUMP_MAGIC "TRC"
+#define TRACE_DUMP_VERSION 1U
+
+#if TRACE_ENABLE
+#define TRACE(evt, arg, payload) \
+  trace_event((evt), (uint32_t)(arg), (uint32_t)(payload))
+#else
+#define TRACE(evt, arg, payload) ((void)0)
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Event IDs */
+typedef enum {
+
+  TRACE_EVT_DT_OVERFLOW,    // payload: ticks elapsed before the next record
+  TRACE_EVT_TMR_CB_START,   // arg: tmr instance, payload: callback address
+  TRACE_EVT_TMR_CB_END,     // arg: tmr instance
+  TRACE_EVT_TTYS_RX,        // arg: ttys instance, payload: byte
+  TRACE_EVT_TTYS_RX_OVF,    // arg: ttys instance, payload: USART SR
+  TRACE_EVT_TTYS_TX_START,  // arg: ttys instance, payload: byte
+  TRACE_EVT_TTYS_TX_DONE,   // arg: ttys instance
+  TRACE_EVT_GPIO_EDGE,      // arg: highest changed input, payload: new snapshot
+
+  TRACE_EVT_USER = 0x80U,   // Application events from here on
+
+} trace_evt_t;
+
+/* Error Codes */
+typedef enum {
+
+  TRACE_ERR_RUNNING = 0xC0U,
+
+} trace_errors_t;
+
+/* Trace record, 8 bytes */
+typedef struct {
+  uint16_t traceDt;  // Ticks since the previous record
+  uint8_t traceEvt;
+  uint8_t traceArg;
+  uint32_t tracePayload;
+
+} trace_record_t;
+
+/* Recorder state, only accessed through the functions below */
+typedef struct {
+  uint32_t traceHead;  // Total number of records written
+  uint32_t traceLast;  // Cycle count the previous delta was taken from
+  bool traceIsOn;
+
+  trace_record_t traceRecords[TRACE_NUM_RECORDS];
+
+} trace_ring_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Public (global) variables
+////////////////////////////////////////////////////////////////////////////////
+extern trace_ring_t traceRing;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Core API */
+uint32_t trace_init(void);
+uint32_t trace_start(void);
+uint32_t trace_stop(void);
+uint32_t trace_dump(uint32_t ttysInstIdx);
+
+/* Slow path of trace_event() */
+void trace_dt_overflow(uint32_t traceTicks);
+
+/**
+ * @brief: Records an event. About 20 cycles when the delta fits 16 bits,
+ *         see the trace_event case of bench_modules().
+ *
+ * @param[in]: traceEvt
+ * @param[in]: traceArg
+ * @param[in]: tracePayload
+ * @return[out]: void
+ **/
+__STATIC_INLINE void trace_event(uint32_t traceEvt, uint32_t traceArg,
+                                 uint32_t tracePayload) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (traceRing.traceIsOn) {
+    uint32_t traceTicks =
+        (DWT->CYCCNT - traceRing.traceLast) >> TRACE_TS_SHIFT;
+    traceRing.traceLast += traceTicks << TRACE_TS_SHIFT;
+
+    if (traceTicks > TRACE_DT_MAX) {
+      trace_dt_overflow(traceTicks);
+      traceTicks = 0U;
+    }
+
+    trace_record_t *traceRec =
+        &traceRing.traceRecords[traceRing.traceHead++ &
+                                (TRACE_NUM_RECORDS - 1U)];
+    traceRec->traceDt = (uint16_t)traceTicks;
+    traceRec->traceEvt = (uint8_t)traceEvt;
+    traceRec->traceArg = (uint8_t)traceArg;
+    traceRec->tracePayload = tracePayload;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+#endif  // trace.h
@@ -1,10 +1,21 @@
 #include <ttys.h>
+#include <gpio.h>
+#include <prof.h>
+#include <trace.h>
 
-﻿﻿////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
 // Private (Static) Variables
 ////////////////////////////////////////////////////////////////////////////////
 static ttys_handler_t ttysInstances[TTYS_NUM_INSTANCES];
 static void ttys_interrupt(uint32_t ttysInstId, IRQn_Type irqType);
+static uint32_t ttys_configure(uint32_t ttysInstIdx,
+							   const ttys_config_t* ttysConfig);
+static void ttys_tx_next(uint32_t ttysInstIdx);
+static void ttys_rx_throttle(uint32_t ttysInstIdx);
+static void ttys_rx_release(uint32_t ttysInstIdx);
+static void ttys_tx_poll(uint32_t ttysInstIdx);
+static void ttys_async_complete(ttys_async_t* ttysAsync);
+static void ttys_async_cancel(ttys_async_t* ttysAsync);
 
 ////////////////////////////////////////////////////////////////////////////////
 // Global Function Definitions
@@ -20,7 +31,7 @@ static void ttys_interrupt(uint32_t ttysInstId, IRQn_Type irqType);
  */
 uint32_t ttys_def_init(uint32_t ttysInstIdx) {
 	// Checks to see if the index is valid
-	if (ttysInstIdx > TTYS_NUM_INSTANCES || ttysInstIdx < 0U) return TTYS_ERR_IDX;
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
 
 	// Creates a temporary ttys handler to modify the ttys instances
 	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
@@ -35,15 +46,18 @@ uint32_t ttys_def_init(uint32_t ttysInstIdx) {
 
 /**
  * @brief: This function initialises the ttys instance by setting the rx and tx
- * buffers to 0 and setting the index values to 0.
+ * buffers to 0 and setting the index values to 0. With a config the USART
+ * clock, frame format and baud rate are set up as well, without one the
+ * USART is left as the startup code configured it.
  *
  * @param[in]: ttysInstIdx
+ * @param[in]: ttysConfig. Can be NULL
  * @return[out]: uint32_t
  **/
-uint32_t ttys_init(uint32_t ttysInstIdx) {
+uint32_t ttys_init(uint32_t ttysInstIdx, const ttys_config_t* ttysConfig) {
 	
 	// Checking to see if the index is valid
-	if (ttysInstIdx > TTYS_NUM_INSTANCES || ttysInstIdx < 0U) return TTYS_ERR_IDX;
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
 	
 	// Creating a temporary ttys handler to modify the ttys instances
 	ttys_handler_t* ttysTmp = NULL;
@@ -81,7 +95,24 @@ uint32_t ttys_init(uint32_t ttysInstIdx) {
 	(void)memset(ttysTmp->rxBuffer, 0U, MAX_BUFFER_SIZE);
 	(void)memset(ttysTmp->txBuffer, 0U, MAX_BUFFER_SIZE);
 
-	return EXIT_SUCCESS;
+	// Clearing the statistics and the async requests
+	(void)memset(&ttysTmp->ttysStats, 0U, sizeof(ttys_stats_t));
+	(void)memset(&ttysTmp->rxAsync, 0U, sizeof(ttys_async_t));
+	(void)memset(&ttysTmp->txAsync, 0U, sizeof(ttys_async_t));
+	ttysTmp->rxHook = NULL;
+	ttysTmp->rxHookCtx = NULL;
+
+	// Flow control is off unless the config turns it on
+	ttysTmp->ttysFlowCtrl = TTYS_FLOW_NONE;
+	ttysTmp->isRxThrottled = false;
+	ttysTmp->isTxPaused = false;
+	ttysTmp->txCtrlChar = 0U;
+	ttysTmp->isRs485 = false;
+	ttysTmp->isRs485Tx = false;
+
+	if (ttysConfig == NULL) return EXIT_SUCCESS;
+
+	return ttys_configure(ttysInstIdx, ttysConfig);
 }
 
 /**
@@ -93,7 +124,7 @@ uint32_t ttys_init(uint32_t ttysInstIdx) {
 uint32_t ttys_start(uint32_t ttysInstIdx) {
 	
 	// Checking to see if the index value is valid.
-	if (ttysInstIdx > TTYS_NUM_INSTANCES || ttysInstIdx < 0U) return TTYS_ERR_IDX;
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
 	
 	// Creating a temporary handler.
 	ttys_handler_t* ttysTmp;
@@ -102,8 +133,10 @@ uint32_t ttys_start(uint32_t ttysInstIdx) {
 	// Init the interrupt type to 0
 	IRQn_Type irqType = 0U;
 
-	// Enabling the TX and RX interrupts for the ttys instances
-	LL_USART_EnableIT_RXNE(ttysTmp->ttysPortx);
+	// Enabling the RX interrupt, unless RTS/CTS is holding the peer off
+	if (!ttysTmp->isRxThrottled) {
+		LL_USART_EnableIT_RXNE(ttysTmp->ttysPortx);
+	}
 
 	// Setting the NVIC IRQ type
 	switch (ttysInstIdx) {
@@ -128,6 +161,9 @@ uint32_t ttys_start(uint32_t ttysInstIdx) {
 	// Enabling the NVIC
 	NVIC_EnableIRQ(irqType);
 
+	// From here on TX is driven by the TXE interrupt
+	ttysTmp->isStarted = true;
+
 	// Returning
 	return EXIT_SUCCESS;
 }
@@ -142,12 +178,27 @@ uint32_t ttys_start(uint32_t ttysInstIdx) {
 uint32_t ttys_close(uint32_t ttysInstIdx) {
 
 	// Checking to see if the index value is valid
-	if (ttysInstIdx > TTYS_NUM_INSTANCES || ttysInstIdx < 0U) return TTYS_ERR_IDX;
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
 	
 	// Creating a temporary ttys handler.
 	ttys_handler_t* tmpTtys;
 	tmpTtys = &ttysInstances[ttysInstIdx];
 
+	// Cancelling the pending async requests
+	(void)ttys_cancel_async(ttysInstIdx, TTYS_ASYNC_RX | TTYS_ASYNC_TX);
+
+	// Stopping the interrupts, an RS-485 transmission releases the bus here
+	if (tmpTtys->ttysPortx != NULL) {
+		LL_USART_DisableIT_RXNE(tmpTtys->ttysPortx);
+		LL_USART_DisableIT_TXE(tmpTtys->ttysPortx);
+		LL_USART_DisableIT_TC(tmpTtys->ttysPortx);
+	}
+	if (tmpTtys->isRs485Tx) {
+		(void)io_set_val(tmpTtys->rs485DeIdx, RESET);
+		tmpTtys->isRs485Tx = false;
+	}
+	tmpTtys->isStarted = false;
+
 	// Clearing the Tx and Rx buffers
 	(void)memset(tmpTtys->rxBuffer, 0U, MAX_BUFFER_SIZE);
 	(void)memset(tmpTtys->txBuffer, 0U, MAX_BUFFER_SIZE);
@@ -162,12 +213,12 @@ uint32_t ttys_close(uint32_t ttysInstIdx) {
  * @brief: Reads in data from the USART port.
  *
  * @param[in]: ttysInstId
- * @return[out]: uint32_t
+ * @return[out]: char. 0 if the RX ring is empty
  **/
 char ttys_getc(uint32_t ttysInstIdx) {
 	char dataRec = 0U;
 
-	if (ttysInstIdx > TTYS_NUM_INSTANCES || ttysInstIdx < 0U) return TTYS_ERR_IDX;
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
 
 	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
 
@@ -175,18 +226,17 @@ char ttys_getc(uint32_t ttysInstIdx) {
 		return EXIT_FAILURE;
 	}
 
-	uint32_t putIdx = ttysTmp->rxPutIdx;
-
-	if (putIdx + 1 > MAX_BUFFER_SIZE - 1) putIdx = 0U;
+	// The ring is empty when both indexes meet
+	uint32_t getIdx = ttysTmp->rxGetIdx;
+	if (getIdx == ttysTmp->rxPutIdx) return dataRec;
 
-	uint32_t getIdx = ttysTmp->rxGetIdx + 1;
-	if (getIdx > MAX_BUFFER_SIZE) getIdx = 0U;
+	getIdx = getIdx + 1;
+	if (getIdx > MAX_BUFFER_SIZE - 1) getIdx = 0U;
 
 	dataRec = ttysTmp->rxBuffer[getIdx];
+	ttysTmp->rxGetIdx = getIdx;
 
-	if (dataRec != 0U) {
-		ttysTmp->rxGetIdx = getIdx;
-	}
+	if (ttysTmp->isRxThrottled) ttys_rx_release(ttysInstIdx);
 
 	return dataRec;
 }
@@ -198,61 +248,580 @@ char ttys_getc(uint32_t ttysInstIdx) {
  * @return[out]: uint32_t
  **/
 uint32_t ttys_read_buf(uint32_t ttysInstIdx) {
-	if (ttysInstIdx > TTYS_NUM_INSTANCES || ttysInstIdx < 0U) return TTYS_ERR_IDX;
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
 
 	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
-	char data;
 
 	if (!ttysTmp->isInstOpen) return EXIT_FAILURE;
 
-	uint32_t getIdx = ttysTmp->rxGetIdx + 1;
-	if (getIdx > MAX_BUFFER_SIZE) getIdx = 0U;
+	return (uint8_t)ttys_getc(ttysInstIdx);
+}
+
+/**
+ * @brief: Queues a byte for transmission, sent by the TXE interrupt. Waits
+ *         while the TX ring is full or an async write is pending, moving
+ *         bytes out by polling so it also works with interrupts masked.
+ *
+ * @param[in]: ttysInstId
+ * @param[in]: data
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_putc(uint32_t ttysInstIdx, char data) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+
+	// Bytes are not interleaved with a pending async write
+	while (ttysTmp->txAsync.isActive) ttys_tx_poll(ttysInstIdx);
 
-	data = ttysTmp->rxBuffer[getIdx];
+	uint32_t txPutIdx = ttysTmp->txPutIdx + 1;
+	if (txPutIdx > MAX_BUFFER_SIZE - 1) txPutIdx = 0U;
 
-	if (data != 0U) {
-		ttysTmp->rxGetIdx = getIdx;
+	// Waiting for room in the TX ring
+	while (txPutIdx == ttysTmp->txGetIdx) ttys_tx_poll(ttysInstIdx);
+
+	ttysTmp->txBuffer[ttysTmp->txPutIdx] = data;
+	ttysTmp->txPutIdx = txPutIdx;
+
+	uint32_t txLevel = TTYS_RING_LEVEL(txPutIdx, ttysTmp->txGetIdx);
+	if (txLevel > ttysTmp->ttysStats.txHighWater) {
+		ttysTmp->ttysStats.txHighWater = txLevel;
 	}
 
-	return data;
+	LL_USART_EnableIT_TXE(ttysTmp->ttysPortx);
+
+	// Without the interrupt the ring is sent right away
+	if (!ttysTmp->isStarted) {
+		while (ttysTmp->txGetIdx != ttysTmp->txPutIdx) {
+			ttys_tx_poll(ttysInstIdx);
+		}
+	}
+
+	return EXIT_SUCCESS;
 }
 
 /**
- * @brief: Transmit data to the USART port.
+ * @brief: Queues a buffer for transmission with ttys_putc(), for the binary
+ *         dumps of the other modules.
  *
- * @param[in]: ttysInstId
+ * @param[in]: ttysInstIdx
  * @param[in]: data
+ * @param[in]: len
  * @return[out]: uint32_t
  **/
-uint32_t ttys_putc(uint32_t ttysInstIdx, char data) {
-	if (ttysInstIdx > TTYS_NUM_INSTANCES || ttysInstIdx < 0U) return TTYS_ERR_IDX;
+uint32_t ttys_write(uint32_t ttysInstIdx, const void* data, uint32_t len) {
+	const uint8_t* ttysBytes = (const uint8_t*)data;
+	uint32_t ttysRet = EXIT_SUCCESS;
+
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+	if (data == NULL && len != 0U) return TTYS_ERR_NULL;
+
+	while (len-- != 0U && ttysRet == EXIT_SUCCESS) {
+		ttysRet = ttys_putc(ttysInstIdx, (char)*ttysBytes++);
+	}
+
+	return ttysRet;
+}
+
+/**
+ * @brief: Queues an unsigned LEB128 varint: 7 bits per byte, least
+ *         significant first, the top bit set on all but the last byte.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: val
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_write_varint(uint32_t ttysInstIdx, uint32_t val) {
+	uint8_t ttysVarint[5U];
+	uint32_t varintLen = 0U;
+
+	while (val >= 0x80U) {
+		ttysVarint[varintLen++] = (uint8_t)((val & 0x7FU) | 0x80U);
+		val >>= 7U;
+	}
+	ttysVarint[varintLen++] = (uint8_t)val;
+
+	return ttys_write(ttysInstIdx, ttysVarint, varintLen);
+}
+
+/**
+ * @brief: Starts an async read. Bytes already in the RX ring are taken
+ *         first, the rest are stored straight into asyncBuf by the ISR. The
+ *         callback runs once asyncLen bytes were read, from the caller if
+ *         the RX ring already held them.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: asyncBuf
+ * @param[in]: asyncLen
+ * @param[in]: asyncCb
+ * @param[in]: asyncCtx
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_read_async(uint32_t ttysInstIdx, void* asyncBuf,
+						 uint32_t asyncLen, ttys_async_cb asyncCb,
+						 void* asyncCtx) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+	if (asyncBuf == NULL || asyncLen == 0U) return TTYS_ERR_NULL;
+
 	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+	ttys_async_t* ttysAsync = &ttysTmp->rxAsync;
+	uint32_t primask = __get_PRIMASK();
 
-	uint16_t txPutIdx = ttysTmp->txPutIdx;
-	uint16_t txGetIdx = ttysTmp->txGetIdx;
+	__disable_irq();
 
-	txPutIdx = txPutIdx + 1;
+	if (ttysAsync->isActive) {
+		__set_PRIMASK(primask);
+		return TTYS_ERR_BUSY;
+	}
 
-	if ((txPutIdx) > MAX_BUFFER_SIZE - 1) txPutIdx = 0U;
-	if (txGetIdx + 1 > MAX_BUFFER_SIZE) txGetIdx = 0U;
-	while (!LL_USART_IsActiveFlag_TXE(ttysTmp->ttysPortx));
+	ttysAsync->asyncBuf = asyncBuf;
+	ttysAsync->asyncLen = asyncLen;
+	ttysAsync->asyncDone = 0U;
+	ttysAsync->asyncCb = asyncCb;
+	ttysAsync->asyncCtx = asyncCtx;
 
-	ttysTmp->txBuffer[ttysTmp->txPutIdx] = data;
-	LL_USART_TransmitData8(ttysTmp->ttysPortx, ttysTmp->txBuffer[txGetIdx++]);
+	// Taking what is already in the RX ring
+	while (ttysAsync->asyncDone < asyncLen &&
+		   ttysTmp->rxGetIdx != ttysTmp->rxPutIdx) {
+		uint32_t getIdx = ttysTmp->rxGetIdx + 1;
+		if (getIdx > MAX_BUFFER_SIZE - 1) getIdx = 0U;
 
-	while (!LL_USART_IsActiveFlag_TC(ttysTmp->ttysPortx));
+		ttysAsync->asyncBuf[ttysAsync->asyncDone++] = ttysTmp->rxBuffer[getIdx];
+		ttysTmp->rxGetIdx = getIdx;
+	}
 
-	ttysTmp->txPutIdx = txPutIdx;
-	ttysTmp->txGetIdx = txGetIdx;
+	ttysAsync->isActive = (ttysAsync->asyncDone < asyncLen);
+
+	if (ttysTmp->isRxThrottled) ttys_rx_release(ttysInstIdx);
+
+	__set_PRIMASK(primask);
+
+	if (!ttysAsync->isActive && asyncCb != NULL) {
+		asyncCb(asyncCtx, EXIT_SUCCESS, asyncLen);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Starts an async write of asyncBuf, which must stay valid until the
+ *         callback runs. The callback runs from the ISR once the last byte
+ *         was handed to the USART (it may still be on the wire). Bytes queued
+ *         by ttys_putc() before the call are sent first.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: asyncBuf
+ * @param[in]: asyncLen
+ * @param[in]: asyncCb
+ * @param[in]: asyncCtx
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_write_async(uint32_t ttysInstIdx, const void* asyncBuf,
+						  uint32_t asyncLen, ttys_async_cb asyncCb,
+						  void* asyncCtx) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+	if (asyncBuf == NULL || asyncLen == 0U) return TTYS_ERR_NULL;
+
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+	ttys_async_t* ttysAsync = &ttysTmp->txAsync;
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	if (ttysAsync->isActive) {
+		__set_PRIMASK(primask);
+		return TTYS_ERR_BUSY;
+	}
+
+	ttysAsync->asyncBuf = (uint8_t*)asyncBuf;
+	ttysAsync->asyncLen = asyncLen;
+	ttysAsync->asyncDone = 0U;
+	ttysAsync->asyncCb = asyncCb;
+	ttysAsync->asyncCtx = asyncCtx;
+	ttysAsync->isActive = true;
+
+	LL_USART_EnableIT_TXE(ttysTmp->ttysPortx);
+
+	__set_PRIMASK(primask);
+
+	// Without the interrupt the request is completed here
+	if (!ttysTmp->isStarted) {
+		while (ttysAsync->isActive) ttys_tx_poll(ttysInstIdx);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Cancels the pending async requests in asyncDirs. Their callbacks
+ *         run from the caller with TTYS_ERR_CANCELLED and the number of
+ *         bytes moved so far.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: asyncDirs. TTYS_ASYNC_RX and/or TTYS_ASYNC_TX
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_cancel_async(uint32_t ttysInstIdx, uint32_t asyncDirs) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+
+	if (asyncDirs & TTYS_ASYNC_RX) ttys_async_cancel(&ttysTmp->rxAsync);
+	if (asyncDirs & TTYS_ASYNC_TX) ttys_async_cancel(&ttysTmp->txAsync);
 
 	return EXIT_SUCCESS;
 }
 
+/**
+ * @brief: Installs a hook that takes every received byte from the ISR in
+ *         place of the RX ring and async reads. NULL removes it.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: rxHook
+ * @param[in]: hookCtx
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_set_rx_hook(uint32_t ttysInstIdx, ttys_rx_hook rxHook,
+						  void* hookCtx) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	ttysTmp->rxHook = rxHook;
+	ttysTmp->rxHookCtx = hookCtx;
+	__set_PRIMASK(primask);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Finds the BRR value for a baud rate. The baud is fPCLK / div, div
+ *         being USARTDIV in 1/16ths with OVER16 and in 1/8ths with OVER8, so
+ *         both modes have the same resolution and the closest div gives the
+ *         lowest error. OVER8 only widens the range (up to fPCLK / 8) at the
+ *         cost of noise tolerance, so TTYS_OVERSAMPLING_AUTO picks it only
+ *         when OVER16 cannot reach the baud.
+ *
+ * @param[in]: ttysPclk. USART kernel clock
+ * @param[in]: ttysBaudReq
+ * @param[in]: ttysOverSampling. LL_USART_OVERSAMPLING_x or
+ *             TTYS_OVERSAMPLING_AUTO
+ * @param[out]: ttysBaud
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_baud_solve(uint32_t ttysPclk, uint32_t ttysBaudReq,
+						 uint32_t ttysOverSampling, ttys_baud_t* ttysBaud) {
+	if (ttysBaud == NULL) return TTYS_ERR_NULL;
+	if (ttysPclk == 0U || ttysBaudReq == 0U) return TTYS_ERR_BAUD;
+
+	uint32_t ttysDiv =
+		(uint32_t)(((uint64_t)ttysPclk + ttysBaudReq / 2U) / ttysBaudReq);
+
+	if (ttysOverSampling == TTYS_OVERSAMPLING_AUTO) {
+		ttysOverSampling = (ttysDiv >= 16U) ? LL_USART_OVERSAMPLING_16
+											: LL_USART_OVERSAMPLING_8;
+	}
+
+	switch (ttysOverSampling) {
+		case LL_USART_OVERSAMPLING_16:
+			// DIV_Mantissa must be at least 1
+			if (ttysDiv < 16U || ttysDiv > 0xFFFFU) return TTYS_ERR_BAUD;
+
+			ttysBaud->ttysBrr = ttysDiv;
+			break;
+
+		case LL_USART_OVERSAMPLING_8:
+			if (ttysDiv < 8U || ttysDiv > ((0xFFFU << 3U) | 7U)) {
+				return TTYS_ERR_BAUD;
+			}
+
+			// The fraction is 3 bits, DIV_Fraction[3] must be kept cleared
+			ttysBaud->ttysBrr = ((ttysDiv >> 3U) << 4U) | (ttysDiv & 7U);
+			break;
+
+		default:
+			return TTYS_ERR_CONFIG;
+	}
+
+	// |fPCLK / div - baud| / baud, in ppm
+	uint64_t ttysDivBaud = (uint64_t)ttysDiv * ttysBaudReq;
+	uint64_t ttysDelta = (ttysDivBaud > ttysPclk) ? (ttysDivBaud - ttysPclk)
+												  : (ttysPclk - ttysDivBaud);
+
+	ttysBaud->ttysOverSampling = ttysOverSampling;
+	ttysBaud->ttysActualBaud = (ttysPclk + ttysDiv / 2U) / ttysDiv;
+	ttysBaud->ttysErrPpm = (uint32_t)((ttysDelta * 1000000U) / ttysDivBaud);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Returns the baud rate solution applied by ttys_init().
+ *
+ * @param[in]: ttysInstIdx
+ * @param[out]: ttysBaud
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_get_baud(uint32_t ttysInstIdx, ttys_baud_t* ttysBaud) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+	if (ttysBaud == NULL) return TTYS_ERR_NULL;
+
+	*ttysBaud = ttysInstances[ttysInstIdx].ttysBaud;
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Reports whether an instance has work in progress: received bytes
+ *         not yet read, or a transmission not yet finished. Matches
+ *         tmr_busy_func, so it can be given to tmr_sleep_add_hook() to keep
+ *         the CPU awake while the main loop has data to handle.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: bool
+ **/
+bool ttys_is_busy(uint32_t ttysInstIdx) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return false;
+
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+
+	return ttysTmp->rxPutIdx != ttysTmp->rxGetIdx ||
+		   ttysTmp->txPutIdx != ttysTmp->txGetIdx ||
+		   ttysTmp->txAsync.isActive || ttysTmp->txCtrlChar != 0 ||
+		   ttysTmp->isRs485Tx;
+}
+
+/**
+ * @brief: Returns the free space in the TX ring, the number of bytes that
+ *         ttys_putc() can queue without waiting.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: uint32_t. 0 if the index is invalid
+ **/
+uint32_t ttys_tx_free(uint32_t ttysInstIdx) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return 0U;
+
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+
+	return (MAX_BUFFER_SIZE - 1U) -
+		   TTYS_RING_LEVEL(ttysTmp->txPutIdx, ttysTmp->txGetIdx);
+}
+
+/**
+ * @brief: Copies the statistics of a ttys instance. The counters are
+ *         written without locking by the ISR and the writers, so a copy
+ *         taken while traffic is flowing can be a few bytes out of step.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[out]: ttysStats
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_get_stats(uint32_t ttysInstIdx, ttys_stats_t* ttysStats) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+	if (ttysStats == NULL) return TTYS_ERR_NULL;
+
+	*ttysStats = ttysInstances[ttysInstIdx].ttysStats;
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Clears the statistics of a ttys instance.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_reset_stats(uint32_t ttysInstIdx) {
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	(void)memset(&ttysInstances[ttysInstIdx].ttysStats, 0U,
+				 sizeof(ttys_stats_t));
+	__set_PRIMASK(primask);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Writes the statistics of a ttys instance to another instance as
+ *         a binary record: "TST", version, instance, then the counters of
+ *         ttys_stats_t as little-endian uint32_t.
+ *
+ * @param[in]: ttysInstIdx. Instance the statistics are taken from
+ * @param[in]: ttysOutIdx. Instance the record is written to
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_dump_stats(uint32_t ttysInstIdx, uint32_t ttysOutIdx) {
+	ttys_stats_t ttysStats;
+	const uint8_t ttysHeader[5U] = {TTYS_STATS_MAGIC[0U], TTYS_STATS_MAGIC[1U],
+									TTYS_STATS_MAGIC[2U], TTYS_STATS_VERSION,
+									(uint8_t)ttysInstIdx};
+
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES || ttysOutIdx >= TTYS_NUM_INSTANCES) {
+		return TTYS_ERR_IDX;
+	}
+
+	// Taking the copy first, the dump itself adds to the counters
+	(void)ttys_get_stats(ttysInstIdx, &ttysStats);
+
+	(void)ttys_write(ttysOutIdx, ttysHeader, sizeof(ttysHeader));
+	(void)ttys_write(ttysOutIdx, &ttysStats, sizeof(ttysStats));
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Sets up the USART clock, frame format and baud rate. USART2 is
+ *         clocked from APB1, USART1 and USART6 from APB2.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: ttysConfig
+ * @return[out]: uint32_t
+ **/
+static uint32_t ttys_configure(uint32_t ttysInstIdx,
+							   const ttys_config_t* ttysConfig) {
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+	LL_RCC_ClocksTypeDef ttysClocks;
+	ttys_baud_t ttysBaud;
+	uint32_t ttysPclk = 0U;
+	uint32_t ttysRet = 0U;
+
+	// 0 selects the default mark, the check is on the marks that apply
+	uint32_t rxHighMark = (ttysConfig->rxHighMark != 0U)
+							  ? ttysConfig->rxHighMark
+							  : TTYS_RX_HIGH_MARK_DEF;
+	uint32_t rxLowMark = (ttysConfig->rxLowMark != 0U) ? ttysConfig->rxLowMark
+													   : TTYS_RX_LOW_MARK_DEF;
+
+	if (ttysConfig->ttysParity != LL_USART_PARITY_NONE &&
+		ttysConfig->ttysParity != LL_USART_PARITY_EVEN &&
+		ttysConfig->ttysParity != LL_USART_PARITY_ODD) {
+		return TTYS_ERR_CONFIG;
+	}
+	if (ttysConfig->ttysFlowCtrl > TTYS_FLOW_XON_XOFF ||
+		(ttysConfig->ttysFlowCtrl == TTYS_FLOW_RTS_CTS &&
+		 (ttysInstIdx == TTYS_INSTANCE_3 || ttysConfig->isRs485 ||
+		  ttysConfig->isHalfDuplex))) {
+		return TTYS_ERR_CONFIG;
+	}
+
+	if (ttysConfig->ttysStopBits != LL_USART_STOPBITS_0_5 &&
+		ttysConfig->ttysStopBits != LL_USART_STOPBITS_1 &&
+		ttysConfig->ttysStopBits != LL_USART_STOPBITS_1_5 &&
+		ttysConfig->ttysStopBits != LL_USART_STOPBITS_2) {
+		return TTYS_ERR_CONFIG;
+	}
+
+	LL_RCC_GetSystemClocksFreq(&ttysClocks);
+
+	// USART1 and USART6 sit on APB2, USART2 on APB1
+	ttysPclk = (ttysInstIdx == TTYS_INSTANCE_2) ? ttysClocks.PCLK1_Frequency
+												: ttysClocks.PCLK2_Frequency;
+
+	// The high mark has to leave room for the bytes already on their way
+	if (rxHighMark >= MAX_BUFFER_SIZE - 1U || rxLowMark >= rxHighMark) {
+		return TTYS_ERR_CONFIG;
+	}
+
+	ttysRet = ttys_baud_solve(ttysPclk, ttysConfig->ttysBaud,
+							  ttysConfig->ttysOverSampling, &ttysBaud);
+	if (ttysRet != EXIT_SUCCESS) return ttysRet;
+	if (ttysBaud.ttysErrPpm > TTYS_BAUD_MAX_ERR_PPM) return TTYS_ERR_BAUD;
+
+	// Nothing is touched until the whole config is valid. The DE pin starts
+	// released, the gpio module must be initialised first
+	if (ttysConfig->isRs485 &&
+		io_set_val(ttysConfig->rs485DeIdx, RESET) != EXIT_SUCCESS) {
+		return TTYS_ERR_CONFIG;
+	}
+
+	switch (ttysInstIdx) {
+		case TTYS_INSTANCE_1:
+			LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_USART1);
+			break;
+
+		case TTYS_INSTANCE_2:
+			LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_USART2);
+			break;
+
+		case TTYS_INSTANCE_3:
+			LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_USART6);
+			break;
+
+		default:
+			return TTYS_ERR_IDX;
+	}
+
+	// The frame format can only be changed while the USART is disabled
+	LL_USART_Disable(ttysTmp->ttysPortx);
+
+	// The parity bit takes the place of the MSB, so 9 bit words keep 8 data bits
+	LL_USART_SetDataWidth(ttysTmp->ttysPortx,
+						  (ttysConfig->ttysParity == LL_USART_PARITY_NONE)
+							  ? LL_USART_DATAWIDTH_8B
+							  : LL_USART_DATAWIDTH_9B);
+	LL_USART_SetParity(ttysTmp->ttysPortx, ttysConfig->ttysParity);
+	LL_USART_SetStopBitsLength(ttysTmp->ttysPortx, ttysConfig->ttysStopBits);
+	LL_USART_SetOverSampling(ttysTmp->ttysPortx, ttysBaud.ttysOverSampling);
+	LL_USART_WriteReg(ttysTmp->ttysPortx, BRR, ttysBaud.ttysBrr);
+	LL_USART_SetTransferDirection(ttysTmp->ttysPortx, LL_USART_DIRECTION_TX_RX);
+
+	// With RTS/CTS the USART drops RTS while DR holds an unread byte, so the
+	// ISR holds off reading DR (RXNEIE off) to stop the peer
+	LL_USART_SetHWFlowCtrl(ttysTmp->ttysPortx,
+						   (ttysConfig->ttysFlowCtrl == TTYS_FLOW_RTS_CTS)
+							   ? LL_USART_HWCONTROL_RTS_CTS
+							   : LL_USART_HWCONTROL_NONE);
+
+	// In half-duplex the TX pin is also the RX input, so every byte sent is
+	// received back
+	if (ttysConfig->isHalfDuplex) {
+		LL_USART_EnableHalfDuplex(ttysTmp->ttysPortx);
+	} else {
+		LL_USART_DisableHalfDuplex(ttysTmp->ttysPortx);
+	}
+
+	LL_USART_Enable(ttysTmp->ttysPortx);
+
+	ttysTmp->ttysBaud = ttysBaud;
+	ttysTmp->ttysFlowCtrl = ttysConfig->ttysFlowCtrl;
+	ttysTmp->rxHighMark = rxHighMark;
+	ttysTmp->rxLowMark = rxLowMark;
+	ttysTmp->isRs485 = ttysConfig->isRs485;
+	ttysTmp->rs485DeIdx = ttysConfig->rs485DeIdx;
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: USART1 IRQHandler.
+ */
+void USART1_IRQHandler(void) {
+	PROF_ISR_ENTER();
+	ttys_interrupt(TTYS_INSTANCE_1, USART1_IRQn);
+	PROF_ISR_EXIT(PROF_VEC_USART1);
+}
 
 /**
  * @brief: USART2 IRQHandler.
  */
-void USART2_IRQHandler(void) { ttys_interrupt(TTYS_INSTANCE_2, USART2_IRQn); }
+void USART2_IRQHandler(void) {
+	PROF_ISR_ENTER();
+	ttys_interrupt(TTYS_INSTANCE_2, USART2_IRQn);
+	PROF_ISR_EXIT(PROF_VEC_USART2);
+}
+
+/**
+ * @brief: USART6 IRQHandler.
+ */
+void USART6_IRQHandler(void) {
+	PROF_ISR_ENTER();
+	ttys_interrupt(TTYS_INSTANCE_3, USART6_IRQn);
+	PROF_ISR_EXIT(PROF_VEC_USART6);
+}
 
 
 static void ttys_interrupt(uint32_t ttysInstIdx, IRQn_Type irqType) {
@@ -266,7 +835,31 @@ static void ttys_interrupt(uint32_t ttysInstIdx, IRQn_Type irqType) {
 		return;
 	}
 
-	usartSr = ttysTmp->ttysPortx->SR;
+	usartSr = LL_USART_ReadReg(ttysTmp->ttysPortx, SR);
+
+	// While RTS/CTS backpressure holds DR unread (RXNEIE off), the TXE and TC
+	// interrupts must not read it either. The byte and its error flags are
+	// taken once the backpressure is released.
+	if ((usartSr & LL_USART_SR_RXNE) &&
+		!LL_USART_IsEnabledIT_RXNE(ttysTmp->ttysPortx)) {
+		usartSr &= ~(LL_USART_SR_RXNE | LL_USART_SR_ORE | LL_USART_SR_FE |
+					 LL_USART_SR_NE);
+	}
+
+	// Counting the receive errors, reading SR then DR clears them
+	if (usartSr & (LL_USART_SR_ORE | LL_USART_SR_FE | LL_USART_SR_NE)) {
+		if (usartSr & LL_USART_SR_ORE) {
+			ttysTmp->ttysStats.oreErrs++;
+			TRACE(TRACE_EVT_TTYS_RX_OVF, ttysInstIdx, usartSr);
+		}
+		if (usartSr & LL_USART_SR_FE) ttysTmp->ttysStats.feErrs++;
+		if (usartSr & LL_USART_SR_NE) ttysTmp->ttysStats.neErrs++;
+
+		// Without RXNE nothing else reads DR, and ORE keeps the IRQ pending
+		if (!(usartSr & LL_USART_SR_RXNE)) {
+			(void)LL_USART_ReceiveData8(ttysTmp->ttysPortx);
+		}
+	}
 
 	// Check to see if data is received
 	if (usartSr & LL_USART_SR_RXNE) {
@@ -274,12 +867,238 @@ static void ttys_interrupt(uint32_t ttysInstIdx, IRQn_Type irqType) {
 
 		if (putIdx > MAX_BUFFER_SIZE - 1) putIdx = 0U;
 
-		// char dataRec = ttysTmp->ttysPortx->DR;
 		char dataRec = 0U;
-		dataRec = LL_USART_ReceiveData8(TTYS_PORT_2);
+		dataRec = LL_USART_ReceiveData8(ttysTmp->ttysPortx);
+		TRACE(TRACE_EVT_TTYS_RX, ttysInstIdx, (uint8_t)dataRec);
+
+		// Our own transmission echoed back by the RS-485 transceiver is not
+		// counted and dropped
+		if (!ttysTmp->isRs485Tx) ttysTmp->ttysStats.bytesIn++;
+
+		if (ttysTmp->isRs485Tx) {
+			// Echo
+		} else if (ttysTmp->ttysFlowCtrl == TTYS_FLOW_XON_XOFF &&
+			(dataRec == TTYS_XON || dataRec == TTYS_XOFF)) {
+			// Flow control from the peer, not stored
+			ttysTmp->isTxPaused = (dataRec == TTYS_XOFF);
+			if (!ttysTmp->isTxPaused) LL_USART_EnableIT_TXE(ttysTmp->ttysPortx);
+		} else if (ttysTmp->rxHook != NULL) {
+			// The hook takes the byte (e.g. the channel demux)
+			ttysTmp->rxHook(ttysTmp->rxHookCtx, dataRec);
+		} else if (ttysTmp->rxAsync.isActive) {
+			// An async read takes the byte directly
+			ttys_async_t* ttysAsync = &ttysTmp->rxAsync;
+
+			ttysAsync->asyncBuf[ttysAsync->asyncDone++] = dataRec;
+			if (ttysAsync->asyncDone == ttysAsync->asyncLen) {
+				ttys_async_complete(ttysAsync);
+			}
+		} else if (putIdx == ttysTmp->rxGetIdx) {
+			// The ring is full, the new byte is dropped so unread data is kept
+			ttysTmp->ttysStats.rxDrops++;
+		} else {
+			ttysTmp->rxBuffer[putIdx] = dataRec;
+			ttysTmp->rxPutIdx = putIdx;
+
+			uint32_t rxLevel = TTYS_RING_LEVEL(putIdx, ttysTmp->rxGetIdx);
+			if (rxLevel > ttysTmp->ttysStats.rxHighWater) {
+				ttysTmp->ttysStats.rxHighWater = rxLevel;
+			}
+
+			if (ttysTmp->ttysFlowCtrl != TTYS_FLOW_NONE &&
+				!ttysTmp->isRxThrottled && rxLevel >= ttysTmp->rxHighMark) {
+				ttys_rx_throttle(ttysInstIdx);
+			}
+		}
+	}
+
+	// Check to see if the USART can take the next byte
+	if ((usartSr & LL_USART_SR_TXE) &&
+		LL_USART_IsEnabledIT_TXE(ttysTmp->ttysPortx)) {
+		ttys_tx_next(ttysInstIdx);
+	}
+
+	// RS-485: the last byte left the shift register, the bus is released
+	if ((usartSr & LL_USART_SR_TC) &&
+		LL_USART_IsEnabledIT_TC(ttysTmp->ttysPortx)) {
+		LL_USART_DisableIT_TC(ttysTmp->ttysPortx);
+		LL_USART_ClearFlag_TC(ttysTmp->ttysPortx);
+
+		(void)io_set_val(ttysTmp->rs485DeIdx, RESET);
+		ttysTmp->isRs485Tx = false;
+		TRACE(TRACE_EVT_TTYS_TX_DONE, ttysInstIdx, 0U);
+	}
+}
+
+/**
+ * @brief: Hands the next byte to the USART, from the TX ring first and then
+ *         from the pending async write. Turns the TXE interrupt off once
+ *         both are empty. Called with TXE set, from the ISR or with
+ *         interrupts disabled.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: void
+ **/
+static void ttys_tx_next(uint32_t ttysInstIdx) {
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+	ttys_async_t* ttysAsync = &ttysTmp->txAsync;
+	char data = 0U;
+
+	if (ttysTmp->txCtrlChar != 0U) {
+		// XON/XOFF go ahead of everything else, even while paused
+		data = ttysTmp->txCtrlChar;
+		ttysTmp->txCtrlChar = 0U;
+	} else if (ttysTmp->isTxPaused) {
+		// The RX side turns the interrupt back on when XON arrives
+		LL_USART_DisableIT_TXE(ttysTmp->ttysPortx);
+		return;
+	} else if (ttysTmp->txGetIdx != ttysTmp->txPutIdx) {
+		uint32_t txGetIdx = ttysTmp->txGetIdx;
+
+		data = ttysTmp->txBuffer[txGetIdx++];
+		if (txGetIdx > MAX_BUFFER_SIZE - 1) txGetIdx = 0U;
+		ttysTmp->txGetIdx = txGetIdx;
+	} else if (ttysAsync->isActive) {
+		data = (char)ttysAsync->asyncBuf[ttysAsync->asyncDone++];
+	} else {
+		LL_USART_DisableIT_TXE(ttysTmp->ttysPortx);
+
+		// RS-485 keeps DE up until TC, the last byte is still shifting out
+		if (ttysTmp->isRs485Tx) {
+			LL_USART_EnableIT_TC(ttysTmp->ttysPortx);
+		} else {
+			TRACE(TRACE_EVT_TTYS_TX_DONE, ttysInstIdx, 0U);
+		}
+		return;
+	}
+
+	// RS-485: taking the bus, or keeping it if TC was about to release it
+	if (ttysTmp->isRs485) {
+		LL_USART_DisableIT_TC(ttysTmp->ttysPortx);
+		if (!ttysTmp->isRs485Tx) {
+			ttysTmp->isRs485Tx = true;
+			(void)io_set_val(ttysTmp->rs485DeIdx, SET);
+		}
+	}
+
+	TRACE(TRACE_EVT_TTYS_TX_START, ttysInstIdx, (uint8_t)data);
+	LL_USART_TransmitData8(ttysTmp->ttysPortx, data);
+	ttysTmp->ttysStats.bytesOut++;
+
+	if (ttysAsync->isActive && ttysAsync->asyncDone == ttysAsync->asyncLen) {
+		ttys_async_complete(ttysAsync);
+	}
+}
+
+/**
+ * @brief: Applies backpressure once the RX ring reached its high mark. With
+ *         RTS/CTS, DR is left unread (RXNEIE off) so the USART drops RTS,
+ *         with XON/XOFF an XOFF is sent ahead of the TX ring.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: void
+ **/
+static void ttys_rx_throttle(uint32_t ttysInstIdx) {
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+
+	ttysTmp->isRxThrottled = true;
+
+	if (ttysTmp->ttysFlowCtrl == TTYS_FLOW_RTS_CTS) {
+		LL_USART_DisableIT_RXNE(ttysTmp->ttysPortx);
+	} else {
+		ttysTmp->txCtrlChar = TTYS_XOFF;
+		LL_USART_EnableIT_TXE(ttysTmp->ttysPortx);
+	}
+}
+
+/**
+ * @brief: Releases the backpressure once the reader drained the RX ring down
+ *         to its low mark. The gap between the marks keeps the link from
+ *         toggling on every byte.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: void
+ **/
+static void ttys_rx_release(uint32_t ttysInstIdx) {
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	if (ttysTmp->isRxThrottled &&
+		TTYS_RING_LEVEL(ttysTmp->rxPutIdx, ttysTmp->rxGetIdx) <=
+			ttysTmp->rxLowMark) {
+		ttysTmp->isRxThrottled = false;
+
+		if (ttysTmp->ttysFlowCtrl == TTYS_FLOW_RTS_CTS) {
+			LL_USART_EnableIT_RXNE(ttysTmp->ttysPortx);
+		} else {
+			ttysTmp->txCtrlChar = TTYS_XON;
+			LL_USART_EnableIT_TXE(ttysTmp->ttysPortx);
+		}
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Moves one byte out by polling TXE, for callers that wait on the
+ *         TX ring and may have interrupts masked.
+ *
+ * @param[in]: ttysInstIdx
+ * @return[out]: void
+ **/
+static void ttys_tx_poll(uint32_t ttysInstIdx) {
+	ttys_handler_t* ttysTmp = &ttysInstances[ttysInstIdx];
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (LL_USART_IsActiveFlag_TXE(ttysTmp->ttysPortx)) {
+		ttys_tx_next(ttysInstIdx);
+	}
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Ends an async request that moved all its bytes and runs its
+ *         callback.
+ *
+ * @param[in]: ttysAsync
+ * @return[out]: void
+ **/
+static void ttys_async_complete(ttys_async_t* ttysAsync) {
+	ttysAsync->isActive = false;
+
+	if (ttysAsync->asyncCb != NULL) {
+		ttysAsync->asyncCb(ttysAsync->asyncCtx, EXIT_SUCCESS,
+						   ttysAsync->asyncDone);
+	}
+}
+
+/**
+ * @brief: Ends an async request early and runs its callback with
+ *         TTYS_ERR_CANCELLED, unless it already completed.
+ *
+ * @param[in]: ttysAsync
+ * @return[out]: void
+ **/
+static void ttys_async_cancel(ttys_async_t* ttysAsync) {
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	if (!ttysAsync->isActive) {
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	ttysAsync->isActive = false;
+	uint32_t asyncDone = ttysAsync->asyncDone;
+
+	__set_PRIMASK(primask);
 
-		ttysTmp->rxBuffer[putIdx] = dataRec;
-		ttysTmp->rxPutIdx = putIdx;
+	if (ttysAsync->asyncCb != NULL) {
+		ttysAsync->asyncCb(ttysAsync->asyncCtx, TTYS_ERR_CANCELLED, asyncDone);
 	}
 }
 
@@ -16,6 +16,8 @@
 #include <sys/times.h>
 
 /* MCU includes */
+#include <stm32f4xx_ll_bus.h>
+#include <stm32f4xx_ll_rcc.h>
 #include <stm32f4xx_ll_usart.h>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -24,6 +26,31 @@
 #define NON_BLOCKING DISABLE
 #define MAX_BUFFER_SIZE 80U
 
+// Bytes waiting in a ring
+#define TTYS_RING_LEVEL(putIdx, getIdx) \
+  (((putIdx) + MAX_BUFFER_SIZE - (getIdx)) % MAX_BUFFER_SIZE)
+
+// Oversampling selection, TTYS_OVERSAMPLING_AUTO uses OVER16 whenever the baud
+// can be reached with it and falls back to OVER8 above fPCLK / 16
+#define TTYS_OVERSAMPLING_AUTO 0xFFFFFFFFU
+
+// Software flow control characters
+#define TTYS_XON 0x11U
+#define TTYS_XOFF 0x13U
+
+// Default RX ring watermarks for flow control, in bytes waiting
+#define TTYS_RX_HIGH_MARK_DEF ((MAX_BUFFER_SIZE * 3U) / 4U)
+#define TTYS_RX_LOW_MARK_DEF (MAX_BUFFER_SIZE / 4U)
+
+// Largest baud error accepted by ttys_init(), in ppm
+#ifndef TTYS_BAUD_MAX_ERR_PPM
+#define TTYS_BAUD_MAX_ERR_PPM 15000U
+#endif
+
+// Statistics export header
+#define TTYS_STATS_MAGIC "TST"
+#define TTYS_STATS_VERSION 1U
+
 //
 // TTYs Mappings for the STM32F401RE
 //
@@ -47,6 +74,11 @@ typedef enum {
   TTYS_ERR_IDX = 0x54U,
   TTYS_ERR_RX,
   TTYS_ERR_TX,
+  TTYS_ERR_NULL,
+  TTYS_ERR_BUSY,
+  TTYS_ERR_CANCELLED,
+  TTYS_ERR_BAUD,
+  TTYS_ERR_CONFIG,
 
 } ttys_errors_t;
 
@@ -60,6 +92,88 @@ typedef enum {
   TTYS_NUM_INSTANCES
 } ttys_instance_id_t;
 
+/* Flow control modes */
+typedef enum {
+
+  TTYS_FLOW_NONE,
+  TTYS_FLOW_RTS_CTS,   // USART1 and USART2 only
+  TTYS_FLOW_XON_XOFF,
+
+} ttys_flow_ctrl_t;
+
+/* Ttys line configuration */
+typedef struct {
+  uint32_t ttysBaud;
+  uint32_t ttysParity;        // LL_USART_PARITY_x, 8 data bits are kept
+  uint32_t ttysStopBits;      // LL_USART_STOPBITS_x
+  uint32_t ttysOverSampling;  // LL_USART_OVERSAMPLING_x or TTYS_OVERSAMPLING_AUTO
+
+  uint32_t ttysFlowCtrl;  // ttys_flow_ctrl_t
+  uint32_t rxHighMark;    // Backpressure at this many bytes waiting, 0: default
+  uint32_t rxLowMark;     // Released at this many bytes waiting, 0: default
+
+  bool isRs485;          // Half-duplex RS-485, DE driven from a gpio output
+  uint32_t rs485DeIdx;   // Index of the DE pin in the gpio ioOutputs array
+
+  bool isHalfDuplex;     // Single wire (HDSEL), RX listens on the TX pin
+
+} ttys_config_t;
+
+/* Baud rate solution */
+typedef struct {
+  uint32_t ttysBrr;
+  uint32_t ttysOverSampling;  // LL_USART_OVERSAMPLING_x
+  uint32_t ttysActualBaud;
+  uint32_t ttysErrPpm;  // |actual - requested| / requested
+
+} ttys_baud_t;
+
+/* Async directions, for ttys_cancel_async() */
+typedef enum {
+
+  TTYS_ASYNC_RX = 1U << 0U,
+  TTYS_ASYNC_TX = 1U << 1U,
+
+} ttys_async_dir_t;
+
+//
+// Async completion callback, called from the USART ISR (or from the caller
+// for a read already satisfied by the RX ring, or a cancel). asyncStatus is
+// EXIT_SUCCESS or TTYS_ERR_CANCELLED, asyncLen the number of bytes moved.
+// The request is no longer pending when the callback runs, so it can start
+// the next one.
+//
+typedef void (*ttys_async_cb)(void *asyncCtx, uint32_t asyncStatus,
+                              uint32_t asyncLen);
+
+// RX hook, takes every received byte in place of the RX ring. Called from
+// the USART ISR.
+typedef void (*ttys_rx_hook)(void *hookCtx, char data);
+
+/* Async request */
+typedef struct {
+  uint8_t *asyncBuf;  // Only read for writes
+  uint32_t asyncLen;
+  volatile uint32_t asyncDone;
+  ttys_async_cb asyncCb;
+  void *asyncCtx;
+  volatile bool isActive;
+
+} ttys_async_t;
+
+/* Ttys Statistics */
+typedef struct {
+  uint32_t bytesIn;
+  uint32_t bytesOut;
+  uint32_t rxDrops;  // Bytes dropped because the RX ring was full
+  uint32_t oreErrs;  // Overrun, bytes lost in the USART data register
+  uint32_t feErrs;   // Framing errors
+  uint32_t neErrs;   // Noise errors
+  uint32_t rxHighWater;  // Most bytes waiting in the RX ring
+  uint32_t txHighWater;  // Most bytes waiting in the TX ring
+
+} ttys_stats_t;
+
 /* Ttys Handler */
 typedef struct {
   ttys_port_t *ttysPortx;
@@ -73,7 +187,30 @@ typedef struct {
   char txBuffer[MAX_BUFFER_SIZE];
   char rxBuffer[MAX_BUFFER_SIZE];
 
+  ttys_async_t rxAsync;
+  ttys_async_t txAsync;
+
+  ttys_rx_hook rxHook;
+  void *rxHookCtx;
+
+  ttys_stats_t ttysStats;
+  ttys_baud_t ttysBaud;  // Set by ttys_init() when given a config
+
+  // Flow control
+  uint32_t ttysFlowCtrl;
+  uint32_t rxHighMark;
+  uint32_t rxLowMark;
+  volatile bool isRxThrottled;  // Backpressure applied to the peer
+  volatile bool isTxPaused;     // XOFF received from the peer
+  volatile char txCtrlChar;     // XON/XOFF to send ahead of the TX ring, 0: none
+
+  // RS-485
+  bool isRs485;
+  uint32_t rs485DeIdx;
+  volatile bool isRs485Tx;  // DE is driven, received bytes are our own echo
+
   bool isInstOpen;
+  bool isStarted;  // Set by ttys_start(), TX is polled until then
 } ttys_handler_t;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -82,12 +219,38 @@ typedef struct {
 
 /* Core API */
 uint32_t ttys_def_init(uint32_t ttysInstIdx);
-uint32_t ttys_init(uint32_t ttysInstIdx);
+uint32_t ttys_init(uint32_t ttysInstIdx, const ttys_config_t *ttysConfig);
 uint32_t ttys_start(uint32_t ttysInstIdx);
+uint32_t ttys_close(uint32_t ttysInstIdx);
 uint32_t ttys_putc(uint32_t ttysInstIdx, char data);
 uint32_t ttys_read_buf(uint32_t ttysInstIdx);
+uint32_t ttys_write(uint32_t ttysInstIdx, const void *data, uint32_t len);
+uint32_t ttys_write_varint(uint32_t ttysInstIdx, uint32_t val);
 
 /* Other API */
 char ttys_getc(uint32_t ttysInstIdx);
+bool ttys_is_busy(uint32_t ttysInstIdx);
+uint32_t ttys_tx_free(uint32_t ttysInstIdx);
+
+/* Line configuration */
+uint32_t ttys_baud_solve(uint32_t ttysPclk, uint32_t ttysBaudReq,
+                         uint32_t ttysOverSampling, ttys_baud_t *ttysBaud);
+uint32_t ttys_get_baud(uint32_t ttysInstIdx, ttys_baud_t *ttysBaud);
+
+/* Async API */
+uint32_t ttys_read_async(uint32_t ttysInstIdx, void *asyncBuf,
+                         uint32_t asyncLen, ttys_async_cb asyncCb,
+                         void *asyncCtx);
+uint32_t ttys_write_async(uint32_t ttysInstIdx, const void *asyncBuf,
+                          uint32_t asyncLen, ttys_async_cb asyncCb,
+                          void *asyncCtx);
+uint32_t ttys_cancel_async(uint32_t ttysInstIdx, uint32_t asyncDirs);
+uint32_t ttys_set_rx_hook(uint32_t ttysInstIdx, ttys_rx_hook rxHook,
+                          void *hookCtx);
+
+/* Statistics */
+uint32_t ttys_get_stats(uint32_t ttysInstIdx, ttys_stats_t *ttysStats);
+uint32_t ttys_reset_stats(uint32_t ttysInstIdx);
+uint32_t ttys_dump_stats(uint32_t ttysInstIdx, uint32_t ttysOutIdx);
 
 #endif  // usart.h
\ No newline at end of file
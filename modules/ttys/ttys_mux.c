@@ -0,0 +1,495 @@
+/**
+ * @file ttys_mux.c
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Virtual channels multiplexed over one ttys instance
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <ttys_mux.h>
+
+_Static_assert((TTYS_MUX_RING_SIZE & (TTYS_MUX_RING_SIZE - 1U)) == 0U,
+			   "ttys_mux: TTYS_MUX_RING_SIZE must be a power of 2");
+_Static_assert(TTYS_MUX_MAX_PAYLOAD <= 0xFFU,
+			   "ttys_mux: the length field is one byte");
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Macros
+////////////////////////////////////////////////////////////////////////////////
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, MSB first, no final XOR. Run over
+// a frame with its CRC appended it leaves 0
+#define TTYS_MUX_CRC_POLY 0x1021U
+#define TTYS_MUX_CRC_INIT 0xFFFFU
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Types
+////////////////////////////////////////////////////////////////////////////////
+
+/* RX parser states */
+typedef enum {
+
+	TTYS_MUX_RX_SYNC,
+	TTYS_MUX_RX_CHAN,
+	TTYS_MUX_RX_LEN,
+	TTYS_MUX_RX_DATA,
+	TTYS_MUX_RX_CRC,
+
+} ttys_mux_rx_state_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Function Declarations
+////////////////////////////////////////////////////////////////////////////////
+static void ttys_mux_rx(void* hookCtx, char data);
+static void ttys_mux_tx_done(void* asyncCtx, uint32_t asyncStatus,
+							 uint32_t asyncLen);
+static void ttys_mux_rx_commit(void);
+static int32_t ttys_mux_next_chan(void);
+static uint32_t ttys_mux_level(const ttys_mux_ring_t* muxRing);
+static uint16_t ttys_mux_crc(uint16_t muxCrc, uint8_t muxByte);
+static uint32_t ttys_mux_stuff(uint8_t* muxOut, uint8_t muxByte);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Variables
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t muxInstIdx;
+static bool muxIsInit;
+
+static ttys_mux_ring_t muxRxRings[TTYS_MUX_NUM_CHANNELS];
+static ttys_mux_ring_t muxTxRings[TTYS_MUX_NUM_CHANNELS];
+static ttys_mux_stats_t muxStats[TTYS_MUX_NUM_CHANNELS];
+
+// RX parser, run byte by byte from the ttys ISR. The payload is only handed
+// to the channel once the CRC checked out
+static uint32_t muxRxState;
+static uint32_t muxRxChan;
+static uint32_t muxRxLen;
+static uint32_t muxRxPos;
+static uint16_t muxRxCrc;
+static bool muxRxEsc;
+static uint8_t muxRxBuf[TTYS_MUX_MAX_PAYLOAD];
+static uint32_t muxRxErrors;
+
+// Weighted round-robin: frames a channel may send per turn, and the frames
+// left in the current turn
+static uint8_t muxWeight[TTYS_MUX_NUM_CHANNELS];
+static uint8_t muxCredit[TTYS_MUX_NUM_CHANNELS];
+static uint32_t muxTxChan;
+
+// One frame is in flight at a time
+static volatile bool muxTxBusy;
+static uint8_t muxTxFrame[TTYS_MUX_FRAME_MAX];
+
+////////////////////////////////////////////////////////////////////////////////
+// Global Function Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: Takes over a started ttys instance for the virtual channels. Every
+ *         received byte goes through the demux, and the instance must not
+ *         be written with ttys_putc()/printf() any more.
+ *
+ * @param[in]: ttysInstIdx
+ * @param[in]: muxWeights. Frames each channel may send per round, at least 1
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_mux_init(uint32_t ttysInstIdx,
+					   const uint8_t muxWeights[TTYS_MUX_NUM_CHANNELS]) {
+	uint32_t muxChan = 0U;
+
+	if (ttysInstIdx >= TTYS_NUM_INSTANCES) return TTYS_ERR_IDX;
+	if (muxWeights == NULL) return TTYS_MUX_ERR_CONFIG;
+
+	for (muxChan = 0U; muxChan < TTYS_MUX_NUM_CHANNELS; muxChan++) {
+		if (muxWeights[muxChan] == 0U) return TTYS_MUX_ERR_CONFIG;
+		muxWeight[muxChan] = muxWeights[muxChan];
+	}
+
+	(void)memset(muxRxRings, 0U, sizeof(muxRxRings));
+	(void)memset(muxTxRings, 0U, sizeof(muxTxRings));
+	(void)memset(muxStats, 0U, sizeof(muxStats));
+
+	muxInstIdx = ttysInstIdx;
+	muxRxState = TTYS_MUX_RX_SYNC;
+	muxRxEsc = false;
+	muxRxErrors = 0U;
+	muxTxChan = 0U;
+	muxCredit[0U] = muxWeight[0U];
+	muxTxBusy = false;
+	muxIsInit = true;
+
+	return ttys_set_rx_hook(ttysInstIdx, ttys_mux_rx, NULL);
+}
+
+/**
+ * @brief: Queues data on a channel and kicks the transmitter. Only as much
+ *         as fits in the channel's TX ring is taken.
+ *
+ * @param[in]: muxChan
+ * @param[in]: muxData
+ * @param[in]: muxLen
+ * @return[out]: uint32_t. Number of bytes queued
+ **/
+uint32_t ttys_mux_write(uint32_t muxChan, const void* muxData,
+						uint32_t muxLen) {
+	if (!muxIsInit || muxChan >= TTYS_MUX_NUM_CHANNELS || muxData == NULL) {
+		return 0U;
+	}
+
+	ttys_mux_ring_t* muxRing = &muxTxRings[muxChan];
+	const uint8_t* muxBytes = (const uint8_t*)muxData;
+	uint32_t muxFree = TTYS_MUX_RING_SIZE - ttys_mux_level(muxRing);
+	uint32_t muxHead = muxRing->muxHead;
+	uint32_t muxIdx = 0U;
+
+	if (muxLen > muxFree) muxLen = muxFree;
+
+	for (muxIdx = 0U; muxIdx < muxLen; muxIdx++) {
+		muxRing->muxBuf[(muxHead + muxIdx) & (TTYS_MUX_RING_SIZE - 1U)] =
+			muxBytes[muxIdx];
+	}
+	muxRing->muxHead = muxHead + muxLen;
+
+	(void)ttys_mux_pump();
+
+	return muxLen;
+}
+
+/**
+ * @brief: Reads the data received on a channel.
+ *
+ * @param[in]: muxChan
+ * @param[out]: muxData
+ * @param[in]: muxLen. Size of muxData
+ * @return[out]: uint32_t. Number of bytes read
+ **/
+uint32_t ttys_mux_read(uint32_t muxChan, void* muxData, uint32_t muxLen) {
+	if (!muxIsInit || muxChan >= TTYS_MUX_NUM_CHANNELS || muxData == NULL) {
+		return 0U;
+	}
+
+	ttys_mux_ring_t* muxRing = &muxRxRings[muxChan];
+	uint8_t* muxBytes = (uint8_t*)muxData;
+	uint32_t muxLevel = ttys_mux_level(muxRing);
+	uint32_t muxTail = muxRing->muxTail;
+	uint32_t muxIdx = 0U;
+
+	if (muxLen > muxLevel) muxLen = muxLevel;
+
+	for (muxIdx = 0U; muxIdx < muxLen; muxIdx++) {
+		muxBytes[muxIdx] =
+			muxRing->muxBuf[(muxTail + muxIdx) & (TTYS_MUX_RING_SIZE - 1U)];
+	}
+	muxRing->muxTail = muxTail + muxLen;
+
+	return muxLen;
+}
+
+/**
+ * @brief: Sends the next frame if none is in flight. Each completed frame
+ *         starts the next one from the ISR, so this only has to be called
+ *         after new data was queued (ttys_mux_write() does it). The payload
+ *         stays in the channel's TX ring until the frame was handed to
+ *         ttys_write_async(), so a refused write is sent by a later call.
+ *
+ * @return[out]: uint32_t. Payload bytes in the frame started, 0 if none
+ **/
+uint32_t ttys_mux_pump(void) {
+	uint32_t primask = __get_PRIMASK();
+	uint32_t muxIdx = 0U;
+	uint32_t muxFrameLen = 0U;
+	uint16_t muxCrc = TTYS_MUX_CRC_INIT;
+
+	if (!muxIsInit) return 0U;
+
+	__disable_irq();
+
+	if (muxTxBusy) {
+		__set_PRIMASK(primask);
+		return 0U;
+	}
+
+	int32_t muxChan = ttys_mux_next_chan();
+	if (muxChan < 0) {
+		__set_PRIMASK(primask);
+		return 0U;
+	}
+
+	muxTxBusy = true;
+	__set_PRIMASK(primask);
+
+	// Building the frame from the channel's TX ring
+	ttys_mux_ring_t* muxRing = &muxTxRings[muxChan];
+	uint32_t muxLen = ttys_mux_level(muxRing);
+	uint32_t muxTail = muxRing->muxTail;
+
+	if (muxLen > TTYS_MUX_MAX_PAYLOAD) muxLen = TTYS_MUX_MAX_PAYLOAD;
+
+	muxTxFrame[muxFrameLen++] = TTYS_MUX_SYNC;
+
+	muxCrc = ttys_mux_crc(muxCrc, (uint8_t)muxChan);
+	muxFrameLen += ttys_mux_stuff(&muxTxFrame[muxFrameLen], (uint8_t)muxChan);
+	muxCrc = ttys_mux_crc(muxCrc, (uint8_t)muxLen);
+	muxFrameLen += ttys_mux_stuff(&muxTxFrame[muxFrameLen], (uint8_t)muxLen);
+
+	for (muxIdx = 0U; muxIdx < muxLen; muxIdx++) {
+		uint8_t muxByte =
+			muxRing->muxBuf[(muxTail + muxIdx) & (TTYS_MUX_RING_SIZE - 1U)];
+
+		muxCrc = ttys_mux_crc(muxCrc, muxByte);
+		muxFrameLen += ttys_mux_stuff(&muxTxFrame[muxFrameLen], muxByte);
+	}
+
+	muxFrameLen += ttys_mux_stuff(&muxTxFrame[muxFrameLen],
+								  (uint8_t)(muxCrc >> 8U));
+	muxFrameLen += ttys_mux_stuff(&muxTxFrame[muxFrameLen], (uint8_t)muxCrc);
+
+	// The frame can complete, and the next one start from the ISR, as soon
+	// as the write is accepted, so the ring moves on with it
+	__disable_irq();
+
+	if (ttys_write_async(muxInstIdx, muxTxFrame, muxFrameLen,
+						 ttys_mux_tx_done, NULL) != EXIT_SUCCESS) {
+		muxTxBusy = false;
+		__set_PRIMASK(primask);
+		return 0U;
+	}
+
+	muxRing->muxTail = muxTail + muxLen;
+	muxStats[muxChan].txBytes += muxLen;
+	muxStats[muxChan].txFrames++;
+
+	__set_PRIMASK(primask);
+
+	return muxLen;
+}
+
+/**
+ * @brief: Copies the statistics of a channel.
+ *
+ * @param[in]: muxChan
+ * @param[out]: muxChanStats
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_mux_get_stats(uint32_t muxChan, ttys_mux_stats_t* muxChanStats) {
+	if (muxChan >= TTYS_MUX_NUM_CHANNELS) return TTYS_MUX_ERR_CHAN;
+	if (muxChanStats == NULL) return TTYS_ERR_NULL;
+
+	*muxChanStats = muxStats[muxChan];
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief: Returns the number of frames discarded for a bad channel number,
+ *         length or CRC, or cut short by the next sync byte.
+ *
+ * @return[out]: uint32_t
+ **/
+uint32_t ttys_mux_get_rx_errors(void) { return muxRxErrors; }
+
+////////////////////////////////////////////////////////////////////////////////
+// Private (Static) Function Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief: ttys RX hook. Unstuffs and demuxes one byte. A sync byte always
+ *         starts a new frame, the payload is collected and only goes into
+ *         the channel's RX ring once the CRC matched.
+ *
+ * @param[in]: hookCtx
+ * @param[in]: data
+ * @return[out]: void
+ **/
+static void ttys_mux_rx(void* hookCtx, char data) {
+	uint8_t muxByte = (uint8_t)data;
+
+	(void)hookCtx;
+
+	if (muxByte == TTYS_MUX_SYNC) {
+		// The frame in progress was cut short
+		if (muxRxState != TTYS_MUX_RX_SYNC) muxRxErrors++;
+
+		muxRxState = TTYS_MUX_RX_CHAN;
+		muxRxCrc = TTYS_MUX_CRC_INIT;
+		muxRxEsc = false;
+		return;
+	}
+
+	// Waiting for the next frame
+	if (muxRxState == TTYS_MUX_RX_SYNC) return;
+
+	if (muxByte == TTYS_MUX_ESC) {
+		muxRxEsc = true;
+		return;
+	}
+	if (muxRxEsc) {
+		muxByte ^= TTYS_MUX_ESC_XOR;
+		muxRxEsc = false;
+	}
+
+	muxRxCrc = ttys_mux_crc(muxRxCrc, muxByte);
+
+	switch (muxRxState) {
+		case TTYS_MUX_RX_CHAN:
+			if (muxByte >= TTYS_MUX_NUM_CHANNELS) {
+				muxRxErrors++;
+				muxRxState = TTYS_MUX_RX_SYNC;
+				break;
+			}
+			muxRxChan = muxByte;
+			muxRxState = TTYS_MUX_RX_LEN;
+			break;
+
+		case TTYS_MUX_RX_LEN:
+			if (muxByte > TTYS_MUX_MAX_PAYLOAD) {
+				muxRxErrors++;
+				muxRxState = TTYS_MUX_RX_SYNC;
+				break;
+			}
+			muxRxLen = muxByte;
+			muxRxPos = 0U;
+			muxRxState = (muxRxLen != 0U) ? TTYS_MUX_RX_DATA : TTYS_MUX_RX_CRC;
+			break;
+
+		case TTYS_MUX_RX_DATA:
+			muxRxBuf[muxRxPos++] = muxByte;
+			if (muxRxPos == muxRxLen) {
+				muxRxPos = 0U;
+				muxRxState = TTYS_MUX_RX_CRC;
+			}
+			break;
+
+		case TTYS_MUX_RX_CRC:
+			if (++muxRxPos < TTYS_MUX_CRC_SIZE) break;
+
+			if (muxRxCrc == 0U) {
+				ttys_mux_rx_commit();
+			} else {
+				muxRxErrors++;
+			}
+			muxRxState = TTYS_MUX_RX_SYNC;
+			break;
+
+		default:
+			muxRxState = TTYS_MUX_RX_SYNC;
+			break;
+	}
+}
+
+/**
+ * @brief: Hands the payload of a good frame to its channel's RX ring.
+ *
+ * @return[out]: void
+ **/
+static void ttys_mux_rx_commit(void) {
+	ttys_mux_ring_t* muxRing = &muxRxRings[muxRxChan];
+	uint32_t muxIdx = 0U;
+
+	for (muxIdx = 0U; muxIdx < muxRxLen; muxIdx++) {
+		if (ttys_mux_level(muxRing) < TTYS_MUX_RING_SIZE) {
+			muxRing->muxBuf[muxRing->muxHead & (TTYS_MUX_RING_SIZE - 1U)] =
+				muxRxBuf[muxIdx];
+			muxRing->muxHead++;
+			muxStats[muxRxChan].rxBytes++;
+		} else {
+			muxStats[muxRxChan].rxDrops++;
+		}
+	}
+}
+
+/**
+ * @brief: Write completion, starts the next frame.
+ *
+ * @param[in]: asyncCtx
+ * @param[in]: asyncStatus
+ * @param[in]: asyncLen
+ * @return[out]: void
+ **/
+static void ttys_mux_tx_done(void* asyncCtx, uint32_t asyncStatus,
+							 uint32_t asyncLen) {
+	(void)asyncCtx;
+	(void)asyncStatus;
+	(void)asyncLen;
+
+	muxTxBusy = false;
+	(void)ttys_mux_pump();
+}
+
+/**
+ * @brief: Picks the channel of the next frame. The current channel keeps
+ *         the turn while it has data and credit left, then the turn moves on
+ *         and the next channel gets its weight as credit, so a busy channel
+ *         sends at most its weight in frames before the others get a turn.
+ *
+ * @return[out]: int32_t. The channel, -1 if no channel has data
+ **/
+static int32_t ttys_mux_next_chan(void) {
+	uint32_t muxTry = 0U;
+
+	for (muxTry = 0U; muxTry <= TTYS_MUX_NUM_CHANNELS; muxTry++) {
+		if (muxCredit[muxTxChan] != 0U &&
+			ttys_mux_level(&muxTxRings[muxTxChan]) != 0U) {
+			muxCredit[muxTxChan]--;
+			return (int32_t)muxTxChan;
+		}
+
+		muxTxChan = (muxTxChan + 1U) % TTYS_MUX_NUM_CHANNELS;
+		muxCredit[muxTxChan] = muxWeight[muxTxChan];
+	}
+
+	return -1;
+}
+
+/**
+ * @brief: Bytes waiting in a ring.
+ *
+ * @param[in]: muxRing
+ * @return[out]: uint32_t
+ **/
+static uint32_t ttys_mux_level(const ttys_mux_ring_t* muxRing) {
+	return muxRing->muxHead - muxRing->muxTail;
+}
+
+/**
+ * @brief: Updates a CRC-16/CCITT-FALSE with one byte.
+ *
+ * @param[in]: muxCrc
+ * @param[in]: muxByte
+ * @return[out]: uint16_t
+ **/
+static uint16_t ttys_mux_crc(uint16_t muxCrc, uint8_t muxByte) {
+	uint32_t muxBit = 0U;
+
+	muxCrc ^= (uint16_t)(muxByte << 8U);
+	for (muxBit = 0U; muxBit < 8U; muxBit++) {
+		muxCrc = (uint16_t)((muxCrc << 1U) ^
+							(TTYS_MUX_CRC_POLY & (0U - (muxCrc >> 15U))));
+	}
+
+	return muxCrc;
+}
+
+/**
+ * @brief: Writes one frame byte, escaped if it is the sync or escape byte.
+ *
+ * @param[out]: muxOut
+ * @param[in]: muxByte
+ * @return[out]: uint32_t. Bytes written, 1 or 2
+ **/
+static uint32_t ttys_mux_stuff(uint8_t* muxOut, uint8_t muxByte) {
+	if (muxByte != TTYS_MUX_SYNC && muxByte != TTYS_MUX_ESC) {
+		muxOut[0U] = muxByte;
+		return 1U;
+	}
+
+	muxOut[0U] = TTYS_MUX_ESC;
+	muxOut[1U] = muxByte ^ TTYS_MUX_ESC_XOR;
+	return 2U;
+}
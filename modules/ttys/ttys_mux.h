@@ -0,0 +1,104 @@
+/**
+ * @file ttys_mux.h
+ * @author Owais Talpur (owaistalpur@hotmail.com)
+ * @brief Virtual channels multiplexed over one ttys instance
+ * @version 0.1
+ * @date 2025
+ *
+ * @copyright Copyright (c) 2025
+ *
+ **/
+
+#ifndef TTYS_MUX_H
+#define TTYS_MUX_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <ttys.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Common macros
+////////////////////////////////////////////////////////////////////////////////
+
+// Frames are [TTYS_MUX_SYNC][channel][length][payload][CRC-16, MSB first].
+// Everything after the sync byte is byte-stuffed: TTYS_MUX_SYNC and
+// TTYS_MUX_ESC are sent as TTYS_MUX_ESC and the byte XOR TTYS_MUX_ESC_XOR,
+// so the sync byte only ever starts a frame
+#define TTYS_MUX_SYNC 0x7EU
+#define TTYS_MUX_ESC 0x7DU
+#define TTYS_MUX_ESC_XOR 0x20U
+#define TTYS_MUX_HDR_SIZE 3U
+#define TTYS_MUX_CRC_SIZE 2U
+
+#ifndef TTYS_MUX_MAX_PAYLOAD
+#define TTYS_MUX_MAX_PAYLOAD 32U
+#endif
+
+// Longest frame on the wire, with every byte after the sync byte stuffed
+#define TTYS_MUX_FRAME_MAX                                   \
+  (1U + 2U * (TTYS_MUX_HDR_SIZE - 1U + TTYS_MUX_MAX_PAYLOAD + \
+              TTYS_MUX_CRC_SIZE))
+
+// Per-channel ring size, must be a power of 2
+#ifndef TTYS_MUX_RING_SIZE
+#define TTYS_MUX_RING_SIZE 128U
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Type Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Channels */
+typedef enum {
+
+  TTYS_MUX_CONSOLE,
+  TTYS_MUX_TELEMETRY,
+  TTYS_MUX_LOG,
+  TTYS_MUX_UPDATE,
+
+  TTYS_MUX_NUM_CHANNELS
+} ttys_mux_chan_t;
+
+/* Error Codes */
+typedef enum {
+
+  TTYS_MUX_ERR_CHAN = 0x5CU,
+  TTYS_MUX_ERR_CONFIG,
+
+} ttys_mux_errors_t;
+
+/* Single producer, single consumer byte ring */
+typedef struct {
+  volatile uint32_t muxHead;  // Free running, written by the producer
+  volatile uint32_t muxTail;  // Free running, written by the consumer
+  uint8_t muxBuf[TTYS_MUX_RING_SIZE];
+
+} ttys_mux_ring_t;
+
+/* Per-channel statistics */
+typedef struct {
+  uint32_t rxBytes;
+  uint32_t rxDrops;  // Payload bytes lost because the RX ring was full
+  uint32_t txBytes;
+  uint32_t txFrames;
+
+} ttys_mux_stats_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Module Interface
+////////////////////////////////////////////////////////////////////////////////
+
+/* Core API */
+uint32_t ttys_mux_init(uint32_t ttysInstIdx,
+                       const uint8_t muxWeights[TTYS_MUX_NUM_CHANNELS]);
+uint32_t ttys_mux_write(uint32_t muxChan, const void *muxData,
+                        uint32_t muxLen);
+uint32_t ttys_mux_read(uint32_t muxChan, void *muxData, uint32_t muxLen);
+uint32_t ttys_mux_pump(void);
+
+/* Other API */
+uint32_t ttys_mux_get_stats(uint32_t muxChan, ttys_mux_stats_t *muxStats);
+uint32_t ttys_mux_get_rx_errors(void);
+
+#endif  // ttys_mux.h